@@ -30,6 +30,8 @@
 // C++ INCLUDES
 // =====================================================================================================================
 #include <iostream>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 // =====================================================================================================================
 
@@ -56,7 +58,7 @@ using zmqutils::common::CommandReply;
 using zmqutils::common::ServerCommand;
 using zmqutils::utils::BinarySerializer;
 
-void parseCommand(CommandClientBase &client, const std::string &command)
+void parseCommand(AmelasControllerClient &client, const std::string &command)
 {
     zmqutils::common::OperationResult client_result = OperationResult::COMMAND_OK;
 
@@ -103,6 +105,29 @@ void parseCommand(CommandClientBase &client, const std::string &command)
         else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_GET_HOME_POSITION))
         {
             std::cout << "Sending get home position command." << std::endl;
+
+            // Ask for a packed reply sending only the packed header.
+            char *param_token = std::strtok(nullptr, " ");
+            if (param_token && std::string(param_token) == "packed")
+                command_msg.params_size = BinarySerializer::fastSerializationPacked(command_msg.params);
+
+            // Send several pipelined requests using the asynchronous channel.
+            if (param_token && std::string(param_token) == "async")
+            {
+                char *count_token = std::strtok(nullptr, " ");
+                int count = count_token ? std::atoi(count_token) : 10;
+                std::vector<std::future<CommandReply>> futures;
+                for (int i = 0; i < count; i++)
+                    futures.push_back(client.sendCommandAsync(command_msg));
+                for (size_t i = 0; i < futures.size(); i++)
+                {
+                    CommandReply reply = futures[i].get();
+                    std::cout<<"Async reply "<<i<<" server result: "<<static_cast<int>(reply.server_result)
+                             <<" ("<<reply.params_size<<" bytes)"<<std::endl;
+                }
+                delete[] command_str;
+                return;
+            }
         }
         else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_SET_HOME_POSITION))
         {
@@ -137,7 +162,17 @@ void parseCommand(CommandClientBase &client, const std::string &command)
                 }
             }
 
-            if (valid_params)
+            // Check the optional wire format.
+            param_token = valid_params ? std::strtok(nullptr, " ") : nullptr;
+            bool packed = param_token && std::string(param_token) == "packed";
+
+            if (valid_params && packed)
+            {
+                std::cout<<"Sending (packed): " << az <<" "<<el<<std::endl;
+
+                command_msg.params_size = BinarySerializer::fastSerializationPacked(command_msg.params, az, el);
+            }
+            else if (valid_params)
             {
                 std::cout<<"Sending: " << az <<" "<<el<<std::endl;
 
@@ -164,6 +199,117 @@ void parseCommand(CommandClientBase &client, const std::string &command)
             valid = valid_params;
 
         }
+        else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_BATCH))
+        {
+            std::cout << "Sending batch command (set and get home position)." << std::endl;
+
+            // Parameters: az el [best].
+            char *az_token = std::strtok(nullptr, " ");
+            char *el_token = std::strtok(nullptr, " ");
+            char *mode_token = std::strtok(nullptr, " ");
+            try
+            {
+                AltAzPos pos(std::stod(az_token ? az_token : ""), std::stod(el_token ? el_token : ""));
+                BatchMode mode = (mode_token && std::string(mode_token) == "best") ? BatchMode::BEST_EFFORT :
+                                                                                      BatchMode::STOP_ON_ERROR;
+                std::unique_ptr<std::byte[]> set_params;
+                size_t set_size = BinarySerializer::fastSerialization(set_params, pos.az, pos.el);
+                std::vector<AmelasControllerClient::BatchEntry> entries;
+                entries.push_back({AmelasServerCommand::REQ_SET_HOME_POSITION,
+                                   std::vector<std::byte>(set_params.get(), set_params.get() + set_size)});
+                entries.push_back({AmelasServerCommand::REQ_GET_HOME_POSITION, {}});
+                command_msg = AmelasControllerClient::prepareBatchRequest(mode, entries);
+            }
+            catch (...)
+            {
+                std::cerr << "Bad batch parameters issued.";
+                valid = false;
+            }
+        }
+        else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_BEGIN_TRAJECTORY_UPLOAD))
+        {
+            // Upload a synthetic trajectory (one sample per second) with the begin, chunk and commit commands.
+            char *samples_token = std::strtok(nullptr, " ");
+            int samples = samples_token ? std::atoi(samples_token) : 86400;
+            samples = samples > 0 ? samples : 86400;
+            std::cout << "Uploading a trajectory of " << samples << " samples." << std::endl;
+
+            std::vector<std::int64_t> times(static_cast<size_t>(samples));
+            std::vector<double> az(times.size()), el(times.size());
+            const std::int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            for (size_t i = 0; i < times.size(); i++)
+            {
+                times[i] = start + static_cast<std::int64_t>(i) * 1000000000LL;
+                az[i] = std::fmod(static_cast<double>(i) * 0.01, 360.0);
+                el[i] = 10.0 + 70.0 * std::sin(3.141592653589793 * static_cast<double>(i) / times.size());
+            }
+
+            AmelasError error;
+            auto start_upload = std::chrono::steady_clock::now();
+            client_result = client.doUploadTrajectory(times, az, el, error);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_upload).count();
+            std::cout << "Client Result: " << static_cast<int>(client_result) << std::endl;
+            std::cout << "Controller error: " << static_cast<int>(error) << std::endl;
+            std::cout << "Elapsed: " << elapsed << " ms" << std::endl;
+            delete[] command_str;
+            return;
+        }
+        else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_LOAD_POINTING_MODEL))
+        {
+            // Parameters: slot and the terms in arc seconds (IA IE CA NPAE AN AW TF, the missing ones are zero).
+            char *param_token = std::strtok(nullptr, " ");
+            try
+            {
+                std::uint32_t slot = static_cast<std::uint32_t>(std::stoul(param_token ? param_token : ""));
+                std::vector<double> terms(kPointingModelTerms, 0.0);
+                for (size_t i = 0; i < terms.size() && (param_token = std::strtok(nullptr, " ")); i++)
+                    terms[i] = std::stod(param_token);
+                std::cout << "Sending load pointing model command (slot " << slot << ")." << std::endl;
+                command_msg.params_size = BinarySerializer::fastSerialization(command_msg.params, slot, terms);
+            }
+            catch (...)
+            {
+                std::cerr << "Bad pointing model parameters issued.";
+                valid = false;
+            }
+        }
+        else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_SET_POINTING_MODEL))
+        {
+            char *param_token = std::strtok(nullptr, " ");
+            try
+            {
+                std::uint32_t slot = static_cast<std::uint32_t>(std::stoul(param_token ? param_token : ""));
+                std::cout << "Sending set pointing model command (slot " << slot << ")." << std::endl;
+                command_msg.params_size = BinarySerializer::fastSerialization(command_msg.params, slot);
+            }
+            catch (...)
+            {
+                std::cerr << "Bad pointing model slot issued.";
+                valid = false;
+            }
+        }
+        else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS))
+        {
+            std::cout << "Sending get control loop stats command." << std::endl;
+
+            // Ask for a packed reply sending only the packed header.
+            char *param_token = std::strtok(nullptr, " ");
+            if (param_token && std::string(param_token) == "packed")
+                command_msg.params_size = BinarySerializer::fastSerializationPacked(command_msg.params);
+        }
+        else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_GET_METRICS))
+        {
+            std::cout << "Sending get metrics command." << std::endl;
+
+            // Ask for the text dump or for a packed reply.
+            char *param_token = std::strtok(nullptr, " ");
+            if (param_token && std::string(param_token) == "text")
+                command_msg.params_size = BinarySerializer::fastSerialization(command_msg.params, true);
+            else if (param_token && std::string(param_token) == "packed")
+                command_msg.params_size = BinarySerializer::fastSerializationPacked(command_msg.params);
+        }
         else
         {
             valid = false;
@@ -227,10 +373,44 @@ void parseCommand(CommandClientBase &client, const std::string &command)
                     return;
                 }
 
+                // Check the wire format of the reply.
+                bool packed = BinarySerializer::isPackedData(reply.params.get(), reply.params_size);
+
                 // Get the controller result.
                 // TODO ERROR CONTROL
 
-                if(command_id > static_cast<CommandType>(ServerCommand::END_BASE_COMMANDS))
+                if(command_id == static_cast<CommandType>(AmelasServerCommand::REQ_BATCH))
+                {
+                    std::vector<AmelasControllerClient::BatchResult> results;
+                    if (!AmelasControllerClient::parseBatchReply(reply, results))
+                        std::cout<<"BAD PARAMS"<<std::endl;
+                    for (size_t i = 0; i < results.size(); i++)
+                        std::cout<<"Entry "<<i<<" result: "<<static_cast<int>(results[i].result)
+                                 <<" ("<<results[i].params.size()<<" bytes)"<<std::endl;
+                }
+                else if(command_id == static_cast<CommandType>(AmelasServerCommand::REQ_GET_METRICS))
+                {
+                    // The request parameters select the text dump.
+                    try
+                    {
+                        std::string dump;
+                        if (packed)
+                            std::cout<<"Packed metrics ("<<reply.params_size<<" bytes)"<<std::endl;
+                        else if (command_msg.params_size)
+                        {
+                            BinarySerializer::fastDeserialization(reply.params.get(), reply.params_size, dump);
+                            std::cout<<dump;
+                        }
+                        else
+                            std::cout<<BinarySerializer(reply.params.get(), reply.params_size).toJsonString()
+                                     <<std::endl;
+                    }
+                    catch(...)
+                    {
+                        std::cout<<"BAD PARAMS"<<std::endl;
+                    }
+                }
+                else if(command_id > static_cast<CommandType>(ServerCommand::END_BASE_COMMANDS) && !packed)
                 {
                     AmelasError error;
 
@@ -251,9 +431,15 @@ void parseCommand(CommandClientBase &client, const std::string &command)
                         double el;
 
                         // Deserialize the parameters.
-                        BinarySerializer::fastDeserialization(reply.params.get(), reply.params_size, error, az, el);
+                        if (packed)
+                            BinarySerializer::fastDeserializationPacked(reply.params.get(), reply.params_size,
+                                                                        error, az, el);
+                        else
+                            BinarySerializer::fastDeserialization(reply.params.get(), reply.params_size,
+                                                                  error, az, el);
 
                         // Generate the struct.
+                        std::cout<<"Controller error: "<<static_cast<int>(error)<<std::endl;
                         std::cout<<"Az: "<<az<<std::endl;
                         std::cout<<"El: "<<el<<std::endl;
                     }
@@ -264,6 +450,19 @@ void parseCommand(CommandClientBase &client, const std::string &command)
                         //result = ClientResult::
                     }
                 }
+                else if (command_id == static_cast<CommandType>(AmelasServerCommand::REQ_SET_HOME_POSITION) && packed)
+                {
+                    try
+                    {
+                        AmelasError error;
+                        BinarySerializer::fastDeserializationPacked(reply.params.get(), reply.params_size, error);
+                        std::cout<<"Controller error: "<<static_cast<int>(error)<<std::endl;
+                    }
+                    catch(...)
+                    {
+                        std::cout<<"BAD PARAMS"<<std::endl;
+                    }
+                }
             }
         }
         else
@@ -318,6 +517,9 @@ int main(int, char**)
         return 1;
     }
 
+    // Start the asynchronous channel for the pipelined requests.
+    client.startAsyncChannel();
+
     //client.startAutoAlive();
     std::string command;
 
@@ -332,12 +534,22 @@ int main(int, char**)
         std::cout<<"- REQ_ALIVE:            2"<<std::endl;
         std::cout<<"- REQ_GET_SERVER_TIME:  3"<<std::endl;
         std::cout<<"- CUSTOM:         cmd param1 param2 ..."<<std::endl;
+        std::cout<<"- CUSTOM PACKED:  cmd param1 param2 ... packed"<<std::endl;
+        std::cout<<"- REQ_BATCH:      35 az el [best]"<<std::endl;
+        std::cout<<"- ASYNC GET HOME: 34 async [n]"<<std::endl;
+        std::cout<<"- UPLOAD TRAJ.:   36 [samples]"<<std::endl;
+        std::cout<<"- LOAD POINTING:  39 slot [IA IE CA NPAE AN AW TF]"<<std::endl;
+        std::cout<<"- SET POINTING:   40 slot"<<std::endl;
+        std::cout<<"- LOOP STATS:     41"<<std::endl;
+        std::cout<<"- SERVER METRICS: 42 [text|packed]"<<std::endl;
         std::cout<<"-- Other --"<<std::endl;
         std::cout<<"- Client exit:             exit"<<std::endl;
         std::cout<<"- Enable auto-alive:       auto_alive_en"<<std::endl;
         std::cout<<"- Disable auto-alive:      auto_alive_ds"<<std::endl;
         std::cout<<"- Enable auto-alive clbk:  auto_alive_clbk_en"<<std::endl;
         std::cout<<"- Disable auto-alive clbk: auto_alive_clbk_ds"<<std::endl;
+        std::cout<<"- Enable shared heartbeat: shared_hb_en"<<std::endl;
+        std::cout<<"- Disable shared heartbeat: shared_hb_ds"<<std::endl;
         std::cout<<"------------------------------------------------------"<<std::endl;
         std::cout<<"Write a command: ";
         std::getline(std::cin, command);
@@ -374,6 +586,19 @@ int main(int, char**)
             client.setAliveCallbacksEnabled(false);
             continue;
         }
+        else if(command == "shared_hb_en")
+        {
+            std::cout << "Enabling shared heartbeat..." << std::endl;
+            client.disableAutoAlive();
+            client.enableSharedHeartbeat();
+            continue;
+        }
+        else if(command == "shared_hb_ds")
+        {
+            std::cout << "Disabling shared heartbeat..." << std::endl;
+            client.disableSharedHeartbeat();
+            continue;
+        }
 
         // Break if we want to close the example program.
         if(console_cfg.closeStatus() || std::cin.eof())
@@ -72,6 +72,10 @@ int main(int, char**)
     // Configuration variables.
     unsigned port = 9999;
     bool client_status_check = true;
+    bool router_mode = true;
+    unsigned router_workers = 4;
+    unsigned telemetry_port = 9998;
+    unsigned telemetry_rate = 50;
 
     // Instantiate the Amelas controller.
     AmelasController amelas_controller;
@@ -82,17 +86,40 @@ int main(int, char**)
     // Disable or enables the client status checking.
     amelas_server.setClientStatusCheck(client_status_check);
 
+    // Enable the router mode (concurrent read only commands and serialized mutating commands).
+    amelas_server.setRouterMode(router_mode, router_workers);
+
+    // Enable the mount state telemetry.
+    amelas_server.setTelemetry(true, telemetry_port, telemetry_rate);
+    amelas_server.setTelemetrySource(&amelas_controller, &AmelasController::getMountState);
+
     // ---------------------------------------
 
     // Set the controller callbacks in the server.
 
-    amelas_server.registerControllerCallback(AmelasServerCommand::REQ_SET_HOME_POSITION,
-                                             &amelas_controller,
-                                             &AmelasController::setHomePosition);
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_SET_HOME_POSITION>(
+        &amelas_controller, &AmelasController::setHomePosition);
+
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_GET_HOME_POSITION>(
+        &amelas_controller, &AmelasController::getHomePosition);
+
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_BEGIN_TRAJECTORY_UPLOAD>(
+        &amelas_controller, &AmelasController::beginTrajectoryUpload);
+
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_UPLOAD_TRAJECTORY_CHUNK>(
+        &amelas_controller, &AmelasController::uploadTrajectoryChunk);
+
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_COMMIT_TRAJECTORY_UPLOAD>(
+        &amelas_controller, &AmelasController::commitTrajectoryUpload);
 
-    amelas_server.registerControllerCallback(AmelasServerCommand::REQ_GET_HOME_POSITION,
-                                             &amelas_controller,
-                                             &AmelasController::getHomePosition);
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_LOAD_POINTING_MODEL>(
+        &amelas_controller, &AmelasController::loadPointingModel);
+
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_SET_POINTING_MODEL>(
+        &amelas_controller, &AmelasController::setPointingModel);
+
+    amelas_server.registerControllerCallback<AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS>(
+        &amelas_controller, &AmelasController::getControlLoopStats);
 
     // ---------------------------------------
 
@@ -109,6 +136,9 @@ int main(int, char**)
         return 1;
     }
 
+    // Start the control loop (with real time scheduling and memory locking if the process has the privileges).
+    amelas_controller.startControlLoop();
+
     // Wait for closing as an infinite loop until ctrl-c.
     console_cfg.waitForClose();
 
@@ -118,6 +148,12 @@ int main(int, char**)
     // Stop the server.
     amelas_server.stopServer();
 
+    // Stop the control loop.
+    amelas_controller.stopControlLoop();
+
+    // Show the server metrics.
+    std::cout << amelas_server.dumpMetrics();
+
     // Final log.
     std::cout << "Server stoped. All ok!!" << std::endl;
 
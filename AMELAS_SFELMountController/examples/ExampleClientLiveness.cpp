@@ -0,0 +1,212 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleClientLiveness.cpp
+ * @brief EXAMPLE FILE - Compares the client liveness tracking (ordered map and scan vs hash table and timer wheel).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+// =====================================================================================================================
+
+using namespace amelas::communication;
+using Clock = std::chrono::steady_clock;
+
+// Simulation configuration: liveness timeout, requests per client and timeout, simulated timeouts and probability of a
+// short-lived client. The map and scan approach is limited to kMaxScanVisits (it is O(clients) per request).
+constexpr std::chrono::milliseconds kTimeout{1000};
+constexpr std::size_t kRequestsPerTimeout = 4;
+constexpr std::size_t kSimulatedTimeouts = 3;
+constexpr std::size_t kMinRequests = 200000;
+constexpr unsigned kShortLivedPerMille = 10;
+constexpr std::size_t kMaxScanVisits = 400000000;
+
+// Simulated client event: a request from a client or a new client that replaces it (the old one dies silently).
+struct ClientEvent
+{
+    std::size_t client;
+    bool replace;
+};
+
+// Random UUID (the bytes are enough for the benchmark).
+UUID randomUUID(std::mt19937_64& rng)
+{
+    std::array<std::byte, UUID::kUUIDSize> bytes;
+    for (auto& byte : bytes)
+        byte = static_cast<std::byte>(rng());
+    return UUID(bytes);
+}
+
+// Result of a run.
+struct RunResult
+{
+    double ns_per_request;
+    std::size_t requests;
+    std::size_t dead;
+};
+
+// Previous approach: ordered map, lookup of the client of each request and scan of all the clients after each request.
+RunResult runMapScan(const std::vector<UUID>& uuids, const std::vector<UUID>& new_uuids, Clock::duration period,
+                     const std::vector<ClientEvent>& events, std::size_t requests)
+{
+    std::map<UUID, HostInfo> clients;
+    std::vector<UUID> current = uuids;
+    std::size_t dead = 0, next_new = 0;
+    Clock::time_point now = Clock::now();
+    for (const UUID& uuid : uuids)
+    {
+        HostInfo client(uuid, "127.0.0.1", "1", "host", "monitor");
+        client.last_seen = now;
+        clients.emplace(uuid, client);
+    }
+
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < requests; i++)
+    {
+        const ClientEvent& event = events[i];
+        now += period;
+        if (event.replace)
+        {
+            HostInfo client(new_uuids[next_new], "127.0.0.1", "1", "host", "monitor");
+            client.last_seen = now;
+            current[event.client] = new_uuids[next_new++];
+            clients.emplace(client.uuid, client);
+        }
+        else
+        {
+            auto it = clients.find(current[event.client]);
+            if (it != clients.end())
+                it->second.last_seen = now;
+        }
+        for (auto it = clients.begin(); it != clients.end();)
+        {
+            if (now - it->second.last_seen > kTimeout)
+            {
+                it = clients.erase(it);
+                dead++;
+            }
+            else
+                it++;
+        }
+    }
+    const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return {elapsed / static_cast<double>(requests), requests, dead};
+}
+
+// New approach: hash table and timer wheel.
+RunResult runRegistry(const std::vector<UUID>& uuids, const std::vector<UUID>& new_uuids, Clock::duration period,
+                      const std::vector<ClientEvent>& events, std::size_t requests)
+{
+    ClientRegistry clients;
+    std::vector<UUID> current = uuids;
+    std::vector<HostInfo> dead_clients;
+    std::size_t dead = 0, next_new = 0;
+    Clock::time_point now = Clock::now();
+    clients.setTimeout(kTimeout);
+    for (const UUID& uuid : uuids)
+    {
+        HostInfo client(uuid, "127.0.0.1", "1", "host", "monitor");
+        client.last_seen = now;
+        clients.insert(client);
+    }
+
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < requests; i++)
+    {
+        const ClientEvent& event = events[i];
+        now += period;
+        if (event.replace)
+        {
+            HostInfo client(new_uuids[next_new], "127.0.0.1", "1", "host", "monitor");
+            client.last_seen = now;
+            current[event.client] = new_uuids[next_new++];
+            clients.insert(client);
+        }
+        else
+            clients.touch(current[event.client], now);
+        clients.collectExpired(now, dead_clients);
+        dead += dead_clients.size();
+        dead_clients.clear();
+    }
+    const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return {elapsed / static_cast<double>(requests), requests, dead};
+}
+
+/**
+ * @brief Main entry point of the program `ExampleClientLiveness`.
+ *
+ * Each simulated request comes from a random client, and some of them are short-lived clients that replace one of the
+ * existing ones (the replaced client stops sending requests and must expire after the timeout). The simulated time
+ * advances a fixed period per request, so both approaches see the same events and expire the same clients.
+ */
+int main()
+{
+    std::cout << "Client liveness benchmark (timeout " << kTimeout.count() << " ms, " << kRequestsPerTimeout
+              << " requests per client and timeout, " << kShortLivedPerMille << " per mille short-lived clients)"
+              << std::endl;
+    std::cout << std::setw(8) << "Clients" << std::setw(11) << "Requests" << std::setw(18) << "Map+scan ns/req"
+              << std::setw(18) << "Registry ns/req" << std::setw(10) << "Speedup" << std::setw(18) << "Dead (map/reg)"
+              << std::endl;
+
+    for (std::size_t clients : {std::size_t(10), std::size_t(1000), std::size_t(50000)})
+    {
+        // Same events for both approaches, covering several timeouts.
+        std::mt19937_64 rng(clients);
+        const std::size_t requests = std::max(kMinRequests, clients * kRequestsPerTimeout * kSimulatedTimeouts);
+        const Clock::duration period = std::chrono::duration_cast<Clock::duration>(kTimeout) /
+                                       static_cast<Clock::rep>(clients * kRequestsPerTimeout);
+        std::vector<UUID> uuids, new_uuids;
+        std::vector<ClientEvent> events(requests);
+        for (std::size_t i = 0; i < clients; i++)
+            uuids.push_back(randomUUID(rng));
+        for (ClientEvent& event : events)
+        {
+            event.client = static_cast<std::size_t>(rng() % clients);
+            event.replace = rng() % 1000 < kShortLivedPerMille;
+            if (event.replace)
+                new_uuids.push_back(randomUUID(rng));
+        }
+
+        // The map and scan approach only runs the first requests in the big cases (its dead clients are not shown).
+        const RunResult map = runMapScan(uuids, new_uuids, period, events,
+                                         std::min(requests, kMaxScanVisits / clients));
+        const RunResult registry = runRegistry(uuids, new_uuids, period, events, requests);
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << clients << std::setw(11) << requests
+                  << std::setw(18) << map.ns_per_request << std::setw(18) << registry.ns_per_request << std::setw(9)
+                  << map.ns_per_request / registry.ns_per_request << "x" << std::setw(10)
+                  << (map.requests == requests ? std::to_string(map.dead) : std::string("-")) << "/"
+                  << registry.dead << std::endl;
+    }
+
+    return 0;
+}
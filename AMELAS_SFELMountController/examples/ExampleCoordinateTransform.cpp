@@ -0,0 +1,118 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleCoordinateTransform.cpp
+ * @brief EXAMPLE FILE - Benchmark of the batch RA/Dec to Az/El transform (scalar, vectorized and parallel versions).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+// =====================================================================================================================
+
+using namespace amelas::controller;
+
+// Maximum angular difference in arc seconds between two results (with the azimuth wrap, ignoring the zenith).
+double maxDifference(const HorizontalBatch& a, const HorizontalBatch& b)
+{
+    double max_diff = 0.0;
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        double diff_az = std::fabs(a.az[i] - b.az[i]);
+        diff_az = std::fmin(diff_az, 360.0 - diff_az) * std::cos(a.el[i] * 3.14159265358979323846 / 180.0);
+        max_diff = std::fmax(max_diff, std::fmax(diff_az, std::fabs(a.el[i] - b.el[i])));
+    }
+    return max_diff * 3600.0;
+}
+
+void runBenchmark(const CoordinateTransform& transform, const EquatorialBatch& stars, unsigned threads)
+{
+    HorizontalBatch reference, result;
+    reference.az.resize(stars.size());
+    reference.el.resize(stars.size());
+
+    // Scalar reference.
+    auto t0 = std::chrono::steady_clock::now();
+    transform.transformScalar(stars.ra.data(), stars.dec.data(), stars.size(), reference.az.data(),
+                              reference.el.data());
+    const double scalar_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    // Best kernel (vectorized if available, parallel for the big lists).
+    t0 = std::chrono::steady_clock::now();
+    transform.transform(stars, result, threads);
+    const double batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    // Results.
+    std::cout << std::left << std::setw(8) << stars.size() << " stars | threads " << threads << " | scalar "
+              << std::fixed << std::setprecision(2) << scalar_ns / stars.size() << " ns/star | batch "
+              << batch_ns / stars.size() << " ns/star | speedup " << scalar_ns / batch_ns << " | max diff "
+              << std::scientific << std::setprecision(2) << maxDifference(reference, result) << " arcsec"
+              << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+/**
+ * @brief Main entry point of the program `ExampleCoordinateTransform`.
+ */
+int main(int, char**)
+{
+    // Station (San Fernando) and observation time.
+    StationLocation station;
+    station.latitude = 36.46525;
+    station.longitude = -6.20530;
+    station.pressure = 1013.0;
+    station.temperature = 18.0;
+    CoordinateTransform transform(station);
+    transform.setTime(1700000000LL * 1000000000LL);
+
+    std::cout << "Coordinate transform benchmark (vectorized kernel: "
+              << (CoordinateTransform::isVectorized() ? "AVX2" : "no") << ")" << std::endl;
+
+    // Random stars uniformly distributed over the sphere.
+    std::mt19937_64 generator(2310);
+    std::uniform_real_distribution<double> ra_dist(0.0, 360.0);
+    std::uniform_real_distribution<double> sin_dist(-1.0, 1.0);
+
+    for (std::size_t count : {1000u, 100000u, 2000000u})
+    {
+        EquatorialBatch stars;
+        stars.ra.resize(count);
+        stars.dec.resize(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            stars.ra[i] = ra_dist(generator);
+            stars.dec[i] = std::asin(sin_dist(generator)) * 180.0 / 3.14159265358979323846;
+        }
+        runBenchmark(transform, stars, 1);
+        if (count >= CoordinateTransform::kParallelThreshold)
+            runBenchmark(transform, stars, 0);
+    }
+
+    return 0;
+}
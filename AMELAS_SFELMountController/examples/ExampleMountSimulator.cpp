@@ -0,0 +1,128 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleMountSimulator.cpp
+ * @brief EXAMPLE FILE - Replays tracking passes with the simulated mount in virtual time (tracking error benchmark).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+// =====================================================================================================================
+
+using namespace amelas::controller;
+
+// Start of the simulated night (UTC nanoseconds) and San Fernando station.
+constexpr std::int64_t kNightStart = 1700000000LL * 1000000000LL;
+const StationLocation kStation = {36.4652, -6.2055, 1013.0, 15.0};
+
+// Tabulate a star (RA/Dec) with one sample per second.
+void starTrajectory(double ra, double dec, double duration, TrajectoryBuffer& trajectory)
+{
+    CoordinateTransform transform(kStation);
+    trajectory.size = static_cast<std::size_t>(duration) + 1;
+    for (std::size_t i = 0; i < trajectory.size; i++)
+    {
+        trajectory.timestamps[i] = kNightStart + static_cast<std::int64_t>(i) * 1000000000LL;
+        transform.setTime(trajectory.timestamps[i]);
+        transform.transform(&ra, &dec, 1, &trajectory.az[i], &trajectory.el[i]);
+    }
+}
+
+// Tabulate a fast pass (analytic, like a LEO satellite) with one sample per second: the azimuth crosses 0/360 and
+// the elevation culminates at 85 degrees.
+void passTrajectory(double duration, TrajectoryBuffer& trajectory)
+{
+    trajectory.size = static_cast<std::size_t>(duration) + 1;
+    for (std::size_t i = 0; i < trajectory.size; i++)
+    {
+        const double x = (static_cast<double>(i) - duration / 2.0) / 90.0;
+        trajectory.timestamps[i] = kNightStart + static_cast<std::int64_t>(i) * 1000000000LL;
+        trajectory.az[i] = std::fmod(330.0 + 80.0 * std::tanh(x) + 360.0, 360.0);
+        trajectory.el[i] = 10.0 + 75.0 * std::exp(-x * x);
+    }
+}
+
+void runSimulation(const std::string& name, const TrajectoryBuffer& trajectory, double speed)
+{
+    // Prepare the interpolator.
+    TrajectoryInterpolator interpolator;
+    if (interpolator.prepare(trajectory, kDefaultInterpolationMethod, kDefaultInterpolationOrder) !=
+        AmelasError::SUCCESS)
+    {
+        std::cout << name << ": invalid trajectory." << std::endl;
+        return;
+    }
+
+    // Simulated mount in virtual time, starting at the park position.
+    auto clock = std::make_shared<VirtualClock>(kNightStart, speed);
+    MountSimulator simulator(MountSimulatorConfig(), clock);
+    simulator.reset(AltAzPos(0.0, 45.0));
+
+    // Track the whole trajectory.
+    TrackingStats stats;
+    const AmelasError error = simulator.track(interpolator, stats);
+
+    // Results.
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << " | simulated " << std::setw(8) << stats.simulated_time << " s | wall " << std::setprecision(3)
+              << std::setw(7) << stats.wall_time << " s | x" << std::setprecision(0) << std::setw(6)
+              << stats.simulated_time / stats.wall_time << " | acquire " << std::setprecision(2)
+              << stats.acquire_time << " s | rms " << std::setprecision(4) << stats.rms_error << "\" | max "
+              << stats.max_error << "\" (az " << stats.max_az_error << "\", el " << stats.max_el_error << "\")"
+              << (error != AmelasError::SUCCESS ? " | " + std::string(ControllerErrorStr[static_cast<size_t>(error)])
+                                                : "") << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+/**
+ * @brief Main entry point of the program `ExampleMountSimulator`.
+ *
+ * Usage: ExampleMountSimulator [speed]. The speed of the virtual clock is 0 (as fast as possible) by default.
+ */
+int main(int argc, char** argv)
+{
+    const double speed = argc > 1 ? std::atof(argv[1]) : 0.0;
+    TrajectoryBuffer trajectory;
+
+    std::cout << "Mount simulator benchmark (1 kHz servo, virtual clock speed "
+              << (speed > 0.0 ? std::to_string(speed) : std::string("unlimited")) << ")" << std::endl;
+
+    // Fast pass (10 minutes).
+    passTrajectory(600.0, trajectory);
+    runSimulation("LEO pass", trajectory, speed);
+
+    // Stars tracked for a whole night (8 hours).
+    starTrajectory(37.95, 89.26, 8.0 * 3600.0, trajectory);
+    runSimulation("Polaris night", trajectory, speed);
+    starTrajectory(79.17, 46.00, 4.0 * 3600.0, trajectory);
+    runSimulation("Capella 4 h", trajectory, speed);
+
+    return 0;
+}
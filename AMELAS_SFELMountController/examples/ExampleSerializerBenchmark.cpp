@@ -0,0 +1,113 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleSerializerBenchmark.cpp
+ * @brief EXAMPLE FILE - Per field cost of the BinarySerializer and the LocalBinarySerializer.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include <LibZMQUtils/Utils>
+// =====================================================================================================================
+
+using zmqutils::utils::BinarySerializer;
+using zmqutils::utils::LocalBinarySerializer;
+using Clock = std::chrono::steady_clock;
+
+// Iterations of each measurement.
+constexpr std::size_t kIterations = 1000000;
+
+// Sink of the results, so the compiler can't remove the measured loops.
+volatile std::uint64_t sink = 0;
+
+// Time a serialization and a deserialization of a field with the given serializer (ns per operation).
+template <typename Serializer, typename T>
+void measure(const T& value, double& ser_ns, double& des_ns)
+{
+    // Serialization.
+    std::unique_ptr<std::byte[]> data;
+    std::uint64_t size = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < kIterations; i++)
+    {
+        size = Serializer::fastSerialization(data, value);
+        sink = sink + size;
+    }
+    ser_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / kIterations;
+
+    // Deserialization.
+    T result{};
+    start = Clock::now();
+    for (std::size_t i = 0; i < kIterations; i++)
+    {
+        Serializer::fastDeserialization(data.get(), size, result);
+        sink = sink + static_cast<std::uint64_t>(reinterpret_cast<const std::uint8_t*>(&result)[0]);
+    }
+    des_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / kIterations;
+}
+
+// Compare both serializers for a field type and print a row.
+template <typename T>
+void compare(const std::string& name, const T& value)
+{
+    double bin_ser, bin_des, loc_ser, loc_des;
+    measure<BinarySerializer>(value, bin_ser, bin_des);
+    measure<LocalBinarySerializer>(value, loc_ser, loc_des);
+    std::cout << std::fixed << std::setprecision(1) << std::setw(16) << name
+              << std::setw(12) << bin_ser << std::setw(12) << loc_ser << std::setw(9) << bin_ser / loc_ser << "x"
+              << std::setw(12) << bin_des << std::setw(12) << loc_des << std::setw(9) << bin_des / loc_des << "x"
+              << std::endl;
+}
+
+/**
+ * @brief Main entry point of the program `ExampleSerializerBenchmark`.
+ *
+ * Measures the cost of serializing and deserializing a single field of each supported kind with the synchronized
+ * BinarySerializer (before) and the single-owner LocalBinarySerializer (after), in nanoseconds per operation. Both
+ * use the same tagged wire format, so the difference is the per field synchronization overhead.
+ */
+int main()
+{
+    std::cout << "Serializer per field cost (" << kIterations << " iterations, ns/op)" << std::endl;
+    std::cout << std::setw(16) << "Field" << std::setw(12) << "Ser Binary" << std::setw(12) << "Ser Local"
+              << std::setw(10) << "Speedup" << std::setw(12) << "Des Binary" << std::setw(12) << "Des Local"
+              << std::setw(10) << "Speedup" << std::endl;
+
+    compare("bool", true);
+    compare("int32", std::int32_t(-123456));
+    compare("uint64", std::uint64_t(1234567890123ULL));
+    compare("double", 123.456789);
+    compare("string (16)", std::string("AMELAS_MOUNT_001"));
+    compare("array<dbl,8>", std::array<double, 8>{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+    compare("vector<dbl,256>", std::vector<double>(256, 45.0));
+
+    return 0;
+}
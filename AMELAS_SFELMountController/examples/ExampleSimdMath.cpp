@@ -0,0 +1,103 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleSimdMath.cpp
+ * @brief EXAMPLE FILE - Check of the vectorized math kernels against the standard library.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/simd_math.h"
+// =====================================================================================================================
+
+#ifdef AMELAS_SIMD_AVX2
+
+// Maximum error allowed against std::atan2 (radians).
+constexpr double kMaxError = 1e-14;
+
+// Compare atan2Pd with std::atan2 for the given pairs (the size must be a multiple of 4). The results must have the
+// same sign bit, so the signed zeros are checked too. Returns the number of mismatches.
+std::size_t checkAtan2(const std::vector<double>& ys, const std::vector<double>& xs, bool verbose)
+{
+    std::size_t failures = 0;
+    for (std::size_t i = 0; i < ys.size(); i += 4)
+    {
+        double result[4];
+        _mm256_storeu_pd(result, amelas::utils::atan2Pd(_mm256_loadu_pd(&ys[i]), _mm256_loadu_pd(&xs[i])));
+        for (std::size_t k = 0; k < 4; k++)
+        {
+            const double expected = std::atan2(ys[i + k], xs[i + k]);
+            const bool ok = std::fabs(result[k] - expected) <= kMaxError &&
+                            std::signbit(result[k]) == std::signbit(expected);
+            failures += ok ? 0 : 1;
+            if (verbose || !ok)
+                std::cout << "atan2(" << std::setw(4) << ys[i + k] << ", " << std::setw(4) << xs[i + k] << ") = "
+                          << std::setw(22) << result[k] << "  std: " << std::setw(22) << expected
+                          << (ok ? "" : "  MISMATCH") << std::endl;
+        }
+    }
+    return failures;
+}
+
+#endif
+
+/**
+ * @brief Main entry point of the program `ExampleSimdMath`.
+ *
+ * Checks atan2Pd against std::atan2 on the signed zeros and the axes (atan2(+-0, +-0), atan2(+-0, +-x) and
+ * atan2(+-y, +-0)), and on random pairs of all the quadrants. Returns 1 if any result differs. The kernels are only
+ * available when the example is built with AVX2 and FMA (AMELAS_ENABLE_AVX2).
+ */
+int main()
+{
+#ifdef AMELAS_SIMD_AVX2
+    // Signed zeros and axes.
+    const std::vector<double> zero_ys = {0.0, -0.0, 0.0, -0.0, 0.0, -0.0, 0.0, -0.0, 1.0, -1.0, 1.0, -1.0};
+    const std::vector<double> zero_xs = {0.0, 0.0, -0.0, -0.0, 2.0, 2.0, -2.0, -2.0, 0.0, 0.0, -0.0, -0.0};
+    std::cout << std::setprecision(17) << "Signed zeros and axes" << std::endl;
+    std::size_t failures = checkAtan2(zero_ys, zero_xs, true);
+
+    // Random pairs.
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> distribution(-100.0, 100.0);
+    std::vector<double> ys(100000), xs(100000);
+    for (std::size_t i = 0; i < ys.size(); i++)
+    {
+        ys[i] = distribution(generator);
+        xs[i] = distribution(generator);
+    }
+    failures += checkAtan2(ys, xs, false);
+    std::cout << std::endl << "Random pairs: " << ys.size() << std::endl;
+
+    std::cout << "Mismatches: " << failures << std::endl;
+    return failures ? 1 : 0;
+#else
+    std::cout << "The vectorized kernels are not available (build with AMELAS_ENABLE_AVX2)." << std::endl;
+    return 0;
+#endif
+}
@@ -0,0 +1,249 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleStateRing.cpp
+ * @brief EXAMPLE FILE - Throughput and latency of the shared memory ring of mount states.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+// =====================================================================================================================
+
+// AMELAS INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/async_logger.h"
+#include "AmelasUtils/latency_histogram.h"
+// =====================================================================================================================
+
+using namespace amelas::controller;
+using amelas::utils::ShmRingResult;
+using Clock = std::chrono::steady_clock;
+
+// Benchmark configuration. The latency run publishes a frame each kLatencyPeriod (the writer spins to keep the pace).
+const std::string kRingName = "/amelas_state_ring_example";
+constexpr std::size_t kThroughputFrames = 20000000;
+constexpr std::size_t kLatencyFrames = 200000;
+constexpr std::chrono::nanoseconds kLatencyPeriod{10000};
+
+// Result of a reader.
+struct ReaderResult
+{
+    std::uint64_t frames = 0;
+    std::uint64_t lost = 0;
+    std::uint64_t overruns = 0;
+    amelas::utils::LatencyHistogram latency;
+};
+
+std::int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Run a writer and `readers` reader threads. Each reader maps the ring by itself, as a reader process would do. With
+// a period the frames carry their publication time and the readers record the latency.
+double runRing(std::size_t readers, std::size_t frames, std::chrono::nanoseconds period,
+               std::vector<ReaderResult>& results)
+{
+    MountStateRingWriter writer;
+    if (!writer.create(kRingName, kDefaultStateRingCapacity, kMountStateFrameId))
+        return 0.0;
+
+    // The readers spin, unless there are not enough processors for all the threads.
+    const bool spin = std::thread::hardware_concurrency() > readers;
+    results = std::vector<ReaderResult>(readers);
+    std::atomic<std::size_t> ready(0);
+    std::atomic_bool done(false);
+    std::vector<std::thread> threads;
+    for (std::size_t r = 0; r < readers; r++)
+    {
+        threads.emplace_back([&, r]
+        {
+            MountStateRingReader reader;
+            ReaderResult& result = results[r];
+            const bool opened = reader.open(kRingName, kMountStateFrameId);
+            ready++;
+            if (!opened)
+                return;
+            MountStateBlock state;
+            for (;;)
+            {
+                const ShmRingResult read = reader.tryRead(state);
+                if (read == ShmRingResult::FRAME)
+                {
+                    result.frames++;
+                    if (period.count() > 0)
+                        result.latency.recordSingleWriter(nowNs() - state.timestamp);
+                }
+                else if (read == ShmRingResult::EMPTY)
+                {
+                    if (done.load(std::memory_order_acquire) && reader.getAvailable() == 0)
+                        break;
+                    if (!spin)
+                        std::this_thread::yield();
+                }
+            }
+            result.lost = reader.getLostFrames();
+            result.overruns = reader.getOverruns();
+        });
+    }
+    while (ready.load() < readers)
+        std::this_thread::yield();
+
+    // Publish the frames.
+    MountStateBlock state;
+    state.status = MountStatus::TRACKING;
+    const auto start = Clock::now();
+    std::int64_t next = nowNs();
+    for (std::size_t i = 0; i < frames; i++)
+    {
+        if (period.count() > 0)
+        {
+            next += period.count();
+            while (nowNs() < next) {}
+        }
+        state.timestamp = nowNs();
+        state.az = static_cast<double>(i % 360000) * 0.001;
+        state.el = 45.0;
+        writer.publish(state);
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    done = true;
+    for (std::thread& thread : threads)
+        thread.join();
+    return static_cast<double>(frames) / elapsed;
+}
+
+/**
+ * @brief Main entry point of the program `ExampleStateRing`.
+ *
+ * Measures the throughput of the ring with an unpaced writer and 1, 2 and 4 readers (the readers that fall behind
+ * detect the overruns and count the lost frames), the publication to read latency with a writer paced at 100 kHz,
+ * and the cost of a publication and a read without threads. Finally, it enables the state ring of an AmelasController
+ * and reads the frame of a mount state update. The latencies need a free processor for each thread (the readers
+ * spin); with fewer processors they measure the scheduler.
+ */
+int main()
+{
+    // Only the warnings.
+    amelas::utils::AsyncLogger::getInstance().setLevel(amelas::utils::LogLevel::WARNING);
+
+    // Throughput.
+    std::cout << "State ring throughput (" << kThroughputFrames << " frames of " << sizeof(MountStateBlock)
+              << " bytes, capacity " << kDefaultStateRingCapacity << ")" << std::endl;
+    std::cout << std::setw(8) << "Readers" << std::setw(16) << "Writer Mfps" << std::setw(18) << "Read (min/max)"
+              << std::setw(18) << "Lost (min/max)" << std::setw(12) << "Overruns" << std::endl;
+    for (std::size_t readers : {std::size_t(1), std::size_t(2), std::size_t(4)})
+    {
+        std::vector<ReaderResult> results;
+        const double rate = runRing(readers, kThroughputFrames, std::chrono::nanoseconds(0), results);
+        if (rate == 0.0)
+        {
+            std::cout << "Unable to create the ring " << kRingName << "." << std::endl;
+            return 1;
+        }
+        std::uint64_t min_read = ~0ULL, max_read = 0, min_lost = ~0ULL, max_lost = 0, overruns = 0;
+        for (const ReaderResult& result : results)
+        {
+            min_read = std::min(min_read, result.frames);
+            max_read = std::max(max_read, result.frames);
+            min_lost = std::min(min_lost, result.lost);
+            max_lost = std::max(max_lost, result.lost);
+            overruns += result.overruns;
+        }
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << readers << std::setw(16) << rate / 1e6
+                  << std::setw(18) << (std::to_string(min_read) + "/" + std::to_string(max_read))
+                  << std::setw(18) << (std::to_string(min_lost) + "/" + std::to_string(max_lost))
+                  << std::setw(12) << overruns << std::endl;
+    }
+
+    // Latency.
+    std::cout << std::endl << "State ring latency (" << kLatencyFrames << " frames at "
+              << 1e9 / static_cast<double>(kLatencyPeriod.count()) / 1e3 << " kHz, ns)" << std::endl;
+    std::cout << std::setw(8) << "Readers" << std::setw(10) << "min" << std::setw(10) << "mean" << std::setw(10)
+              << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max"
+              << std::setw(10) << "Lost" << std::endl;
+    for (std::size_t readers : {std::size_t(1), std::size_t(2)})
+    {
+        std::vector<ReaderResult> results;
+        runRing(readers, kLatencyFrames, kLatencyPeriod, results);
+        amelas::utils::LatencyHistogram latency;
+        std::uint64_t lost = 0;
+        for (const ReaderResult& result : results)
+        {
+            latency.merge(result.latency);
+            lost += result.lost;
+        }
+        const amelas::utils::LatencySummary summary = latency.getSummary();
+        std::cout << std::setw(8) << readers;
+        for (std::int64_t value : {summary.min, summary.mean, summary.p50, summary.p99, summary.p999, summary.max})
+            std::cout << std::setw(10) << value;
+        std::cout << std::setw(10) << lost << std::endl;
+    }
+
+    // Cost of a publication and a read of the latest frame in the same thread (no cache transfers).
+    {
+        MountStateRingWriter writer;
+        MountStateRingReader reader;
+        MountStateBlock state, latest;
+        writer.create(kRingName, kDefaultStateRingCapacity, kMountStateFrameId);
+        reader.open(kRingName, kMountStateFrameId);
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < kThroughputFrames; i++)
+        {
+            state.timestamp = static_cast<std::int64_t>(i);
+            writer.publish(state);
+            reader.readLatest(latest);
+        }
+        const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        std::cout << std::endl << "Publish and read latest in one thread: " << std::setprecision(1)
+                  << elapsed / static_cast<double>(kThroughputFrames) << " ns" << std::endl;
+    }
+
+    // Controller state ring.
+    AmelasController controller;
+    MountStateRingReader reader;
+    MountStateBlock state;
+    if (!controller.enableStateRing(kRingName) || !reader.open(kRingName, kMountStateFrameId))
+    {
+        std::cout << "Unable to enable the controller state ring." << std::endl;
+        return 1;
+    }
+    controller.setHomePosition(AltAzPos(120.0, 30.0));
+    const bool read = reader.tryRead(state) == ShmRingResult::FRAME;
+    std::cout << std::endl << "Controller state ring: " << (read ? "frame read" : "no frame") << " (az " << state.az
+              << ", el " << state.el << ", home " << state.home_az << "/" << state.home_el << ")" << std::endl;
+    controller.disableStateRing();
+    std::cout << "Writer open after disabling the ring: " << std::boolalpha << reader.isWriterOpen() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleTrajectoryInterpolator.cpp
+ * @brief EXAMPLE FILE - Benchmark of the trajectory interpolator (time per setpoint and interpolation error).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+// =====================================================================================================================
+
+using namespace amelas::controller;
+
+// Reference pass (analytic): the azimuth crosses 0/360 and the elevation culminates at 85 degrees.
+constexpr double kPassDuration = 600.0;   // Seconds.
+
+void referencePosition(double t, double& az, double& el)
+{
+    const double x = (t - kPassDuration / 2.0) / 90.0;
+    az = std::fmod(330.0 + 80.0 * std::tanh(x) + 360.0, 360.0);
+    el = 10.0 + 75.0 * std::exp(-x * x);
+}
+
+// Angular difference in arc seconds (with the azimuth wrap).
+double errorArcsec(double a, double b)
+{
+    double diff = std::fabs(a - b);
+    diff = std::fmin(diff, 360.0 - diff);
+    return diff * 3600.0;
+}
+
+void runBenchmark(double step_s, InterpolationMethod method, unsigned order, unsigned rate_hz)
+{
+    // Tabulate the reference.
+    const std::int64_t start = 1700000000LL * 1000000000LL;
+    const std::size_t samples = static_cast<std::size_t>(kPassDuration / step_s) + 1;
+    TrajectoryBuffer trajectory(samples);
+    for (std::size_t i = 0; i < samples; i++)
+    {
+        const double t = static_cast<double>(i) * step_s;
+        trajectory.timestamps[i] = start + static_cast<std::int64_t>(std::llround(t * 1e9));
+        referencePosition(t, trajectory.az[i], trajectory.el[i]);
+    }
+    trajectory.size = samples;
+
+    // Prepare the interpolator.
+    TrajectoryInterpolator interpolator;
+    auto t0 = std::chrono::steady_clock::now();
+    AmelasError error = interpolator.prepare(trajectory, method, order);
+    const double prepare_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (error != AmelasError::SUCCESS)
+    {
+        std::cout << "Prepare error: " << static_cast<int>(error) << std::endl;
+        return;
+    }
+
+    // Setpoint times at the servo rate, evaluated in look-ahead windows of one second.
+    const std::size_t setpoints = static_cast<std::size_t>(kPassDuration) * rate_hz;
+    const std::int64_t period = 1000000000LL / rate_hz;
+    std::vector<std::int64_t> times(setpoints);
+    std::vector<double> az(setpoints), el(setpoints);
+    for (std::size_t i = 0; i < setpoints; i++)
+        times[i] = start + static_cast<std::int64_t>(i) * period;
+
+    // Batch evaluation.
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < setpoints; i += rate_hz)
+        interpolator.evaluate(times.data() + i, std::min<std::size_t>(rate_hz, setpoints - i), az.data() + i,
+                              el.data() + i);
+    const double batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    // Single evaluation (it must match the batch evaluation).
+    AltAzPos pos;
+    double max_diff = 0.0;
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < setpoints; i++)
+    {
+        interpolator.evaluate(times[i], pos);
+        max_diff = std::fmax(max_diff, std::fabs(pos.el - el[i]));
+    }
+    const double single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    // Error against the reference.
+    double max_az = 0.0, max_el = 0.0;
+    for (std::size_t i = 0; i < setpoints; i++)
+    {
+        double ref_az, ref_el;
+        referencePosition(static_cast<double>(times[i] - start) * 1e-9, ref_az, ref_el);
+        max_az = std::fmax(max_az, errorArcsec(az[i], ref_az));
+        max_el = std::fmax(max_el, std::fabs(el[i] - ref_el) * 3600.0);
+    }
+
+    // Results.
+    std::cout << std::left << std::setw(9) << InterpolationMethodStr[static_cast<std::size_t>(method)]
+              << " order " << interpolator.getDegree() << " | step " << step_s << " s | prepare "
+              << std::fixed << std::setprecision(3) << prepare_ms << " ms | batch "
+              << std::setprecision(2) << batch_ns / setpoints << " ns/setpoint | single "
+              << single_ns / setpoints << " ns/setpoint | max error az " << std::setprecision(6) << max_az
+              << " arcsec, el " << max_el << " arcsec" << (max_diff > 0.0 ? " | BATCH MISMATCH" : "") << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+/**
+ * @brief Main entry point of the program `ExampleTrajectoryInterpolator`.
+ */
+int main(int, char**)
+{
+    const unsigned rate_hz = 1000;
+    std::cout << "Trajectory interpolator benchmark (" << kPassDuration << " s pass, " << rate_hz << " Hz setpoints)"
+              << std::endl;
+
+    for (double step : {1.0, 5.0})
+    {
+        runBenchmark(step, InterpolationMethod::HERMITE, 3, rate_hz);
+        for (unsigned order : {3u, 5u, 7u, 9u})
+            runBenchmark(step, InterpolationMethod::LAGRANGE, order, rate_hz);
+    }
+
+    return 0;
+}
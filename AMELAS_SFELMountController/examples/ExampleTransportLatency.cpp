@@ -0,0 +1,161 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleTransportLatency.cpp
+ * @brief EXAMPLE FILE - Compares the round trip latency of a co-located client over tcp, ipc and inproc.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+#include <AmelasClientInterface>
+// =====================================================================================================================
+
+// AMELAS INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/async_logger.h"
+// =====================================================================================================================
+
+using namespace amelas::communication;
+using amelas::controller::AmelasController;
+using zmqutils::common::RequestData;
+using Clock = std::chrono::steady_clock;
+
+// Benchmark configuration.
+constexpr unsigned kPort = 9990;
+constexpr std::size_t kWarmupRequests = 1000;
+constexpr std::size_t kRequests = 20000;
+const std::string kIpcEndpoint = "ipc://amelas_transport_latency";
+
+// Latency summary of the sequential round trips (send and wait for the reply) of a channel.
+bool measure(AmelasControllerClient& client, bool moved, amelas::utils::LatencySummary& summary)
+{
+    amelas::utils::LatencyHistogram histogram;
+    const auto command = static_cast<ServerCommand>(AmelasServerCommand::REQ_GET_HOME_POSITION);
+    for (std::size_t i = 0; i < kWarmupRequests + kRequests; i++)
+    {
+        const auto start = Clock::now();
+        CommandReply reply;
+        if (moved)
+            reply = client.sendCommandAsync(RequestData(command)).get();
+        else
+        {
+            const RequestData request(command);
+            reply = client.sendCommandAsync(request).get();
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        if (reply.server_result != OperationResult::COMMAND_OK)
+            return false;
+        if (i >= kWarmupRequests)
+            histogram.record(elapsed.count());
+    }
+    summary = histogram.getSummary();
+    return true;
+}
+
+/**
+ * @brief Main entry point of the program `ExampleTransportLatency`.
+ *
+ * Starts a router mode server with a tcp endpoint, an ipc local endpoint (if the platform supports it) and the default
+ * inproc local endpoint, and measures the round trip of REQ_GET_HOME_POSITION from the asynchronous channel of a
+ * client in the same process through each of them. The inproc channel is measured with the copied requests and with
+ * the moved requests fast path.
+ */
+int main()
+{
+    // Only the warnings, the logging of each request would dominate the latencies.
+    amelas::utils::AsyncLogger::getInstance().setLevel(amelas::utils::LogLevel::WARNING);
+
+    // Controller and server (the ipc endpoint is optional).
+    AmelasController controller;
+    AmelasControllerServer server(kPort, "127.0.0.1");
+    server.setRouterMode(true);
+    server.setClientStatusCheck(false);
+    server.registerControllerCallback<AmelasServerCommand::REQ_GET_HOME_POSITION>(
+        &controller, &AmelasController::getHomePosition);
+    bool ipc = true;
+    server.setLocalEndpoints({kIpcEndpoint, kDefaultInprocEndpoint});
+    if (!server.startServer())
+    {
+        ipc = false;
+        server.setLocalEndpoints({kDefaultInprocEndpoint});
+        if (!server.startServer())
+        {
+            std::cout << "Unable to start the server." << std::endl;
+            return 1;
+        }
+    }
+
+    // Transports to compare (endpoint and moved requests).
+    struct Transport
+    {
+        std::string name;
+        std::string endpoint;
+        bool moved;
+    };
+    std::vector<Transport> transports = {{"tcp", "tcp://127.0.0.1:" + std::to_string(kPort), false}};
+    if (ipc)
+        transports.push_back({"ipc", kIpcEndpoint, false});
+    transports.push_back({"inproc", kDefaultInprocEndpoint, false});
+    transports.push_back({"inproc (moved)", kDefaultInprocEndpoint, true});
+
+    std::cout << "Round trip latency of REQ_GET_HOME_POSITION (" << kRequests << " sequential requests, us)"
+              << std::endl;
+    std::cout << std::setw(16) << "Transport" << std::setw(10) << "min" << std::setw(10) << "mean" << std::setw(10)
+              << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+
+    for (const Transport& transport : transports)
+    {
+        // The client connects with the base channel (tcp) and sends the requests with the asynchronous channel.
+        AmelasControllerClient client("tcp://127.0.0.1:" + std::to_string(kPort), "LatencyClient");
+        client.setAliveCallbacksEnabled(false);
+        amelas::utils::LatencySummary summary;
+        if (!client.startClient() || client.doConnect() != OperationResult::COMMAND_OK ||
+            !client.startAsyncChannel(common::kDefaultMaxInFlight, common::kDefaultAsyncTimeoutMsec,
+                                      transport.endpoint) ||
+            !measure(client, transport.moved, summary))
+        {
+            std::cout << std::setw(16) << transport.name << "  failed" << std::endl;
+            client.stopClient();
+            continue;
+        }
+        client.stopAsyncChannel();
+        client.doDisconnect();
+        client.stopClient();
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(16) << transport.name;
+        for (std::int64_t value : {summary.min, summary.mean, summary.p50, summary.p99, summary.p999, summary.max})
+            std::cout << std::setw(10) << static_cast<double>(value) / 1000.0;
+        std::cout << std::endl;
+    }
+    if (!ipc)
+        std::cout << "The ipc transport is not available in this platform." << std::endl;
+
+    server.stopServer();
+    return 0;
+}
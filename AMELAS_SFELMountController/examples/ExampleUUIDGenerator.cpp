@@ -0,0 +1,166 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file ExampleUUIDGenerator.cpp
+ * @brief EXAMPLE FILE - Compares the UUID generators, the string conversions and the UUID containers.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS INTERFACE INCLUDES
+// =====================================================================================================================
+#include <AmelasServerInterface>
+// =====================================================================================================================
+
+using zmqutils::utils::ThreadLocalUUIDGenerator;
+using zmqutils::utils::UUID;
+using zmqutils::utils::UUIDGenerator;
+using Clock = std::chrono::steady_clock;
+
+// Benchmark configuration: UUIDs per thread, thread counts and UUIDs for the string and container tests.
+constexpr std::size_t kUUIDsPerThread = 200000;
+constexpr std::size_t kThreadCounts[] = {1, 2, 4, 8};
+constexpr std::size_t kStringUUIDs = 200000;
+constexpr std::size_t kContainerUUIDs = 200000;
+
+// Checksum of the results, so the compiler cannot discard the benchmarked work.
+std::size_t checksum = 0;
+
+// Nanoseconds per operation of a function doing `operations` operations.
+double measure(const std::function<void()>& function, std::size_t operations)
+{
+    const auto start = Clock::now();
+    function();
+    const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return elapsed / static_cast<double>(operations);
+}
+
+// Nanoseconds per UUID generating kUUIDsPerThread UUIDs in each of the threads.
+template <typename Generate>
+double measureThreads(std::size_t threads, Generate generate)
+{
+    return measure([threads, generate]
+    {
+        std::vector<std::thread> workers;
+        std::vector<std::size_t> sums(threads, 0);
+        for (std::size_t i = 0; i < threads; i++)
+        {
+            workers.emplace_back([&sums, i, generate]
+            {
+                for (std::size_t j = 0; j < kUUIDsPerThread; j++)
+                    sums[i] += static_cast<std::size_t>(generate().getBytes()[0]);
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        for (std::size_t sum : sums)
+            checksum += sum;
+    }, threads * kUUIDsPerThread);
+}
+
+/**
+ * @brief Main entry point of the program `ExampleUUIDGenerator`.
+ *
+ * The singleton UUIDGenerator takes a global mutex and inserts each UUID in a set of all the generated UUIDs, so its
+ * cost grows with the UUIDs generated during the whole process (this benchmark runs it first with an empty set) and
+ * with the contention between threads. The ThreadLocalUUIDGenerator has no shared state.
+ */
+int main()
+{
+    // Generators.
+    std::cout << "UUID generation (" << kUUIDsPerThread << " UUIDs per thread, ns per UUID)" << std::endl;
+    std::cout << std::setw(8) << "Threads" << std::setw(16) << "UUIDGenerator" << std::setw(16) << "ThreadLocal"
+              << std::setw(10) << "Speedup" << std::endl;
+    for (std::size_t threads : kThreadCounts)
+    {
+        const double singleton = measureThreads(threads, []{return UUIDGenerator::getInstance().generateUUIDv4();});
+        const double local = measureThreads(threads, []{return ThreadLocalUUIDGenerator::generateUUIDv4();});
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << threads << std::setw(16) << singleton
+                  << std::setw(16) << local << std::setw(9) << singleton / local << "x" << std::endl;
+    }
+
+    // String conversions.
+    std::vector<UUID> uuids;
+    uuids.reserve(kContainerUUIDs);
+    for (std::size_t i = 0; i < kContainerUUIDs; i++)
+        uuids.push_back(ThreadLocalUUIDGenerator::generateUUIDv4());
+    for (std::size_t i = 0; i < 1000; i++)
+    {
+        if (uuids[i].toRFC4122String() != uuids[i].toRFC4122StringFast())
+        {
+            std::cout << "Different string conversion: " << uuids[i].toRFC4122String() << " / "
+                      << uuids[i].toRFC4122StringFast() << std::endl;
+            return 1;
+        }
+    }
+    const double stream = measure([&uuids]
+    {
+        for (std::size_t i = 0; i < kStringUUIDs; i++)
+            checksum += uuids[i].toRFC4122String().size();
+    }, kStringUUIDs);
+    const double fast = measure([&uuids]
+    {
+        for (std::size_t i = 0; i < kStringUUIDs; i++)
+            checksum += uuids[i].toRFC4122StringFast().size();
+    }, kStringUUIDs);
+    const double in_place = measure([&uuids]
+    {
+        char buffer[UUID::kRFC4122Size];
+        for (std::size_t i = 0; i < kStringUUIDs; i++)
+        {
+            uuids[i].writeRFC4122(buffer);
+            checksum += static_cast<std::size_t>(buffer[i % UUID::kRFC4122Size]);
+        }
+    }, kStringUUIDs);
+    std::cout << std::endl << "String conversion (ns per UUID)" << std::endl;
+    std::cout << std::setw(28) << "toRFC4122String: " << stream << std::endl;
+    std::cout << std::setw(28) << "toRFC4122StringFast: " << fast << std::endl;
+    std::cout << std::setw(28) << "writeRFC4122: " << in_place << std::endl;
+
+    // Containers (insertion and lookup of all the UUIDs).
+    const double ordered = measure([&uuids]
+    {
+        std::set<UUID> set(uuids.begin(), uuids.end());
+        for (const UUID& uuid : uuids)
+            checksum += set.count(uuid);
+    }, kContainerUUIDs);
+    const double hashed = measure([&uuids]
+    {
+        std::unordered_set<UUID> set(uuids.begin(), uuids.end());
+        for (const UUID& uuid : uuids)
+            checksum += set.count(uuid);
+    }, kContainerUUIDs);
+    std::cout << std::endl << "Insert and find (" << kContainerUUIDs << " UUIDs, ns per UUID)" << std::endl;
+    std::cout << std::setw(28) << "std::set: " << ordered << std::endl;
+    std::cout << std::setw(28) << "std::unordered_set: " << hashed << std::endl;
+
+    std::cout << std::endl << "Checksum: " << checksum << std::endl;
+    return 0;
+}
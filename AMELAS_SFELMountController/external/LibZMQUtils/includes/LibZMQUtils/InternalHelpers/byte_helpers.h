@@ -0,0 +1,218 @@
+/***********************************************************************************************************************
+ *   LibZMQUtils (ZMQ Utilitites Library): A libre library with ZMQ related useful utilities.                          *
+ *                                                                                                                     *
+ *   Copyright (C) 2023 Degoras Project Team                                                                           *
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >                             *
+ *                      < Jesús Relinque Madroñal >                                                                    *
+ *                                                                                                                     *
+ *   This file is part of LibZMQUtils.                                                                                 *
+ *                                                                                                                     *
+ *   Licensed under the European Union Public License (EUPL), Version 1.2 or subsequent versions of the EUPL license   *
+ *   as soon they will be approved by the European Commission (IDABC).                                                 *
+ *                                                                                                                     *
+ *   This project is free software: you can redistribute it and/or modify it under the terms of the EUPL license as    *
+ *   published by the IDABC, either Version 1.2 or, at your option, any later version.                                 *
+ *                                                                                                                     *
+ *   This project is distributed in the hope that it will be useful. Unless required by applicable law or agreed to in *
+ *   writing, it is distributed on an "AS IS" basis, WITHOUT ANY WARRANTY OR CONDITIONS OF ANY KIND; without even the  *
+ *   implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the EUPL license to check specific   *
+ *   language governing permissions and limitations and more details.                                                  *
+ *                                                                                                                     *
+ *   You should use this project in compliance with the EUPL license. You should have received a copy of the license   *
+ *   along with this project. If not, see the license at < https://eupl.eu/ >.                                         *
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file byte_helpers.h
+ * @brief This file contains several helper tools related with raw bytes (bulk byte order conversions).
+ * @warning Not exported. Only for internal library usage.
+ * @author Degoras Project Team
+ * @copyright EUPL License
+ * @version 2309.5
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+//======================================================================================================================
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+// =====================================================================================================================
+
+// DEFINITIONS
+// =====================================================================================================================
+#if defined(__AVX2__)
+#define ZMQUTILS_BYTESWAP_AVX2
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define ZMQUTILS_BYTESWAP_SSSE3
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#define ZMQUTILS_BYTESWAP_SSE2
+#endif
+// =====================================================================================================================
+
+// ZMQUTILS NAMESPACES
+// =====================================================================================================================
+namespace zmqutils{
+namespace internal_helpers{
+namespace bytes{
+// =====================================================================================================================
+
+// Scalar byte swap helpers.
+
+inline std::uint16_t byteSwap16(std::uint16_t value)
+{
+#if defined(_MSC_VER)
+    return _byteswap_ushort(value);
+#else
+    return __builtin_bswap16(value);
+#endif
+}
+
+inline std::uint32_t byteSwap32(std::uint32_t value)
+{
+#if defined(_MSC_VER)
+    return _byteswap_ulong(value);
+#else
+    return __builtin_bswap32(value);
+#endif
+}
+
+inline std::uint64_t byteSwap64(std::uint64_t value)
+{
+#if defined(_MSC_VER)
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+// Scalar loop for elements of a fixed size. Unaligned data is handled with memcpy.
+template <typename UIntT, UIntT(*SwapF)(UIntT)>
+inline void byteSwapScalar(const std::byte* src, std::byte* dst, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        UIntT value;
+        std::memcpy(&value, src + i*sizeof(UIntT), sizeof(UIntT));
+        value = SwapF(value);
+        std::memcpy(dst + i*sizeof(UIntT), &value, sizeof(UIntT));
+    }
+}
+
+#if defined(ZMQUTILS_BYTESWAP_SSSE3)
+
+// Shuffle mask that reverses each element of the given size within a 128 bits lane.
+inline __m128i byteSwapMask128(std::size_t elem_size)
+{
+    if (elem_size == 2)
+        return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    if (elem_size == 4)
+        return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+}
+
+#elif defined(ZMQUTILS_BYTESWAP_SSE2)
+
+// SSE2 has no byte shuffle, so the bytes are swapped within 16 bits words and the words are permuted.
+inline __m128i byteSwapSSE2(__m128i v, std::size_t elem_size)
+{
+    // Swap the bytes of each 16 bits word.
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    // Reverse the words within each element.
+    if (elem_size == 4)
+    {
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    else if (elem_size == 8)
+    {
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+    return v;
+}
+
+#endif
+
+/**
+ * @brief Reverse the byte order of each element of a contiguous array in one pass.
+ *
+ * Uses AVX2 (32 bytes per step) or SSSE3/SSE2 (16 bytes per step) when the compiler targets them, and a scalar loop
+ * for the tail and for other architectures. Elements of 2, 4 and 8 bytes are vectorized; other sizes are reversed
+ * element by element. The source and destination can be unaligned but must not overlap.
+ *
+ * @param src Pointer to the source elements.
+ * @param dst Pointer to the destination elements.
+ * @param count Number of elements.
+ * @param elem_size Size in bytes of each element.
+ */
+inline void bulkByteSwap(const std::byte* src, std::byte* dst, std::size_t count, std::size_t elem_size)
+{
+    // Single bytes don't need conversion.
+    if (elem_size <= 1)
+    {
+        std::memcpy(dst, src, count * elem_size);
+        return;
+    }
+
+    // Other sizes (structs, long double...) are reversed element by element.
+    if (elem_size != 2 && elem_size != 4 && elem_size != 8)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            std::reverse_copy(src + i*elem_size, src + (i+1)*elem_size, dst + i*elem_size);
+        return;
+    }
+
+    // Vectorized part.
+    const std::size_t total = count * elem_size;
+    std::size_t done = 0;
+
+#if defined(ZMQUTILS_BYTESWAP_AVX2)
+    const __m128i mask_lane = byteSwapMask128(elem_size);
+    const __m256i mask256 = _mm256_broadcastsi128_si256(mask_lane);
+    for (; done + 32 <= total; done += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done), _mm256_shuffle_epi8(v, mask256));
+    }
+#endif
+
+#if defined(ZMQUTILS_BYTESWAP_SSSE3)
+    const __m128i mask128 = byteSwapMask128(elem_size);
+    for (; done + 16 <= total; done += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done), _mm_shuffle_epi8(v, mask128));
+    }
+#elif defined(ZMQUTILS_BYTESWAP_SSE2)
+    for (; done + 16 <= total; done += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done), byteSwapSSE2(v, elem_size));
+    }
+#endif
+
+    // Scalar tail (or whole array without SIMD support).
+    const std::size_t rem = (total - done) / elem_size;
+    if (elem_size == 2)
+        byteSwapScalar<std::uint16_t, byteSwap16>(src + done, dst + done, rem);
+    else if (elem_size == 4)
+        byteSwapScalar<std::uint32_t, byteSwap32>(src + done, dst + done, rem);
+    else
+        byteSwapScalar<std::uint64_t, byteSwap64>(src + done, dst + done, rem);
+}
+
+}}} // END NAMESPACES.
+// =====================================================================================================================
@@ -37,6 +37,7 @@
 // C++ INCLUDES
 // =====================================================================================================================
 #include <mutex>
+#include <array>
 #include <vector>
 #include <atomic>
 #include <memory>
@@ -46,6 +47,7 @@
 // ZMQUTILS INCLUDES
 // =====================================================================================================================
 #include "LibZMQUtils/Global/libzmqutils_global.h"
+#include "LibZMQUtils/Utilities/buffer_pool.h"
 // =====================================================================================================================
 
 // ZMQUTILS NAMESPACES
@@ -55,6 +57,7 @@ namespace utils{
 // =====================================================================================================================
 
 class BinarySerializer;
+class LocalBinarySerializer;
 
 // Traits.
 // ---------------------------------------------------------------------------------------------------------------------
@@ -193,14 +196,28 @@ public:
  * @note This class will detect the machine's byte order and will adjust the reversal accordingly if using this
  * class in a context with different native byte order.
  *
+ * @note For serializers that are only used by one thread (like the stack-local ones of the request processing
+ * functions) use `LocalBinarySerializer`, which has the same wire format without the mutex and atomics overhead.
+ *
  * @see Serializable
+ * @see LocalBinarySerializer
  */
 class BinarySerializer
 {
+    // The single-owner serializer reuses the internal conversion helpers.
+    friend class LocalBinarySerializer;
+
 public:
 
     using SizeUnit = std::uint64_t;                      ///< Alias for the size unit.
     using BytesSmartPtr = std::unique_ptr<std::byte[]>;  ///< Alias for the bytes storage smart pointer.
+    using SchemaId = std::uint16_t;                      ///< Alias for the packed format schema identifier.
+
+    static constexpr std::uint8_t kPackedMagic = 0xB5;     ///< First byte of a packed format buffer.
+    static constexpr std::uint8_t kPackedVersion = 1;      ///< Current version of the packed format.
+    static constexpr std::uint8_t kPackedVersionMask = 0x0F;  ///< Bits of the version byte used by the version.
+    static constexpr std::uint8_t kPackedFlagLittle = 0x10;   ///< Version byte flag for little-endian payloads.
+    static constexpr SizeUnit kPackedHeaderSize = 4;       ///< Packed header size (magic, version and schema).
 
     /// Enumeration representing the byte order (endianness) of data.
     enum class Endianess
@@ -326,6 +343,9 @@ public:
      * @param[out] out The unique pointer where the serialized data will be stored. The pointer will be allocated within the function.
      * @param[in] args The input data items to be serialized.
      * @return The size of the serialized data.
+     *
+     * @note For data without Serializable objects, `LocalBinarySerializer` provides allocation-free variants that
+     * write into a caller-provided buffer or into an inline buffer sized at compile time.
      */
     template<typename... Args>
     static SizeUnit fastSerialization(BytesSmartPtr& out, const Args&... args);
@@ -367,6 +387,121 @@ public:
     template<typename... Args>
     static void fastDeserialization(BytesSmartPtr&& src, SizeUnit size, Args&... args);
 
+    /**
+     * @brief A static function that serializes multiple fixed-size data items using the packed wire format.
+     *
+     * The packed format is an opt-in alternative to the default tagged format. Instead of writing a `SizeUnit` length
+     * before every value, it writes a small header followed by the values back to back:
+     *
+     * @code
+     *   [magic (1 byte)] [version (1 byte)] [schema id (2 bytes)] [value 1] [value 2] ... [value N]
+     * @endcode
+     *
+     * The schema identifier is computed at compile time from the number, sizes and kinds of the serialized types, so
+     * the reader can detect a layout mismatch without per-field metadata. For example, an error code and two doubles
+     * take 24 bytes in the packed format instead of the 40 bytes of the tagged format.
+     *
+     * The values are stored with the same byte order than the tagged format, so both encodings can coexist over the
+     * same transport. Use `isPackedData` in the receiver to select the decoding function.
+     *
+     * Besides trivial types, `std::array` and `std::vector` of trivial types are supported. Arrays are stored as their
+     * elements back to back, and vectors as a `SizeUnit` element count followed by the elements. The byte order of
+     * the elements is converted in bulk (SIMD when available) instead of element by element.
+     *
+     * @tparam Args Variadic template argument for types. All of them must be trivial and trivially copyable, or arrays
+     *              or vectors of trivial and trivially copyable types.
+     * @param[out] out The unique pointer where the serialized data will be stored. It is allocated with the exact size.
+     * @param[in] args The input data items to be serialized. Can be empty (header only).
+     * @return The size of the serialized data.
+     */
+    template<typename... Args>
+    static SizeUnit fastSerializationPacked(BytesSmartPtr& out, const Args&... args);
+
+    /**
+     * @brief A static function that serializes multiple data items using the packed wire format and the native byte
+     * order of the host.
+     *
+     * The layout is the same as `fastSerializationPacked`, but the values are not converted to the network byte order.
+     * Instead, the byte order is recorded in the header (`kPackedFlagLittle`) and the reader only converts the data if
+     * its own byte order is different. When both ends share the byte order, large arrays and vectors are copied with a
+     * single `memcpy` on each side. `fastDeserializationPacked` handles both variants transparently.
+     *
+     * @tparam Args Variadic template argument for types. The same types as in `fastSerializationPacked` are supported.
+     * @param[out] out The unique pointer where the serialized data will be stored. It is allocated with the exact size.
+     * @param[in] args The input data items to be serialized. Can be empty (header only).
+     * @return The size of the serialized data.
+     */
+    template<typename... Args>
+    static SizeUnit fastSerializationPackedNative(BytesSmartPtr& out, const Args&... args);
+
+    /**
+     * @brief A static function that serializes multiple data items using the native packed wire format into a buffer
+     * taken from a BufferPool.
+     *
+     * Same as the `fastSerializationPackedNative` with a plain smart pointer, but the storage is reused through the
+     * pool, so in steady state no heap allocation is done.
+     *
+     * @param[out] out The pooled buffer where the serialized data will be stored.
+     * @param[in] args The input data items to be serialized. Can be empty (header only).
+     * @return The size of the serialized data (the buffer capacity can be bigger).
+     */
+    template<typename... Args>
+    static SizeUnit fastSerializationPackedNative(BufferPool::PooledBytes& out, const Args&... args);
+
+    /**
+     * @brief A static function that deserializes a packed format buffer into its original data items.
+     *
+     * Buffers written with `fastSerializationPacked` and `fastSerializationPackedNative` are both accepted. The byte
+     * order of the values is only converted when it differs from the byte order of the host.
+     *
+     * @tparam Args Variadic template argument for types. Must match the types used in the serialization.
+     * @param[in] src The binary data to be deserialized.
+     * @param[in] size The size of the binary data.
+     * @param[out] args The variables where the deserialized data items are stored.
+     *
+     * @throw std::out_of_range If the size of the data does not match the packed layout of the types.
+     * @throw std::logic_error If the header is not a valid packed header or the schema identifier does not match.
+     *
+     * @warning The @a src parameter is a void pointer, so be careful.
+     */
+    template<typename... Args>
+    static void fastDeserializationPacked(const void* src, SizeUnit size, Args&... args);
+
+    /**
+     * @brief Check if a buffer starts with a valid packed format header.
+     *
+     * The tagged format always starts with the most significant byte of a `SizeUnit` length, which is zero for any
+     * realistic size, so the packed magic byte can't be confused with a tagged buffer.
+     *
+     * @param src The binary data to be checked.
+     * @param size The size of the binary data.
+     * @return True if the data uses the packed format, false otherwise.
+     */
+    static bool isPackedData(const void* src, SizeUnit size);
+
+    /**
+     * @brief Compute at compile time the packed schema identifier for the given types.
+     * @return The schema identifier. An empty set of types always has the identifier 0.
+     */
+    template<typename... Args>
+    static constexpr SchemaId packedSchemaId();
+
+    /**
+     * @brief Compute at compile time the size of the packed serialization of the given types (header included).
+     * @return The total packed size in bytes.
+     * @note Only fixed-size types are allowed. For layouts with vectors use `calcPackedSize`.
+     */
+    template<typename... Args>
+    static constexpr SizeUnit packedSize();
+
+    /**
+     * @brief Compute the size of the packed serialization of the given values (header included).
+     * @param args The values to be serialized.
+     * @return The total packed size in bytes.
+     */
+    template<typename... Args>
+    static SizeUnit calcPackedSize(const Args&... args);
+
     /**
      * @brief Serializes the given values into the binary stream.
      *
@@ -485,6 +620,35 @@ protected:
     template <typename T, SizeUnit N>
     struct is_container<std::array<T, N>> : std::true_type {};
 
+    // Packed format layout traits (element type, element count and variable length).
+
+    template <typename T>
+    struct packed_traits
+    {
+        using Elem = T;
+        static constexpr SizeUnit kCount = 1;
+        static constexpr bool kIsArray = false;
+        static constexpr bool kIsVector = false;
+    };
+
+    template <typename T, std::size_t N>
+    struct packed_traits<std::array<T, N>>
+    {
+        using Elem = T;
+        static constexpr SizeUnit kCount = N;
+        static constexpr bool kIsArray = true;
+        static constexpr bool kIsVector = false;
+    };
+
+    template <typename T>
+    struct packed_traits<std::vector<T>>
+    {
+        using Elem = T;
+        static constexpr SizeUnit kCount = 0;
+        static constexpr bool kIsArray = false;
+        static constexpr bool kIsVector = true;
+    };
+
     // -----------------------------------------------------------------------------------------------------------------
 
     // Internal function to determine the endianess of the system.
@@ -514,6 +678,10 @@ protected:
     template<typename T, typename C>
     static void binarySerializeDeserialize(const T* src, SizeUnit data_size_bytes, C* dst, bool reverse);
 
+    // Internal bulk serialization/deserialization helper function for contiguous arrays of elements.
+    static void bulkSerializeDeserialize(const std::byte* src, SizeUnit count, SizeUnit elem_size, std::byte* dst,
+                                         bool reverse);
+
     // Internal binary serialization helper function.
     template<typename T, typename C>
     void binarySerialize(const T* src, SizeUnit data_size_bytes, C* dst);
@@ -522,6 +690,18 @@ protected:
     template<typename T, typename C>
     void binaryDeserialize(const T *src, SizeUnit data_size_bytes, C *dst);
 
+    // Internal packed serialization function (network or native byte order) over a buffer of calcPackedSize bytes.
+    template<typename... Args>
+    static SizeUnit packedSerializationInto(std::byte* dst, bool native, const Args&... args);
+
+    // Internal packed single value writing helper.
+    template<typename T>
+    static void writePacked(const T& value, std::byte*& cursor, bool reverse);
+
+    // Internal packed single value reading helper.
+    template<typename T>
+    static void readPacked(T& value, const std::byte*& cursor, const std::byte* end, bool reverse);
+
     // Recursive writing helper.
     template<typename T, typename... Args>
     void writeRecursive(const T& value, const Args&... args);
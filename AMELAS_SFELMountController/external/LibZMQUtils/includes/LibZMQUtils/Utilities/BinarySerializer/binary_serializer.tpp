@@ -39,19 +39,18 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <cstring>
 #include <mutex>
 #include <type_traits>
 #include <atomic>
-#include <iostream>
 // =====================================================================================================================
 
 // ZMQUTILS INCLUDES
 // =====================================================================================================================
 #include "LibZMQUtils/Utilities/BinarySerializer/binary_serializer.h"
+#include "LibZMQUtils/InternalHelpers/byte_helpers.h"
 // =====================================================================================================================
 
 // ZMQUTILS NAMESPACES
@@ -111,6 +110,20 @@ void BinarySerializer::binarySerializeDeserialize(const TSRC* src, SizeUnit data
     }
 }
 
+inline void BinarySerializer::bulkSerializeDeserialize(const std::byte* src, SizeUnit count, SizeUnit elem_size,
+                                                       std::byte* dst, bool reverse)
+{
+    // Check if there is data.
+    if (count == 0)
+        return;
+
+    // Copy the whole block at once (with bulk reverse of each element if neccesary).
+    if (reverse)
+        internal_helpers::bytes::bulkByteSwap(src, dst, count, elem_size);
+    else
+        std::memcpy(dst, src, count * elem_size);
+}
+
 template<typename T>
 BinarySerializer::SizeUnit BinarySerializer::calcTotalSize(const T& data)
 {
@@ -179,19 +192,12 @@ void BinarySerializer::readRecursive(T& value, Args&... args)
 template<typename... Args>
 BinarySerializer::SizeUnit BinarySerializer::fastSerialization(BytesSmartPtr& out, const Args&... args)
 {
-    // Do the serialization
-    BinarySerializer serializer;
+    // Reserve the expected size instead of the default capacity.
+    BinarySerializer serializer((BinarySerializer::calcTotalSize(args) + ... + 0));
+
+    // Do the serialization.
     const SizeUnit size = serializer.write(std::forward<const Args&>(args)...);
-    std::cout<<"Fast internal: "<<serializer.getDataHexString()<<std::endl;
     serializer.moveUnique(out);
-    std::stringstream ss;
-    for(size_t i = 0; i < size; i++)
-    {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(out[i]);
-        if (i < size - 1)
-            ss << " ";
-    }
-    std::cout<<"Fast internal 2: "<<ss.str()<<std::endl;
     return size;
 }
 
@@ -215,6 +221,238 @@ void BinarySerializer::fastDeserialization(BytesSmartPtr&& src, SizeUnit size, A
         throw std::out_of_range("BinarySerializer: Not all data was deserialized.");
 }
 
+template<typename... Args>
+constexpr BinarySerializer::SchemaId BinarySerializer::packedSchemaId()
+{
+    if constexpr (sizeof...(Args) == 0)
+    {
+        return 0;
+    }
+    else
+    {
+        // Layout descriptor of each type (element kind, element size and element count, 0 for vectors).
+        constexpr std::uint64_t descriptors[] =
+        {
+            ((static_cast<std::uint64_t>(packed_traits<Args>::kCount) << 32) |
+             (static_cast<std::uint64_t>(sizeof(typename packed_traits<Args>::Elem)) << 8) |
+             (std::is_floating_point_v<typename packed_traits<Args>::Elem> ? 1u :
+              std::is_enum_v<typename packed_traits<Args>::Elem> ? 2u :
+              std::is_signed_v<typename packed_traits<Args>::Elem> ? 3u : 4u))...
+        };
+
+        // FNV-1a hash of the number of types and the descriptors.
+        std::uint32_t hash = 2166136261u;
+        hash = (hash ^ static_cast<std::uint32_t>(sizeof...(Args))) * 16777619u;
+        for(std::uint64_t desc : descriptors)
+        {
+            // Scalars keep the 32 bits descriptor of the first packed version.
+            const unsigned desc_bytes = (desc >> 32) == 1 ? 4 : 8;
+            for(unsigned i = 0; i < desc_bytes; i++)
+                hash = (hash ^ static_cast<std::uint32_t>((desc >> (8*i)) & 0xFFu)) * 16777619u;
+        }
+
+        // Fold to 16 bits. The 0 identifier is reserved for the empty schema.
+        const SchemaId id = static_cast<SchemaId>((hash >> 16) ^ (hash & 0xFFFFu));
+        return id == 0 ? 0xFFFF : id;
+    }
+}
+
+template<typename... Args>
+constexpr BinarySerializer::SizeUnit BinarySerializer::packedSize()
+{
+    static_assert(!(packed_traits<Args>::kIsVector || ...), "Vectors have no compile time packed size.");
+    return kPackedHeaderSize + (static_cast<SizeUnit>(sizeof(Args)) + ... + 0);
+}
+
+template<typename... Args>
+BinarySerializer::SizeUnit BinarySerializer::calcPackedSize(const Args&... args)
+{
+    // Size of each value (vectors include the element count).
+    auto value_size = [](const auto& value) -> SizeUnit
+    {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (packed_traits<T>::kIsVector)
+            return sizeof(SizeUnit) + value.size() * sizeof(typename packed_traits<T>::Elem);
+        else
+            return sizeof(T);
+    };
+    return kPackedHeaderSize + (value_size(args) + ... + 0);
+}
+
+inline bool BinarySerializer::isPackedData(const void* src, SizeUnit size)
+{
+    return src && size >= kPackedHeaderSize && *static_cast<const std::uint8_t*>(src) == kPackedMagic;
+}
+
+template<typename T>
+void BinarySerializer::writePacked(const T& value, std::byte*& cursor, bool reverse)
+{
+    using Elem = typename packed_traits<T>::Elem;
+
+    // Check the types.
+    (BinarySerializer::checkTriviallyCopyable<Elem>());
+    (BinarySerializer::checkTrivial<Elem>());
+
+    if constexpr (packed_traits<T>::kIsVector)
+    {
+        // Write the number of elements and the elements in bulk.
+        const SizeUnit count = value.size();
+        BinarySerializer::binarySerializeDeserialize(&count, sizeof(SizeUnit), cursor, reverse);
+        cursor += sizeof(SizeUnit);
+        BinarySerializer::bulkSerializeDeserialize(reinterpret_cast<const std::byte*>(value.data()), count,
+                                                   sizeof(Elem), cursor, reverse);
+        cursor += count * sizeof(Elem);
+    }
+    else if constexpr (packed_traits<T>::kIsArray)
+    {
+        // Write the elements of the array in bulk.
+        BinarySerializer::bulkSerializeDeserialize(reinterpret_cast<const std::byte*>(value.data()),
+                                                   packed_traits<T>::kCount, sizeof(Elem), cursor, reverse);
+        cursor += sizeof(T);
+    }
+    else
+    {
+        BinarySerializer::binarySerializeDeserialize(&value, sizeof(T), cursor, reverse);
+        cursor += sizeof(T);
+    }
+}
+
+template<typename T>
+void BinarySerializer::readPacked(T& value, const std::byte*& cursor, const std::byte* end, bool reverse)
+{
+    using Elem = typename packed_traits<T>::Elem;
+
+    // Check the types.
+    (BinarySerializer::checkTriviallyCopyable<Elem>());
+    (BinarySerializer::checkTrivial<Elem>());
+
+    if constexpr (packed_traits<T>::kIsVector)
+    {
+        // Read the number of elements.
+        if (static_cast<SizeUnit>(end - cursor) < sizeof(SizeUnit))
+            throw std::out_of_range("BinarySerializer: Not enough data left to read the size of the vector.");
+        SizeUnit count;
+        BinarySerializer::binarySerializeDeserialize(cursor, sizeof(SizeUnit), &count, reverse);
+        cursor += sizeof(SizeUnit);
+
+        // Check if we have enough data left to read the elements.
+        if (count > static_cast<SizeUnit>(end - cursor) / sizeof(Elem))
+            throw std::out_of_range("BinarySerializer: Read vector data beyond the data size.");
+
+        // Read the elements in bulk.
+        value.resize(count);
+        BinarySerializer::bulkSerializeDeserialize(cursor, count, sizeof(Elem),
+                                                   reinterpret_cast<std::byte*>(value.data()), reverse);
+        cursor += count * sizeof(Elem);
+    }
+    else
+    {
+        // Check if we have enough data left to read the value.
+        if (static_cast<SizeUnit>(end - cursor) < sizeof(T))
+            throw std::out_of_range("BinarySerializer: Read value beyond the data size.");
+
+        if constexpr (packed_traits<T>::kIsArray)
+            BinarySerializer::bulkSerializeDeserialize(cursor, packed_traits<T>::kCount, sizeof(Elem),
+                                                       reinterpret_cast<std::byte*>(value.data()), reverse);
+        else
+            BinarySerializer::binarySerializeDeserialize(cursor, sizeof(T), &value, reverse);
+        cursor += sizeof(T);
+    }
+}
+
+template<typename... Args>
+BinarySerializer::SizeUnit BinarySerializer::packedSerializationInto(std::byte* dst, bool native, const Args&... args)
+{
+    // Get the layout.
+    constexpr SchemaId schema = BinarySerializer::packedSchemaId<Args...>();
+    const SizeUnit size = BinarySerializer::calcPackedSize(args...);
+    const bool little = BinarySerializer::determineEndianess() == Endianess::LITTLE_ENDIAN;
+    const bool reverse = little && !native;
+
+    // Write the header. The schema identifier is always stored in network byte order.
+    std::uint8_t version = kPackedVersion;
+    if (native && little)
+        version |= kPackedFlagLittle;
+    dst[0] = static_cast<std::byte>(kPackedMagic);
+    dst[1] = static_cast<std::byte>(version);
+    BinarySerializer::binarySerializeDeserialize(&schema, sizeof(SchemaId), dst + 2, little);
+
+    // Write the values back to back.
+    [[maybe_unused]] std::byte* cursor = dst + kPackedHeaderSize;
+    (BinarySerializer::writePacked(args, cursor, reverse), ...);
+
+    // Return the serialized size.
+    return size;
+}
+
+template<typename... Args>
+BinarySerializer::SizeUnit BinarySerializer::fastSerializationPacked(BytesSmartPtr& out, const Args&... args)
+{
+    // Allocate the exact storage and serialize directly into it.
+    out = BytesSmartPtr(new std::byte[BinarySerializer::calcPackedSize(args...)]);
+    return BinarySerializer::packedSerializationInto(out.get(), false, args...);
+}
+
+template<typename... Args>
+BinarySerializer::SizeUnit BinarySerializer::fastSerializationPackedNative(BytesSmartPtr& out, const Args&... args)
+{
+    // Allocate the exact storage and serialize directly into it.
+    out = BytesSmartPtr(new std::byte[BinarySerializer::calcPackedSize(args...)]);
+    return BinarySerializer::packedSerializationInto(out.get(), true, args...);
+}
+
+template<typename... Args>
+BinarySerializer::SizeUnit BinarySerializer::fastSerializationPackedNative(BufferPool::PooledBytes& out,
+                                                                           const Args&... args)
+{
+    // Take the storage from the pool and serialize directly into it.
+    out = BufferPool::defaultPool().acquire(BinarySerializer::calcPackedSize(args...));
+    return BinarySerializer::packedSerializationInto(out.get(), true, args...);
+}
+
+template<typename... Args>
+void BinarySerializer::fastDeserializationPacked(const void* src, SizeUnit size, Args&... args)
+{
+    // Get the layout at compile time.
+    constexpr bool has_vectors = (packed_traits<Args>::kIsVector || ...);
+    constexpr SchemaId expected_schema = BinarySerializer::packedSchemaId<Args...>();
+    const bool little = BinarySerializer::determineEndianess() == Endianess::LITTLE_ENDIAN;
+
+    // Check the header.
+    const std::byte* data = static_cast<const std::byte*>(src);
+    if (!BinarySerializer::isPackedData(src, size))
+        throw std::logic_error("BinarySerializer: The data does not have a valid packed header.");
+    const std::uint8_t version = static_cast<std::uint8_t>(data[1]);
+    if ((version & kPackedVersionMask) != kPackedVersion)
+        throw std::logic_error("BinarySerializer: Unsupported packed format version.");
+
+    // Check the size (only possible in advance for fixed layouts).
+    if constexpr (!has_vectors)
+    {
+        if (size != BinarySerializer::packedSize<Args...>())
+            throw std::out_of_range("BinarySerializer: The data size does not match the packed layout.");
+    }
+
+    // Check the schema.
+    SchemaId schema;
+    BinarySerializer::binarySerializeDeserialize(data + 2, sizeof(SchemaId), &schema, little);
+    if (schema != expected_schema)
+        throw std::logic_error("BinarySerializer: The packed schema does not match the expected types.");
+
+    // Only convert the values if the byte order of the payload differs from the host one.
+    const bool payload_little = (version & kPackedFlagLittle) != 0;
+    const bool reverse = payload_little != little;
+
+    // Read the values.
+    [[maybe_unused]] const std::byte* cursor = data + kPackedHeaderSize;
+    [[maybe_unused]] const std::byte* end = data + size;
+    (BinarySerializer::readPacked(args, cursor, end, reverse), ...);
+
+    // Check that all the data was deserialized.
+    if (cursor != end)
+        throw std::out_of_range("BinarySerializer: The data size does not match the packed layout.");
+}
+
 template<typename T, typename... Args, typename>
 BinarySerializer::SizeUnit BinarySerializer::write(const T& value, const Args&... args)
 {
@@ -287,12 +525,11 @@ void BinarySerializer::writeSingle(const std::array<T, L>& arr)
     BinarySerializer::binarySerialize(&elem_size, sizeof(SizeUnit), this->data_.get() + size_);
     this->size_ += sizeof(SizeUnit);
 
-    // Write each value of the array.
-    for(const auto& val : arr)
-    {
-        BinarySerializer::binarySerialize(&val, elem_size, this->data_.get() + this->size_);
-        this->size_ += elem_size;
-    }
+    // Write all the values of the array in bulk.
+    const bool reverse = this->endianess_ == Endianess::LITTLE_ENDIAN;
+    BinarySerializer::bulkSerializeDeserialize(reinterpret_cast<const std::byte*>(arr.data()), array_size, elem_size,
+                                               this->data_.get() + this->size_, reverse);
+    this->size_ += elem_size * array_size;
 }
 
 template<typename T>
@@ -317,12 +554,11 @@ void BinarySerializer::writeSingle(const std::vector<T>& v)
     BinarySerializer::binarySerialize(&elem_size, sizeof(SizeUnit), this->data_.get() + size_);
     this->size_ += sizeof(SizeUnit);
 
-    // Write each value of the vector.
-    for(const auto& val : v)
-    {
-        BinarySerializer::binarySerialize(&val, elem_size, this->data_.get() + this->size_);
-        this->size_ += elem_size;
-    }
+    // Write all the values of the vector in bulk.
+    const bool reverse = this->endianess_ == Endianess::LITTLE_ENDIAN;
+    BinarySerializer::bulkSerializeDeserialize(reinterpret_cast<const std::byte*>(v.data()), vector_size, elem_size,
+                                               this->data_.get() + this->size_, reverse);
+    this->size_ += elem_size * vector_size;
 }
 
 template<typename T>
@@ -400,15 +636,31 @@ void BinarySerializer::readSingle(std::array<T, L>& arr)
     if(size_elem == 0)
         throw std::out_of_range("BinarySerializer: Unknow size of elements of the array.");
 
+    // Check if the array or element sizes are greater than the expected sizes for the type.
+    if (size_array > L)
+        throw std::out_of_range("BinarySerializer: The serialized array size is greater than the array for storage.");
+    if (size_elem > sizeof(T))
+        throw std::logic_error("BinarySerializer: The serialized element size is greater than type for storage.");
+
     // Check if we have enough data left to read the string.
     if (this->offset_ + size_elem*size_array > this->size_)
         throw std::out_of_range("BinarySerializer: Read array data beyond the data size.");
 
-    // Read all the elements.
-    for(std::uint64_t i = 0; i < size_array; i++)
+    // Read all the elements (in bulk if the element sizes match).
+    if (size_elem == sizeof(T))
+    {
+        const bool reverse = this->endianess_ == Endianess::LITTLE_ENDIAN;
+        BinarySerializer::bulkSerializeDeserialize(this->data_.get() + this->offset_, size_array, size_elem,
+                                                   reinterpret_cast<std::byte*>(arr.data()), reverse);
+        this->offset_ += size_elem * size_array;
+    }
+    else
     {
-        BinarySerializer::binaryDeserialize(this->data_.get() + this->offset_, size_elem, &arr[i]);
-        this->offset_ += size_elem;
+        for(std::uint64_t i = 0; i < size_array; i++)
+        {
+            BinarySerializer::binaryDeserialize(this->data_.get() + this->offset_, size_elem, &arr[i]);
+            this->offset_ += size_elem;
+        }
     }
 }
 
@@ -448,6 +700,10 @@ void BinarySerializer::readSingle(std::vector<T>& v)
     if(size_elem == 0)
         throw std::out_of_range("BinarySerializer: Unknow size of elements of the vector.");
 
+    // Check if the size is greater than the expected size for the type.
+    if (size_elem > sizeof(T))
+        throw std::logic_error("BinarySerializer: The serialized element size is greater than type for storage.");
+
     // Check if we have enough data left to read the data.
     if (this->offset_ + size_elem*size_vector > this->size_)
         throw std::out_of_range("BinarySerializer: Read vector data beyond the data size.");
@@ -456,11 +712,21 @@ void BinarySerializer::readSingle(std::vector<T>& v)
     v.clear();
     v.resize(size_vector);
 
-    // Read all the elements.
-    for(std::uint64_t i = 0; i < size_vector; i++)
+    // Read all the elements (in bulk if the element sizes match).
+    if (size_elem == sizeof(T))
+    {
+        const bool reverse = this->endianess_ == Endianess::LITTLE_ENDIAN;
+        BinarySerializer::bulkSerializeDeserialize(this->data_.get() + this->offset_, size_vector, size_elem,
+                                                   reinterpret_cast<std::byte*>(v.data()), reverse);
+        this->offset_ += size_elem * size_vector;
+    }
+    else
     {
-        BinarySerializer::binaryDeserialize(this->data_.get() + this->offset_, size_elem, &v[i]);
-        this->offset_ += size_elem;
+        for(std::uint64_t i = 0; i < size_vector; i++)
+        {
+            BinarySerializer::binaryDeserialize(this->data_.get() + this->offset_, size_elem, &v[i]);
+            this->offset_ += size_elem;
+        }
     }
 }
 
@@ -0,0 +1,396 @@
+/***********************************************************************************************************************
+ *   LibZMQUtils (ZMQ Utilitites Library): A libre library with ZMQ related useful utilities.                          *
+ *                                                                                                                     *
+ *   Copyright (C) 2023 Degoras Project Team                                                                           *
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >                             *
+ *                      < Jesús Relinque Madroñal >                                                                    *
+ *                                                                                                                     *
+ *   This file is part of LibZMQUtils.                                                                                 *
+ *                                                                                                                     *
+ *   Licensed under the European Union Public License (EUPL), Version 1.2 or subsequent versions of the EUPL license   *
+ *   as soon they will be approved by the European Commission (IDABC).                                                 *
+ *                                                                                                                     *
+ *   This project is free software: you can redistribute it and/or modify it under the terms of the EUPL license as    *
+ *   published by the IDABC, either Version 1.2 or, at your option, any later version.                                 *
+ *                                                                                                                     *
+ *   This project is distributed in the hope that it will be useful. Unless required by applicable law or agreed to in *
+ *   writing, it is distributed on an "AS IS" basis, WITHOUT ANY WARRANTY OR CONDITIONS OF ANY KIND; without even the  *
+ *   implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the EUPL license to check specific   *
+ *   language governing permissions and limitations and more details.                                                  *
+ *                                                                                                                     *
+ *   You should use this project in compliance with the EUPL license. You should have received a copy of the license   *
+ *   along with this project. If not, see the license at < https://eupl.eu/ >.                                         *
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file local_binary_serializer.h
+ * @brief This file contains the declaration of the LocalBinarySerializer class.
+ * @author Degoras Project Team
+ * @copyright EUPL License
+ * @version 2309.5
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include "LibZMQUtils/Utilities/BinarySerializer/binary_serializer.h"
+#include "LibZMQUtils/Utilities/buffer_pool.h"
+// =====================================================================================================================
+
+// ZMQUTILS NAMESPACES
+// =====================================================================================================================
+namespace zmqutils{
+namespace utils{
+// =====================================================================================================================
+
+/**
+ * @class LocalBinarySerializer
+ *
+ * @brief Single-owner variant of the BinarySerializer, without any synchronization.
+ *
+ * This class writes and reads exactly the same tagged wire format as BinarySerializer, so data produced by one of them
+ * can be consumed by the other. The differences are:
+ *
+ * - **No synchronization:** The cursors are plain integers and there is no mutex, so each written or read field costs
+ *   only the bounds check and the copy. Use it for serializers that live in a single thread, like the stack-local
+ *   serializers used while processing a request or a reply.
+ *
+ * - **Storage modes:** Besides owning its buffer, the serializer can write into an external buffer provided by the
+ *   caller (without growing it), or read from a borrowed buffer without copying it.
+ *
+ * - **Supported types:** Trivial and trivially copyable types, strings, and arrays and vectors of trivial types.
+ *   Serializable objects are not supported because their interface works over a BinarySerializer. Serialize their
+ *   fields directly instead (the tagged format stores the fields of a Serializable object inline, so the resulting
+ *   data is the same).
+ *
+ * Usage Example:
+ *
+ * @code{.cpp}
+ *   LocalBinarySerializer serializer(request.params.get(), request.params_size);  // No copy.
+ *   double az, el;
+ *   serializer.read(az, el);
+ * @endcode
+ *
+ * @warning This class is not thread safe.
+ * @warning In the borrowed mode the source buffer must outlive the serializer.
+ *
+ * @see BinarySerializer
+ */
+class LocalBinarySerializer
+{
+public:
+
+    using SizeUnit = BinarySerializer::SizeUnit;            ///< Alias for the size unit.
+    using BytesSmartPtr = BinarySerializer::BytesSmartPtr;  ///< Alias for the bytes storage smart pointer.
+
+    /// Enumeration representing the storage mode of the serializer.
+    enum class StorageMode
+    {
+        OWNED,     ///< The serializer owns and grows its buffer.
+        EXTERNAL,  ///< The serializer writes into a caller-provided buffer with fixed capacity.
+        BORROWED   ///< The serializer reads from a caller-provided buffer (read only, no copy).
+    };
+
+    /**
+     * @brief Construct a new `LocalBinarySerializer` object that owns its buffer.
+     * @param capacity The initial capacity of the serializer. Default is 1024.
+     */
+    explicit LocalBinarySerializer(SizeUnit capacity = 1024);
+
+    /**
+     * @brief Construct a new `LocalBinarySerializer` object over an external writable buffer.
+     * @param dst Pointer to the external buffer.
+     * @param capacity Capacity of the external buffer.
+     * @param size Size of the valid data already stored in the buffer (0 to start writing from the beginning).
+     * @warning The serializer will never grow the external buffer.
+     */
+    LocalBinarySerializer(std::byte* dst, SizeUnit capacity, SizeUnit size);
+
+    /**
+     * @brief Construct a new `LocalBinarySerializer` object that reads from a borrowed buffer without copying it.
+     * @param src Pointer to the data source to read.
+     * @param size Size of the data to read.
+     * @warning The @a src parameter is a void pointer, so be careful.
+     */
+    LocalBinarySerializer(const void* src, SizeUnit size);
+
+    /**
+     * @brief Construct a new `LocalBinarySerializer` object that takes the ownership of the given data.
+     * @param src Smart pointer with the data.
+     * @param size Size of the data.
+     */
+    LocalBinarySerializer(BytesSmartPtr&& src, SizeUnit size);
+
+    LocalBinarySerializer(const LocalBinarySerializer&) = delete;
+
+    LocalBinarySerializer& operator=(const LocalBinarySerializer&) = delete;
+
+    LocalBinarySerializer(LocalBinarySerializer&& other) noexcept;
+
+    LocalBinarySerializer& operator=(LocalBinarySerializer&& other) noexcept;
+
+    /**
+     * @brief Reserve memory for the serializer.
+     * @param size The size of memory to reserve.
+     * @throw std::out_of_range If the serializer does not own the buffer and the capacity is not enough.
+     */
+    void reserve(SizeUnit size);
+
+    /**
+     * @brief Clear the data held by the serializer. External and borrowed buffers are only detached.
+     */
+    void clearData();
+
+    /**
+     * @brief Reset the internal read offset.
+     */
+    void resetReading();
+
+    /**
+     * @brief Move the data held by the serializer to a smart pointer.
+     * @param[out] out The smart pointer with the data.
+     * @return The size of the data.
+     * @note For external and borrowed buffers the data is copied into a new allocation.
+     */
+    SizeUnit moveUnique(BytesSmartPtr& out);
+
+    /**
+     * @brief Get a pointer to the serialized data.
+     * @return Pointer to the data.
+     */
+    const std::byte* getData() const;
+
+    /**
+     * @brief Get the current size of the data held by the serializer.
+     * @return The current size of the data.
+     */
+    SizeUnit getSize() const;
+
+    /**
+     * @brief Get the current capacity of the serializer.
+     * @return The current capacity.
+     */
+    SizeUnit getCapacity() const;
+
+    /**
+     * @brief Get the storage mode of the serializer.
+     * @return The storage mode.
+     */
+    StorageMode getStorageMode() const;
+
+    /**
+     * @brief Check whether all data has been read.
+     * @return True if all data has been read, false otherwise.
+     */
+    bool allReaded() const;
+
+    /**
+     * @brief Get a hex string representation of the data held by the serializer.
+     * @return Hex string representation of the data (same format as BinarySerializer).
+     */
+    std::string getDataHexString() const;
+
+    /**
+     * @brief Serializes the given values into the buffer using the tagged format.
+     * @param value The first value to be serialized.
+     * @param args The remaining values to be serialized.
+     * @return The total size in bytes that the values occupy after being serialized.
+     * @throw std::out_of_range If the serializer does not own the buffer and the capacity is not enough.
+     * @throw std::logic_error If the serializer is in borrowed (read only) mode.
+     */
+    template<typename T, typename... Args>
+    SizeUnit write(const T& value, const Args&... args);
+
+    /**
+     * @brief Deserializes the given values from the buffer using the tagged format.
+     * @param[out] value The first lvalue reference where the read data should be stored.
+     * @param[out] args The remaining lvalue references where the read data should be stored.
+     * @throw std::out_of_range If you read beyond the size of the stored data.
+     * @throw std::logic_error If the serialized value size is greater than type for storage.
+     */
+    template<typename T, typename... Args>
+    void read(T& value, Args&... args);
+
+    /**
+     * @brief A static function that serializes multiple data items using the tagged format.
+     *
+     * Equivalent to `BinarySerializer::fastSerialization`, but without any synchronization and with a single
+     * allocation of the exact size.
+     *
+     * @param[out] out The unique pointer where the serialized data will be stored.
+     * @param[in] args The input data items to be serialized.
+     * @return The size of the serialized data.
+     */
+    template<typename... Args>
+    static SizeUnit fastSerialization(BytesSmartPtr& out, const Args&... args);
+
+    /**
+     * @brief Compute at compile time the tagged serialized size of the given fixed-size types.
+     * @return The total size in bytes.
+     * @note Only trivial types and arrays of them are allowed. For strings and vectors use `calcTotalSize`.
+     */
+    template<typename... Args>
+    static constexpr SizeUnit fixedSerializedSize();
+
+    /// Inline storage for the fixed-size serialization of the given types.
+    template<typename... Args>
+    using FixedBuffer = std::array<std::byte, LocalBinarySerializer::fixedSerializedSize<Args...>()>;
+
+    /**
+     * @brief A static function that serializes multiple data items into a buffer taken from a BufferPool.
+     *
+     * Same as the `fastSerialization` with a plain smart pointer, but the storage is reused through the pool, so in
+     * steady state no heap allocation is done.
+     *
+     * @param[out] out The pooled buffer where the serialized data will be stored.
+     * @param[in] args The input data items to be serialized.
+     * @return The size of the serialized data (the buffer capacity can be bigger).
+     */
+    template<typename... Args>
+    static SizeUnit fastSerialization(BufferPool::PooledBytes& out, const Args&... args);
+
+    /**
+     * @brief A static function that serializes multiple data items directly into a caller-provided buffer.
+     *
+     * No allocation is done. Use `calcTotalSize` (or `fixedSerializedSize` for fixed-size types) to size the buffer.
+     *
+     * @param[out] dst Pointer to the destination buffer.
+     * @param[in] capacity Capacity of the destination buffer.
+     * @param[in] args The input data items to be serialized.
+     * @return The size of the serialized data.
+     * @throw std::out_of_range If the capacity of the buffer is not enough.
+     */
+    template<typename... Args>
+    static SizeUnit fastSerializationInto(std::byte* dst, SizeUnit capacity, const Args&... args);
+
+    /**
+     * @brief A static function that serializes fixed-size data items into an inline buffer sized at compile time.
+     *
+     * Usage Example:
+     *
+     * @code{.cpp}
+     *   auto data = LocalBinarySerializer::fastSerializationFixed(error, az, el);  // std::array, no allocation.
+     *   socket.send(zmq::buffer(data));
+     * @endcode
+     *
+     * @param[in] args The input data items to be serialized. Only trivial types and arrays of them are allowed.
+     * @return The inline buffer with the serialized data (its size is the serialized size).
+     */
+    template<typename... Args>
+    static FixedBuffer<Args...> fastSerializationFixed(const Args&... args);
+
+    /**
+     * @brief A static function that deserializes tagged data without copying it.
+     *
+     * Equivalent to `BinarySerializer::fastDeserialization`, but the data is read in place.
+     *
+     * @param[in] src The binary data to be deserialized.
+     * @param[in] size The size of the binary data.
+     * @param[out] args The variables where the deserialized data items are stored.
+     * @throw std::out_of_range If not all data was deserialized or you read beyond the size of the data.
+     * @throw std::logic_error If the serialized value size is greater than type for storage.
+     */
+    template<typename... Args>
+    static void fastDeserialization(const void* src, SizeUnit size, Args&... args);
+
+    /**
+     * @brief Compute the size of the tagged serialization of the given values.
+     * @param args The values to be serialized.
+     * @return The total size in bytes.
+     */
+    template<typename... Args>
+    static SizeUnit calcTotalSize(const Args&... args);
+
+private:
+
+    // Internal compile time size of a fixed-size type (scalars and arrays).
+    template<typename T>
+    struct fixed_size
+    {
+        static_assert(std::is_trivial_v<T> && std::is_trivially_copyable_v<T>,
+                      "Only trivial types and arrays of them have a compile time serialized size.");
+        static constexpr SizeUnit value = sizeof(SizeUnit) + sizeof(T);
+    };
+
+    template<typename T, std::size_t L>
+    struct fixed_size<std::array<T, L>>
+    {
+        static constexpr SizeUnit value = sizeof(SizeUnit) + sizeof(SizeUnit) + sizeof(T) * L;
+    };
+
+    // Internal cached byte order check.
+    static bool hostReverse();
+
+    // Internal size calculator functions.
+    template<typename T>
+    static SizeUnit calcSingleSize(const T& data);
+
+    template<typename T, std::size_t L>
+    static SizeUnit calcSingleSize(const std::array<T, L>& data);
+
+    template<typename T>
+    static SizeUnit calcSingleSize(const std::vector<T>& data);
+
+    static SizeUnit calcSingleSize(const std::string& data);
+
+    // Internal helper to ensure the capacity for writing.
+    void ensureCapacity(SizeUnit size);
+
+    // Internal helper to write and read a size unit.
+    void writeSizeUnit(SizeUnit value);
+    SizeUnit readSizeUnit(const char* what);
+
+    // Write data functions.
+    template<typename T>
+    void writeSingle(const T& data);
+
+    template<typename T, std::size_t L>
+    void writeSingle(const std::array<T, L>& arr);
+
+    template<typename T>
+    void writeSingle(const std::vector<T>& v);
+
+    void writeSingle(const std::string& str);
+
+    // Read data functions.
+    template<typename T>
+    void readSingle(T& value);
+
+    template<typename T, std::size_t L>
+    void readSingle(std::array<T, L>& arr);
+
+    template<typename T>
+    void readSingle(std::vector<T>& v);
+
+    void readSingle(std::string& str);
+
+    // Internal containers and variables.
+    BytesSmartPtr owned_;       ///< Owned storage (only in the owned mode).
+    std::byte* data_;           ///< Pointer to the current storage.
+    SizeUnit size_;             ///< Current size of the data.
+    SizeUnit capacity_;         ///< Current capacity.
+    SizeUnit offset_;           ///< Offset when reading.
+    StorageMode mode_;          ///< Storage mode.
+    bool reverse_;              ///< Reverse the byte order (little-endian systems).
+};
+
+}} // END NAMESPACES
+// =====================================================================================================================
+
+// TEMPLATES INCLUDES
+// =====================================================================================================================
+#include "LibZMQUtils/Utilities/BinarySerializer/local_binary_serializer.tpp"
+// =====================================================================================================================
@@ -0,0 +1,546 @@
+/***********************************************************************************************************************
+ *   LibZMQUtils (ZMQ Utilitites Library): A libre library with ZMQ related useful utilities.                          *
+ *                                                                                                                     *
+ *   Copyright (C) 2023 Degoras Project Team                                                                           *
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >                             *
+ *                      < Jesús Relinque Madroñal >                                                                    *
+ *                                                                                                                     *
+ *   This file is part of LibZMQUtils.                                                                                 *
+ *                                                                                                                     *
+ *   Licensed under the European Union Public License (EUPL), Version 1.2 or subsequent versions of the EUPL license   *
+ *   as soon they will be approved by the European Commission (IDABC).                                                 *
+ *                                                                                                                     *
+ *   This project is free software: you can redistribute it and/or modify it under the terms of the EUPL license as    *
+ *   published by the IDABC, either Version 1.2 or, at your option, any later version.                                 *
+ *                                                                                                                     *
+ *   This project is distributed in the hope that it will be useful. Unless required by applicable law or agreed to in *
+ *   writing, it is distributed on an "AS IS" basis, WITHOUT ANY WARRANTY OR CONDITIONS OF ANY KIND; without even the  *
+ *   implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the EUPL license to check specific   *
+ *   language governing permissions and limitations and more details.                                                  *
+ *                                                                                                                     *
+ *   You should use this project in compliance with the EUPL license. You should have received a copy of the license   *
+ *   along with this project. If not, see the license at < https://eupl.eu/ >.                                         *
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file local_binary_serializer.tpp
+ * @brief This file contains the template and inline implementation part of the LocalBinarySerializer class.
+ * @author Degoras Project Team
+ * @copyright EUPL License
+ * @version 2309.5
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include "LibZMQUtils/Utilities/BinarySerializer/local_binary_serializer.h"
+// =====================================================================================================================
+
+// ZMQUTILS NAMESPACES
+// =====================================================================================================================
+namespace zmqutils{
+namespace utils{
+// =====================================================================================================================
+
+inline bool LocalBinarySerializer::hostReverse()
+{
+    static const bool reverse = BinarySerializer::determineEndianess() == BinarySerializer::Endianess::LITTLE_ENDIAN;
+    return reverse;
+}
+
+inline LocalBinarySerializer::LocalBinarySerializer(SizeUnit capacity) :
+    owned_(capacity ? new std::byte[capacity] : nullptr),
+    data_(owned_.get()),
+    size_(0),
+    capacity_(capacity),
+    offset_(0),
+    mode_(StorageMode::OWNED),
+    reverse_(LocalBinarySerializer::hostReverse())
+{}
+
+inline LocalBinarySerializer::LocalBinarySerializer(std::byte* dst, SizeUnit capacity, SizeUnit size) :
+    data_(dst),
+    size_(std::min(size, capacity)),
+    capacity_(capacity),
+    offset_(0),
+    mode_(StorageMode::EXTERNAL),
+    reverse_(LocalBinarySerializer::hostReverse())
+{}
+
+inline LocalBinarySerializer::LocalBinarySerializer(const void* src, SizeUnit size) :
+    data_(static_cast<std::byte*>(const_cast<void*>(src))),
+    size_(src ? size : 0),
+    capacity_(src ? size : 0),
+    offset_(0),
+    mode_(StorageMode::BORROWED),
+    reverse_(LocalBinarySerializer::hostReverse())
+{}
+
+inline LocalBinarySerializer::LocalBinarySerializer(BytesSmartPtr&& src, SizeUnit size) :
+    owned_(std::move(src)),
+    data_(owned_.get()),
+    size_(data_ ? size : 0),
+    capacity_(data_ ? size : 0),
+    offset_(0),
+    mode_(StorageMode::OWNED),
+    reverse_(LocalBinarySerializer::hostReverse())
+{}
+
+inline LocalBinarySerializer::LocalBinarySerializer(LocalBinarySerializer&& other) noexcept :
+    owned_(std::move(other.owned_)),
+    data_(other.data_),
+    size_(other.size_),
+    capacity_(other.capacity_),
+    offset_(other.offset_),
+    mode_(other.mode_),
+    reverse_(other.reverse_)
+{
+    other.data_ = nullptr;
+    other.size_ = other.capacity_ = other.offset_ = 0;
+    other.mode_ = StorageMode::OWNED;
+}
+
+inline LocalBinarySerializer& LocalBinarySerializer::operator=(LocalBinarySerializer&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->owned_ = std::move(other.owned_);
+        this->data_ = other.data_;
+        this->size_ = other.size_;
+        this->capacity_ = other.capacity_;
+        this->offset_ = other.offset_;
+        this->mode_ = other.mode_;
+        this->reverse_ = other.reverse_;
+        other.data_ = nullptr;
+        other.size_ = other.capacity_ = other.offset_ = 0;
+        other.mode_ = StorageMode::OWNED;
+    }
+    return *this;
+}
+
+inline void LocalBinarySerializer::reserve(SizeUnit size)
+{
+    // Check if we need more space.
+    if (size <= this->capacity_)
+        return;
+
+    // Only the owned storage can grow.
+    if (this->mode_ != StorageMode::OWNED)
+        throw std::out_of_range("LocalBinarySerializer: Not enough capacity in the external buffer.");
+
+    // Reallocate and copy the current data.
+    BytesSmartPtr new_data(new std::byte[size]);
+    if (this->size_ > 0)
+        std::memcpy(new_data.get(), this->data_, this->size_);
+    this->owned_ = std::move(new_data);
+    this->data_ = this->owned_.get();
+    this->capacity_ = size;
+}
+
+inline void LocalBinarySerializer::clearData()
+{
+    this->owned_.reset();
+    this->data_ = nullptr;
+    this->size_ = 0;
+    this->capacity_ = 0;
+    this->offset_ = 0;
+    this->mode_ = StorageMode::OWNED;
+}
+
+inline void LocalBinarySerializer::resetReading()
+{
+    this->offset_ = 0;
+}
+
+inline LocalBinarySerializer::SizeUnit LocalBinarySerializer::moveUnique(BytesSmartPtr& out)
+{
+    const SizeUnit size = this->size_;
+
+    // Move the owned storage or copy the external data.
+    if (this->mode_ == StorageMode::OWNED)
+    {
+        out = std::move(this->owned_);
+    }
+    else
+    {
+        out = BytesSmartPtr(size ? new std::byte[size] : nullptr);
+        if (size > 0)
+            std::memcpy(out.get(), this->data_, size);
+    }
+
+    // Clear the serializer.
+    this->clearData();
+    return size;
+}
+
+inline const std::byte* LocalBinarySerializer::getData() const
+{
+    return this->data_;
+}
+
+inline LocalBinarySerializer::SizeUnit LocalBinarySerializer::getSize() const
+{
+    return this->size_;
+}
+
+inline LocalBinarySerializer::SizeUnit LocalBinarySerializer::getCapacity() const
+{
+    return this->capacity_;
+}
+
+inline LocalBinarySerializer::StorageMode LocalBinarySerializer::getStorageMode() const
+{
+    return this->mode_;
+}
+
+inline bool LocalBinarySerializer::allReaded() const
+{
+    return this->offset_ == this->size_;
+}
+
+inline std::string LocalBinarySerializer::getDataHexString() const
+{
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string result;
+    if (this->size_ == 0)
+        return result;
+    result.reserve(this->size_ * 3 - 1);
+    for (SizeUnit i = 0; i < this->size_; i++)
+    {
+        const auto byte = static_cast<unsigned>(this->data_[i]);
+        if (i > 0)
+            result.push_back(' ');
+        result.push_back(kHexDigits[byte >> 4]);
+        result.push_back(kHexDigits[byte & 0x0F]);
+    }
+    return result;
+}
+
+template<typename T, typename... Args>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::write(const T& value, const Args&... args)
+{
+    // Calculate total size of all arguments.
+    const SizeUnit t_size = LocalBinarySerializer::calcTotalSize(value, args...);
+
+    // Reserve space in one go.
+    this->ensureCapacity(this->size_ + t_size);
+
+    // Write all the values.
+    this->writeSingle(value);
+    (this->writeSingle(args), ...);
+
+    // Return the writed size.
+    return t_size;
+}
+
+template<typename T, typename... Args>
+void LocalBinarySerializer::read(T& value, Args&... args)
+{
+    this->readSingle(value);
+    (this->readSingle(args), ...);
+}
+
+template<typename... Args>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::fastSerialization(BytesSmartPtr& out, const Args&... args)
+{
+    // Allocate the exact storage and serialize directly into it.
+    const SizeUnit size = LocalBinarySerializer::calcTotalSize(args...);
+    out = BytesSmartPtr(size ? new std::byte[size] : nullptr);
+    return LocalBinarySerializer::fastSerializationInto(out.get(), size, args...);
+}
+
+template<typename... Args>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::fastSerialization(BufferPool::PooledBytes& out,
+                                                                         const Args&... args)
+{
+    // Take the storage from the pool and serialize directly into it.
+    const SizeUnit size = LocalBinarySerializer::calcTotalSize(args...);
+    out = BufferPool::defaultPool().acquire(size);
+    return LocalBinarySerializer::fastSerializationInto(out.get(), size, args...);
+}
+
+template<typename... Args>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::fastSerializationInto(std::byte* dst, SizeUnit capacity,
+                                                                             const Args&... args)
+{
+    // Do the serialization over the external buffer.
+    LocalBinarySerializer serializer(dst, capacity, 0);
+    if constexpr (sizeof...(Args) > 0)
+        serializer.write(args...);
+    return serializer.getSize();
+}
+
+template<typename... Args>
+LocalBinarySerializer::FixedBuffer<Args...> LocalBinarySerializer::fastSerializationFixed(const Args&... args)
+{
+    // Do the serialization over the inline buffer.
+    FixedBuffer<Args...> data;
+    LocalBinarySerializer::fastSerializationInto(data.data(), data.size(), args...);
+    return data;
+}
+
+template<typename... Args>
+constexpr LocalBinarySerializer::SizeUnit LocalBinarySerializer::fixedSerializedSize()
+{
+    return (fixed_size<Args>::value + ... + 0);
+}
+
+template<typename... Args>
+void LocalBinarySerializer::fastDeserialization(const void* src, SizeUnit size, Args&... args)
+{
+    // Do the deserialization in place.
+    LocalBinarySerializer serializer(src, size);
+    if constexpr (sizeof...(Args) > 0)
+        serializer.read(args...);
+    if(!serializer.allReaded())
+        throw std::out_of_range("LocalBinarySerializer: Not all data was deserialized.");
+}
+
+template<typename... Args>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::calcTotalSize(const Args&... args)
+{
+    return (LocalBinarySerializer::calcSingleSize(args) + ... + 0);
+}
+
+template<typename T>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::calcSingleSize(const T&)
+{
+    return sizeof(SizeUnit) + sizeof(T);
+}
+
+template<typename T, std::size_t L>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::calcSingleSize(const std::array<T, L>&)
+{
+    return sizeof(SizeUnit) + sizeof(SizeUnit) + sizeof(T) * L;
+}
+
+template<typename T>
+LocalBinarySerializer::SizeUnit LocalBinarySerializer::calcSingleSize(const std::vector<T>& data)
+{
+    return sizeof(SizeUnit) + sizeof(SizeUnit) + sizeof(T) * data.size();
+}
+
+inline LocalBinarySerializer::SizeUnit LocalBinarySerializer::calcSingleSize(const std::string& data)
+{
+    return sizeof(SizeUnit) + data.size();
+}
+
+inline void LocalBinarySerializer::ensureCapacity(SizeUnit size)
+{
+    // Borrowed data is read only.
+    if (this->mode_ == StorageMode::BORROWED)
+        throw std::logic_error("LocalBinarySerializer: Can't write into a borrowed buffer.");
+
+    // Grow the owned storage geometrically to amortize consecutive writes.
+    if (size > this->capacity_)
+        this->reserve(this->mode_ == StorageMode::OWNED ? std::max(size, this->capacity_ * 2) : size);
+}
+
+inline void LocalBinarySerializer::writeSizeUnit(SizeUnit value)
+{
+    BinarySerializer::binarySerializeDeserialize(&value, sizeof(SizeUnit), this->data_ + this->size_, this->reverse_);
+    this->size_ += sizeof(SizeUnit);
+}
+
+inline LocalBinarySerializer::SizeUnit LocalBinarySerializer::readSizeUnit(const char* what)
+{
+    // Ensure that there's enough data left to read the size.
+    if (this->offset_ + sizeof(SizeUnit) > this->size_)
+        throw std::out_of_range(std::string("LocalBinarySerializer: Not enough data left to read the size of ") + what);
+
+    SizeUnit value;
+    BinarySerializer::binarySerializeDeserialize(this->data_ + this->offset_, sizeof(SizeUnit), &value, this->reverse_);
+    this->offset_ += sizeof(SizeUnit);
+    return value;
+}
+
+template<typename T>
+void LocalBinarySerializer::writeSingle(const T& data)
+{
+    // Check the types.
+    static_assert(!std::is_base_of_v<Serializable, T>, "Serializable objects are not supported, write the fields.");
+    static_assert(!std::is_pointer_v<T>, "Pointers are not supported.");
+    BinarySerializer::checkTriviallyCopyable<T>();
+    BinarySerializer::checkTrivial<T>();
+
+    // Serialize the size of the data and the data.
+    this->writeSizeUnit(sizeof(T));
+    BinarySerializer::binarySerializeDeserialize(&data, sizeof(T), this->data_ + this->size_, this->reverse_);
+    this->size_ += sizeof(T);
+}
+
+template<typename T, std::size_t L>
+void LocalBinarySerializer::writeSingle(const std::array<T, L>& arr)
+{
+    // Check the types.
+    BinarySerializer::checkTriviallyCopyable<T>();
+    BinarySerializer::checkTrivial<T>();
+
+    // Serialize the array size, the size of each element and all the values in bulk.
+    this->writeSizeUnit(L);
+    this->writeSizeUnit(sizeof(T));
+    BinarySerializer::bulkSerializeDeserialize(reinterpret_cast<const std::byte*>(arr.data()), L, sizeof(T),
+                                               this->data_ + this->size_, this->reverse_);
+    this->size_ += sizeof(T) * L;
+}
+
+template<typename T>
+void LocalBinarySerializer::writeSingle(const std::vector<T>& v)
+{
+    // Check the types.
+    BinarySerializer::checkTriviallyCopyable<T>();
+    BinarySerializer::checkTrivial<T>();
+
+    // Serialize the vector size, the size of each element and all the values in bulk.
+    this->writeSizeUnit(v.size());
+    this->writeSizeUnit(sizeof(T));
+    BinarySerializer::bulkSerializeDeserialize(reinterpret_cast<const std::byte*>(v.data()), v.size(), sizeof(T),
+                                               this->data_ + this->size_, this->reverse_);
+    this->size_ += sizeof(T) * v.size();
+}
+
+inline void LocalBinarySerializer::writeSingle(const std::string& str)
+{
+    // Serialize the size of the string and the characters.
+    this->writeSizeUnit(str.size());
+    if (!str.empty())
+        std::memcpy(this->data_ + this->size_, str.data(), str.size());
+    this->size_ += str.size();
+}
+
+template<typename T>
+void LocalBinarySerializer::readSingle(T& value)
+{
+    // Check the types.
+    static_assert(!std::is_base_of_v<Serializable, T>, "Serializable objects are not supported, read the fields.");
+    static_assert(!std::is_pointer_v<T>, "Pointers are not supported.");
+    BinarySerializer::checkTriviallyCopyable<T>();
+    BinarySerializer::checkTrivial<T>();
+
+    // Read the size of the value.
+    const SizeUnit size = this->readSizeUnit("the value.");
+
+    // Check if we have enough data left to read the value.
+    if (this->offset_ + size > this->size_)
+        throw std::out_of_range("LocalBinarySerializer: Read value beyond the data size.");
+
+    // Check if the size is greater than the expected size for the type.
+    if (size > sizeof(T))
+        throw std::logic_error("LocalBinarySerializer: The serialized value size is greater than type for storage.");
+
+    // Read the value.
+    BinarySerializer::binarySerializeDeserialize(this->data_ + this->offset_, size, &value, this->reverse_);
+    this->offset_ += size;
+}
+
+template<typename T, std::size_t L>
+void LocalBinarySerializer::readSingle(std::array<T, L>& arr)
+{
+    // Read the size of the array and the size of the elements.
+    const SizeUnit size_array = this->readSizeUnit("the array.");
+    if (size_array == 0)
+    {
+        // Skip the size of the elements if present.
+        if (this->offset_ + sizeof(SizeUnit) <= this->size_)
+            this->offset_ += sizeof(SizeUnit);
+        return;
+    }
+    const SizeUnit size_elem = this->readSizeUnit("elements of the array.");
+
+    // Check the sizes.
+    if (size_elem == 0)
+        throw std::out_of_range("LocalBinarySerializer: Unknow size of elements of the array.");
+    if (size_array > L)
+        throw std::out_of_range("LocalBinarySerializer: The serialized array size is greater than the array.");
+    if (size_elem > sizeof(T))
+        throw std::logic_error("LocalBinarySerializer: The serialized element size is greater than type for storage.");
+    if (this->offset_ + size_elem*size_array > this->size_)
+        throw std::out_of_range("LocalBinarySerializer: Read array data beyond the data size.");
+
+    // Read all the elements (in bulk if the element sizes match).
+    if (size_elem == sizeof(T))
+    {
+        BinarySerializer::bulkSerializeDeserialize(this->data_ + this->offset_, size_array, size_elem,
+                                                   reinterpret_cast<std::byte*>(arr.data()), this->reverse_);
+        this->offset_ += size_elem * size_array;
+    }
+    else
+    {
+        for (SizeUnit i = 0; i < size_array; i++)
+        {
+            BinarySerializer::binarySerializeDeserialize(this->data_ + this->offset_, size_elem, &arr[i], this->reverse_);
+            this->offset_ += size_elem;
+        }
+    }
+}
+
+template<typename T>
+void LocalBinarySerializer::readSingle(std::vector<T>& v)
+{
+    // Read the size of the vector and the size of the elements.
+    const SizeUnit size_vector = this->readSizeUnit("the vector.");
+    v.clear();
+    if (size_vector == 0)
+    {
+        // Skip the size of the elements if present.
+        if (this->offset_ + sizeof(SizeUnit) <= this->size_)
+            this->offset_ += sizeof(SizeUnit);
+        return;
+    }
+    const SizeUnit size_elem = this->readSizeUnit("elements of the vector.");
+
+    // Check the sizes.
+    if (size_elem == 0)
+        throw std::out_of_range("LocalBinarySerializer: Unknow size of elements of the vector.");
+    if (size_elem > sizeof(T))
+        throw std::logic_error("LocalBinarySerializer: The serialized element size is greater than type for storage.");
+    if (size_vector > (this->size_ - this->offset_) / size_elem)
+        throw std::out_of_range("LocalBinarySerializer: Read vector data beyond the data size.");
+
+    // Prepare the vector.
+    v.resize(size_vector);
+
+    // Read all the elements (in bulk if the element sizes match).
+    if (size_elem == sizeof(T))
+    {
+        BinarySerializer::bulkSerializeDeserialize(this->data_ + this->offset_, size_vector, size_elem,
+                                                   reinterpret_cast<std::byte*>(v.data()), this->reverse_);
+        this->offset_ += size_elem * size_vector;
+    }
+    else
+    {
+        for (SizeUnit i = 0; i < size_vector; i++)
+        {
+            BinarySerializer::binarySerializeDeserialize(this->data_ + this->offset_, size_elem, &v[i], this->reverse_);
+            this->offset_ += size_elem;
+        }
+    }
+}
+
+inline void LocalBinarySerializer::readSingle(std::string& str)
+{
+    // Read the size of the string.
+    const SizeUnit size = this->readSizeUnit("the string.");
+
+    // Check if we have enough data left to read the string.
+    if (this->offset_ + size > this->size_)
+        throw std::out_of_range("LocalBinarySerializer: Read string beyond the data size.");
+
+    // Read the characters.
+    str.assign(reinterpret_cast<const char*>(this->data_ + this->offset_), size);
+    this->offset_ += size;
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
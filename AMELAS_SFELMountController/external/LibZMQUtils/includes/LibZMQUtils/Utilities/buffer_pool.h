@@ -0,0 +1,308 @@
+/***********************************************************************************************************************
+ *   LibZMQUtils (ZMQ Utilitites Library): A libre library with ZMQ related useful utilities.                          *
+ *                                                                                                                     *
+ *   Copyright (C) 2023 Degoras Project Team                                                                           *
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >                             *
+ *                      < Jesús Relinque Madroñal >                                                                    *
+ *                                                                                                                     *
+ *   This file is part of LibZMQUtils.                                                                                 *
+ *                                                                                                                     *
+ *   Licensed under the European Union Public License (EUPL), Version 1.2 or subsequent versions of the EUPL license   *
+ *   as soon they will be approved by the European Commission (IDABC).                                                 *
+ *                                                                                                                     *
+ *   This project is free software: you can redistribute it and/or modify it under the terms of the EUPL license as    *
+ *   published by the IDABC, either Version 1.2 or, at your option, any later version.                                 *
+ *                                                                                                                     *
+ *   This project is distributed in the hope that it will be useful. Unless required by applicable law or agreed to in *
+ *   writing, it is distributed on an "AS IS" basis, WITHOUT ANY WARRANTY OR CONDITIONS OF ANY KIND; without even the  *
+ *   implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the EUPL license to check specific   *
+ *   language governing permissions and limitations and more details.                                                  *
+ *                                                                                                                     *
+ *   You should use this project in compliance with the EUPL license. You should have received a copy of the license   *
+ *   along with this project. If not, see the license at < https://eupl.eu/ >.                                         *
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file buffer_pool.h
+ * @brief This file contains the declaration and inline implementation of the `BufferPool` class.
+ * @author Degoras Project Team
+ * @copyright EUPL License
+ * @version 2309.5
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+// =====================================================================================================================
+
+// ZMQUTILS NAMESPACES
+// =====================================================================================================================
+namespace zmqutils{
+namespace utils{
+// =====================================================================================================================
+
+/**
+ * @class BufferPool
+ *
+ * @brief A lock-free pool of byte buffers organized in size classes.
+ *
+ * The pool keeps released buffers in a bounded set of slots per size class (64 B, 256 B, 1 KiB ... 1 MiB) and gives
+ * them back on the next acquisition of the same class, so the steady state of a request/reply loop does not touch
+ * the heap allocator. Acquire and release only use atomic exchanges over the slots, so the pool can be shared by any
+ * number of threads without locks. When a class has no cached buffer a new one is allocated (a miss), and when all
+ * the slots of a class are full the released buffer is freed (a discard). Requests bigger than the largest class are
+ * served directly from the heap.
+ *
+ * The buffers are handed out as `PooledBytes`, a unique pointer whose deleter returns the storage to the pool, so
+ * their lifetime is managed automatically.
+ *
+ * Usage Example:
+ *
+ * @code{.cpp}
+ *   BufferPool::PooledBytes buffer = BufferPool::defaultPool().acquire(params_size);
+ *   std::memcpy(buffer.get(), params, params_size);
+ *   // The buffer returns to the pool when it goes out of scope.
+ * @endcode
+ *
+ * @warning The pool must outlive all the buffers acquired from it. The default pool is never destroyed, so its
+ *          buffers can be released at any time, even from static destructors.
+ */
+class BufferPool
+{
+public:
+
+    // -----------------------------------------------------------------------------------------------------------------
+    using SizeUnit = std::uint64_t;                            ///< Alias for the size unit.
+    // -----------------------------------------------------------------------------------------------------------------
+
+    static constexpr std::uint32_t kNumClasses = 8;             ///< Number of size classes.
+    static constexpr SizeUnit kMinClassSize = 64;               ///< Size of the smallest class (each class is x4).
+    static constexpr std::uint32_t kNoClass = kNumClasses;      ///< Class of the buffers not managed by the pool.
+    static constexpr std::size_t kDefaultSlotsPerClass = 64;    ///< Default cached buffers per class.
+
+    /// Deleter that returns the buffers to their pool.
+    struct Deleter
+    {
+        BufferPool* pool = nullptr;          ///< Owner pool (null for heap buffers).
+        std::uint32_t size_class = kNoClass; ///< Size class of the buffer.
+
+        void operator()(std::byte* ptr) const noexcept
+        {
+            if (this->pool && this->size_class < kNumClasses)
+                this->pool->release(ptr, this->size_class);
+            else
+                delete[] ptr;
+        }
+    };
+
+    using PooledBytes = std::unique_ptr<std::byte[], Deleter>;  ///< Alias for the pooled bytes smart pointer.
+
+    /// Snapshot of the pool counters.
+    struct Stats
+    {
+        std::uint64_t hits;        ///< Acquisitions served with a cached buffer.
+        std::uint64_t misses;      ///< Acquisitions that needed a new allocation (oversize included).
+        std::uint64_t oversize;    ///< Acquisitions bigger than the largest class.
+        std::uint64_t discards;    ///< Released buffers freed because the slots of their class were full.
+        std::uint64_t in_use;      ///< Buffers currently handed out (oversize not included).
+        std::uint64_t high_water;  ///< Maximum number of buffers handed out at the same time.
+    };
+
+    /**
+     * @brief Construct a new pool.
+     * @param slots_per_class Maximum number of cached buffers for each size class.
+     */
+    explicit BufferPool(std::size_t slots_per_class = kDefaultSlotsPerClass) :
+        slots_per_class_(slots_per_class ? slots_per_class : 1)
+    {
+        for (std::uint32_t size_class = 0; size_class < kNumClasses; size_class++)
+        {
+            this->slots_[size_class].reset(new std::atomic<std::byte*>[this->slots_per_class_]);
+            for (std::size_t i = 0; i < this->slots_per_class_; i++)
+                this->slots_[size_class][i].store(nullptr, std::memory_order_relaxed);
+            this->deleters_[size_class] = Deleter{this, size_class};
+        }
+    }
+
+    BufferPool(const BufferPool&) = delete;
+
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    BufferPool(BufferPool&&) = delete;
+
+    BufferPool& operator=(BufferPool&&) = delete;
+
+    /**
+     * @brief Destructor. Frees all the cached buffers.
+     */
+    ~BufferPool()
+    {
+        this->trim();
+    }
+
+    /**
+     * @brief Get the process wide default pool.
+     *
+     * The pool is intentionally leaked, so the buffers released after the static destructors started (for example,
+     * by other static objects or by detached threads) still find it alive.
+     *
+     * @return Reference to the default pool.
+     */
+    static BufferPool& defaultPool()
+    {
+        static BufferPool& pool = *new BufferPool();
+        return pool;
+    }
+
+    /**
+     * @brief Get the size of the buffers of a class.
+     * @param size_class The size class.
+     * @return The size in bytes.
+     */
+    static constexpr SizeUnit classSize(std::uint32_t size_class)
+    {
+        return kMinClassSize << (2 * size_class);
+    }
+
+    /**
+     * @brief Get the smallest class able to store the given size.
+     * @param size The size in bytes.
+     * @return The size class, or kNoClass if the size is bigger than the largest class.
+     */
+    static constexpr std::uint32_t sizeClassFor(SizeUnit size)
+    {
+        for (std::uint32_t size_class = 0; size_class < kNumClasses; size_class++)
+            if (size <= BufferPool::classSize(size_class))
+                return size_class;
+        return kNoClass;
+    }
+
+    /**
+     * @brief Acquire a buffer of at least the given size.
+     * @param size The required size in bytes.
+     * @return The buffer. Its capacity is the size of its class (or exactly @a size for oversize requests).
+     */
+    PooledBytes acquire(SizeUnit size)
+    {
+        const std::uint32_t size_class = BufferPool::sizeClassFor(size);
+
+        // Oversize requests go directly to the heap.
+        if (size_class == kNoClass)
+        {
+            this->oversize_.fetch_add(1, std::memory_order_relaxed);
+            this->misses_.fetch_add(1, std::memory_order_relaxed);
+            return PooledBytes(new std::byte[size], Deleter{nullptr, kNoClass});
+        }
+
+        // Count the buffer as in use and update the high-water mark.
+        const std::uint64_t in_use = this->in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::uint64_t high = this->high_water_.load(std::memory_order_relaxed);
+        while (in_use > high && !this->high_water_.compare_exchange_weak(high, in_use, std::memory_order_relaxed)){}
+
+        // Try to take a cached buffer, starting from a rotating position to spread the contention.
+        auto& slots = this->slots_[size_class];
+        const std::size_t start = this->hints_[size_class].fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < this->slots_per_class_; i++)
+        {
+            auto& slot = slots[(start + i) % this->slots_per_class_];
+            if (slot.load(std::memory_order_relaxed) == nullptr)
+                continue;
+            std::byte* ptr = slot.exchange(nullptr, std::memory_order_acquire);
+            if (ptr)
+            {
+                this->hits_.fetch_add(1, std::memory_order_relaxed);
+                return PooledBytes(ptr, Deleter{this, size_class});
+            }
+        }
+
+        // No cached buffer, allocate a new one.
+        this->misses_.fetch_add(1, std::memory_order_relaxed);
+        return PooledBytes(new std::byte[BufferPool::classSize(size_class)], Deleter{this, size_class});
+    }
+
+    /**
+     * @brief Get a stable pointer to the deleter of a buffer.
+     *
+     * Useful to release pooled buffers through C style callbacks that only carry a `void*` hint (for example, the
+     * free function of a zero-copy ZeroMQ message) without allocating a deleter for each buffer.
+     *
+     * @param buffer The pooled buffer.
+     * @return Pointer to a deleter equivalent to the one of the buffer, or null for heap buffers.
+     */
+    const Deleter* stableDeleter(const PooledBytes& buffer) const
+    {
+        const Deleter& deleter = buffer.get_deleter();
+        if (deleter.pool != this || deleter.size_class >= kNumClasses)
+            return nullptr;
+        return &this->deleters_[deleter.size_class];
+    }
+
+    /**
+     * @brief Get a snapshot of the pool counters.
+     * @return The counters.
+     */
+    Stats getStats() const
+    {
+        return Stats{this->hits_.load(std::memory_order_relaxed),
+                     this->misses_.load(std::memory_order_relaxed),
+                     this->oversize_.load(std::memory_order_relaxed),
+                     this->discards_.load(std::memory_order_relaxed),
+                     this->in_use_.load(std::memory_order_relaxed),
+                     this->high_water_.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief Free all the cached buffers. The buffers in use are not affected.
+     */
+    void trim()
+    {
+        for (auto& slots : this->slots_)
+            for (std::size_t i = 0; i < this->slots_per_class_; i++)
+                delete[] slots[i].exchange(nullptr, std::memory_order_acquire);
+    }
+
+private:
+
+    // Return a buffer to its class, or free it if all the slots are full.
+    void release(std::byte* ptr, std::uint32_t size_class) noexcept
+    {
+        this->in_use_.fetch_sub(1, std::memory_order_relaxed);
+        auto& slots = this->slots_[size_class];
+        const std::size_t start = this->hints_[size_class].load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < this->slots_per_class_; i++)
+        {
+            auto& slot = slots[(start + i) % this->slots_per_class_];
+            std::byte* expected = nullptr;
+            if (slot.load(std::memory_order_relaxed) == nullptr &&
+                slot.compare_exchange_strong(expected, ptr, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+        this->discards_.fetch_add(1, std::memory_order_relaxed);
+        delete[] ptr;
+    }
+
+    // Slots and rotating start positions of each class.
+    std::array<std::unique_ptr<std::atomic<std::byte*>[]>, kNumClasses> slots_;
+    std::array<std::atomic<std::size_t>, kNumClasses> hints_ {};
+    std::array<Deleter, kNumClasses> deleters_;
+    const std::size_t slots_per_class_;
+
+    // Counters.
+    std::atomic<std::uint64_t> hits_ {0};
+    std::atomic<std::uint64_t> misses_ {0};
+    std::atomic<std::uint64_t> oversize_ {0};
+    std::atomic<std::uint64_t> discards_ {0};
+    std::atomic<std::uint64_t> in_use_ {0};
+    std::atomic<std::uint64_t> high_water_ {0};
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
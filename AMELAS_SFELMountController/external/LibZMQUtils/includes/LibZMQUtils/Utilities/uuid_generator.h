@@ -24,7 +24,7 @@
 
 /** ********************************************************************************************************************
  * @file uuid_generator.h
- * @brief This file contains the declaration of the UUIDGenerator class.
+ * @brief This file contains the declaration of the UUID, UUIDGenerator and ThreadLocalUUIDGenerator classes.
  * @author Degoras Project Team
  * @copyright EUPL License
  * @version 2309.5
@@ -37,10 +37,16 @@
 // C++ INCLUDES
 // =====================================================================================================================
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <functional>
 #include <mutex>
 #include <random>
 #include <set>
 #include <array>
+#include <string>
+#include <thread>
 // =====================================================================================================================
 
 // ZMQUTILS INCLUDES
@@ -63,6 +69,7 @@ class UUID
 public:
 
     LIBZMQUTILS_EXPORT static inline constexpr unsigned kUUIDSize = 16;  ///< UUID bytes size.
+    static inline constexpr unsigned kRFC4122Size = 36;                  ///< UUID string representation size.
 
     /**
      * @brief Construct a new UUID object from an array of 16 bytes.
@@ -102,10 +109,46 @@ public:
      */
     LIBZMQUTILS_EXPORT std::string toRFC4122String() const;
 
+    /**
+     * @brief Writes the string representation of the UUID in a buffer.
+     *
+     * Same format as toRFC4122String, but each byte is converted with a lookup table instead of a string stream, so
+     * there are no allocations nor locale accesses. Exactly kRFC4122Size characters are written (no null terminator).
+     *
+     * @param dest Destination buffer (at least kRFC4122Size characters).
+     */
+    void writeRFC4122(char* dest) const
+    {
+        static constexpr char kHexDigits[] = "0123456789abcdef";
+        for (unsigned i = 0; i < kUUIDSize; i++)
+        {
+            if (i == 4 || i == 6 || i == 8 || i == 10)
+                *dest++ = '-';
+            const auto byte = static_cast<unsigned>(this->bytes_[i]);
+            *dest++ = kHexDigits[byte >> 4];
+            *dest++ = kHexDigits[byte & 0x0F];
+        }
+    }
+
+    /**
+     * @brief Returns string representation of the UUID (same result as toRFC4122String, using writeRFC4122).
+     * @return String representation of the UUID
+     */
+    std::string toRFC4122StringFast() const
+    {
+        std::string result(kRFC4122Size, '\0');
+        this->writeRFC4122(&result[0]);
+        return result;
+    }
+
     LIBZMQUTILS_EXPORT const std::array<std::byte, 16>& getBytes() const;
 
     LIBZMQUTILS_EXPORT bool operator<(const UUID& rhs) const;
 
+    bool operator==(const UUID& rhs) const {return this->bytes_ == rhs.bytes_;}
+
+    bool operator!=(const UUID& rhs) const {return this->bytes_ != rhs.bytes_;}
+
 private:
 
     // Members.
@@ -139,6 +182,9 @@ private:
  * @warning This class relies on std::random_device for random number generation. On some platforms, this does not
  * actually provide a non-deterministic random number generator. In such cases, the randomness of the generated UUIDs
  * may be weaker and a random seed will be generated using a timestamp.
+ *
+ * @warning All the generated UUIDs are stored in a set during the whole life of the process, and each generation takes
+ * a global mutex. For long running processes or many threads, use ThreadLocalUUIDGenerator instead.
  */
 class UUIDGenerator
 {
@@ -173,5 +219,146 @@ private:
     std::set<UUID> generated_uuids_;  ///< Set of all generated UUIDs to ensure uniqueness.
 };
 
+/**
+ * @class ThreadLocalUUIDGenerator
+ *
+ * @brief Lock free generator of version 4 UUIDs (RFC 4122) with per thread state.
+ *
+ * Each thread has its own xoshiro256** generator (256 bits of state, 64 random bits per step), created the first time
+ * the thread generates a UUID. So the generation takes no lock, shares no cache lines between threads and keeps no
+ * memory of the previous UUIDs. The uniqueness relies on the 122 random bits of each UUID (a collision is expected
+ * only after about 2^61 UUIDs), instead of a set of all the generated ones as in UUIDGenerator.
+ *
+ * The state of each thread is seeded mixing std::random_device with the time, the thread id and the state address,
+ * so the threads get different streams even on platforms where std::random_device is deterministic.
+ *
+ * @note The class is thread safe.
+ *
+ * @note The generator is not cryptographically secure: the UUIDs must not be used as secrets.
+ */
+class ThreadLocalUUIDGenerator
+{
+public:
+
+    /**
+     * @brief Generates a version 4 UUID
+     * @return A random UUID
+     */
+    static UUID generateUUIDv4()
+    {
+        std::array<std::byte, UUID::kUUIDSize> bytes;
+        ThreadLocalUUIDGenerator::generateBytes(bytes);
+        return UUID(bytes);
+    }
+
+    /**
+     * @brief Generates the bytes of a version 4 UUID (version and variant bits already set).
+     * @param bytes Destination bytes.
+     */
+    static void generateBytes(std::array<std::byte, UUID::kUUIDSize>& bytes)
+    {
+        State& state = ThreadLocalUUIDGenerator::getState();
+        const std::uint64_t words[2] = {state.next(), state.next()};
+        std::memcpy(bytes.data(), words, sizeof(words));
+        bytes[6] = (bytes[6] & std::byte{0x0F}) | std::byte{0x40};
+        bytes[8] = (bytes[8] & std::byte{0x3F}) | std::byte{0x80};
+    }
+
+    ThreadLocalUUIDGenerator() = delete;
+
+private:
+
+    // xoshiro256** state of a thread.
+    struct State
+    {
+        State()
+        {
+            // Entropy sources. The random device can fail or be deterministic in some platforms.
+            std::uint64_t seed = static_cast<std::uint64_t>(
+                std::chrono::high_resolution_clock::now().time_since_epoch().count());
+            seed ^= static_cast<std::uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) << 17;
+            seed ^= static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(this));
+            std::uint64_t device_bits[4] = {};
+            try
+            {
+                std::random_device device;
+                for (std::uint64_t& bits : device_bits)
+                    bits = (static_cast<std::uint64_t>(device()) << 32) ^ device();
+            }
+            catch (...) {}
+
+            // Expand the seed with splitmix64 (never gives an all zero state).
+            for (unsigned i = 0; i < 4; i++)
+            {
+                seed += 0x9E3779B97F4A7C15ULL;
+                std::uint64_t value = seed ^ device_bits[i];
+                value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+                this->s[i] = value ^ (value >> 31);
+            }
+            if ((this->s[0] | this->s[1] | this->s[2] | this->s[3]) == 0)
+                this->s[0] = 0x9E3779B97F4A7C15ULL;
+        }
+
+        std::uint64_t next()
+        {
+            const std::uint64_t result = State::rotl(this->s[1] * 5, 7) * 9;
+            const std::uint64_t t = this->s[1] << 17;
+            this->s[2] ^= this->s[0];
+            this->s[3] ^= this->s[1];
+            this->s[1] ^= this->s[2];
+            this->s[0] ^= this->s[3];
+            this->s[2] ^= t;
+            this->s[3] = State::rotl(this->s[3], 45);
+            return result;
+        }
+
+        static std::uint64_t rotl(std::uint64_t value, int bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        std::uint64_t s[4];
+    };
+
+    static State& getState()
+    {
+        thread_local State state;
+        return state;
+    }
+};
+
 }} // END NAMESPACES.
 // =====================================================================================================================
+
+// STD SPECIALIZATIONS
+// =====================================================================================================================
+namespace std{
+
+/**
+ * @brief Hash of a UUID, so it can be used as key of the unordered containers.
+ *
+ * The two 64 bits halves are combined and mixed with the MurmurHash3 finalizer, so all the bits of the UUID affect the
+ * low bits of the hash (also for the non random UUIDs). The hash is not seeded: for keys chosen by remote peers, use a
+ * seeded hash instead.
+ */
+template<>
+struct hash<zmqutils::utils::UUID>
+{
+    std::size_t operator()(const zmqutils::utils::UUID& uuid) const noexcept
+    {
+        std::uint64_t low, high;
+        std::memcpy(&low, uuid.getBytes().data(), sizeof(low));
+        std::memcpy(&high, uuid.getBytes().data() + sizeof(low), sizeof(high));
+        std::uint64_t value = low ^ ((high << 32) | (high >> 32)) ^ (high * 0x9E3779B97F4A7C15ULL);
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDULL;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ULL;
+        value ^= value >> 33;
+        return static_cast<std::size_t>(value);
+    }
+};
+
+} // END NAMESPACE STD.
+// =====================================================================================================================
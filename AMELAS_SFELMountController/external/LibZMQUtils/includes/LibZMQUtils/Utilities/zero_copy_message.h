@@ -0,0 +1,198 @@
+/***********************************************************************************************************************
+ *   LibZMQUtils (ZMQ Utilitites Library): A libre library with ZMQ related useful utilities.                          *
+ *                                                                                                                     *
+ *   Copyright (C) 2023 Degoras Project Team                                                                           *
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >                             *
+ *                      < Jesús Relinque Madroñal >                                                                    *
+ *                                                                                                                     *
+ *   This file is part of LibZMQUtils.                                                                                 *
+ *                                                                                                                     *
+ *   Licensed under the European Union Public License (EUPL), Version 1.2 or subsequent versions of the EUPL license   *
+ *   as soon they will be approved by the European Commission (IDABC).                                                 *
+ *                                                                                                                     *
+ *   This project is free software: you can redistribute it and/or modify it under the terms of the EUPL license as    *
+ *   published by the IDABC, either Version 1.2 or, at your option, any later version.                                 *
+ *                                                                                                                     *
+ *   This project is distributed in the hope that it will be useful. Unless required by applicable law or agreed to in *
+ *   writing, it is distributed on an "AS IS" basis, WITHOUT ANY WARRANTY OR CONDITIONS OF ANY KIND; without even the  *
+ *   implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the EUPL license to check specific   *
+ *   language governing permissions and limitations and more details.                                                  *
+ *                                                                                                                     *
+ *   You should use this project in compliance with the EUPL license. You should have received a copy of the license   *
+ *   along with this project. If not, see the license at < https://eupl.eu/ >.                                         *
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file zero_copy_message.h
+ * @brief This file contains helpers to build and consume ZeroMQ messages without copying the payload.
+ * @author Degoras Project Team
+ * @copyright EUPL License
+ * @version 2309.5
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <zmq/zmq.hpp>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include "LibZMQUtils/Utilities/buffer_pool.h"
+// =====================================================================================================================
+
+// ZMQUTILS NAMESPACES
+// =====================================================================================================================
+namespace zmqutils{
+namespace utils{
+// =====================================================================================================================
+
+// Free functions used by libzmq when it releases the zero-copy message storage.
+namespace zerocopy_internal
+{
+    inline void freeHeapBytes(void* data, void*)
+    {
+        delete[] static_cast<std::byte*>(data);
+    }
+
+    inline void freePooledBytes(void* data, void* hint)
+    {
+        (*static_cast<const BufferPool::Deleter*>(hint))(static_cast<std::byte*>(data));
+    }
+}
+
+/**
+ * @brief Build a ZeroMQ message that takes the ownership of a heap buffer without copying it.
+ *
+ * The storage is handed to libzmq through `zmq_msg_init_data` and released with `delete[]` once the message has
+ * been sent (or destroyed).
+ *
+ * @param data The buffer with the payload. It is released from the smart pointer.
+ * @param size The size of the payload.
+ * @return The message. An empty message if @a data is null or @a size is 0.
+ * @throw zmq::error_t If libzmq can't initialize the message (the buffer stays owned by @a data).
+ */
+inline zmq::message_t makeZeroCopyMessage(std::unique_ptr<std::byte[]>&& data, std::size_t size)
+{
+    if (!data || size == 0)
+    {
+        data.reset();
+        return zmq::message_t();
+    }
+    zmq::message_t msg(data.get(), size, &zerocopy_internal::freeHeapBytes, nullptr);
+    data.release();
+    return msg;
+}
+
+/**
+ * @brief Build a ZeroMQ message that takes the ownership of a pooled buffer without copying it.
+ *
+ * The storage is handed to libzmq through `zmq_msg_init_data` and returned to its BufferPool once the message has
+ * been sent (or destroyed). No allocation is done for the release callback.
+ *
+ * @param data The pooled buffer with the payload. It is released from the smart pointer.
+ * @param size The size of the payload (can be smaller than the buffer capacity).
+ * @return The message. An empty message if @a data is null or @a size is 0.
+ * @throw zmq::error_t If libzmq can't initialize the message (the buffer stays owned by @a data).
+ */
+inline zmq::message_t makeZeroCopyMessage(BufferPool::PooledBytes&& data, std::size_t size)
+{
+    if (!data || size == 0)
+    {
+        data.reset();
+        return zmq::message_t();
+    }
+    const BufferPool* pool = data.get_deleter().pool;
+    const BufferPool::Deleter* deleter = pool ? pool->stableDeleter(data) : nullptr;
+    zmq::message_t msg = deleter ?
+        zmq::message_t(data.get(), size, &zerocopy_internal::freePooledBytes, const_cast<BufferPool::Deleter*>(deleter)) :
+        zmq::message_t(data.get(), size, &zerocopy_internal::freeHeapBytes, nullptr);
+    data.release();
+    return msg;
+}
+
+/**
+ * @class BorrowedBytes
+ *
+ * @brief Read-only view over the payload of a received ZeroMQ message, which keeps the message alive.
+ *
+ * Instead of copying the payload of a received frame into a new buffer, the message is moved into this object and its
+ * storage is read in place (for example, with a LocalBinarySerializer in borrowed mode). Use `toUnique` only when a
+ * legacy interface needs an owned copy.
+ */
+class BorrowedBytes
+{
+public:
+
+    BorrowedBytes() = default;
+
+    /**
+     * @brief Construct the view taking the ownership of a received message.
+     * @param msg The received message.
+     */
+    explicit BorrowedBytes(zmq::message_t&& msg) :
+        msg_(std::move(msg))
+    {}
+
+    /**
+     * @brief Get a pointer to the payload.
+     * @return Pointer to the payload, or null if it is empty.
+     */
+    const std::byte* data() const
+    {
+        return this->msg_.size() ? this->msg_.data<std::byte>() : nullptr;
+    }
+
+    /**
+     * @brief Get the size of the payload.
+     * @return The size in bytes.
+     */
+    std::size_t size() const
+    {
+        return this->msg_.size();
+    }
+
+    /**
+     * @brief Check if the payload is empty.
+     * @return True if there is no payload.
+     */
+    bool empty() const
+    {
+        return this->msg_.size() == 0;
+    }
+
+    /**
+     * @brief Copy the payload into a new owned buffer.
+     * @return The owned copy, or null if the payload is empty.
+     */
+    std::unique_ptr<std::byte[]> toUnique() const
+    {
+        if (this->empty())
+            return nullptr;
+        std::unique_ptr<std::byte[]> copy(new std::byte[this->size()]);
+        std::memcpy(copy.get(), this->data(), this->size());
+        return copy;
+    }
+
+    /**
+     * @brief Get the underlying message.
+     * @return Reference to the message.
+     */
+    zmq::message_t& message()
+    {
+        return this->msg_;
+    }
+
+private:
+
+    zmq::message_t msg_;  ///< Received message that owns the payload storage.
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -27,7 +27,11 @@
 
 // C++ INCLUDES
 // =====================================================================================================================
+#include <array>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 // =====================================================================================================================
 
@@ -40,6 +44,11 @@
 // PROJECT INCLUDES
 // =====================================================================================================================
 #include "common.h"
+#include "control_loop.h"
+#include "mount_simulator.h"
+#include "pointing_model.h"
+#include "trajectory_interpolator.h"
+#include "AmelasUtils/seqlock.h"
 #include "libamelas_global.h"
 // =====================================================================================================================
 
@@ -55,16 +64,161 @@ public:
 
     LIBAMELAS_EXPORT AmelasController();
 
+    LIBAMELAS_EXPORT ~AmelasController();
+
     LIBAMELAS_EXPORT AmelasError setHomePosition(const AltAzPos& pos);
 
     LIBAMELAS_EXPORT AmelasError getHomePosition(AltAzPos& pos);
 
     LIBAMELAS_EXPORT AmelasError getDatetime(std::string&);
 
+    // Get the mount state. It reads a seqlock snapshot, so it never blocks (and it is never blocked by) the writers
+    // and it can be called from any thread without the controller lock.
+    LIBAMELAS_EXPORT AmelasError getMountState(MountState& state);
+
+    // Get the raw mount state block (lock-free snapshot).
+    MountStateBlock getMountStateBlock() const {return this->state_.load();}
+
+    // Trajectory upload: begin (total samples), chunks (in order) and commit (checksum of all the samples). Beginning
+    // a new upload discards the previous one. The active trajectory is only replaced after a successful commit.
+    LIBAMELAS_EXPORT AmelasError beginTrajectoryUpload(std::uint32_t samples);
+
+    LIBAMELAS_EXPORT AmelasError uploadTrajectoryChunk(const TrajectoryChunk& chunk);
+
+    LIBAMELAS_EXPORT AmelasError commitTrajectoryUpload(std::uint32_t checksum);
+
+    // Set the interpolation used for the trajectories. The active trajectory is prepared again.
+    LIBAMELAS_EXPORT AmelasError setInterpolation(InterpolationMethod method, unsigned order);
+
+    // Get the interpolated trajectory position at a time (UTC nanoseconds), with the pointing model applied.
+    LIBAMELAS_EXPORT AmelasError getTrajectoryPosition(std::int64_t time, AltAzPos& pos);
+
+    // Pointing models. The models are loaded in slots and the active one is switched atomically, correcting again the
+    // active trajectory. Loading the model of the active slot also switches it. The home position is a mount position,
+    // so it is not corrected.
+    LIBAMELAS_EXPORT AmelasError loadPointingModel(std::uint32_t slot, const PointingModel& model);
+
+    LIBAMELAS_EXPORT AmelasError setPointingModel(std::uint32_t slot);
+
+    // Get the active pointing model. Can be called from any thread.
+    LIBAMELAS_EXPORT std::shared_ptr<const PointingModel> getPointingModel() const;
+
+    // Track the active trajectory with a simulated mount (paced by its clock), publishing the simulated states as the
+    // mount state (only while the control loop is not running, the loop drives the mount). It blocks until the end of
+    // the trajectory, so it is intended for tests and benchmarks.
+    LIBAMELAS_EXPORT AmelasError simulateTrajectory(MountSimulator& simulator, TrackingStats& stats);
+
+    // Control loop. Each cycle evaluates the active trajectory at the scheduled time and sends the setpoint to the
+    // mount. The stats (wake-up latency, execution time and missed deadlines) can be read from any thread.
+    LIBAMELAS_EXPORT bool startControlLoop(const ControlLoopConfig& config = ControlLoopConfig());
+
+    LIBAMELAS_EXPORT void stopControlLoop();
+
+    LIBAMELAS_EXPORT AmelasError getControlLoopStats(ControlLoopStats& stats);
+
+    // Mount state ring. While it is enabled, each update of the mount state is also published as a frame in a shared
+    // memory ring (MountStateRingReader), so the local consumers get every sample without sockets. Enabling it again
+    // replaces the ring (the readers of the previous one see it closed).
+    LIBAMELAS_EXPORT bool enableStateRing(const std::string& name = kDefaultStateRingName,
+                                          std::size_t capacity = kDefaultStateRingCapacity);
+
+    LIBAMELAS_EXPORT void disableStateRing();
+
 private:
 
-    AltAzPos home_pos_;
+    // Holder of the mount state writer role. The mount state has a single writer: the control loop or a simulation
+    // while they run, otherwise the command threads one at a time. The commands hand the home position and the ring
+    // changes to the writer, so the control loop never waits for other threads.
+    enum class StateWriter : std::uint32_t
+    {
+        NONE,
+        COMMAND,
+        CONTROL_LOOP,
+        SIMULATION
+    };
+
+    // Home position, written by the commands and merged in the mount state by the state writer.
+    struct HomeBlock
+    {
+        double az = -1.0;
+        double el = -1.0;
+    };
+
+    // Take the state writer role. It only waits for the commands (short updates); returns false if the control loop
+    // or a simulation holds it.
+    bool acquireStateWriter(StateWriter writer);
+
+    void releaseStateWriter();
+
+    // Update the mount state and publish it in the state ring (if enabled). Only for the state writer.
+    template <typename F>
+    void updateState(F&& function);
+
+    // Apply the home position and ring changes requested by the commands. Only for the state writer.
+    void applyStateRequests();
+
+    bool hasStateRequests() const;
+
+    // Apply the requests as the state writer if it is free, otherwise wait until the holder applies them.
+    void syncStateRequests();
+
+    // Hand a new state ring (or none) to the state writer and close the previous one (the caller holds the ring
+    // mutex).
+    void replaceStateRing(std::unique_ptr<MountStateRingWriter> ring);
+
+    // Control loop cycle (executed in the loop thread).
+    void controlCycle(std::int64_t time, std::uint64_t cycle);
+
+    // Apply the pointing model to a trajectory and prepare the interpolator with the mount trajectory.
+    AmelasError prepareTrajectory(const TrajectoryBuffer& trajectory, const PointingModel& model,
+                                  InterpolationMethod method, unsigned order);
+
+    // Mount state (position, velocity, status, errors and home), published with a single writer seqlock. The writer
+    // keeps its own copy of the block, only accessed by the holder of the writer role.
+    utils::SeqLock<MountStateBlock> state_;
+    MountStateBlock writer_state_;
+    std::atomic<StateWriter> state_writer_;
+
+    // Home position (the commands are serialized with the mutex) and its version applied by the state writer.
+    utils::SeqLock<HomeBlock> home_;
+    std::atomic<std::uint64_t> home_applied_;
+    std::mutex home_mtx_;
+
+    // Mount state ring, only used by the state writer. The commands leave the new ring in the request slot and the
+    // writer swaps it with the active one, leaving the previous ring in the slot to be closed by the command.
+    std::unique_ptr<MountStateRingWriter> state_ring_;
+    std::unique_ptr<MountStateRingWriter> state_ring_request_;
+    std::atomic_bool state_ring_pending_;
+    std::mutex state_ring_mtx_;
+
+    // Active trajectory and upload staging buffer (swapped on commit).
+    TrajectoryBuffer trajectory_;
+    TrajectoryBuffer upload_buffer_;
+    std::size_t upload_expected_;
+    std::uint32_t upload_checksum_;
+    bool upload_active_;
+
+    // Trajectory interpolation. The interpolator is prepared with the mount trajectory (pointing model applied) and
+    // published with the atomic shared_ptr functions, so the control loop never sees a partially prepared one.
+    std::shared_ptr<const TrajectoryInterpolator> interpolator_;
+    std::atomic<std::uint64_t> interpolator_version_;
+    InterpolationMethod interp_method_;
+    unsigned interp_order_;
+    TrajectoryBuffer mount_trajectory_;
+
+    // Pointing models (immutable, the active one is accessed with the atomic shared_ptr functions).
+    std::array<std::shared_ptr<const PointingModel>, kPointingModelSlots> pointing_slots_;
+    std::shared_ptr<const PointingModel> pointing_model_;
+    std::uint32_t pointing_slot_;
 
+    // Control loop and its private state (only accessed from the loop thread). The loop is the last member, so it is
+    // stopped before destroying the rest.
+    std::shared_ptr<const TrajectoryInterpolator> loop_interpolator_;
+    std::uint64_t loop_version_;
+    AltAzPos loop_setpoint_;
+    std::int64_t loop_time_;
+    bool loop_tracking_;
+    ControlLoop control_loop_;
 };
 
 }} // END NAMESPACES.
@@ -27,11 +27,13 @@
 
 // C++ INCLUDES
 // =====================================================================================================================
+#include <array>
 #include <string>
 #include <map>
 #include <vector>
 #include <variant>
 #include <functional>
+#include <cstdint>
 // =====================================================================================================================
 
 // ZMQUTILS INCLUDES
@@ -41,6 +43,7 @@
 
 // PROJECT INCLUDES
 // =====================================================================================================================
+#include "AmelasUtils/shm_ring.h"
 #include "libamelas_global.h"
 // =====================================================================================================================
 
@@ -52,6 +55,8 @@ namespace controller{
 
 // CONSTANTS
 // =====================================================================================================================
+constexpr std::size_t kMaxTrajectorySamples = 131072;      ///< Trajectory capacity (a full day at 1 Hz fits).
+constexpr std::size_t kMaxTrajectoryChunkSamples = 2048;   ///< Maximum samples in each uploaded chunk.
 // =====================================================================================================================
 
 // CONVENIENT ALIAS, ENUMERATIONS AND CONSTEXPR
@@ -64,14 +69,26 @@ enum class AmelasError : std::int32_t
     INVALID_ERROR = -1,
     SUCCESS = 0,
     INVALID_POSITION = 1,
-    UNSAFE_POSITION = 2
+    UNSAFE_POSITION = 2,
+    INVALID_TRAJECTORY = 3,
+    TRAJECTORY_CHECKSUM_ERROR = 4,
+    NO_TRAJECTORY_UPLOAD = 5,
+    INVALID_INTERPOLATION = 6,
+    OUT_OF_TRAJECTORY = 7,
+    INVALID_POINTING_MODEL = 8
 };
 
-static constexpr std::array<const char*, 3>  ControllerErrorStr
+static constexpr std::array<const char*, 9>  ControllerErrorStr
 {
     "SUCCESS - Controller process success",
     "INVALID_POSITION - The provided position (az/alt) is invalid.",
-    "UNSAFE_POSITION - The provided position (az/alt) is unsafe."
+    "UNSAFE_POSITION - The provided position (az/alt) is unsafe.",
+    "INVALID_TRAJECTORY - The provided trajectory (size, order or samples) is invalid.",
+    "TRAJECTORY_CHECKSUM_ERROR - The uploaded trajectory checksum does not match.",
+    "NO_TRAJECTORY_UPLOAD - There is no trajectory upload in progress.",
+    "INVALID_INTERPOLATION - The interpolation method or order is invalid.",
+    "OUT_OF_TRAJECTORY - There is no active trajectory for the requested time.",
+    "INVALID_POINTING_MODEL - The pointing model (slot or terms) is invalid."
 };
 
 struct AltAzPos final : public zmqutils::utils::Serializable
@@ -96,6 +113,86 @@ struct AltAzPos final : public zmqutils::utils::Serializable
     double el;
 };
 
+// Mount status.
+enum class MountStatus : std::int32_t
+{
+    IDLE     = 0,
+    SLEWING  = 1,
+    TRACKING = 2,
+    FAULT    = 3
+};
+
+static constexpr std::array<const char*, 4> MountStatusStr
+{
+    "IDLE",
+    "SLEWING",
+    "TRACKING",
+    "FAULT"
+};
+
+// Mount state block shared between its single writer (control loop, simulation or commands) and the readers
+// (telemetry, request workers, logger). It is trivially copyable, so it is published with a seqlock and read without
+// locks.
+struct MountStateBlock
+{
+    std::int64_t timestamp = 0;                ///< Time of the last update (UTC nanoseconds since epoch).
+    double az = -1.0;                          ///< Current mount azimuth (degrees).
+    double el = -1.0;                          ///< Current mount elevation (degrees).
+    double az_rate = 0.0;                      ///< Current azimuth velocity (degrees per second).
+    double el_rate = 0.0;                      ///< Current elevation velocity (degrees per second).
+    double home_az = -1.0;                     ///< Configured home azimuth (degrees).
+    double home_el = -1.0;                     ///< Configured home elevation (degrees).
+    MountStatus status = MountStatus::IDLE;    ///< Current mount status.
+    AmelasError error = AmelasError::SUCCESS;  ///< Last mount error.
+};
+
+// Snapshot of the mount state.
+struct MountState
+{
+    std::int64_t timestamp = 0;                ///< State time (UTC nanoseconds since epoch).
+    AltAzPos position;                         ///< Current mount position.
+    AltAzPos velocity;                         ///< Current mount velocity (degrees per second).
+    AltAzPos home_position;                    ///< Configured home position.
+    MountStatus status = MountStatus::IDLE;    ///< Current mount status.
+    AmelasError error = AmelasError::SUCCESS;  ///< Last mount error.
+};
+
+// Shared memory ring of mount states for the local consumers (each update of the mount state is a frame).
+constexpr char kDefaultStateRingName[] = "/amelas_mount_state";   ///< Default ring name.
+constexpr std::size_t kDefaultStateRingCapacity = 4096;           ///< Default capacity (4 s at 1 kHz).
+constexpr std::uint64_t kMountStateFrameId = 0x0001;              ///< Frame identifier of the MountStateBlock layout.
+using MountStateRingWriter = utils::ShmRingWriter<MountStateBlock>;
+using MountStateRingReader = utils::ShmRingReader<MountStateBlock>;
+
+// Trajectory storage as a structure of arrays. The arrays are allocated with the full capacity in the constructor, so
+// the uploads never allocate memory.
+struct TrajectoryBuffer
+{
+    LIBAMELAS_EXPORT explicit TrajectoryBuffer(std::size_t capacity = kMaxTrajectorySamples);
+
+    std::size_t capacity() const {return this->timestamps.size();}
+
+    std::vector<std::int64_t> timestamps;   ///< Sample times (UTC nanoseconds since epoch), strictly increasing.
+    std::vector<double> az;                 ///< Sample azimuths (degrees).
+    std::vector<double> el;                 ///< Sample elevations (degrees).
+    std::size_t size = 0;                   ///< Number of valid samples.
+};
+
+// View of an uploaded chunk of trajectory samples (the data is owned by the caller).
+struct TrajectoryChunk
+{
+    std::uint32_t offset = 0;                 ///< Index of the first sample in the trajectory.
+    std::uint32_t count = 0;                  ///< Number of samples in the chunk.
+    const std::int64_t* timestamps = nullptr;
+    const double* az = nullptr;
+    const double* el = nullptr;
+};
+
+// Update the trajectory checksum (CRC-32 of the samples in order, each one as timestamp, az and el in native byte
+// order) with a group of samples. The initial value is 0.
+LIBAMELAS_EXPORT std::uint32_t updateTrajectoryChecksum(std::uint32_t crc, const std::int64_t* timestamps,
+                                                        const double* az, const double* el, std::size_t count);
+
 // Generic callback.
 template<typename... Args>
 using AmelasControllerCallback = controller::AmelasError(AmelasController::*)(Args...);
@@ -104,6 +201,7 @@ using AmelasControllerCallback = controller::AmelasError(AmelasController::*)(Ar
 using SetHomePositionCallback = std::function<AmelasError(const AltAzPos&)>;
 using GetHomePositionCallback = std::function<AmelasError(AltAzPos&)>;
 using GetDatetimeCallback = std::function<AmelasError(std::string&)>;
+using GetMountStateCallback = std::function<AmelasError(MountState&)>;
 
 // =====================================================================================================================
 
@@ -0,0 +1,149 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file control_loop.h
+ * @brief This file contains the declaration of the ControlLoop class (periodic real time executor).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/latency_histogram.h"
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Cycle function: scheduled time of the cycle (UTC nanoseconds since epoch) and cycle number.
+using ControlCycleFunction = std::function<void(std::int64_t, std::uint64_t)>;
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Control loop configuration.
+struct ControlLoopConfig
+{
+    std::int64_t period = 1000000;   ///< Loop period (nanoseconds, 1 kHz).
+    int priority = 80;               ///< SCHED_FIFO priority (1 to 99). 0 keeps the normal scheduling.
+    int cpu = -1;                    ///< CPU of the loop thread (-1 for any).
+    bool lock_memory = true;         ///< Lock the process memory (mlockall) to avoid page faults in the loop.
+};
+
+// Control loop statistics. The wake-up latency is the delay between the scheduled time and the actual wake-up, and
+// the execution time is the duration of the cycle function (nanoseconds).
+struct ControlLoopStats
+{
+    std::int64_t period = 0;                 ///< Loop period (nanoseconds).
+    std::uint64_t cycles = 0;                ///< Executed cycles.
+    std::uint64_t missed_deadlines = 0;      ///< Cycles finished after the start of the next one.
+    std::uint64_t skipped_cycles = 0;        ///< Cycles not executed due to the overruns.
+    bool realtime = false;                   ///< The loop runs with the real time scheduling.
+    bool memory_locked = false;              ///< The process memory is locked.
+    utils::LatencySummary wakeup_latency;    ///< Wake-up latency (jitter) summary.
+    utils::LatencySummary execution_time;    ///< Execution time summary.
+};
+
+/**
+ * @brief Periodic executor for the mount control loop.
+ *
+ * The loop runs in a dedicated thread with absolute deadlines (clock_nanosleep with TIMER_ABSTIME on Linux), so the
+ * period does not drift. When permitted, the thread uses SCHED_FIFO with the configured priority and CPU, and the
+ * process memory is locked with mlockall. If the privileges are missing the loop runs anyway with the normal
+ * scheduling (the stats report it). Before the first cycle the thread prefaults its stack and the histograms.
+ *
+ * After an overrun (a cycle that finishes after the next deadline) the late cycles are skipped and the loop keeps its
+ * phase. Each cycle records the wake-up latency and the execution time in lock-free histograms, so the stats can be
+ * read from any thread at any time without disturbing the loop.
+ *
+ * The cycle function must not allocate or block.
+ */
+class ControlLoop
+{
+public:
+
+    static constexpr std::size_t kPrefaultStackSize = 256 * 1024;   ///< Stack prefaulted by the loop thread (bytes).
+
+    LIBAMELAS_EXPORT ControlLoop();
+
+    ControlLoop(const ControlLoop&) = delete;
+    ControlLoop& operator=(const ControlLoop&) = delete;
+
+    // Start the loop. Returns false if it is already running or the configuration is invalid.
+    LIBAMELAS_EXPORT bool start(const ControlLoopConfig& config, ControlCycleFunction function);
+
+    // Stop the loop and wait for the thread.
+    LIBAMELAS_EXPORT void stop();
+
+    // Get the statistics (can be called from any thread).
+    LIBAMELAS_EXPORT void getStats(ControlLoopStats& stats) const;
+
+    // Clear the statistics (can be called from any thread).
+    LIBAMELAS_EXPORT void resetStats();
+
+    bool isRunning() const {return this->running_.load(std::memory_order_acquire);}
+
+    LIBAMELAS_EXPORT ~ControlLoop();
+
+private:
+
+    // Loop thread.
+    void loopWorker();
+
+    // Apply the real time configuration to the calling thread and lock the memory. Returns true if the thread runs
+    // with the real time scheduling.
+    bool setupRealtime();
+
+    // Configuration and cycle function.
+    ControlLoopConfig config_;
+    ControlCycleFunction function_;
+
+    // Thread and state.
+    std::thread thread_;
+    std::mutex mtx_;
+    std::atomic_bool running_;
+    std::atomic_bool realtime_;
+    std::atomic_bool memory_locked_;
+
+    // Statistics.
+    std::atomic<std::int64_t> period_;
+    std::atomic<std::uint64_t> cycles_;
+    std::atomic<std::uint64_t> missed_;
+    std::atomic<std::uint64_t> skipped_;
+    utils::LatencyHistogram wakeup_hist_;
+    utils::LatencyHistogram exec_hist_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
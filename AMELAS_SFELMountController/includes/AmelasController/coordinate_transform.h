@@ -0,0 +1,165 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file coordinate_transform.h
+ * @brief This file contains the declaration of the CoordinateTransform class (batch RA/Dec to Az/El).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// Station location (geodetic, degrees) and atmospheric conditions for the refraction.
+struct StationLocation
+{
+    double latitude = 0.0;       ///< Latitude (degrees, north positive).
+    double longitude = 0.0;      ///< Longitude (degrees, east positive).
+    double pressure = 1010.0;    ///< Atmospheric pressure (hPa).
+    double temperature = 10.0;   ///< Air temperature (Celsius).
+};
+
+// Corrections applied by the transform. The input coordinates are mean equatorial coordinates of the catalog epoch.
+struct TransformOptions
+{
+    bool precession = true;      ///< IAU 1976 precession from the catalog epoch to the date.
+    bool nutation = true;        ///< IAU 1980 nutation (main terms) and equation of the equinoxes.
+    bool aberration = true;      ///< Annual aberration.
+    bool refraction = true;      ///< Atmospheric refraction (Saemundsson, scaled with the pressure and temperature).
+    double epoch = 2000.0;       ///< Catalog epoch (Julian year).
+    double dut1 = 0.0;           ///< UT1 - UTC (seconds).
+    double tt_utc = 69.184;      ///< TT - UTC (seconds).
+};
+
+// Batch of equatorial coordinates (structure of arrays, degrees).
+struct EquatorialBatch
+{
+    std::vector<double> ra;
+    std::vector<double> dec;
+
+    std::size_t size() const {return this->ra.size();}
+};
+
+// Batch of horizontal coordinates (structure of arrays, degrees).
+struct HorizontalBatch
+{
+    std::vector<double> az;
+    std::vector<double> el;
+
+    std::size_t size() const {return this->az.size();}
+};
+
+/**
+ * @brief Batch transform from equatorial (RA/Dec) to horizontal (Az/El) coordinates.
+ *
+ * All the time dependent quantities (precession, nutation, sidereal time and the Earth velocity) only depend on the
+ * observation time, so `setTime` reduces them to a single rotation matrix and an aberration vector. Then each star
+ * only needs the unit vector, the aberration, the rotation and the conversion back to angles (and the refraction).
+ *
+ * The kernel works over arrays (structure of arrays). When the library is built with AVX2 (AMELAS_ENABLE_AVX2) the
+ * stars are processed in groups of 4 with vectorized sincos and atan2 approximations (the differences with the scalar
+ * version are below 1e-7 arc seconds). The big lists (kParallelThreshold or more stars) are split between several
+ * threads using OpenMP.
+ *
+ * The models are the classical low precision ones (IAU 1976/1980, Sun from the mean elements), so the accuracy is a
+ * few tenths of arc second, enough for pointing. The azimuth is measured from the north towards the east, in [0, 360).
+ *
+ * The transform functions are const and can be called concurrently. The `setTime` function must not be called while
+ * transforming.
+ */
+class CoordinateTransform
+{
+public:
+
+    static constexpr std::size_t kParallelThreshold = 16384;   ///< Minimum stars for the parallel transform.
+    static constexpr std::size_t kParallelBlock = 4096;        ///< Stars processed by each parallel task.
+
+    LIBAMELAS_EXPORT CoordinateTransform(const StationLocation& station = StationLocation(),
+                                         const TransformOptions& options = TransformOptions());
+
+    // Configuration. The time must be set again after changing it.
+    LIBAMELAS_EXPORT void setStation(const StationLocation& station);
+    LIBAMELAS_EXPORT void setOptions(const TransformOptions& options);
+
+    // Compute the time dependent quantities for an observation time (UTC nanoseconds since the Unix epoch).
+    LIBAMELAS_EXPORT void setTime(std::int64_t time);
+
+    // Transform a group of stars (degrees). The threads are only used for the big lists (0 uses all the cores).
+    LIBAMELAS_EXPORT void transform(const double* ra, const double* dec, std::size_t count, double* az, double* el,
+                                    unsigned threads = 1) const;
+
+    LIBAMELAS_EXPORT void transform(const EquatorialBatch& input, HorizontalBatch& output,
+                                    unsigned threads = 1) const;
+
+    // Scalar reference version (the same models using the standard math functions).
+    LIBAMELAS_EXPORT void transformScalar(const double* ra, const double* dec, std::size_t count, double* az,
+                                          double* el) const;
+
+    // Check if the library was built with the vectorized kernel.
+    LIBAMELAS_EXPORT static bool isVectorized();
+
+    const StationLocation& getStation() const {return this->station_;}
+
+    const TransformOptions& getOptions() const {return this->options_;}
+
+    std::int64_t getTime() const {return this->time_;}
+
+    // Apparent local sidereal time of the current time (degrees).
+    double getSiderealTime() const {return this->last_;}
+
+private:
+
+    // Transform a range of stars with the best kernel.
+    void transformRange(const double* ra, const double* dec, std::size_t count, double* az, double* el) const;
+
+    // Vectorized kernel (only available in the AVX2 builds). Returns the number of stars processed (multiple of 4).
+    std::size_t transformAvx2(const double* ra, const double* dec, std::size_t count, double* az, double* el) const;
+
+    // Configuration.
+    StationLocation station_;
+    TransformOptions options_;
+    std::int64_t time_;
+
+    // Time dependent quantities.
+    std::array<double, 9> matrix_;     ///< Mean of epoch to local horizon (north, east, up) rotation, row major.
+    std::array<double, 3> velocity_;   ///< Earth velocity (units of c) in the frame of the catalog.
+    double last_;                      ///< Apparent local sidereal time (degrees).
+    double refraction_scale_;          ///< Pressure and temperature factor of the refraction.
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,237 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file mount_simulator.h
+ * @brief This file contains the declaration of the MountSimulator class and the simulation clocks.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/common.h"
+#include "AmelasController/trajectory_interpolator.h"
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+using SimulationCallback = std::function<void(const MountStateBlock&)>;
+// ---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Clock used to pace the simulations (UTC nanoseconds since epoch).
+ */
+class SimulationClock
+{
+public:
+
+    // Get the current time.
+    virtual std::int64_t now() const = 0;
+
+    // Wait until a time. The virtual clocks advance their time instead of waiting (or wait a scaled time).
+    virtual void sleepUntil(std::int64_t time) = 0;
+
+    virtual ~SimulationClock() = default;
+};
+
+/**
+ * @brief Wall clock (system clock), for the real time simulations.
+ */
+class WallClock final : public SimulationClock
+{
+public:
+
+    LIBAMELAS_EXPORT std::int64_t now() const final;
+
+    LIBAMELAS_EXPORT void sleepUntil(std::int64_t time) final;
+};
+
+/**
+ * @brief Virtual clock, for the simulations faster than real time.
+ *
+ * With speed 0 the time jumps directly to the requested time, so the simulation runs as fast as possible. With a
+ * positive speed the clock runs `speed` times faster than the steady clock (for example, 100 replays a night in a
+ * few minutes while keeping the timing of the callbacks).
+ */
+class VirtualClock final : public SimulationClock
+{
+public:
+
+    LIBAMELAS_EXPORT explicit VirtualClock(std::int64_t start, double speed = 0.0);
+
+    LIBAMELAS_EXPORT std::int64_t now() const final;
+
+    LIBAMELAS_EXPORT void sleepUntil(std::int64_t time) final;
+
+    // Move the time forward (it never goes backwards).
+    LIBAMELAS_EXPORT void advance(std::int64_t ns);
+
+    double getSpeed() const {return this->speed_;}
+
+private:
+
+    std::atomic<std::int64_t> time_;
+    std::int64_t start_;
+    std::chrono::steady_clock::time_point wall_start_;
+    double speed_;
+};
+
+// Configuration of a simulated axis (degrees and seconds).
+struct AxisConfig
+{
+    double max_velocity;          ///< Maximum velocity (degrees per second).
+    double max_acceleration;      ///< Maximum acceleration (degrees per second squared).
+    double encoder_resolution;    ///< Encoder step (degrees). The servo only sees quantized positions.
+    double min_position;          ///< Lower limit (degrees). For the azimuth, the unwrapped cable wrap limit.
+    double max_position;          ///< Upper limit (degrees). For the azimuth, the unwrapped cable wrap limit.
+    double position_gain;         ///< Proportional gain of the position loop (1/s).
+};
+
+// Configuration of the simulated mount. The defaults are a generic SLR mount with 26 bits encoders.
+struct MountSimulatorConfig
+{
+    AxisConfig azimuth = {10.0, 5.0, 360.0 / 67108864.0, -270.0, 270.0, 30.0};
+    AxisConfig elevation = {5.0, 3.0, 360.0 / 67108864.0, 0.0, 90.0, 30.0};
+    std::int64_t servo_period = 1000000;   ///< Servo period (nanoseconds, 1 kHz).
+    double acquire_threshold = 1.0;        ///< Error to consider the target acquired (arc seconds).
+    double settle_time = 1.0;              ///< Time below the threshold to consider the target acquired (seconds).
+};
+
+// Results of a simulated tracking. The errors are the on-sky distance between the setpoint and the encoders, and
+// only the steps after the acquisition are included.
+struct TrackingStats
+{
+    std::size_t steps = 0;               ///< Simulated servo steps.
+    std::size_t tracking_steps = 0;      ///< Steps after the acquisition.
+    double acquire_time = -1.0;          ///< Time until the acquisition, settled (seconds, -1 if not acquired).
+    double rms_error = 0.0;              ///< RMS tracking error (arc seconds).
+    double max_error = 0.0;              ///< Maximum tracking error (arc seconds).
+    double max_az_error = 0.0;           ///< Maximum azimuth error, without the cos(el) factor (arc seconds).
+    double max_el_error = 0.0;           ///< Maximum elevation error (arc seconds).
+    double simulated_time = 0.0;         ///< Simulated time (seconds).
+    double wall_time = 0.0;              ///< Wall time spent (seconds).
+    AmelasError error = AmelasError::SUCCESS;
+};
+
+/**
+ * @brief Deterministic servo simulator of an alt-azimuth mount.
+ *
+ * Each axis follows the setpoint with a velocity feed-forward plus a position loop that brakes with the maximum
+ * acceleration (the feedback velocity is limited to sqrt(2 a |e|)), with the velocity and acceleration limits of the
+ * configuration. The loop sees the positions quantized to the encoder resolution. The azimuth is simulated unwrapped
+ * inside the cable wrap limits: the wrap is selected on the first setpoint (the nearest one to the mount) and the
+ * following setpoints are unwrapped continuously. A setpoint outside the limits is clamped and sets the FAULT status
+ * with the UNSAFE_POSITION error.
+ *
+ * The dynamics are integrated with the fixed servo period and the state times are the servo ticks, so the results do
+ * not depend on the clock. The clock only paces the simulation: with the WallClock it runs in real time and with the
+ * VirtualClock it runs as fast as possible (or at a fixed speed).
+ *
+ * The simulator is not thread safe. The states are delivered with a callback, so they can be published (for example,
+ * into the controller seqlock).
+ */
+class MountSimulator
+{
+public:
+
+    LIBAMELAS_EXPORT MountSimulator(const MountSimulatorConfig& config, std::shared_ptr<SimulationClock> clock);
+
+    // Place the mount in a position (stopped, idle and without the cable wrap selection).
+    LIBAMELAS_EXPORT void reset(const AltAzPos& pos);
+
+    // Set the setpoint (wrapped azimuth in degrees) and the feed-forward velocity (degrees per second).
+    LIBAMELAS_EXPORT void setSetpoint(const AltAzPos& pos, const AltAzPos& rate);
+
+    // Advance the dynamics one servo period (without waiting for the clock).
+    LIBAMELAS_EXPORT void step();
+
+    // Track a prepared trajectory from the current clock time (or from the trajectory start if it is later) until its
+    // end, waiting for the clock in each servo tick. The callback receives the state after each step.
+    LIBAMELAS_EXPORT AmelasError track(const TrajectoryInterpolator& interpolator, TrackingStats& stats,
+                                       const SimulationCallback& callback = {});
+
+    // Get the mount state (encoder positions, wrapped azimuth).
+    LIBAMELAS_EXPORT MountStateBlock getState() const;
+
+    // Get the unwrapped azimuth (cable wrap position, degrees).
+    double getUnwrappedAzimuth() const {return this->az_.position;}
+
+    const MountSimulatorConfig& getConfig() const {return this->config_;}
+
+    SimulationClock& getClock() {return *this->clock_;}
+
+private:
+
+    // State of a simulated axis.
+    struct AxisState
+    {
+        double position = 0.0;   ///< True position (degrees).
+        double velocity = 0.0;   ///< Velocity (degrees per second).
+        double setpoint = 0.0;   ///< Setpoint (degrees, the azimuth unwrapped).
+        double rate = 0.0;       ///< Feed-forward velocity (degrees per second).
+    };
+
+    // Advance an axis one step.
+    static void stepAxis(const AxisConfig& config, AxisState& axis, double dt);
+
+    // Quantize a position to the encoder resolution.
+    static double readEncoder(const AxisConfig& config, double position);
+
+    // Clamp a setpoint to the limits of an axis. Returns false if it was outside.
+    static bool clampSetpoint(const AxisConfig& config, double& setpoint);
+
+    // Get the on-sky error between the encoders and the setpoint (degrees), and the error of each axis.
+    double getTrackingError(double& az_error, double& el_error) const;
+
+    // Configuration and clock.
+    MountSimulatorConfig config_;
+    std::shared_ptr<SimulationClock> clock_;
+    double dt_;
+
+    // Axes state.
+    AxisState az_;
+    AxisState el_;
+    double last_setpoint_az_;
+    bool wrap_selected_;
+    std::size_t settle_steps_;
+    std::int64_t time_;
+    MountStatus status_;
+    AmelasError error_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,146 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file pointing_model.h
+ * @brief This file contains the declaration of the PointingModel class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <cstddef>
+#include <cstdint>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/common.h"
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// Pointing model terms (TPOINT alt-azimuth conventions, coefficients in arc seconds). The corrections are added to the
+// commanded position (A, E) to get the mount position.
+// - IA:   azimuth index error.                        dA = -IA
+// - IE:   elevation index error.                      dE = +IE
+// - CA:   left-right collimation error.               dA = -CA / cos(E)
+// - NPAE: non perpendicularity of the axes.           dA = -NPAE tan(E)
+// - AN:   azimuth axis tilt towards the north.        dA = -AN sin(A) tan(E),  dE = -AN cos(A)
+// - AW:   azimuth axis tilt towards the west.         dA = -AW cos(A) tan(E),  dE = +AW sin(A)
+// - TF:   tube flexure.                               dE = -TF cos(E)
+enum class PointingTerm : std::uint32_t
+{
+    IA   = 0,
+    IE   = 1,
+    CA   = 2,
+    NPAE = 3,
+    AN   = 4,
+    AW   = 5,
+    TF   = 6,
+    END_POINTING_TERMS = 7
+};
+
+static constexpr std::array<const char*, 7> PointingTermStr
+{
+    "IA",
+    "IE",
+    "CA",
+    "NPAE",
+    "AN",
+    "AW",
+    "TF"
+};
+
+constexpr std::size_t kPointingModelTerms = static_cast<std::size_t>(PointingTerm::END_POINTING_TERMS);
+constexpr std::size_t kPointingModelSlots = 4;   ///< Number of models stored in the controller.
+
+/**
+ * @brief Alt-azimuth pointing model (TPOINT style terms).
+ *
+ * The batch `apply` processes the positions in blocks of kBlockSize samples in two passes: first the sines and cosines
+ * of each sample are computed once (with the vectorized sincos in the AVX2 builds), then all the terms are applied in
+ * a single fused pass without branches that the compiler vectorizes. The coefficients are converted to degrees (with
+ * the TPOINT signs) when the model is built, so the fused pass only multiplies and adds.
+ *
+ * The azimuth terms diverge at the zenith, so the elevation used for tan(E) and 1/cos(E) is limited to kMaxElevation.
+ * The models are immutable after construction, so they can be shared between threads.
+ */
+class PointingModel
+{
+public:
+
+    // Model configuration.
+    static constexpr std::size_t kBlockSize = 64;   ///< Samples processed in each block of the batch version.
+    static constexpr double kMaxTerm = 7200.0;      ///< Maximum absolute value of each coefficient (arc seconds).
+    static constexpr double kMaxElevation = 89.9;   ///< Maximum elevation used in the azimuth terms (degrees).
+
+    // Null model (no corrections).
+    LIBAMELAS_EXPORT PointingModel();
+
+    // Model with the coefficients in arc seconds, in PointingTerm order.
+    LIBAMELAS_EXPORT explicit PointingModel(const std::array<double, kPointingModelTerms>& terms);
+
+    // Check if all the coefficients are finite and inside the limits.
+    LIBAMELAS_EXPORT bool isValid() const;
+
+    // Apply the model to a position.
+    LIBAMELAS_EXPORT AltAzPos apply(const AltAzPos& pos) const;
+
+    // Apply the model to a group of positions (degrees). The output arrays can be the input ones.
+    LIBAMELAS_EXPORT void apply(const double* az, const double* el, std::size_t count, double* out_az,
+                                double* out_el) const;
+
+    // Apply the model to a trajectory. The timestamps are copied, so the output is the mount trajectory.
+    LIBAMELAS_EXPORT void apply(const TrajectoryBuffer& input, TrajectoryBuffer& output) const;
+
+    double getTerm(PointingTerm term) const {return this->terms_[static_cast<std::size_t>(term)];}
+
+    const std::array<double, kPointingModelTerms>& getTerms() const {return this->terms_;}
+
+private:
+
+    // Apply the model to a block of kBlockSize or less positions.
+    void applyBlock(const double* az, const double* el, std::size_t count, double* out_az, double* out_el) const;
+
+    // Coefficients in arc seconds.
+    std::array<double, kPointingModelTerms> terms_;
+
+    // Coefficients of the fused pass (degrees, with the signs of each term).
+    double az_index_;     ///< -IA
+    double az_coll_;      ///< -CA, multiplies 1/cos(E).
+    double az_npae_;      ///< -NPAE, multiplies tan(E).
+    double az_an_;        ///< -AN, multiplies sin(A) tan(E).
+    double az_aw_;        ///< -AW, multiplies cos(A) tan(E).
+    double el_index_;     ///< IE
+    double el_an_;        ///< -AN, multiplies cos(A).
+    double el_aw_;        ///< AW, multiplies sin(A).
+    double el_tf_;        ///< -TF, multiplies cos(E).
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
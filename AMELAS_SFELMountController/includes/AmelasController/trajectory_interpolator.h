@@ -0,0 +1,153 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file trajectory_interpolator.h
+ * @brief This file contains the declaration of the TrajectoryInterpolator class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/common.h"
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// Interpolation methods.
+// - LAGRANGE: polynomial of the selected order through the order + 1 samples centered on each segment.
+// - HERMITE:  cubic Hermite spline (order 3) with the derivatives estimated from the neighbour samples.
+enum class InterpolationMethod : std::int32_t
+{
+    LAGRANGE = 0,
+    HERMITE  = 1
+};
+
+static constexpr std::array<const char*, 2> InterpolationMethodStr
+{
+    "LAGRANGE",
+    "HERMITE"
+};
+
+// Default interpolation used by the controller.
+constexpr InterpolationMethod kDefaultInterpolationMethod = InterpolationMethod::LAGRANGE;
+constexpr unsigned kDefaultInterpolationOrder = 7;
+
+/**
+ * @brief Interpolation engine for the tabulated trajectories.
+ *
+ * The `prepare` function computes once the polynomial coefficients of each segment (between two samples) in the local
+ * time of the segment, u = (t - t_i) / (t_i+1 - t_i). Then the setpoints are evaluated with the Horner scheme, without
+ * allocations. The batch evaluation processes the look-ahead windows in small blocks of samples with the degree loop
+ * outside, so the compiler vectorizes the sample loop.
+ *
+ * The azimuth is unwrapped before computing the coefficients, so the crossings of 0/360 degrees are interpolated
+ * properly, and the results are wrapped again to [0, 360).
+ *
+ * The evaluation functions are const and can be called concurrently. The `prepare` function must not be called while
+ * evaluating.
+ */
+class TrajectoryInterpolator
+{
+public:
+
+    // Interpolator configuration.
+    static constexpr unsigned kMaxOrder = 9;                   ///< Maximum Lagrange order.
+    static constexpr std::size_t kMaxCoefficients = kMaxOrder + 1;
+    static constexpr std::size_t kEvaluationBlock = 64;        ///< Samples evaluated together in the batch version.
+
+    LIBAMELAS_EXPORT TrajectoryInterpolator();
+
+    // Compute the coefficients of all the segments. The order is only used by the Lagrange method (Hermite is cubic).
+    LIBAMELAS_EXPORT AmelasError prepare(const TrajectoryBuffer& trajectory, InterpolationMethod method,
+                                         unsigned order);
+
+    // Check if an interpolation method and order are supported.
+    static constexpr bool isValidConfiguration(InterpolationMethod method, unsigned order)
+    {
+        return method == InterpolationMethod::HERMITE ||
+               (method == InterpolationMethod::LAGRANGE && order > 0 && order <= kMaxOrder);
+    }
+
+    // Evaluate the position at a time (UTC nanoseconds). Returns false if the time is outside the trajectory.
+    LIBAMELAS_EXPORT bool evaluate(std::int64_t time, AltAzPos& pos) const;
+
+    // Evaluate the positions at a group of times (usually an increasing look-ahead window). The positions outside the
+    // trajectory are set to NaN. Returns the number of positions inside the trajectory.
+    LIBAMELAS_EXPORT std::size_t evaluate(const std::int64_t* times, std::size_t count, double* az, double* el) const;
+
+    // Clear the prepared trajectory.
+    LIBAMELAS_EXPORT void clear();
+
+    bool isReady() const {return this->segments_ != 0;}
+
+    std::int64_t getStartTime() const {return this->start_time_;}
+
+    std::int64_t getEndTime() const {return this->end_time_;}
+
+    InterpolationMethod getMethod() const {return this->method_;}
+
+    unsigned getDegree() const {return this->degree_;}
+
+private:
+
+    // Coefficients helpers.
+    void computeLagrange(const TrajectoryBuffer& trajectory, unsigned order);
+    void computeHermite(const TrajectoryBuffer& trajectory);
+
+    // Get the segment of a time. The time must be inside the trajectory.
+    std::size_t findSegment(std::int64_t time) const;
+
+    // Evaluate a block of samples of the same segment.
+    void evaluateBlock(std::size_t segment, const std::int64_t* times, std::size_t count,
+                       double* az, double* el) const;
+
+    // Segments (structure of arrays). The coefficients of each segment are contiguous, in ascending degree.
+    std::vector<std::int64_t> seg_start_;   ///< Start time of each segment (the times of the samples).
+    std::vector<double> seg_inv_step_;      ///< Inverse of the duration of each segment (1/ns).
+    std::vector<double> az_coefs_;          ///< Azimuth coefficients (unwrapped azimuth).
+    std::vector<double> el_coefs_;          ///< Elevation coefficients.
+    std::vector<double> unwrapped_az_;      ///< Auxiliar unwrapped azimuths.
+
+    // Configuration.
+    std::size_t segments_;
+    std::size_t stride_;
+    unsigned degree_;
+    InterpolationMethod method_;
+    std::int64_t start_time_;
+    std::int64_t end_time_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
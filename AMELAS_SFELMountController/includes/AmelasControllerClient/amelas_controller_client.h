@@ -27,7 +27,18 @@
 
 // C++ INCLUDES
 // =====================================================================================================================
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 // =====================================================================================================================
 
 // ZMQUTILS INCLUDES
@@ -43,6 +54,10 @@
 
 // PROJECT INCLUDES
 // =====================================================================================================================
+#include "AmelasController/common.h"
+#include "AmelasControllerServer/common.h"
+#include "AmelasControllerServer/inproc_transport.h"
+#include "AmelasControllerClient/heartbeat_scheduler.h"
 // =====================================================================================================================
 
 // AMELAS NAMESPACES
@@ -53,11 +68,22 @@ namespace communication{
 
 using zmqutils::common::RequestData;
 using zmqutils::common::CommandReply;
+using common::TelemetryTopic;
+using common::BatchMode;
+using common::AmelasServerCommand;
+using zmqutils::common::OperationResult;
 
 class AmelasControllerClient : public zmqutils::CommandClientBase
 {
 public:
 
+    // Mount state telemetry callback. The state accumulates the fields of all the received topics.
+    using TelemetryCallback = std::function<void(TelemetryTopic, const controller::MountState&)>;
+
+    // Asynchronous reply callback. The transport errors (timeout, channel stopped) are in the reply server result.
+    // The parameters are read in place from the received frame, so they are only valid during the callback.
+    using AsyncReplyCallback = std::function<void(const CommandReply&)>;
+
      LIBAMELAS_EXPORT AmelasControllerClient(const std::string& server_endpoint,
                               const std::string& client_name = "",
                               const std::string interf_name = "");
@@ -77,6 +103,76 @@ public:
 
 
 
+    // Batch entry (command and serialized parameters) and batch entry result.
+    struct BatchEntry
+    {
+        AmelasServerCommand command;
+        std::vector<std::byte> params;
+    };
+
+    struct BatchResult
+    {
+        OperationResult result;
+        std::vector<std::byte> params;
+    };
+
+    // Prepare a REQ_BATCH request with the given entries.
+    LIBAMELAS_EXPORT static RequestData prepareBatchRequest(BatchMode mode, const std::vector<BatchEntry>& entries);
+
+    // Get the results of a REQ_BATCH reply. Returns false if the reply parameters are invalid.
+    LIBAMELAS_EXPORT static bool parseBatchReply(const CommandReply& reply, std::vector<BatchResult>& results);
+
+    // Start the asynchronous channel, a DEALER socket connected to the server endpoint (or to the given endpoint, for
+    // example a server local endpoint) that allows up to `max_in_flight` pipelined requests. The inproc endpoints use
+    // the process wide inproc context. The requests use the client UUID, so the client must be connected with
+    // `doConnect` before sending asynchronous commands.
+    LIBAMELAS_EXPORT bool startAsyncChannel(unsigned max_in_flight = common::kDefaultMaxInFlight,
+                                            unsigned timeout_ms = common::kDefaultAsyncTimeoutMsec,
+                                            const std::string& endpoint = "");
+
+    // Stop the asynchronous channel. The pending requests are completed with CLIENT_STOPPED.
+    LIBAMELAS_EXPORT void stopAsyncChannel();
+
+    // Send a command without waiting for the reply. If the in-flight limit is reached, the caller waits for a free
+    // slot up to the request timeout. The future version returns the reply; the callback version invokes the callback
+    // from the asynchronous channel thread and returns false if the request could not be queued.
+    LIBAMELAS_EXPORT std::future<CommandReply> sendCommandAsync(const RequestData& request);
+    LIBAMELAS_EXPORT bool sendCommandAsync(const RequestData& request, AsyncReplyCallback callback);
+
+    // Fast path versions that take the request by move. In an inproc channel the request object itself is passed to
+    // the server (and the reply object back), otherwise the parameters are sent without copies.
+    LIBAMELAS_EXPORT std::future<CommandReply> sendCommandAsync(RequestData&& request);
+    LIBAMELAS_EXPORT bool sendCommandAsync(RequestData&& request, AsyncReplyCallback callback);
+
+    // Get the number of in-flight asynchronous requests.
+    LIBAMELAS_EXPORT unsigned getInFlightRequests() const;
+
+    // Upload a trajectory (begin, chunks and commit, verified with the checksum). If the asynchronous channel is
+    // working the chunks are pipelined within the window granted by the server, otherwise they are sent one by one.
+    // The controller result is stored in `error`.
+    LIBAMELAS_EXPORT OperationResult doUploadTrajectory(const std::vector<std::int64_t>& timestamps,
+                                                        const std::vector<double>& az, const std::vector<double>& el,
+                                                        controller::AmelasError& error);
+
+    // Subscribe to the server mount state telemetry. An empty topics list subscribes to all of them. The callback is
+    // invoked from the telemetry thread.
+    LIBAMELAS_EXPORT bool startTelemetry(const std::string& endpoint, const std::vector<TelemetryTopic>& topics,
+                                         TelemetryCallback callback);
+
+    LIBAMELAS_EXPORT void stopTelemetry();
+
+    // Keep the connection alive with the process wide HeartbeatScheduler instead of the client auto alive thread (use
+    // `doConnect(false)`). Any successful reply counts as activity, so REQ_ALIVE is only sent after `period_ms`
+    // without successful commands. It is sent through the asynchronous channel without blocking the scheduler thread:
+    // if the channel is not working or its window is full, the heartbeat is skipped (and counted). The heartbeat stops
+    // when the client is disconnected.
+    LIBAMELAS_EXPORT void enableSharedHeartbeat(unsigned period_ms = zmqutils::common::kClientAlivePeriodMsec);
+
+    LIBAMELAS_EXPORT void disableSharedHeartbeat();
+
+    // Get the number of shared heartbeats skipped because they could not be sent without blocking.
+    LIBAMELAS_EXPORT std::uint64_t getSkippedHeartbeats() const;
+
     LIBAMELAS_EXPORT ~AmelasControllerClient() override;
 
 protected:
@@ -100,6 +196,79 @@ protected:
     LIBAMELAS_EXPORT virtual void onSendingCommand(const RequestData&) override;
 
     LIBAMELAS_EXPORT virtual void onClientError(const zmq::error_t&, const std::string& ext_info) override;
+
+private:
+
+    // Asynchronous request waiting for its reply.
+    struct AsyncPending
+    {
+        std::promise<CommandReply> promise;
+        AsyncReplyCallback callback;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // Check a reply and read the controller error and the rest of the reply parameters.
+    template <typename... Args>
+    static OperationResult readControllerReply(const CommandReply& reply, controller::AmelasError& error,
+                                               Args&... args)
+    {
+        if(reply.server_result != OperationResult::COMMAND_OK)
+            return reply.server_result;
+        try
+        {
+            zmqutils::utils::LocalBinarySerializer::fastDeserialization(reply.params.get(), reply.params_size,
+                                                                        error, args...);
+        }
+        catch(...)
+        {
+            return OperationResult::BAD_PARAMETERS;
+        }
+        return OperationResult::COMMAND_OK;
+    }
+
+    // Asynchronous channel helpers and worker.
+    OperationResult enqueueAsyncRequest(const RequestData& request, AsyncPending& pending);
+    OperationResult enqueueAsyncRequest(RequestData&& request, AsyncPending& pending, bool wait = true);
+    OperationResult enqueueAsyncMessage(zmq::multipart_t& msg, AsyncPending& pending, bool wait = true);
+    void checkAsyncQueued(AsyncPending& pending, OperationResult result);
+    void processAsyncReply(zmq::multipart_t& msg);
+    void completeAsyncRequest(AsyncPending& pending, CommandReply&& reply);
+    void asyncWorker();
+
+    // Telemetry subscriber worker.
+    void telemetryWorker();
+
+    // Shared heartbeat function (called from the scheduler thread).
+    void sendHeartbeat();
+
+    // Telemetry members.
+    std::unique_ptr<zmq::context_t> telemetry_ctx_;
+    std::unique_ptr<zmq::socket_t> telemetry_socket_;
+    std::future<void> telemetry_fut_;
+    std::atomic_bool telemetry_working_ {false};
+    TelemetryCallback telemetry_clbk_;
+
+    // Asynchronous channel members. The DEALER socket is only used in the asynchronous thread, the callers queue the
+    // messages and wake up the thread with the signal socket. The configuration is set under the mutex before the
+    // thread starts, and the inproc flag is atomic because the callers and the thread read it without the mutex.
+    std::unique_ptr<zmq::context_t> async_ctx_;
+    std::unique_ptr<zmq::socket_t> async_socket_;
+    std::unique_ptr<zmq::socket_t> async_signal_recv_;
+    std::unique_ptr<zmq::socket_t> async_signal_send_;
+    std::future<void> async_fut_;
+    std::unordered_map<std::uint64_t, AsyncPending> async_pending_;
+    std::deque<zmq::multipart_t> async_outgoing_;
+    std::condition_variable async_cv_;
+    mutable std::mutex async_mtx_;
+    std::uint64_t async_next_id_ {0};
+    unsigned async_max_in_flight_ {common::kDefaultMaxInFlight};
+    std::chrono::milliseconds async_timeout_ {common::kDefaultAsyncTimeoutMsec};
+    std::atomic_bool async_working_ {false};
+    std::atomic_bool async_inproc_ {false};
+
+    // Shared heartbeat connection (registered in the HeartbeatScheduler singleton) and skipped heartbeats.
+    HeartbeatScheduler::Connection heartbeat_;
+    std::atomic<std::uint64_t> heartbeat_skipped_ {0};
 };
 
 }} // END NAMESPACES.
@@ -0,0 +1,172 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file heartbeat_scheduler.h
+ * @brief This file contains the declaration of the HeartbeatScheduler class (shared heartbeats of many clients).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+/**
+ * @brief Heartbeats of many client connections served by a single thread.
+ *
+ * Each connection has a heartbeat period and records its activity (any successful command) with a lock free touch.
+ * The scheduler keeps one timer per connection in a min heap ordered by deadline, and a single thread sleeps until the
+ * nearest deadline. When a timer expires, the heartbeat is sent only if the connection was idle during the whole
+ * period; otherwise the timer is moved to the last activity plus the period. So busy connections send no heartbeats,
+ * and the cost of the idle ones is one heap operation per period instead of a thread per client.
+ *
+ * The heartbeat functions are called from the scheduler thread without holding the scheduler lock, one at a time, so
+ * they should not block for long (a blocking heartbeat delays the heartbeats of the other connections). The thread is
+ * started with the first connection and finishes when the last one is removed.
+ *
+ * The class is thread safe.
+ */
+class HeartbeatScheduler
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+    using HeartbeatFunction = std::function<void()>;
+
+    /**
+     * @brief Connection served by the scheduler: heartbeat function and time of the last activity.
+     *
+     * The connection must be removed from the scheduler before it is destroyed.
+     */
+    class Connection
+    {
+    public:
+
+        explicit Connection(HeartbeatFunction heartbeat) :
+            heartbeat_(std::move(heartbeat)),
+            last_activity_(Clock::now().time_since_epoch().count())
+        {}
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        // Record an activity of the connection (can be called from any thread).
+        void touch() noexcept
+        {
+            this->last_activity_.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        Clock::time_point getLastActivity() const noexcept
+        {
+            return Clock::time_point(Clock::duration(this->last_activity_.load(std::memory_order_relaxed)));
+        }
+
+    private:
+
+        friend class HeartbeatScheduler;
+
+        HeartbeatFunction heartbeat_;                ///< Function that sends the heartbeat.
+        std::atomic<Clock::rep> last_activity_;      ///< Time of the last activity (clock ticks).
+        std::chrono::milliseconds period_{0};        ///< Heartbeat period (guarded by the scheduler mutex).
+    };
+
+    LIBAMELAS_EXPORT HeartbeatScheduler();
+
+    HeartbeatScheduler(const HeartbeatScheduler&) = delete;
+    HeartbeatScheduler& operator=(const HeartbeatScheduler&) = delete;
+
+    // Process wide scheduler.
+    LIBAMELAS_EXPORT static HeartbeatScheduler& getInstance();
+
+    // Start serving a connection, or change its period if it is already served. The first heartbeat is sent after a
+    // period without activity from now.
+    LIBAMELAS_EXPORT void add(Connection& connection, std::chrono::milliseconds period);
+
+    // Stop serving a connection. If `wait` is true and its heartbeat is being sent, waits until it finishes (except
+    // when called from the heartbeat function itself), also when the connection was already removed without waiting.
+    // Returns false if the connection was not served.
+    LIBAMELAS_EXPORT bool remove(Connection& connection, bool wait = true);
+
+    LIBAMELAS_EXPORT bool contains(const Connection& connection) const;
+
+    LIBAMELAS_EXPORT std::size_t size() const;
+
+    // Heartbeats sent and heartbeats skipped because the connection was active.
+    LIBAMELAS_EXPORT std::uint64_t getSentHeartbeats() const;
+    LIBAMELAS_EXPORT std::uint64_t getSkippedHeartbeats() const;
+
+    LIBAMELAS_EXPORT ~HeartbeatScheduler();
+
+private:
+
+    // Timer of a connection. The removed or rescheduled connections leave stale timers in the heap, which are
+    // discarded by their generation without accessing the connection.
+    struct Timer
+    {
+        Clock::time_point deadline;
+        Connection* connection;
+        std::uint64_t generation;
+
+        bool operator>(const Timer& other) const {return this->deadline > other.deadline;}
+    };
+
+    // Scheduler thread.
+    void worker();
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;   ///< Timers heap.
+    std::unordered_map<const Connection*, std::uint64_t> connections_;           ///< Connections and generations.
+    std::uint64_t next_generation_;                     ///< Generation of the next timer.
+    const Connection* running_;                         ///< Connection whose heartbeat is being sent.
+    std::uint64_t sent_;                                ///< Heartbeats sent.
+    std::uint64_t skipped_;                             ///< Heartbeats skipped.
+    std::thread::id worker_id_;                         ///< Id of the scheduler thread.
+    std::future<void> worker_fut_;                      ///< Scheduler thread future.
+    bool working_;                                      ///< Scheduler thread working flag.
+    std::condition_variable worker_cv_;                 ///< Wakes up the scheduler thread.
+    std::condition_variable running_cv_;                ///< Notifies the end of a heartbeat.
+    mutable std::mutex mtx_;                            ///< Safety mutex.
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
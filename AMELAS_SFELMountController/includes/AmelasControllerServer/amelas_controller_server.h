@@ -31,6 +31,13 @@
 #include <string>
 #include <any>
 #include <variant>
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 // =====================================================================================================================
 
 // ZMQUTILS INCLUDES
@@ -43,7 +50,11 @@
 // =====================================================================================================================
 #include "AmelasController/amelas_controller.h"
 #include "AmelasController/common.h"
+#include "AmelasControllerServer/client_registry.h"
 #include "AmelasControllerServer/common.h"
+#include "AmelasControllerServer/controller_dispatch_table.h"
+#include "AmelasControllerServer/inproc_transport.h"
+#include "AmelasControllerServer/server_metrics.h"
 #include "libamelas_global.h"
 // =====================================================================================================================
 
@@ -61,6 +72,7 @@ using zmqutils::common::OperationResult;
 using zmqutils::common::ServerCommand;
 using zmqutils::common::HostInfo;
 using zmqutils::utils::CallbackHandler;
+using zmqutils::utils::UUID;
 // ---------------------------------------------------------------------------------------------------------------------
 
 // Example of creating a command server from the base.
@@ -70,15 +82,50 @@ public:
 
     LIBAMELAS_EXPORT AmelasControllerServer(unsigned port, const std::string& local_addr = "*");
 
-    // Register callback function helper.
-    template<typename... Args>
-    void registerControllerCallback(AmelasServerCommand command,
-                                    controller::AmelasController* object,
+    // Register callback function helper. The signature is checked at compile time against the command traits. The
+    // callbacks must be registered before starting the server.
+    template<AmelasServerCommand C, typename... Args>
+    bool registerControllerCallback(controller::AmelasController* object,
                                     controller::AmelasControllerCallback<Args...> callback)
     {
-        CallbackHandler::registerCallback(static_cast<CallbackHandler::CallbackId>(command), object, callback);
+        return this->dispatch_table_.registerCallback<C>(object, callback);
     }
 
+    // Enables or disables the router mode. In this mode a ROUTER front end spreads the requests across a pool of
+    // workers: the read only commands run concurrently and the rest are serialized in a single worker. Must be called
+    // before starting the server.
+    LIBAMELAS_EXPORT void setRouterMode(bool enabled, unsigned workers = kDefaultRouterWorkers);
+
+    // Additional router mode endpoints for the co-located clients (ipc://, tcp:// or inproc://). The inproc endpoints
+    // are bound in the process wide inproc context (getInprocContext) and also accept the moved requests. Must be
+    // called before starting the server.
+    LIBAMELAS_EXPORT void setLocalEndpoints(const std::vector<std::string>& endpoints);
+
+    // Enables or disables the mount state telemetry, published with a PUB socket in the given port. The rate is
+    // limited to kMaxTelemetryRateHz. Must be called before starting the server.
+    LIBAMELAS_EXPORT void setTelemetry(bool enabled, unsigned port, unsigned rate_hz = kDefaultTelemetryRateHz);
+
+    // Set the controller function that provides the mount state for the telemetry. It is called without the controller
+    // lock, so it must be lock free (as AmelasController::getMountState, which reads the seqlock snapshot).
+    LIBAMELAS_EXPORT void setTelemetrySource(controller::AmelasController* object,
+                                             controller::AmelasControllerCallback<controller::MountState&> callback);
+
+    // Router mode aware versions of the base server functions.
+    LIBAMELAS_EXPORT bool startServer();
+    LIBAMELAS_EXPORT void stopServer();
+    LIBAMELAS_EXPORT bool isWorking() const;
+    LIBAMELAS_EXPORT std::map<UUID, HostInfo> getConnectedClients() const;
+    LIBAMELAS_EXPORT void setClientAliveTimeout(unsigned timeout_ms);
+    LIBAMELAS_EXPORT void setClientStatusCheck(bool);
+    LIBAMELAS_EXPORT void setAliveCallbacksEnabled(bool);
+
+    // Per command request counters, latencies and queue depths (also available with REQ_GET_METRICS). The metrics are
+    // cleared when the server starts.
+    LIBAMELAS_EXPORT ServerMetricsSnapshot getMetrics() const;
+
+    // Text table of the current metrics.
+    LIBAMELAS_EXPORT std::string dumpMetrics() const;
+
     LIBAMELAS_EXPORT ~AmelasControllerServer() final;
 
 private:
@@ -92,19 +139,90 @@ private:
     // Process functions for all the specific commands.
     void processSetHomePosition(const CommandRequest&, CommandReply&);
     void processGetHomePosition(const CommandRequest&, CommandReply&);
+    void processBatch(const CommandRequest&, CommandReply&);
+    void processBeginTrajectoryUpload(const CommandRequest&, CommandReply&);
+    void processUploadTrajectoryChunk(const CommandRequest&, CommandReply&);
+    void processCommitTrajectoryUpload(const CommandRequest&, CommandReply&);
+    void processLoadPointingModel(const CommandRequest&, CommandReply&);
+    void processSetPointingModel(const CommandRequest&, CommandReply&);
+    void processGetControlLoopStats(const CommandRequest&, CommandReply&);
+    void processGetMetrics(const CommandRequest&, CommandReply&);
 
     // Subclass register process function helper.
     void registerRequestProcFunc(AmelasServerCommand command, AmelasRequestProcFunc func);
 
-    // Subclass invoke callback helper.
-    template <typename ClbkT, typename... Args>
-    controller::AmelasError invokeCallback(const CommandRequest& request, CommandReply& reply, Args&&... args)
+    // Reply serialization helper. The reply uses the same wire format (tagged or packed) as the request.
+    template <typename... Args>
+    static void serializeReply(bool packed, CommandReply& reply, const Args&... args)
     {
-        return ClbkCommandServerBase::invokeCallback<ClbkT>(request, reply,
-                                                            controller::AmelasError::INVALID_ERROR,
-                                                            std::forward<Args>(args)...);
+        using zmqutils::utils::BinarySerializer;
+        using zmqutils::utils::LocalBinarySerializer;
+        reply.params_size = packed ? BinarySerializer::fastSerializationPacked(reply.params, args...) :
+                                     LocalBinarySerializer::fastSerialization(reply.params, args...);
     }
 
+    // Subclass invoke callback helper. The lock free commands read the mount state snapshot without locks, the read
+    // only commands share the controller and the rest get exclusive access.
+    template <AmelasServerCommand C, typename... Args>
+    controller::AmelasError invokeCallback(CommandReply& reply, Args&&... args)
+    {
+        // Auxiliar variables.
+        controller::AmelasError error = controller::AmelasError::INVALID_ERROR;
+        OperationResult result;
+
+        // Call to the controller.
+        if constexpr (isLockFreeCommand(C))
+        {
+            result = this->dispatch_table_.invoke<C>(error, std::forward<Args>(args)...);
+        }
+        else if constexpr (isReadOnlyCommand(C))
+        {
+            std::shared_lock<std::shared_mutex> lock(this->controller_mtx_);
+            result = this->dispatch_table_.invoke<C>(error, std::forward<Args>(args)...);
+        }
+        else
+        {
+            std::unique_lock<std::shared_mutex> lock(this->controller_mtx_);
+            result = this->dispatch_table_.invoke<C>(error, std::forward<Args>(args)...);
+        }
+
+        // Check the dispatch result.
+        if(result != OperationResult::COMMAND_OK)
+        {
+            reply.server_result = result;
+            return controller::AmelasError::INVALID_ERROR;
+        }
+        return error;
+    }
+
+    // Router mode proxy (front end to workers) and workers. Each worker writes the metrics in its own shard.
+    void routerProxyWorker();
+    void routerWorker(const std::string& endpoint, std::size_t metrics_shard);
+
+    // Router mode proxy helper: forward a request from a front end to its worker (with the origin frame if there is an
+    // inproc front end). Returns false if the request was dropped.
+    bool routerForwardRequest(zmq::multipart_t& msg, bool inproc);
+
+    // Router mode request processing (base and custom commands). The moved requests come from an inproc endpoint.
+    void routerProcessMessage(zmq::multipart_t& msg, bool moved, CommandReply& reply, bool& alive_msg,
+                              RequestTrace& trace);
+
+    // Router mode internal base commands.
+    OperationResult routerExecReqConnect(const CommandRequest&);
+    OperationResult routerExecReqDisconnect(const CommandRequest&);
+
+    // Telemetry start, stop and worker.
+    bool startTelemetry();
+    void stopTelemetry();
+    void telemetryWorker();
+
+    // Router mode client helpers.
+    bool routerUpdateClient(const UUID& uuid);
+    void routerCheckClientsAlive();
+
+    // Number of connected clients (without copying them).
+    std::size_t getConnectedClientsCount() const;
+
     // Internal overrided command validation function.
     virtual bool validateCustomCommand(ServerCommand command) final;
 
@@ -140,6 +258,51 @@ private:
 
     // Internal overrided server error callback.
     virtual void onServerError(const zmq::error_t&, const std::string& ext_info) final;
+
+    // Process functions indexed by command id (the base server map is not accessible).
+    std::array<AmelasRequestProcFunc, ControllerDispatchTable::kTableSize> process_fncs_;
+
+    // Controller callbacks and controller access synchronization.
+    ControllerDispatchTable dispatch_table_;
+    std::shared_mutex controller_mtx_;
+
+    // Server metrics and trace of the current request in the classic mode (only used in the base server thread).
+    ServerMetrics metrics_;
+    RequestTrace classic_trace_;
+
+    // Telemetry configuration, sockets and worker.
+    std::string server_addr_;
+    bool telemetry_enabled_;
+    unsigned telemetry_port_;
+    unsigned telemetry_rate_;
+    controller::AmelasController* telemetry_ctrl_;
+    controller::AmelasControllerCallback<controller::MountState&> telemetry_clbk_;
+    std::unique_ptr<zmq::context_t> telemetry_ctx_;
+    std::unique_ptr<zmq::socket_t> telemetry_socket_;
+    std::future<void> telemetry_fut_;
+    std::atomic_bool telemetry_working_;
+
+    // Router mode configuration.
+    std::string router_endpoint_;
+    std::vector<std::string> router_local_endpoints_;
+    bool router_mode_;
+    unsigned router_workers_;
+    std::atomic_bool router_check_alive_;
+    std::atomic_bool router_alive_callbacks_;
+    std::atomic_uint router_alive_timeout_;
+
+    // Router mode sockets, workers and clients.
+    std::unique_ptr<zmq::context_t> router_ctx_;
+    std::unique_ptr<zmq::socket_t> router_frontend_;
+    std::unique_ptr<zmq::socket_t> router_inproc_frontend_;
+    std::unique_ptr<zmq::socket_t> router_read_backend_;
+    std::unique_ptr<zmq::socket_t> router_write_backend_;
+    std::future<void> router_proxy_fut_;
+    std::vector<std::future<void>> router_workers_futs_;
+    ClientRegistry router_clients_;
+    mutable std::mutex router_clients_mtx_;
+    mutable std::mutex router_mtx_;
+    std::atomic_bool router_working_;
 };
 
 }} // END NAMESPACES.
@@ -0,0 +1,149 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file client_registry.h
+ * @brief This file contains the declaration of the ClientRegistry class (connected clients and liveness timeouts).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include <LibZMQUtils/CommandServer>
+#include <LibZMQUtils/Utils>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/timer_wheel.h"
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+using zmqutils::common::HostInfo;
+using zmqutils::utils::UUID;
+// ---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Connected clients of a server with their liveness timeouts.
+ *
+ * The clients are stored in an open addressing hash table (linear probing with backward shift deletion, keyed by a
+ * seeded hash of the UUID bytes), so the lookup of the client of each request is O(1) instead of the O(log n) 16 bytes
+ * comparisons of a std::map. The client data lives in a pool with stable indexes, which are also the ids of the
+ * timers in a hierarchical timer wheel (kTickDuration resolution).
+ *
+ * The timers are lazy: a request only updates the last seen time of its client, and when a timer expires the client is
+ * removed if it was not seen during the timeout or its timer is scheduled again from the last seen time. So the work
+ * of the liveness checks is proportional to the expired timers (at most one per client and timeout period), not to
+ * the number of clients.
+ *
+ * The class is not thread safe.
+ */
+class ClientRegistry
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds kTickDuration{10};   ///< Resolution of the liveness timeouts.
+
+    LIBAMELAS_EXPORT ClientRegistry();
+
+    // Add a client (the timeout starts at its last seen time). Returns false if the UUID is already registered.
+    LIBAMELAS_EXPORT bool insert(const HostInfo& client);
+
+    // Remove a client, copying its data if requested. Returns false if the UUID is not registered.
+    LIBAMELAS_EXPORT bool erase(const UUID& uuid, HostInfo* client = nullptr);
+
+    // Update the last seen time of a client. Returns false if the UUID is not registered.
+    LIBAMELAS_EXPORT bool touch(const UUID& uuid, Clock::time_point now);
+
+    // Get a client (nullptr if the UUID is not registered). The pointer is valid until the next modification.
+    LIBAMELAS_EXPORT const HostInfo* find(const UUID& uuid) const;
+
+    // Set the liveness timeout (0 disables the timeouts). Changing it reschedules all the timers.
+    LIBAMELAS_EXPORT void setTimeout(std::chrono::milliseconds timeout);
+
+    // Remove the clients not seen during the timeout and append them to the dead clients.
+    LIBAMELAS_EXPORT void collectExpired(Clock::time_point now, std::vector<HostInfo>& dead);
+
+    // Remove all the clients.
+    LIBAMELAS_EXPORT void clear();
+
+    // Copy of the clients ordered by UUID.
+    LIBAMELAS_EXPORT std::map<UUID, HostInfo> toMap() const;
+
+    std::size_t size() const {return this->size_;}
+
+private:
+
+    static constexpr std::uint32_t kEmpty = utils::TimerWheel::kNil;
+    static constexpr std::size_t kInitialCapacity = 16;
+
+    // Client data with its hash.
+    struct Node
+    {
+        HostInfo client;
+        std::uint64_t hash = 0;
+        bool used = false;
+    };
+
+    // Hash of a UUID.
+    std::uint64_t hashUUID(const UUID& uuid) const;
+
+    // Position in the hash table of a UUID (the position of the node or the empty position where it would go).
+    std::size_t probe(const UUID& uuid, std::uint64_t hash) const;
+
+    // Hash table helpers.
+    void grow();
+    void removeAt(std::size_t position);
+
+    // Timer helpers.
+    std::uint64_t toTick(Clock::time_point time) const;
+    void scheduleTimer(std::uint32_t node);
+
+    std::vector<Node> nodes_;              ///< Client data pool (the index is the timer id).
+    std::vector<std::uint32_t> free_;      ///< Free nodes of the pool.
+    std::vector<std::uint32_t> table_;     ///< Open addressing table of node indexes (power of two size).
+    std::size_t size_;                     ///< Number of clients.
+    std::uint64_t seed_;                   ///< Hash seed (random, so the clients cannot force collisions).
+    utils::TimerWheel wheel_;              ///< Liveness timers.
+    std::chrono::milliseconds timeout_;    ///< Liveness timeout (0 disabled).
+    Clock::time_point epoch_;              ///< Time of the tick 0.
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -41,43 +41,183 @@ namespace common{
 // WARNING: In our approach, the server commands must be always in order.
 enum class AmelasServerCommand : zmqutils::common::CommandType
 {
-    REQ_SET_HOME_POSITION = 33,
-    REQ_GET_HOME_POSITION = 34,
-    END_IMPL_COMMANDS     = 35,
-    END_AMELAS_COMMANDS   = 50
+    REQ_SET_HOME_POSITION        = 33,
+    REQ_GET_HOME_POSITION        = 34,
+    REQ_BATCH                    = 35,
+    REQ_BEGIN_TRAJECTORY_UPLOAD  = 36,
+    REQ_UPLOAD_TRAJECTORY_CHUNK  = 37,
+    REQ_COMMIT_TRAJECTORY_UPLOAD = 38,
+    REQ_LOAD_POINTING_MODEL      = 39,
+    REQ_SET_POINTING_MODEL       = 40,
+    REQ_GET_CONTROL_LOOP_STATS   = 41,
+    REQ_GET_METRICS              = 42,
+    END_IMPL_COMMANDS            = 43,
+    END_AMELAS_COMMANDS          = 50
 };
 
 // Specific subclass errors (0 to 30 are reserved for the base server).
 enum class AmelasServerResult : zmqutils::common::ResultType
 {
     EMPTY_CALLBACK = 31,
-    INVALID_CALLBACK = 32
+    INVALID_CALLBACK = 32,
+    BATCH_ENTRY_SKIPPED = 33
 };
 
 // Extend the base command strings with those of the subclass.
 static constexpr auto AmelasServerCommandStr = zmqutils::utils::joinArraysConstexpr(
     zmqutils::common::ServerCommandStr,
-    std::array<const char*, 5>
+    std::array<const char*, 13>
     {
         "FUTURE_EXAMPLE",
         "FUTURE_EXAMPLE",
         "REQ_SET_HOME_POSITION",
         "REQ_GET_HOME_POSITION",
+        "REQ_BATCH",
+        "REQ_BEGIN_TRAJECTORY_UPLOAD",
+        "REQ_UPLOAD_TRAJECTORY_CHUNK",
+        "REQ_COMMIT_TRAJECTORY_UPLOAD",
+        "REQ_LOAD_POINTING_MODEL",
+        "REQ_SET_POINTING_MODEL",
+        "REQ_GET_CONTROL_LOOP_STATS",
+        "REQ_GET_METRICS",
         "END_DRGG_COMMANDS"
     });
 
 // Extend the base result strings with those of the subclass.
 static constexpr auto AmelasServerResultStr = zmqutils::utils::joinArraysConstexpr(
     zmqutils::common::OperationResultStr,
-    std::array<const char*, 2>
+    std::array<const char*, 3>
     {
         "EMPTY_CALLBACK - The external callback for the command is empty.",
-        "INVALID_CALLBACK - The external callback for the command is invalid."
+        "INVALID_CALLBACK - The external callback for the command is invalid.",
+        "BATCH_ENTRY_SKIPPED - The batch entry was not executed."
     });
 
 // Usefull const expressions.
 constexpr int kMinCmdId = static_cast<int>(zmqutils::common::ServerCommand::END_BASE_COMMANDS) + 1;
 constexpr int kMaxCmdId = static_cast<int>(AmelasServerCommand::END_AMELAS_COMMANDS) - 1;
 
+// Batch execution modes for REQ_BATCH. The batch parameters are the mode, the number of entries and, for each entry,
+// the command id and its serialized parameters (std::vector<std::byte>). The reply parameters are the number of
+// entries and, for each entry, its OperationResult and its serialized reply parameters. The batch reply result is
+// COMMAND_OK whenever the batch is processed, the status of each command is in its entry result.
+// - STOP_ON_ERROR: all the entries are validated before executing any of them, and the execution stops at the first
+//                  entry that doesn't return COMMAND_OK or whose controller error is not SUCCESS. The rest are reported
+//                  as BATCH_ENTRY_SKIPPED. The batch is not atomic: the entries executed before the failure are not
+//                  undone, and each entry takes the controller lock by itself, so the other clients can observe the
+//                  batch partially applied.
+// - BEST_EFFORT:   all the entries are executed in order, whatever the result of the previous ones.
+enum class BatchMode : std::int32_t
+{
+    STOP_ON_ERROR = 0,
+    BEST_EFFORT   = 1
+};
+
+// Trajectory upload configuration. The upload is a sequence of commands:
+// - REQ_BEGIN_TRAJECTORY_UPLOAD:  params [samples (uint32)],
+//                                 reply [error][window (uint32)][max chunk samples (uint32)].
+// - REQ_UPLOAD_TRAJECTORY_CHUNK:  params [offset (uint32)][times (vector<int64>)][az (vector)][el (vector)],
+//                                 reply [error][received samples (uint32)].
+// - REQ_COMMIT_TRAJECTORY_UPLOAD: params [checksum (uint32)],
+//                                 reply [error].
+// The window is the number of credits granted by the server: the client can have that number of chunks in flight, and
+// each chunk reply returns one credit. The chunks are short write commands, so the rest of the commands and clients
+// are served between them.
+constexpr unsigned kTrajectoryUploadWindow = 8;
+
+// Pointing model commands:
+// - REQ_LOAD_POINTING_MODEL: params [slot (uint32)][terms (vector<double>, arc seconds, in PointingTerm order)],
+//                            reply [error].
+// - REQ_SET_POINTING_MODEL:  params [slot (uint32)],
+//                            reply [error].
+
+// Control loop statistics command (the durations in nanoseconds):
+// - REQ_GET_CONTROL_LOOP_STATS: no params,
+//                               reply [error][period (int64)][cycles (uint64)][missed deadlines (uint64)]
+//                                     [skipped cycles (uint64)][realtime (bool)][memory locked (bool)]
+//                                     [wake-up latency (array<int64, 7>)][execution time (array<int64, 7>)].
+// Each latency array is [count][min][mean][p50][p99][p99.9][max].
+
+// Server metrics command (the durations in nanoseconds, see ServerMetrics):
+// - REQ_GET_METRICS: params [] or [text (bool)],
+//                    reply [results (vector<uint64>, replies by OperationResult id)]
+//                          [queues (array<int64, 4>, read depth, read max depth, write depth, write max depth)]
+//                          [commands (vector<int32>)][requests (vector<uint64>)][errors (vector<uint64>)]
+//                          [latencies (vector<int64>, 4 stages x 7 values per command, in MetricsStage order)],
+//                    or reply [dump (string)] if the text parameter is true.
+// Each stage has the same values as the control loop latency arrays.
+
+// Router mode configuration.
+constexpr unsigned kDefaultRouterWorkers = 4;      ///< Default number of workers for the read only commands.
+constexpr unsigned kRouterPollTimeoutMsec = 250;   ///< Router proxy poll timeout (period of the alive checks).
+
+// Asynchronous client channel configuration. The asynchronous requests are sent from a DEALER socket with the
+// envelope [correlation id][empty][uuid][command][params], and the server replies [correlation id][empty][result]
+// [params]. The REP sockets (base server and router workers) keep the envelope, so the replies can be matched even if
+// they arrive out of order.
+constexpr unsigned kDefaultMaxInFlight = 32;         ///< Default maximum number of in-flight asynchronous requests.
+constexpr unsigned kDefaultAsyncTimeoutMsec = 5000;  ///< Default timeout for the asynchronous requests.
+constexpr unsigned kAsyncPollTimeoutMsec = 50;       ///< Asynchronous channel poll timeout (period of the timeouts).
+
+// Mount state telemetry configuration.
+constexpr unsigned kDefaultTelemetryRateHz = 50;   ///< Default telemetry publication rate.
+constexpr unsigned kMaxTelemetryRateHz = 1000;     ///< Maximum telemetry publication rate.
+
+// Mount state telemetry topics. The subscribers filter by topic prefix ("amelas." receives all of them). Each frame is
+// [topic][payload], with the payload in the packed format (native byte order):
+// - POSITION:      timestamp (int64, UTC ns), az, el.
+// - HOME_POSITION: timestamp, home az, home el.
+// - MOUNT_STATE:   timestamp, az, el, home az, home el.
+enum class TelemetryTopic : std::uint8_t
+{
+    POSITION             = 0,
+    HOME_POSITION        = 1,
+    MOUNT_STATE          = 2,
+    END_TELEMETRY_TOPICS = 3
+};
+
+static constexpr std::array<const char*, 3> TelemetryTopicStr
+{
+    "amelas.position",
+    "amelas.home",
+    "amelas.state"
+};
+
+// Commands that only read the controller state. In router mode they run concurrently in the workers pool, while the
+// rest of the commands are serialized in a single worker.
+constexpr bool isReadOnlyCommand(AmelasServerCommand command)
+{
+    switch (command)
+    {
+        case AmelasServerCommand::REQ_GET_HOME_POSITION: return true;
+        case AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS: return true;
+        case AmelasServerCommand::REQ_GET_METRICS: return true;
+        default: return false;
+    }
+}
+
+// Commands whose reply parameters start with the controller error (AmelasError).
+constexpr bool hasControllerError(AmelasServerCommand command)
+{
+    switch (command)
+    {
+        case AmelasServerCommand::REQ_BATCH: return false;
+        case AmelasServerCommand::REQ_GET_METRICS: return false;
+        default: return true;
+    }
+}
+
+// Read only commands whose controller functions only read lock-free data (the seqlock mount state block or the control
+// loop stats), so they do not need the controller lock (they never wait for the commands that modify the controller).
+constexpr bool isLockFreeCommand(AmelasServerCommand command)
+{
+    switch (command)
+    {
+        case AmelasServerCommand::REQ_GET_HOME_POSITION: return true;
+        case AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS: return true;
+        default: return false;
+    }
+}
+
 }}} // END NAMESPACES.
 // =====================================================================================================================
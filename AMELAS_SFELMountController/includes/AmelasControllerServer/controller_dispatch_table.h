@@ -0,0 +1,234 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file controller_dispatch_table.h
+ * @brief This file contains the declaration of the ControllerDispatchTable class and the command traits.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/common.h"
+#include "AmelasController/control_loop.h"
+#include "AmelasController/pointing_model.h"
+#include "AmelasControllerServer/common.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+using common::AmelasServerCommand;
+using zmqutils::common::OperationResult;
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Compile time traits of the commands with a controller callback. Each command declares the signature of its callback.
+template <AmelasServerCommand C>
+struct ControllerCommandTraits;
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_SET_HOME_POSITION>
+{
+    using Signature = controller::AmelasError(const controller::AltAzPos&);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_GET_HOME_POSITION>
+{
+    using Signature = controller::AmelasError(controller::AltAzPos&);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_BEGIN_TRAJECTORY_UPLOAD>
+{
+    using Signature = controller::AmelasError(std::uint32_t);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_UPLOAD_TRAJECTORY_CHUNK>
+{
+    using Signature = controller::AmelasError(const controller::TrajectoryChunk&);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_COMMIT_TRAJECTORY_UPLOAD>
+{
+    using Signature = controller::AmelasError(std::uint32_t);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_LOAD_POINTING_MODEL>
+{
+    using Signature = controller::AmelasError(std::uint32_t, const controller::PointingModel&);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_SET_POINTING_MODEL>
+{
+    using Signature = controller::AmelasError(std::uint32_t);
+};
+
+template <>
+struct ControllerCommandTraits<AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS>
+{
+    using Signature = controller::AmelasError(controller::ControlLoopStats&);
+};
+
+/**
+ * @brief Dense dispatch table for the controller callbacks, indexed by command id.
+ *
+ * The callbacks are registered with the command as a template parameter, so the signature is checked at compile time
+ * against the command traits. After `freeze` (called when the server starts) the registration is rejected, so the
+ * invocation doesn't need locks, lookups or casts, and never throws.
+ */
+class ControllerDispatchTable
+{
+public:
+
+    // Table configuration.
+    static constexpr std::size_t kTableSize = static_cast<std::size_t>(common::kMaxCmdId - common::kMinCmdId + 1);
+    static constexpr std::size_t kFunctionStorage = 32;   ///< Enough for any member function pointer.
+
+    // Register a controller member function for a command. Returns false if the table is frozen.
+    template <AmelasServerCommand C, typename ClassT, typename... Args>
+    bool registerCallback(ClassT* object, controller::AmelasError(ClassT::*callback)(Args...))
+    {
+        using MemFn = controller::AmelasError(ClassT::*)(Args...);
+        static_assert(ControllerDispatchTable::isValidId(C), "ControllerDispatchTable - Command out of range.");
+        static_assert(std::is_same_v<controller::AmelasError(Args...), typename ControllerCommandTraits<C>::Signature>,
+                      "ControllerDispatchTable - The callback signature does not match the command traits.");
+        static_assert(sizeof(MemFn) <= kFunctionStorage, "ControllerDispatchTable - Member function too big.");
+
+        // Check the table status.
+        if (this->frozen_.load(std::memory_order_acquire) || !object || !callback)
+            return false;
+
+        // Store the entry.
+        Entry& entry = this->entries_[ControllerDispatchTable::index(C)];
+        std::memcpy(entry.function, &callback, sizeof(MemFn));
+        entry.object = object;
+        entry.thunk = reinterpret_cast<GenericThunk>(&ControllerDispatchTable::thunk<ClassT, MemFn, Args...>);
+        return true;
+    }
+
+    // Freeze the table. Must be called before the concurrent invocations start.
+    void freeze()
+    {
+        this->frozen_.store(true, std::memory_order_release);
+    }
+
+    bool isFrozen() const
+    {
+        return this->frozen_.load(std::memory_order_acquire);
+    }
+
+    template <AmelasServerCommand C>
+    bool hasCallback() const noexcept
+    {
+        static_assert(ControllerDispatchTable::isValidId(C), "ControllerDispatchTable - Command out of range.");
+        return this->entries_[ControllerDispatchTable::index(C)].thunk != nullptr;
+    }
+
+    // Invoke the callback of a command. The controller result is stored in `result`.
+    template <AmelasServerCommand C, typename... Args>
+    OperationResult invoke(controller::AmelasError& result, Args&&... args) const noexcept
+    {
+        using Thunk = typename ThunkType<typename ControllerCommandTraits<C>::Signature>::type;
+        static_assert(ControllerDispatchTable::isValidId(C), "ControllerDispatchTable - Command out of range.");
+
+        // Check the entry.
+        const Entry& entry = this->entries_[ControllerDispatchTable::index(C)];
+        if (!entry.thunk)
+            return OperationResult::EMPTY_EXT_CALLBACK;
+
+        // Call to the controller.
+        try
+        {
+            result = reinterpret_cast<Thunk>(entry.thunk)(entry.object, entry.function, std::forward<Args>(args)...);
+            return OperationResult::COMMAND_OK;
+        }
+        catch (...)
+        {
+            return OperationResult::INVALID_EXT_CALLBACK;
+        }
+    }
+
+private:
+
+    // Type erased thunk, converted back to the typed thunk of the command traits before the call.
+    using GenericThunk = void(*)();
+
+    template <typename Signature>
+    struct ThunkType;
+
+    template <typename RetT, typename... Args>
+    struct ThunkType<RetT(Args...)>
+    {
+        using type = RetT(*)(void*, const unsigned char*, Args...);
+    };
+
+    // Table entry.
+    struct Entry
+    {
+        GenericThunk thunk = nullptr;
+        void* object = nullptr;
+        alignas(std::max_align_t) unsigned char function[kFunctionStorage] = {};
+    };
+
+    template <typename ClassT, typename MemFn, typename... Args>
+    static controller::AmelasError thunk(void* object, const unsigned char* function, Args... args)
+    {
+        MemFn callback;
+        std::memcpy(&callback, function, sizeof(MemFn));
+        return (static_cast<ClassT*>(object)->*callback)(std::forward<Args>(args)...);
+    }
+
+    static constexpr bool isValidId(AmelasServerCommand command)
+    {
+        return static_cast<int>(command) >= common::kMinCmdId && static_cast<int>(command) <= common::kMaxCmdId;
+    }
+
+    static constexpr std::size_t index(AmelasServerCommand command)
+    {
+        return static_cast<std::size_t>(static_cast<int>(command) - common::kMinCmdId);
+    }
+
+    // Members.
+    std::array<Entry, kTableSize> entries_;
+    std::atomic_bool frozen_ {false};
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,146 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file inproc_transport.h
+ * @brief This file contains the in-process transport helpers (shared context, moved objects and borrowed frames).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <cstring>
+#include <string>
+#include <utility>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include <zmq/zmq.hpp>
+#include <LibZMQUtils/Utilities/zero_copy_message.h>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+namespace common{
+// =====================================================================================================================
+
+// In-process transport. The ZMQ inproc endpoints only connect sockets of the same context, so the router mode inproc
+// endpoints and the clients asynchronous channels connected to them use the process wide getInprocContext(). Through
+// these endpoints the requests can also be sent by move: the RequestData object travels in a frame whose data is the
+// object itself (a moved frame, followed by the kMovedFrameTag frame), so the parameters are neither serialized in
+// frames nor copied, and the server replies with the CommandReply object in the same way:
+// - Moved request: [envelope][empty][uuid][command][moved RequestData][tag].
+// - Moved reply:   [envelope][empty][result][moved CommandReply][tag].
+// The moved frames are only valid within the process, so they are accepted only from the inproc endpoints.
+constexpr const char* kDefaultInprocEndpoint = "inproc://amelas_controller";   ///< Default server inproc endpoint.
+constexpr std::array<char, 8> kMovedFrameTag {'A', 'M', 'L', 'S', 'M', 'O', 'V', 'E'};
+
+// Process wide context of the inproc endpoints. It lives until the end of the process.
+LIBAMELAS_EXPORT zmq::context_t& getInprocContext();
+
+inline bool isInprocEndpoint(const std::string& endpoint)
+{
+    return endpoint.compare(0, 9, "inproc://") == 0;
+}
+
+// Release function of the moved frames.
+template <typename T>
+void releaseMovedObject(void* data, void*)
+{
+    delete static_cast<T*>(data);
+}
+
+// Frame that owns a moved object. The object is released with the frame, also if the frame is dropped.
+template <typename T>
+zmq::message_t makeMovedFrame(T&& object)
+{
+    T* moved = new T(std::move(object));
+    return zmq::message_t(moved, sizeof(T), &releaseMovedObject<T>, nullptr);
+}
+
+// Object of a moved frame received from an inproc endpoint (nullptr if the size does not match). The object still
+// belongs to the frame, so the caller can only move its contents out.
+template <typename T>
+T* getMovedObject(zmq::message_t& frame)
+{
+    return frame.size() == sizeof(T) ? static_cast<T*>(frame.data()) : nullptr;
+}
+
+inline zmq::message_t makeMovedTagFrame()
+{
+    return zmq::message_t(kMovedFrameTag.data(), kMovedFrameTag.size());
+}
+
+inline bool isMovedTagFrame(const zmq::message_t& frame)
+{
+    return frame.size() == kMovedFrameTag.size() &&
+           std::memcmp(frame.data(), kMovedFrameTag.data(), kMovedFrameTag.size()) == 0;
+}
+
+// Parameters of a request or reply borrowed from a received frame, so they are decoded in place instead of copied.
+// The params pointer of the object is set to the frame payload, which the guard keeps alive, and it is released (not
+// deleted) when the guard is destroyed. The guard must be declared after the object, and the object can't be moved
+// while the parameters are borrowed.
+template <typename T>
+class BorrowedParams
+{
+public:
+
+    explicit BorrowedParams(T& object) :
+        object_(object),
+        borrowed_(false)
+    {}
+
+    BorrowedParams(const BorrowedParams&) = delete;
+    BorrowedParams& operator=(const BorrowedParams&) = delete;
+
+    void borrow(zmq::message_t&& frame)
+    {
+        this->bytes_ = zmqutils::utils::BorrowedBytes(std::move(frame));
+        this->object_.params.reset(const_cast<std::byte*>(this->bytes_.data()));
+        this->object_.params_size = this->bytes_.size();
+        this->borrowed_ = true;
+    }
+
+    ~BorrowedParams()
+    {
+        if(this->borrowed_)
+            this->object_.params.release();
+    }
+
+private:
+
+    T& object_;
+    zmqutils::utils::BorrowedBytes bytes_;
+    bool borrowed_;
+};
+
+}}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,207 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file server_metrics.h
+ * @brief This file contains the declaration of the ServerMetrics class (per command server instrumentation).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasControllerServer/common.h"
+#include "AmelasUtils/cycle_clock.h"
+#include "AmelasUtils/latency_histogram.h"
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+using zmqutils::common::OperationResult;
+using zmqutils::common::ServerCommand;
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Server request stages. Each request records the duration of each stage that could be measured and the total.
+// - DECODE:  from the reception of the request to the start of the processing (frames, uuid, command and validation).
+// - PROCESS: execution of the command (parameters deserialization, controller callback and reply serialization).
+// - REPLY:   from the end of the processing to the reply sent (or to the send callback in the classic mode).
+// - TOTAL:   from the reception of the request to the reply.
+enum class MetricsStage : std::uint8_t
+{
+    DECODE             = 0,
+    PROCESS            = 1,
+    REPLY              = 2,
+    TOTAL              = 3,
+    END_METRICS_STAGES = 4
+};
+
+static constexpr std::array<const char*, 4> MetricsStageStr
+{
+    "DECODE",
+    "PROCESS",
+    "REPLY",
+    "TOTAL"
+};
+
+// Router mode queues (requests dispatched to the workers and not replied yet).
+enum class MetricsQueue : std::uint8_t
+{
+    READ               = 0,
+    WRITE              = 1,
+    END_METRICS_QUEUES = 2
+};
+
+// Timestamps of a request (CycleClock ticks, 0 for the points not reached or not measured).
+struct RequestTrace
+{
+    ServerCommand command = ServerCommand::INVALID_COMMAND;
+    std::uint64_t received = 0;
+    std::uint64_t decoded = 0;
+    std::uint64_t processed = 0;
+    std::uint64_t replied = 0;
+};
+
+// Metrics of a command. The latencies are in nanoseconds.
+struct CommandMetrics
+{
+    std::int32_t command = -1;                                ///< Command id (-1 for the invalid commands).
+    std::uint64_t requests = 0;                               ///< Replied requests.
+    std::uint64_t errors = 0;                                 ///< Requests replied with a result other than OK.
+    std::array<utils::LatencySummary, 4> latencies;           ///< Latency summary of each stage.
+};
+
+// Queue depth gauge (current and maximum number of requests waiting or in process).
+struct QueueMetrics
+{
+    std::int64_t depth = 0;
+    std::int64_t max_depth = 0;
+};
+
+// Snapshot of the server metrics.
+struct ServerMetricsSnapshot
+{
+    std::vector<CommandMetrics> commands;      ///< Commands with at least one request.
+    std::vector<std::uint64_t> results;        ///< Replies by OperationResult id (up to the last non zero result).
+    std::array<QueueMetrics, 2> queues;        ///< Router mode queues (MetricsQueue order).
+};
+
+/**
+ * @brief Per command request counters and latency histograms of the server.
+ *
+ * The writers are the server threads (the classic server thread or the router workers). Each thread owns a shard,
+ * so the counters and the histograms are updated with plain relaxed stores (no locked instructions and no false
+ * sharing between workers), and the timestamps are taken with the CycleClock. The per command slots of a shard are
+ * allocated the first time the command is received in that shard, so only the used commands take memory.
+ *
+ * The readers merge the shards at any time without stopping the writers, and the ticks are converted to nanoseconds
+ * only in the snapshot. The queue gauges are written only by the router proxy thread.
+ */
+class ServerMetrics
+{
+public:
+
+    static constexpr std::size_t kBaseCommandSlots = static_cast<std::size_t>(ServerCommand::RESERVED_COMMANDS);
+    static constexpr std::size_t kCustomCommandSlots = common::kMaxCmdId - common::kMinCmdId + 1;
+    static constexpr std::size_t kCommandSlots = kBaseCommandSlots + kCustomCommandSlots + 1;
+    static constexpr std::size_t kResultSlots = 64;
+    static constexpr std::size_t kStages = static_cast<std::size_t>(MetricsStage::END_METRICS_STAGES);
+
+    LIBAMELAS_EXPORT ServerMetrics();
+
+    ServerMetrics(const ServerMetrics&) = delete;
+    ServerMetrics& operator=(const ServerMetrics&) = delete;
+
+    // Clear the metrics and prepare a shard for each writer thread. It must be called when there are no writers.
+    LIBAMELAS_EXPORT void configure(std::size_t shards);
+
+    // Current ticks of the metrics clock.
+    static std::uint64_t now() noexcept {return utils::CycleClock::now();}
+
+    // Record a replied request in the shard of the calling thread.
+    LIBAMELAS_EXPORT void record(std::size_t shard, const RequestTrace& trace, OperationResult result) noexcept;
+
+    // Router mode queue gauges (only the proxy thread can call them).
+    LIBAMELAS_EXPORT void pushQueue(MetricsQueue queue) noexcept;
+    LIBAMELAS_EXPORT void popQueue(MetricsQueue queue) noexcept;
+
+    // Get a snapshot of the metrics (can be called from any thread).
+    LIBAMELAS_EXPORT ServerMetricsSnapshot getSnapshot() const;
+
+    // Text table of a snapshot (latencies in microseconds).
+    LIBAMELAS_EXPORT static std::string formatSnapshot(const ServerMetricsSnapshot& snapshot);
+
+    LIBAMELAS_EXPORT ~ServerMetrics();
+
+private:
+
+    // Counters and histograms of a command in a shard.
+    struct CommandSlot
+    {
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> errors{0};
+        std::array<utils::LatencyHistogram, kStages> stages;
+    };
+
+    // Metrics written by one thread. Aligned to avoid false sharing between the workers.
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<CommandSlot*>, kCommandSlots> commands{};
+        std::array<std::atomic<std::uint64_t>, kResultSlots> results{};
+    };
+
+    // Queue gauge written by the router proxy.
+    struct QueueGauge
+    {
+        std::atomic<std::int64_t> depth{0};
+        std::atomic<std::int64_t> max_depth{0};
+    };
+
+    // Slot of a command and command of a slot.
+    static std::size_t commandSlot(ServerCommand command) noexcept;
+    static std::int32_t slotCommand(std::size_t slot) noexcept;
+
+    // Release the shards.
+    void clear();
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::array<QueueGauge, 2> queues_;
+    mutable std::mutex mtx_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,233 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file async_logger.h
+ * @brief This file contains the declaration of the AsyncLogger class and the logging macros.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+// =====================================================================================================================
+
+// ZMQUTILS INCLUDES
+// =====================================================================================================================
+#include <LibZMQUtils/Utils>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// LOGGING MACROS
+// =====================================================================================================================
+
+// Minimum level compiled in the build (0 trace, 1 debug, 2 info, 3 warning, 4 critical, 5 disabled). The calls with a
+// lower level are discarded at compile time and the arguments are never evaluated.
+#ifndef AMELAS_LOG_COMPILE_LEVEL
+#define AMELAS_LOG_COMPILE_LEVEL 0
+#endif
+
+#define AMELAS_LOG(level, ...)                                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (static_cast<int>(level) >= AMELAS_LOG_COMPILE_LEVEL)                                             \
+        {                                                                                                              \
+            ::amelas::utils::AsyncLogger& amelas_logger_ = ::amelas::utils::AsyncLogger::getInstance();               \
+            if (amelas_logger_.isEnabled(level))                                                                       \
+                amelas_logger_.log(level, __VA_ARGS__);                                                                \
+        }                                                                                                              \
+    } while (false)
+
+#define AMELAS_LOG_TRACE(...) AMELAS_LOG(::amelas::utils::LogLevel::TRACE, __VA_ARGS__)
+#define AMELAS_LOG_DEBUG(...) AMELAS_LOG(::amelas::utils::LogLevel::DEBUG, __VA_ARGS__)
+#define AMELAS_LOG_INFO(...) AMELAS_LOG(::amelas::utils::LogLevel::INFO, __VA_ARGS__)
+#define AMELAS_LOG_WARNING(...) AMELAS_LOG(::amelas::utils::LogLevel::WARNING, __VA_ARGS__)
+#define AMELAS_LOG_CRITICAL(...) AMELAS_LOG(::amelas::utils::LogLevel::CRITICAL, __VA_ARGS__)
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// Log levels.
+enum class LogLevel : std::int32_t
+{
+    TRACE    = 0,
+    DEBUG    = 1,
+    INFO     = 2,
+    WARNING  = 3,
+    CRITICAL = 4,
+    DISABLED = 5
+};
+
+// Log level strings.
+static constexpr std::array<const char*, 6> LogLevelStr
+{
+    "TRACE",
+    "DEBUG",
+    "INFO",
+    "WARNING",
+    "CRITICAL",
+    "DISABLED"
+};
+
+// Raw bytes argument. The bytes are copied in the record and formatted as hexadecimal in the writer thread.
+struct LogHex
+{
+    const void* data;
+    std::size_t size;
+};
+
+inline LogHex logHex(const void* data, std::size_t size)
+{
+    return LogHex{data, size};
+}
+
+/**
+ * @brief Asynchronous logger with a bounded lock-free ring of binary records.
+ *
+ * The calling threads only copy the raw arguments (numbers, strings, bytes and UUIDs) in a fixed size record of a
+ * bounded MPSC ring (Vyukov queue). A background thread formats the records (timestamps, hexadecimal dumps, UUID
+ * strings) and writes them in batches. If the ring is full the record is dropped and counted, so logging never
+ * blocks the caller.
+ */
+class AsyncLogger
+{
+public:
+
+    // Ring configuration.
+    static constexpr std::size_t kRingSlots = 4096;        ///< Number of records (power of two).
+    static constexpr std::size_t kRecordPayload = 496;     ///< Bytes available for the arguments of each record.
+
+    // Get the logger instance. The writer thread is started in the first call.
+    LIBAMELAS_EXPORT static AsyncLogger& getInstance();
+
+    // Check if the level is enabled at runtime.
+    bool isEnabled(LogLevel level) const
+    {
+        return static_cast<std::int32_t>(level) >= this->level_.load(std::memory_order_relaxed);
+    }
+
+    // Set and get the runtime level.
+    LIBAMELAS_EXPORT void setLevel(LogLevel level);
+    LIBAMELAS_EXPORT LogLevel getLevel() const;
+
+    // Set the output file (appending). An empty path restores the standard output.
+    LIBAMELAS_EXPORT bool setOutputFile(const std::string& path);
+
+    // Wait until all the records logged before the call are written.
+    LIBAMELAS_EXPORT void flush();
+
+    // Get the number of records dropped because the ring was full.
+    LIBAMELAS_EXPORT std::uint64_t getDroppedRecords() const;
+
+    // Log a record. The arguments are concatenated in the final line.
+    template<typename... Args>
+    void log(LogLevel level, const Args&... args);
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    LIBAMELAS_EXPORT ~AsyncLogger();
+
+private:
+
+    // Argument types stored in the records.
+    enum class ArgType : std::uint8_t
+    {
+        BOOL,
+        SIGNED,
+        UNSIGNED,
+        REAL,
+        STRING,
+        HEX,
+        UUID
+    };
+
+    // Binary record.
+    struct Record
+    {
+        std::int64_t timestamp;                           ///< System clock time (nanoseconds since epoch).
+        LogLevel level;                                   ///< Record level.
+        std::uint16_t size;                               ///< Used payload bytes.
+        bool truncated;                                   ///< The arguments did not fit in the payload.
+        std::array<std::byte, kRecordPayload> payload;    ///< Encoded arguments.
+    };
+
+    // Ring cell.
+    struct alignas(64) Cell
+    {
+        std::atomic<std::size_t> sequence;
+        Record record;
+    };
+
+    LIBAMELAS_EXPORT AsyncLogger();
+
+    // Ring helpers.
+    LIBAMELAS_EXPORT Cell* claimCell();
+    LIBAMELAS_EXPORT void publishCell(Cell* cell);
+
+    // Encode helpers.
+    template<typename T>
+    static void encodeArg(Record& record, const T& value);
+    LIBAMELAS_EXPORT static void encodeRaw(Record& record, ArgType type, const void* data, std::size_t size,
+                                           bool with_length);
+
+    // Writer thread and formatting.
+    void writerWorker();
+    static void formatRecord(const Record& record, std::string& out);
+
+    // Ring.
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_;
+    alignas(64) std::atomic<std::size_t> dequeue_pos_;
+
+    // State.
+    std::atomic<std::int32_t> level_;
+    std::atomic<std::uint64_t> dropped_;
+    std::atomic_bool running_;
+    std::FILE* out_;
+    std::mutex out_mtx_;
+    std::thread writer_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
+
+// TEMPLATES INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/async_logger.tpp"
+// =====================================================================================================================
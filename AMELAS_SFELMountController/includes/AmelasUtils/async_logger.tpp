@@ -0,0 +1,100 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file async_logger.tpp
+ * @brief This file contains the template functions of the AsyncLogger class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+template<typename... Args>
+void AsyncLogger::log(LogLevel level, const Args&... args)
+{
+    // Get a free cell. If the ring is full, the record is dropped.
+    Cell* cell = this->claimCell();
+    if (!cell)
+        return;
+
+    // Fill the record in place.
+    Record& record = cell->record;
+    record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count();
+    record.level = level;
+    record.size = 0;
+    record.truncated = false;
+    (AsyncLogger::encodeArg(record, args), ...);
+
+    // Publish the record for the writer.
+    this->publishCell(cell);
+}
+
+template<typename T>
+void AsyncLogger::encodeArg(Record& record, const T& value)
+{
+    if constexpr (std::is_same_v<T, bool>)
+        AsyncLogger::encodeRaw(record, ArgType::BOOL, &value, sizeof(bool), false);
+    else if constexpr (std::is_same_v<T, char>)
+        AsyncLogger::encodeRaw(record, ArgType::STRING, &value, 1, true);
+    else if constexpr (std::is_enum_v<T>)
+        AsyncLogger::encodeArg(record, static_cast<std::underlying_type_t<T>>(value));
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+        const std::int64_t v = value;
+        AsyncLogger::encodeRaw(record, ArgType::SIGNED, &v, sizeof(v), false);
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        const std::uint64_t v = value;
+        AsyncLogger::encodeRaw(record, ArgType::UNSIGNED, &v, sizeof(v), false);
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        const double v = static_cast<double>(value);
+        AsyncLogger::encodeRaw(record, ArgType::REAL, &v, sizeof(v), false);
+    }
+    else if constexpr (std::is_same_v<T, LogHex>)
+        AsyncLogger::encodeRaw(record, ArgType::HEX, value.data, value.data ? value.size : 0, true);
+    else if constexpr (std::is_same_v<T, zmqutils::utils::UUID>)
+        AsyncLogger::encodeRaw(record, ArgType::UUID, value.getBytes().data(), value.getBytes().size(), false);
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+        const std::string_view str(value);
+        AsyncLogger::encodeRaw(record, ArgType::STRING, str.data(), str.size(), true);
+    }
+    else
+        static_assert(sizeof(T) == 0, "AsyncLogger - Unsupported argument type.");
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
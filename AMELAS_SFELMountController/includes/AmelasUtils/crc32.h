@@ -0,0 +1,69 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file crc32.h
+ * @brief This file contains the CRC-32 checksum helpers.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <cstddef>
+#include <cstdint>
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// CRC-32 lookup table (IEEE 802.3, reflected polynomial 0xEDB88320), generated at compile time.
+constexpr std::array<std::uint32_t, 256> makeCrc32Table()
+{
+    std::array<std::uint32_t, 256> table = {};
+    for (std::uint32_t i = 0; i < 256; i++)
+    {
+        std::uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : (crc >> 1);
+        table[i] = crc;
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint32_t, 256> kCrc32Table = makeCrc32Table();
+
+// Update a CRC-32 with a block of data. The initial value is 0, and the checksum of several blocks is obtained chaining
+// the calls (same convention as zlib `crc32`).
+inline std::uint32_t crc32(std::uint32_t crc, const void* data, std::size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++)
+        crc = kCrc32Table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,109 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file cycle_clock.h
+ * @brief This file contains the CycleClock class (cheap timestamps for the instrumentation).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <chrono>
+#include <cstdint>
+#include <thread>
+// =====================================================================================================================
+
+// SYSTEM INCLUDES
+// =====================================================================================================================
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define AMELAS_CYCLE_CLOCK_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define AMELAS_CYCLE_CLOCK_TSC
+#endif
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+/**
+ * @brief Monotonic tick counter for measuring short durations with a minimal overhead.
+ *
+ * On x86 the ticks are the time stamp counter (rdtsc, a few nanoseconds and no system call), elsewhere they are the
+ * steady clock nanoseconds. The durations are recorded in ticks and converted to nanoseconds only when they are read,
+ * using a ratio calibrated against the steady clock the first time it is needed. The rdtsc instruction is not
+ * serializing, so the timestamps can move a few cycles, which is irrelevant for the request latencies.
+ */
+class CycleClock
+{
+public:
+
+    // Current ticks.
+    static std::uint64_t now() noexcept
+    {
+#if defined(AMELAS_CYCLE_CLOCK_TSC)
+        return static_cast<std::uint64_t>(__rdtsc());
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Nanoseconds per tick. The first call calibrates the ratio (it takes kCalibrationMsec).
+    static double nanosecondsPerTick()
+    {
+        static const double ratio = CycleClock::calibrate();
+        return ratio;
+    }
+
+    // Convert ticks to nanoseconds.
+    static std::int64_t toNanoseconds(std::uint64_t ticks)
+    {
+        return static_cast<std::int64_t>(static_cast<double>(ticks) * CycleClock::nanosecondsPerTick() + 0.5);
+    }
+
+    static constexpr unsigned kCalibrationMsec = 20;
+
+private:
+
+    static double calibrate()
+    {
+#if defined(AMELAS_CYCLE_CLOCK_TSC)
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t start_ticks = CycleClock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(kCalibrationMsec));
+        const std::uint64_t ticks = CycleClock::now() - start_ticks;
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+        return ticks > 0 ? nanoseconds / static_cast<double>(ticks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
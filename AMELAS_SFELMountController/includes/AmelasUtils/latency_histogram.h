@@ -0,0 +1,219 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file latency_histogram.h
+ * @brief This file contains the LatencyHistogram class (lock-free log-linear histogram of durations).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// Summary of a histogram (values in the units of the recorded samples, usually nanoseconds).
+struct LatencySummary
+{
+    std::uint64_t count = 0;
+    std::int64_t min = 0;
+    std::int64_t mean = 0;
+    std::int64_t p50 = 0;
+    std::int64_t p99 = 0;
+    std::int64_t p999 = 0;
+    std::int64_t max = 0;
+};
+
+/**
+ * @brief Lock-free log-linear histogram of non negative durations.
+ *
+ * Each power of two is split in kSubBuckets linear buckets, so the relative error of the percentiles is below
+ * 1/kSubBuckets (6 %) for any magnitude, and the exact minimum, maximum and mean are kept apart. All the memory is
+ * inside the object (no allocations), so it can be preallocated and locked before a real time loop starts.
+ *
+ * The `record` function is wait-free (relaxed atomic increments) and can be called from several threads, and the
+ * readers get the summary at any time without stopping the writers. The summary is not an atomic snapshot (a sample
+ * recorded during the read may be partially included), which is enough for monitoring. When each histogram has only
+ * one writer thread (per thread shards), `recordSingleWriter` avoids the locked instructions, and the readers `merge`
+ * the shards into a local histogram.
+ */
+class LatencyHistogram
+{
+public:
+
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::size_t kSubBuckets = std::size_t(1) << kSubBucketBits;
+    static constexpr std::size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    LatencyHistogram()
+    {
+        this->reset();
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Record a sample (the negative values are recorded as 0).
+    void record(std::int64_t value) noexcept
+    {
+        const std::uint64_t v = value > 0 ? static_cast<std::uint64_t>(value) : 0;
+        this->counts_[LatencyHistogram::bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+        this->count_.fetch_add(1, std::memory_order_relaxed);
+        this->sum_.fetch_add(v, std::memory_order_relaxed);
+        std::uint64_t current = this->min_.load(std::memory_order_relaxed);
+        while (v < current && !this->min_.compare_exchange_weak(current, v, std::memory_order_relaxed)) {}
+        current = this->max_.load(std::memory_order_relaxed);
+        while (v > current && !this->max_.compare_exchange_weak(current, v, std::memory_order_relaxed)) {}
+    }
+
+    // Record a sample without read-modify-write atomics. Only valid if the calling thread is the only writer.
+    void recordSingleWriter(std::int64_t value) noexcept
+    {
+        const std::uint64_t v = value > 0 ? static_cast<std::uint64_t>(value) : 0;
+        auto& bucket = this->counts_[LatencyHistogram::bucketIndex(v)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        this->count_.store(this->count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        this->sum_.store(this->sum_.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+        if (v < this->min_.load(std::memory_order_relaxed))
+            this->min_.store(v, std::memory_order_relaxed);
+        if (v > this->max_.load(std::memory_order_relaxed))
+            this->max_.store(v, std::memory_order_relaxed);
+    }
+
+    // Add the samples of other histogram (for example, a shard written by other thread) to this one.
+    void merge(const LatencyHistogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < kBuckets; i++)
+            this->counts_[i].fetch_add(other.counts_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        this->count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        this->sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        const std::uint64_t min = other.min_.load(std::memory_order_relaxed);
+        std::uint64_t current = this->min_.load(std::memory_order_relaxed);
+        while (min < current && !this->min_.compare_exchange_weak(current, min, std::memory_order_relaxed)) {}
+        const std::uint64_t max = other.max_.load(std::memory_order_relaxed);
+        current = this->max_.load(std::memory_order_relaxed);
+        while (max > current && !this->max_.compare_exchange_weak(current, max, std::memory_order_relaxed)) {}
+    }
+
+    // Clear all the samples (also touches all the memory, so it can be used to prefault it).
+    void reset() noexcept
+    {
+        for (auto& count : this->counts_)
+            count.store(0, std::memory_order_relaxed);
+        this->count_.store(0, std::memory_order_relaxed);
+        this->sum_.store(0, std::memory_order_relaxed);
+        this->min_.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+        this->max_.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t getCount() const {return this->count_.load(std::memory_order_relaxed);}
+
+    // Get the value of a percentile (0 to 100). The result is the upper bound of the bucket, limited to the maximum.
+    std::int64_t getPercentile(double percentile) const noexcept
+    {
+        const std::uint64_t total = this->getCount();
+        if (total == 0)
+            return 0;
+        const double rank = std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(total);
+        const std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(rank + 0.5));
+        std::uint64_t accumulated = 0;
+        for (std::size_t i = 0; i < kBuckets; i++)
+        {
+            accumulated += this->counts_[i].load(std::memory_order_relaxed);
+            if (accumulated >= target)
+                return static_cast<std::int64_t>(std::min(LatencyHistogram::bucketUpperBound(i),
+                                                          this->max_.load(std::memory_order_relaxed)));
+        }
+        return static_cast<std::int64_t>(this->max_.load(std::memory_order_relaxed));
+    }
+
+    // Get the summary (count, min, mean, 50 %, 99 %, 99.9 % and max).
+    LatencySummary getSummary() const noexcept
+    {
+        LatencySummary summary;
+        summary.count = this->getCount();
+        if (summary.count == 0)
+            return summary;
+        summary.min = static_cast<std::int64_t>(this->min_.load(std::memory_order_relaxed));
+        summary.max = static_cast<std::int64_t>(this->max_.load(std::memory_order_relaxed));
+        summary.mean = static_cast<std::int64_t>(this->sum_.load(std::memory_order_relaxed) / summary.count);
+        summary.p50 = this->getPercentile(50.0);
+        summary.p99 = this->getPercentile(99.0);
+        summary.p999 = this->getPercentile(99.9);
+        return summary;
+    }
+
+    // Get the bucket of a value.
+    static constexpr std::size_t bucketIndex(std::uint64_t value) noexcept
+    {
+        if (value < kSubBuckets)
+            return static_cast<std::size_t>(value);
+        const unsigned msb = LatencyHistogram::highestBit(value);
+        const unsigned shift = msb - kSubBucketBits;
+        return (msb - kSubBucketBits + 1) * kSubBuckets +
+               static_cast<std::size_t>((value >> shift) & (kSubBuckets - 1));
+    }
+
+    // Get the largest value of a bucket.
+    static constexpr std::uint64_t bucketUpperBound(std::size_t index) noexcept
+    {
+        if (index < kSubBuckets)
+            return index;
+        const unsigned shift = static_cast<unsigned>(index / kSubBuckets) - 1;
+        const std::uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+        return lower + ((std::uint64_t(1) << shift) - 1);
+    }
+
+private:
+
+    // Position of the highest set bit (the value must not be 0).
+    static constexpr unsigned highestBit(std::uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned bit = 0;
+        while (value >>= 1)
+            bit++;
+        return bit;
+#endif
+    }
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> counts_;
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> sum_;
+    std::atomic<std::uint64_t> min_;
+    std::atomic<std::uint64_t> max_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,159 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file seqlock.h
+ * @brief This file contains the SeqLock class template (lock-free snapshots of small trivially copyable blocks).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+/**
+ * @brief Sequence lock for a small trivially copyable block of data.
+ *
+ * The sequence is odd while a writer is updating the block. The readers copy the block and retry if the sequence was
+ * odd or changed during the copy, so they never block the writers and always get torn-free snapshots. The data is
+ * stored in relaxed atomic words, so the concurrent copies are not data races.
+ *
+ * There is a single writer at a time (the callers must serialize the writers), so the writer never waits: it makes
+ * the sequence odd, copies the block and makes the sequence even again. The readers never block the writer.
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock - The type must be trivially copyable.");
+
+public:
+
+    static constexpr std::size_t kWords = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+    static constexpr unsigned kSpinsBeforeYield = 64;
+
+    SeqLock() : SeqLock(T{}) {}
+
+    explicit SeqLock(const T& value) :
+        seq_(0)
+    {
+        this->writeWords(value);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Replace the block.
+    void store(const T& value) noexcept
+    {
+        const std::uint64_t seq = this->lockWriter();
+        this->writeWords(value);
+        this->seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Modify the block in place (read, modify and write as a single update). The function must be short.
+    template <typename F>
+    void update(F&& function)
+    {
+        const std::uint64_t seq = this->lockWriter();
+        T value = this->readWords();
+        function(value);
+        this->writeWords(value);
+        this->seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Get a consistent snapshot, retrying while a writer is updating the block.
+    T load() const noexcept
+    {
+        T value;
+        for (unsigned spins = 0; !this->tryLoad(value); spins++)
+            if (spins >= kSpinsBeforeYield)
+                std::this_thread::yield();
+        return value;
+    }
+
+    // Try to get a consistent snapshot with a single attempt. Returns false if a writer was updating the block.
+    bool tryLoad(T& value) const noexcept
+    {
+        const std::uint64_t before = this->seq_.load(std::memory_order_acquire);
+        if (before & 1u)
+            return false;
+        const T copy = this->readWords();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->seq_.load(std::memory_order_relaxed) != before)
+            return false;
+        value = copy;
+        return true;
+    }
+
+    // Number of updates (useful to detect changes without copying the block).
+    std::uint64_t getVersion() const noexcept
+    {
+        return this->seq_.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+
+    // Mark the update start (odd sequence). Returns the previous sequence.
+    std::uint64_t lockWriter() noexcept
+    {
+        const std::uint64_t seq = this->seq_.load(std::memory_order_relaxed);
+        this->seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq;
+    }
+
+    T readWords() const noexcept
+    {
+        std::array<std::uint64_t, kWords> words;
+        for (std::size_t i = 0; i < kWords; i++)
+            words[i] = this->data_[i].load(std::memory_order_relaxed);
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+    void writeWords(const T& value) noexcept
+    {
+        std::array<std::uint64_t, kWords> words = {};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < kWords; i++)
+            this->data_[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    alignas(64) std::atomic<std::uint64_t> seq_;
+    std::array<std::atomic<std::uint64_t>, kWords> data_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,99 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file shared_memory.h
+ * @brief This file contains the declaration of the SharedMemory class (named shared memory mappings).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cstddef>
+#include <string>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "libamelas_global.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+/**
+ * @brief Named shared memory region mapped in the process.
+ *
+ * On POSIX systems the region is a shm_open object mapped with mmap, and on Windows a named file mapping backed by
+ * the paging file. The names follow the POSIX form ("/name"); on Windows the slash is replaced by the "Local\"
+ * prefix. The creator owns the name: it removes any previous object with the same name (the processes that still
+ * map it keep the old region) and unlinks the name when it is closed. On Windows the object lives while any process
+ * maps it, so the names can not be removed: if the object still exists with the same size, it is reused (`isReused`)
+ * and the creator must reinitialize it for the processes that still map it.
+ *
+ * The mapping is zero filled when created (but not when reused). The class is not thread safe.
+ */
+class SharedMemory
+{
+public:
+
+    LIBAMELAS_EXPORT SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Create a new read-write region of `size` bytes (or reuse the existing one on Windows). Returns false if it can
+    // not be created or mapped.
+    LIBAMELAS_EXPORT bool create(const std::string& name, std::size_t size);
+
+    // Map an existing region (its whole size). Returns false if it does not exist or it can not be mapped.
+    LIBAMELAS_EXPORT bool open(const std::string& name, bool writable = false);
+
+    // Unmap the region (and unlink the name if it was created by this object).
+    LIBAMELAS_EXPORT void close();
+
+    // Remove a name (the processes that map the region keep it).
+    LIBAMELAS_EXPORT static void remove(const std::string& name);
+
+    void* getData() const {return this->data_;}
+    std::size_t getSize() const {return this->size_;}
+    const std::string& getName() const {return this->name_;}
+    bool isOpen() const {return this->data_ != nullptr;}
+    bool isOwner() const {return this->owner_;}
+    bool isReused() const {return this->reused_;}
+
+    LIBAMELAS_EXPORT ~SharedMemory();
+
+private:
+
+    std::string name_;     ///< Region name.
+    void* data_;           ///< Mapped address (nullptr if closed).
+    std::size_t size_;     ///< Mapped size (bytes).
+    void* handle_;         ///< File mapping handle (Windows only).
+    bool owner_;           ///< The region was created by this object.
+    bool reused_;          ///< The region existed when it was created (Windows only).
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
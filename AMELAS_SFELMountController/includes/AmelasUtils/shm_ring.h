@@ -0,0 +1,412 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file shm_ring.h
+ * @brief This file contains the ShmRingWriter and ShmRingReader class templates (shared memory broadcast ring).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/shared_memory.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// Result of a ring read.
+enum class ShmRingResult : std::int32_t
+{
+    FRAME   = 0,    ///< A frame was read.
+    EMPTY   = 1,    ///< There are no new frames.
+    OVERRUN = 2     ///< The writer overwrote unread frames. The cursor was moved to the oldest frame available.
+};
+
+// Header at the start of a ring region. The magic is written last, so the readers never see a partial header. The
+// generation changes each time a writer initializes the region (a reused Windows region keeps its old readers).
+struct ShmRingHeader
+{
+    static constexpr std::uint64_t kMagic = 0x474E495253414D41ULL;   ///< "AMASRING" in little endian.
+    static constexpr std::uint32_t kVersion = 2;
+
+    std::atomic<std::uint64_t> magic;           ///< Magic number (0 while the writer initializes the region).
+    std::uint32_t version;                      ///< Layout version.
+    std::uint32_t frame_size;                   ///< Size of the frames (bytes).
+    std::uint64_t capacity;                     ///< Number of slots (power of two).
+    std::uint64_t frame_id;                     ///< Frame type identifier chosen by the writer.
+    std::atomic<std::uint32_t> writer_open;     ///< The writer is publishing (cleared when it is closed).
+    std::atomic<std::uint32_t> generation;      ///< Initialization of the region (starts at 1).
+    alignas(64) std::atomic<std::uint64_t> head;   ///< Number of frames published.
+};
+
+/**
+ * @brief Slot of a shared memory ring.
+ *
+ * The sequence of the slot is 2 * (i + 1) when it holds the frame i, and odd while the frame is being written, so the
+ * readers validate each copy like a seqlock. The frame is stored in relaxed atomic words, so the concurrent copies are
+ * not data races, and each slot uses its own cache lines.
+ */
+template <typename T>
+struct alignas(64) ShmRingSlot
+{
+    static constexpr std::size_t kWords = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> seq;
+    std::array<std::atomic<std::uint64_t>, kWords> data;
+};
+
+// Size of a ring region with `capacity` slots.
+template <typename T>
+constexpr std::size_t shmRingSize(std::size_t capacity)
+{
+    return ((sizeof(ShmRingHeader) + 63) / 64) * 64 + capacity * sizeof(ShmRingSlot<T>);
+}
+
+/**
+ * @brief Single writer of a shared memory broadcast ring of frames.
+ *
+ * The ring lives in a named SharedMemory region, so the readers can be in other processes. The writer never waits
+ * for the readers: each publish stores the frame in the next slot (overwriting the oldest one) and advances the head,
+ * without locked instructions or system calls. Each reader keeps its own cursor and detects when it has been overrun.
+ *
+ * Only one thread can publish at a time (the callers must serialize the publishes). The type must be trivially
+ * copyable and have the same layout in all the processes.
+ */
+template <typename T>
+class ShmRingWriter
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ShmRingWriter - The type must be trivially copyable.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmRingWriter - 64 bits atomics required.");
+
+public:
+
+    using Slot = ShmRingSlot<T>;
+
+    ShmRingWriter() :
+        header_(nullptr),
+        slots_(nullptr),
+        mask_(0),
+        head_(0)
+    {}
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // Create the ring region with `capacity` slots (rounded up to a power of two). A previous region with the same
+    // name is replaced. Returns false if the region can not be created.
+    bool create(const std::string& name, std::size_t capacity, std::uint64_t frame_id = 0)
+    {
+        this->close();
+        std::size_t slots = 2;
+        while (slots < capacity)
+            slots <<= 1;
+        if (!this->memory_.create(name, shmRingSize<T>(slots)))
+            return false;
+
+        // A reused region is still mapped by the readers of the previous writer, so it is first marked as closed
+        // and the next generation is taken for them to open it again.
+        std::byte* data = static_cast<std::byte*>(this->memory_.getData());
+        std::uint32_t generation = 1;
+        if (this->memory_.isReused())
+        {
+            ShmRingHeader* old = reinterpret_cast<ShmRingHeader*>(data);
+            old->magic.store(0, std::memory_order_relaxed);
+            old->writer_open.store(0, std::memory_order_relaxed);
+            generation = old->generation.load(std::memory_order_relaxed) + 1;
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        // Initialize the header (the new region is zero filled, and the slots are cleared for a reused one) and
+        // publish it.
+        this->header_ = new (data) ShmRingHeader();
+        this->header_->version = ShmRingHeader::kVersion;
+        this->header_->frame_size = static_cast<std::uint32_t>(sizeof(T));
+        this->header_->capacity = slots;
+        this->header_->frame_id = frame_id;
+        this->header_->writer_open.store(1, std::memory_order_relaxed);
+        this->header_->generation.store(generation, std::memory_order_relaxed);
+        this->header_->head.store(0, std::memory_order_relaxed);
+        this->slots_ = reinterpret_cast<Slot*>(data + shmRingSize<T>(0));
+        for (std::size_t i = 0; i < slots; i++)
+            new (&this->slots_[i]) Slot();
+        this->mask_ = slots - 1;
+        this->head_ = 0;
+        this->header_->magic.store(ShmRingHeader::kMagic, std::memory_order_release);
+        return true;
+    }
+
+    // Mark the ring as closed for the readers and release the region.
+    void close()
+    {
+        if (this->header_)
+            this->header_->writer_open.store(0, std::memory_order_release);
+        this->memory_.close();
+        this->header_ = nullptr;
+        this->slots_ = nullptr;
+        this->mask_ = 0;
+        this->head_ = 0;
+    }
+
+    // Publish a frame. It is wait-free: a few relaxed stores and two release stores.
+    void publish(const T& frame) noexcept
+    {
+        // Mark the slot as being written (odd sequence).
+        const std::uint64_t index = this->head_;
+        Slot& slot = this->slots_[index & this->mask_];
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // Store the frame.
+        std::array<std::uint64_t, Slot::kWords> words = {};
+        std::memcpy(words.data(), &frame, sizeof(T));
+        for (std::size_t i = 0; i < Slot::kWords; i++)
+            slot.data[i].store(words[i], std::memory_order_relaxed);
+
+        // Complete the slot and advance the head.
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        this->head_ = index + 1;
+        this->header_->head.store(index + 1, std::memory_order_release);
+    }
+
+    std::uint64_t getPublished() const {return this->head_;}
+    std::size_t getCapacity() const {return this->mask_ ? this->mask_ + 1 : 0;}
+    const std::string& getName() const {return this->memory_.getName();}
+    bool isOpen() const {return this->header_ != nullptr;}
+
+    ~ShmRingWriter()
+    {
+        this->close();
+    }
+
+private:
+
+    SharedMemory memory_;       ///< Ring region.
+    ShmRingHeader* header_;     ///< Header in the region.
+    Slot* slots_;               ///< Slots in the region.
+    std::uint64_t mask_;        ///< Capacity minus one.
+    std::uint64_t head_;        ///< Next frame index (private copy of the shared head).
+};
+
+/**
+ * @brief Reader of a shared memory broadcast ring of frames.
+ *
+ * Each reader maps the region (read only) and keeps its own cursor, so any number of readers can follow the stream
+ * at their own pace without affecting the writer or each other. A read is a few atomic loads and the copy of the
+ * frame, validated with the slot sequence: if the writer overwrote the frame during the copy, or it is more than a
+ * ring ahead, the read reports OVERRUN, the lost frames are counted and the cursor jumps to the oldest frame that is
+ * still available. The latest frame can also be read directly, without following the stream.
+ *
+ * If the writer is restarted, it creates a new region (or reinitializes the same one on Windows, with a new
+ * generation), so the readers must check `isWriterOpen` and open again.
+ * The class is not thread safe (use a reader per thread).
+ */
+template <typename T>
+class ShmRingReader
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ShmRingReader - The type must be trivially copyable.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmRingReader - 64 bits atomics required.");
+
+public:
+
+    using Slot = ShmRingSlot<T>;
+
+    ShmRingReader() :
+        header_(nullptr),
+        slots_(nullptr),
+        mask_(0),
+        cursor_(0),
+        lost_(0),
+        overruns_(0),
+        generation_(0)
+    {}
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Map a ring region, checking its header (layout version, frame size and frame identifier). The cursor starts at
+    // the head, so only the new frames are read. Returns false if the ring does not exist or it does not match.
+    bool open(const std::string& name, std::uint64_t frame_id = 0)
+    {
+        this->close();
+        if (!this->memory_.open(name))
+            return false;
+
+        // Check the header.
+        const std::byte* data = static_cast<const std::byte*>(this->memory_.getData());
+        const ShmRingHeader* header = reinterpret_cast<const ShmRingHeader*>(data);
+        if (this->memory_.getSize() < shmRingSize<T>(0) ||
+            header->magic.load(std::memory_order_acquire) != ShmRingHeader::kMagic ||
+            header->version != ShmRingHeader::kVersion || header->frame_size != sizeof(T) ||
+            header->frame_id != frame_id || header->capacity < 2 || (header->capacity & (header->capacity - 1)) ||
+            this->memory_.getSize() < shmRingSize<T>(header->capacity))
+        {
+            this->memory_.close();
+            return false;
+        }
+
+        this->header_ = header;
+        this->slots_ = reinterpret_cast<const Slot*>(data + shmRingSize<T>(0));
+        this->mask_ = header->capacity - 1;
+        this->generation_ = header->generation.load(std::memory_order_relaxed);
+        this->cursor_ = header->head.load(std::memory_order_acquire);
+        this->lost_ = 0;
+        this->overruns_ = 0;
+        return true;
+    }
+
+    void close()
+    {
+        this->memory_.close();
+        this->header_ = nullptr;
+        this->slots_ = nullptr;
+        this->mask_ = 0;
+    }
+
+    // Read the next frame of the stream.
+    ShmRingResult tryRead(T& frame) noexcept
+    {
+        // Check the available frames.
+        const std::uint64_t head = this->header_->head.load(std::memory_order_acquire);
+        if (this->cursor_ == head)
+            return ShmRingResult::EMPTY;
+        if (head - this->cursor_ > this->mask_ + 1)
+            return this->skipOverrun(head);
+
+        // Copy the frame and check that it was not overwritten.
+        if (!this->readSlot(this->cursor_, frame))
+            return this->skipOverrun(this->header_->head.load(std::memory_order_acquire));
+        this->cursor_++;
+        return ShmRingResult::FRAME;
+    }
+
+    // Read the latest frame, without moving the cursor. Returns false if there are no frames yet.
+    bool readLatest(T& frame, std::uint64_t* index = nullptr) const noexcept
+    {
+        for (;;)
+        {
+            const std::uint64_t head = this->header_->head.load(std::memory_order_acquire);
+            if (head == 0)
+                return false;
+            if (this->readSlot(head - 1, frame))
+            {
+                if (index)
+                    *index = head - 1;
+                return true;
+            }
+        }
+    }
+
+    // Move the cursor to the oldest frame still available (to read the history kept in the ring).
+    void seekOldest() noexcept
+    {
+        const std::uint64_t head = this->header_->head.load(std::memory_order_acquire);
+        this->cursor_ = head > this->mask_ ? head - this->mask_ : 0;
+    }
+
+    // Move the cursor to the head (skip the pending frames).
+    void seekHead() noexcept
+    {
+        this->cursor_ = this->header_->head.load(std::memory_order_acquire);
+    }
+
+    // Frames published and not read yet (it can be more than the capacity after an overrun).
+    std::uint64_t getAvailable() const noexcept
+    {
+        return this->header_->head.load(std::memory_order_acquire) - this->cursor_;
+    }
+
+    // Check if the writer that initialized the region is still publishing.
+    bool isWriterOpen() const noexcept
+    {
+        return this->header_->writer_open.load(std::memory_order_acquire) != 0 &&
+               this->header_->generation.load(std::memory_order_relaxed) == this->generation_;
+    }
+
+    std::uint64_t getCursor() const {return this->cursor_;}
+    std::uint64_t getLostFrames() const {return this->lost_;}
+    std::uint64_t getOverruns() const {return this->overruns_;}
+    std::size_t getCapacity() const {return this->mask_ ? this->mask_ + 1 : 0;}
+    bool isOpen() const {return this->header_ != nullptr;}
+
+    ~ShmRingReader()
+    {
+        this->close();
+    }
+
+private:
+
+    // Copy the frame `index` from its slot. Returns false if the slot does not hold it (overwritten or in progress).
+    bool readSlot(std::uint64_t index, T& frame) const noexcept
+    {
+        const Slot& slot = this->slots_[index & this->mask_];
+        const std::uint64_t seq = 2 * index + 2;
+        if (slot.seq.load(std::memory_order_acquire) != seq)
+            return false;
+        std::array<std::uint64_t, Slot::kWords> words;
+        for (std::size_t i = 0; i < Slot::kWords; i++)
+            words[i] = slot.data[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+            return false;
+        std::memcpy(static_cast<void*>(&frame), words.data(), sizeof(T));
+        return true;
+    }
+
+    // Count the lost frames and move the cursor to the oldest frame available. One slot of margin is left, because
+    // the oldest one may be being overwritten.
+    ShmRingResult skipOverrun(std::uint64_t head) noexcept
+    {
+        const std::uint64_t oldest = head > this->mask_ ? head - this->mask_ : 0;
+        const std::uint64_t cursor = oldest > this->cursor_ ? oldest : this->cursor_ + 1;
+        this->lost_ += cursor - this->cursor_;
+        this->overruns_++;
+        this->cursor_ = cursor;
+        return ShmRingResult::OVERRUN;
+    }
+
+    SharedMemory memory_;              ///< Ring region (read only).
+    const ShmRingHeader* header_;      ///< Header in the region.
+    const Slot* slots_;                ///< Slots in the region.
+    std::uint64_t mask_;               ///< Capacity minus one.
+    std::uint64_t cursor_;             ///< Next frame index to read.
+    std::uint64_t lost_;               ///< Frames lost by overruns.
+    std::uint64_t overruns_;           ///< Overruns detected.
+    std::uint32_t generation_;         ///< Generation of the region when it was opened.
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,160 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file simd_math.h
+ * @brief This file contains the vectorized math functions (AVX2, 4 doubles) used by the batch kernels.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// The vectorized functions need AVX2 and FMA (MSVC does not define __FMA__, but /arch:AVX2 enables both). They are
+// only available when the translation unit is built with them (AMELAS_ENABLE_AVX2), see AMELAS_SIMD_AVX2.
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define AMELAS_SIMD_AVX2
+#endif
+
+#ifdef AMELAS_SIMD_AVX2
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <immintrin.h>
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// The polynomials are the Cephes ones, with an error of a few ulps in the ranges used by the kernels.
+constexpr double kSimdPi = 3.14159265358979323846;
+
+// Polynomial evaluation (Horner), with the coefficients from the highest degree.
+inline __m256d polevlPd(__m256d x, const double* coefs, int degree)
+{
+    __m256d r = _mm256_set1_pd(coefs[0]);
+    for (int i = 1; i <= degree; i++)
+        r = _mm256_fmadd_pd(r, x, _mm256_set1_pd(coefs[i]));
+    return r;
+}
+
+// Sine and cosine. Valid for |x| < 1e9 (the quadrant is computed with 32 bit integers).
+inline void sincosPd(__m256d x, __m256d& s, __m256d& c)
+{
+    // Coefficients.
+    static constexpr double kSinCoefs[] = {1.58962301576546568060e-10, -2.50507477628578072866e-8,
+                                           2.75573136213857245213e-6, -1.98412698295895385996e-4,
+                                           8.33333333332211858878e-3, -1.66666666666666307295e-1};
+    static constexpr double kCosCoefs[] = {-1.13585365213876817300e-11, 2.08757008419747316778e-9,
+                                           -2.75573141792967388112e-7, 2.48015872888517045348e-5,
+                                           -1.38888888888730564116e-3, 4.16666666666665929218e-2};
+
+    // Auxiliar variables.
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d abs_x = _mm256_andnot_pd(sign_mask, x);
+
+    // Octant (j even) and reduction to [-pi/4, pi/4] (pi/4 split in three parts).
+    __m128i j32 = _mm256_cvttpd_epi32(_mm256_mul_pd(abs_x, _mm256_set1_pd(4.0 / kSimdPi)));
+    j32 = _mm_and_si128(_mm_add_epi32(j32, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    const __m256d y = _mm256_cvtepi32_pd(j32);
+    const __m256i j = _mm256_cvtepi32_epi64(j32);
+    __m256d r = _mm256_fnmadd_pd(y, _mm256_set1_pd(7.85398125648498535156e-1), abs_x);
+    r = _mm256_fnmadd_pd(y, _mm256_set1_pd(3.77489470793079817668e-8), r);
+    r = _mm256_fnmadd_pd(y, _mm256_set1_pd(2.69515142907905952645e-15), r);
+
+    // Signs and polynomial selection.
+    const __m256i four = _mm256_set1_epi64x(4);
+    const __m256d sin_sign = _mm256_xor_pd(_mm256_and_pd(x, sign_mask),
+                                           _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(j, four), 61)));
+    const __m256i j_cos = _mm256_andnot_si256(_mm256_sub_epi64(j, _mm256_set1_epi64x(2)), four);
+    const __m256d cos_sign = _mm256_castsi256_pd(_mm256_slli_epi64(j_cos, 61));
+    const __m256d use_cos = _mm256_castsi256_pd(
+        _mm256_cmpeq_epi64(_mm256_and_si256(j, _mm256_set1_epi64x(2)), _mm256_set1_epi64x(2)));
+
+    // Polynomials.
+    const __m256d z = _mm256_mul_pd(r, r);
+    __m256d poly_cos = polevlPd(z, kCosCoefs, 5);
+    poly_cos = _mm256_fmadd_pd(_mm256_mul_pd(poly_cos, z), z,
+                               _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+    __m256d poly_sin = polevlPd(z, kSinCoefs, 5);
+    poly_sin = _mm256_fmadd_pd(_mm256_mul_pd(poly_sin, z), r, r);
+
+    s = _mm256_xor_pd(_mm256_blendv_pd(poly_sin, poly_cos, use_cos), sin_sign);
+    c = _mm256_xor_pd(_mm256_blendv_pd(poly_cos, poly_sin, use_cos), cos_sign);
+}
+
+// Arc tangent (all the range).
+inline __m256d atanPd(__m256d x)
+{
+    // Coefficients.
+    static constexpr double kP[] = {-8.750608600031904122785e-1, -1.615753718733365076637e1,
+                                    -7.500855792314704667340e1, -1.228866684490136173410e2,
+                                    -6.485021904942025371773e1};
+    static constexpr double kQ[] = {1.0, 2.485846490142306297962e1, 1.650270098316988542046e2,
+                                    4.328810604912902668951e2, 4.853903996359136964868e2,
+                                    1.945506571482613964425e2};
+    constexpr double kMoreBits = 6.123233995736765886130e-17;
+
+    // Auxiliar variables.
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d abs_x = _mm256_andnot_pd(sign_mask, x);
+
+    // Range reduction: x > tan(3pi/8) uses -1/x, x > 0.66 uses (x-1)/(x+1).
+    const __m256d big = _mm256_cmp_pd(abs_x, _mm256_set1_pd(2.41421356237309504880), _CMP_GT_OQ);
+    const __m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(abs_x, _mm256_set1_pd(0.66), _CMP_GT_OQ));
+    __m256d r = _mm256_blendv_pd(abs_x, _mm256_div_pd(_mm256_sub_pd(abs_x, one), _mm256_add_pd(abs_x, one)), mid);
+    r = _mm256_blendv_pd(r, _mm256_div_pd(_mm256_set1_pd(-1.0), abs_x), big);
+    __m256d offset = _mm256_blendv_pd(zero, _mm256_set1_pd(kSimdPi / 4.0), mid);
+    offset = _mm256_blendv_pd(offset, _mm256_set1_pd(kSimdPi / 2.0), big);
+    __m256d more = _mm256_blendv_pd(zero, _mm256_set1_pd(0.5 * kMoreBits), mid);
+    more = _mm256_blendv_pd(more, _mm256_set1_pd(kMoreBits), big);
+
+    // Rational approximation.
+    const __m256d z = _mm256_mul_pd(r, r);
+    const __m256d ratio = _mm256_div_pd(_mm256_mul_pd(z, polevlPd(z, kP, 4)), polevlPd(z, kQ, 5));
+    const __m256d result = _mm256_add_pd(offset, _mm256_add_pd(_mm256_fmadd_pd(r, ratio, r), more));
+
+    return _mm256_xor_pd(result, _mm256_and_pd(x, sign_mask));
+}
+
+// Arc tangent of y/x in [-pi, pi], with the signed zeros handled as std::atan2 (the sign of x is taken from its sign
+// bit, so -0 is negative, and atan2(+-0, +0) = +-0, atan2(+-0, -0) = +-pi).
+inline __m256d atan2Pd(__m256d y, __m256d x)
+{
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d x_zero = _mm256_cmp_pd(x, zero, _CMP_EQ_OQ);
+    const __m256d both_zero = _mm256_and_pd(x_zero, _mm256_cmp_pd(y, zero, _CMP_EQ_OQ));
+    const __m256i x_sign = _mm256_castpd_si256(_mm256_and_pd(x, sign_mask));
+    const __m256d x_neg = _mm256_castsi256_pd(_mm256_cmpeq_epi64(x_sign, _mm256_castpd_si256(sign_mask)));
+    const __m256d y_sign = _mm256_and_pd(y, sign_mask);
+    const __m256d pi_signed = _mm256_or_pd(_mm256_set1_pd(kSimdPi), y_sign);
+    const __m256d atan = atanPd(_mm256_div_pd(y, x));
+    const __m256d r = _mm256_blendv_pd(atan, _mm256_add_pd(atan, pi_signed), x_neg);
+    return _mm256_blendv_pd(r, _mm256_blendv_pd(y_sign, pi_signed, x_neg), both_zero);
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
+
+#endif
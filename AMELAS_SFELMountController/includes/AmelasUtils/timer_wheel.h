@@ -0,0 +1,231 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file timer_wheel.h
+ * @brief This file contains the TimerWheel class (hierarchical timing wheel for many timeouts).
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// =====================================================================================================================
+#pragma once
+// =====================================================================================================================
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+/**
+ * @brief Hierarchical timing wheel for a large number of timers identified by small integers.
+ *
+ * The time is measured in ticks (the user chooses the tick duration). The wheel has kLevels levels of kSlots slots:
+ * the level 0 holds the timers of the current kSlots ticks window, and each upper level covers kSlots windows of the
+ * level below. A timer is placed in the level of the highest group of bits in which its expiration differs from the
+ * current tick, and it is moved down (cascaded) when the wheel reaches its window. The timers beyond the span of the
+ * wheel wait in an overflow list, checked once per turn of the top level.
+ *
+ * Scheduling and cancelling are O(1) (the timers are intrusive doubly linked lists stored in arrays indexed by the
+ * timer id, so there are no allocations except when the ids grow). Advancing costs O(ticks + expired + cascaded),
+ * independent of the number of pending timers.
+ *
+ * The class is not thread safe.
+ */
+class TimerWheel
+{
+public:
+
+    static constexpr unsigned kLevelBits = 6;
+    static constexpr unsigned kLevels = 4;
+    static constexpr std::size_t kSlots = std::size_t(1) << kLevelBits;
+    static constexpr unsigned kSpanBits = kLevelBits * kLevels;
+    static constexpr std::uint32_t kNil = std::numeric_limits<std::uint32_t>::max();
+
+    explicit TimerWheel(std::uint64_t start_tick = 0) :
+        current_(start_tick),
+        size_(0)
+    {
+        this->heads_.fill(kNil);
+    }
+
+    // Schedule a timer (rescheduling it if it is already pending). The expirations in the past fire in the next tick.
+    void schedule(std::uint32_t id, std::uint64_t expires)
+    {
+        if (id >= this->links_.size())
+            this->links_.resize(static_cast<std::size_t>(id) + 1);
+        if (this->links_[id].scheduled)
+            this->unlink(id);
+        else
+            this->size_++;
+        this->links_[id].expires = expires < this->current_ ? this->current_ : expires;
+        this->links_[id].scheduled = true;
+        this->place(id);
+    }
+
+    // Cancel a timer (nothing happens if it is not pending).
+    void cancel(std::uint32_t id)
+    {
+        if (!this->isScheduled(id))
+            return;
+        this->unlink(id);
+        this->links_[id].scheduled = false;
+        this->size_--;
+    }
+
+    bool isScheduled(std::uint32_t id) const
+    {
+        return id < this->links_.size() && this->links_[id].scheduled;
+    }
+
+    // Advance the wheel up to the given tick (included), calling `expired(id)` for each expired timer. The callback
+    // can schedule or cancel any timer (the new expirations are at least the next tick).
+    template <typename Callback>
+    void advance(std::uint64_t tick, Callback&& expired)
+    {
+        while (this->current_ <= tick)
+        {
+            const std::uint64_t now = this->current_;
+
+            // Cascade the upper levels whose window starts now, from the top level down.
+            if ((now & (kSlots - 1)) == 0)
+            {
+                unsigned level = 1;
+                while (level < kLevels && ((now >> (kLevelBits * level)) & (kSlots - 1)) == 0)
+                    level++;
+                if (level == kLevels)
+                    this->cascade(kOverflowList);
+                for (unsigned l = std::min(level, kLevels - 1); l >= 1; l--)
+                    this->cascade(TimerWheel::slotIndex(l, now));
+            }
+
+            // Move the timers of this tick to the firing list and fire them one by one, so the callback can schedule or
+            // cancel any timer (also the ones still in the firing list).
+            std::uint32_t id = this->heads_[TimerWheel::slotIndex(0, now)];
+            this->heads_[TimerWheel::slotIndex(0, now)] = kNil;
+            this->heads_[kFiringList] = id;
+            for (; id != kNil; id = this->links_[id].next)
+                this->links_[id].list = kFiringList;
+            this->current_ = now + 1;
+            while ((id = this->heads_[kFiringList]) != kNil)
+            {
+                this->unlink(id);
+                this->links_[id].scheduled = false;
+                this->size_--;
+                expired(id);
+            }
+        }
+    }
+
+    // Remove all the timers.
+    void clear()
+    {
+        this->heads_.fill(kNil);
+        this->links_.clear();
+        this->size_ = 0;
+    }
+
+    std::uint64_t getCurrentTick() const {return this->current_;}
+
+    std::size_t size() const {return this->size_;}
+
+private:
+
+    // Lists: kSlots per level, the overflow list and the list of the timers being fired.
+    static constexpr std::size_t kOverflowList = kLevels * kSlots;
+    static constexpr std::size_t kFiringList = kOverflowList + 1;
+
+    struct Link
+    {
+        std::uint32_t prev = kNil;
+        std::uint32_t next = kNil;
+        std::uint64_t expires = 0;
+        std::uint16_t list = 0;
+        bool scheduled = false;
+    };
+
+    static constexpr std::size_t slotIndex(unsigned level, std::uint64_t tick)
+    {
+        return level * kSlots + static_cast<std::size_t>((tick >> (kLevelBits * level)) & (kSlots - 1));
+    }
+
+    // List of an expiration, relative to the current tick.
+    std::size_t listFor(std::uint64_t expires) const
+    {
+        const std::uint64_t diff = expires ^ this->current_;
+        if (diff >> kSpanBits)
+            return kOverflowList;
+        unsigned level = 0;
+        while (diff >> (kLevelBits * (level + 1)))
+            level++;
+        return TimerWheel::slotIndex(level, expires);
+    }
+
+    void place(std::uint32_t id)
+    {
+        Link& link = this->links_[id];
+        link.list = static_cast<std::uint16_t>(this->listFor(link.expires));
+        std::uint32_t& head = this->heads_[link.list];
+        link.prev = kNil;
+        link.next = head;
+        if (head != kNil)
+            this->links_[head].prev = id;
+        head = id;
+    }
+
+    void unlink(std::uint32_t id)
+    {
+        Link& link = this->links_[id];
+        if (link.next != kNil)
+            this->links_[link.next].prev = link.prev;
+        if (link.prev != kNil)
+            this->links_[link.prev].next = link.next;
+        else
+            this->heads_[link.list] = link.next;
+    }
+
+    // Move the timers of a list to their new positions.
+    void cascade(std::size_t list)
+    {
+        std::uint32_t id = this->heads_[list];
+        this->heads_[list] = kNil;
+        while (id != kNil)
+        {
+            const std::uint32_t next = this->links_[id].next;
+            this->place(id);
+            id = next;
+        }
+    }
+
+    std::vector<Link> links_;
+    std::array<std::uint32_t, kFiringList + 1> heads_;
+    std::uint64_t current_;
+    std::size_t size_;
+};
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -21,9 +21,21 @@
  * @version 2309.5
 ***********************************************************************************************************************/
 
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+// =====================================================================================================================
+
 // PROJECT INCLUDES
 // =====================================================================================================================
 #include "AmelasController/amelas_controller.h"
+#include "AmelasUtils/async_logger.h"
 // =====================================================================================================================
 
 // AMELAS NAMESPACES
@@ -31,9 +43,43 @@
 namespace amelas{
 namespace controller{
 
+template <typename F>
+void AmelasController::updateState(F&& function)
+{
+    // Single writer, so the frames of the ring follow the order of the updates.
+    this->applyStateRequests();
+    function(this->writer_state_);
+    this->state_.store(this->writer_state_);
+    if (this->state_ring_)
+        this->state_ring_->publish(this->writer_state_);
+}
+
 AmelasController::AmelasController() :
-    home_pos_(-1,-1)
-{}
+    state_writer_(StateWriter::NONE),
+    home_applied_(0),
+    state_ring_pending_(false),
+    upload_expected_(0),
+    upload_checksum_(0),
+    upload_active_(false),
+    interpolator_(std::make_shared<TrajectoryInterpolator>()),
+    interpolator_version_(0),
+    interp_method_(kDefaultInterpolationMethod),
+    interp_order_(kDefaultInterpolationOrder),
+    pointing_slot_(0),
+    loop_version_(0),
+    loop_time_(0),
+    loop_tracking_(false)
+{
+    // All the slots start with the null model.
+    for (auto& slot : this->pointing_slots_)
+        slot = std::make_shared<const PointingModel>();
+    this->pointing_model_ = this->pointing_slots_[0];
+}
+
+AmelasController::~AmelasController()
+{
+    this->stopControlLoop();
+}
 
 AmelasError AmelasController::setHomePosition(const AltAzPos &pos)
 {
@@ -47,7 +93,12 @@ AmelasError AmelasController::setHomePosition(const AltAzPos &pos)
     }
     else
     {
-        this->home_pos_ = pos;
+        // Update the home position (the mount position does not change) and wait until it is in the mount state.
+        {
+            std::lock_guard<std::mutex> lock(this->home_mtx_);
+            this->home_.store(HomeBlock{pos.az, pos.el});
+        }
+        this->syncStateRequests();
     }
 
     // Do things in the hardware (PLC) or FPGA.
@@ -56,29 +107,20 @@ AmelasError AmelasController::setHomePosition(const AltAzPos &pos)
     // [...]
 
     // Log.
-    std::string cmd_str = ControllerErrorStr[static_cast<size_t>(error)];
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS CONTROLLER>"<<std::endl;
-    std::cout<<"-> SET_HOME_POSITION"<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Az: "<<pos.az<<std::endl;
-    std::cout<<"El: "<<pos.el<<std::endl;
-    std::cout<<"Error: "<<static_cast<int>(error)<<" ("<<cmd_str<<")"<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> SET_HOME_POSITION | Az: ", pos.az, " | El: ", pos.el,
+                    " | Error: ", static_cast<int>(error), " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
 
     return error;
 }
 
 AmelasError AmelasController::getHomePosition(AltAzPos &pos)
 {
-    pos = this->home_pos_;
+    const HomeBlock home = this->home_.load();
+    pos = AltAzPos(home.az, home.el);
+
+    // Log.
+    AMELAS_LOG_DEBUG("<AMELAS CONTROLLER> GET_HOME_POSITION");
 
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS CONTROLLER>"<<std::endl;
-    std::cout<<"-> GET_HOME_POSITION"<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
-    
     return AmelasError::SUCCESS;
 }
 
@@ -87,6 +129,454 @@ AmelasError AmelasController::getDatetime(std::string &)
     return AmelasError::SUCCESS;
 }
 
+AmelasError AmelasController::getMountState(MountState &state)
+{
+    // Get a consistent snapshot of the state block.
+    const MountStateBlock block = this->state_.load();
+
+    state.timestamp = block.timestamp;
+    state.position = AltAzPos(block.az, block.el);
+    state.velocity = AltAzPos(block.az_rate, block.el_rate);
+    state.home_position = AltAzPos(block.home_az, block.home_el);
+    state.status = block.status;
+    state.error = block.error;
+
+    return AmelasError::SUCCESS;
+}
+
+AmelasError AmelasController::beginTrajectoryUpload(std::uint32_t samples)
+{
+    // Auxiliar result.
+    AmelasError error = AmelasError::SUCCESS;
+
+    // Check the size and reset the staging buffer. A previous upload in progress is discarded.
+    if (samples == 0 || samples > this->upload_buffer_.capacity())
+    {
+        error = AmelasError::INVALID_TRAJECTORY;
+    }
+    else
+    {
+        this->upload_buffer_.size = 0;
+        this->upload_expected_ = samples;
+        this->upload_checksum_ = 0;
+        this->upload_active_ = true;
+    }
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> BEGIN_TRAJECTORY_UPLOAD | Samples: ", samples,
+                    " | Error: ", static_cast<int>(error), " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
+
+    return error;
+}
+
+AmelasError AmelasController::uploadTrajectoryChunk(const TrajectoryChunk &chunk)
+{
+    // Check the upload status and the chunk position. The chunks must be received in order.
+    if (!this->upload_active_)
+        return AmelasError::NO_TRAJECTORY_UPLOAD;
+    if (chunk.count == 0 || chunk.count > kMaxTrajectoryChunkSamples || chunk.offset != this->upload_buffer_.size ||
+        chunk.offset + chunk.count > this->upload_expected_)
+        return AmelasError::INVALID_TRAJECTORY;
+
+    // Check the samples (valid positions and strictly increasing times).
+    std::int64_t last_time = chunk.offset ? this->upload_buffer_.timestamps[chunk.offset - 1] :
+                                            std::numeric_limits<std::int64_t>::min();
+    for (std::uint32_t i = 0; i < chunk.count; i++)
+    {
+        if (chunk.timestamps[i] <= last_time || chunk.az[i] >= 360.0 || chunk.az[i] < 0.0 ||
+            chunk.el[i] > 90.0 || chunk.el[i] < 0.0)
+            return AmelasError::INVALID_TRAJECTORY;
+        last_time = chunk.timestamps[i];
+    }
+
+    // Store the samples and update the checksum.
+    std::copy(chunk.timestamps, chunk.timestamps + chunk.count, this->upload_buffer_.timestamps.begin() + chunk.offset);
+    std::copy(chunk.az, chunk.az + chunk.count, this->upload_buffer_.az.begin() + chunk.offset);
+    std::copy(chunk.el, chunk.el + chunk.count, this->upload_buffer_.el.begin() + chunk.offset);
+    this->upload_buffer_.size += chunk.count;
+    this->upload_checksum_ = updateTrajectoryChecksum(this->upload_checksum_, chunk.timestamps, chunk.az, chunk.el,
+                                                      chunk.count);
+
+    // Log.
+    AMELAS_LOG_TRACE("<AMELAS CONTROLLER> UPLOAD_TRAJECTORY_CHUNK | Offset: ", chunk.offset,
+                     " | Count: ", chunk.count);
+
+    return AmelasError::SUCCESS;
+}
+
+AmelasError AmelasController::commitTrajectoryUpload(std::uint32_t checksum)
+{
+    // Auxiliar result.
+    AmelasError error = AmelasError::SUCCESS;
+
+    // Check the upload and activate the new trajectory. The upload finishes with the commit, whatever the result.
+    if (!this->upload_active_)
+        error = AmelasError::NO_TRAJECTORY_UPLOAD;
+    else if (this->upload_buffer_.size != this->upload_expected_)
+        error = AmelasError::INVALID_TRAJECTORY;
+    else if (checksum != this->upload_checksum_)
+        error = AmelasError::TRAJECTORY_CHECKSUM_ERROR;
+    else if ((error = this->prepareTrajectory(this->upload_buffer_, *this->getPointingModel(), this->interp_method_,
+                                              this->interp_order_)) == AmelasError::SUCCESS)
+        std::swap(this->trajectory_, this->upload_buffer_);
+    this->upload_active_ = false;
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> COMMIT_TRAJECTORY_UPLOAD | Samples: ", this->trajectory_.size,
+                    " | Checksum: ", checksum, " | Error: ", static_cast<int>(error),
+                    " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
+
+    return error;
+}
+
+AmelasError AmelasController::setInterpolation(InterpolationMethod method, unsigned order)
+{
+    // Auxiliar result.
+    AmelasError error = AmelasError::SUCCESS;
+
+    // Check the configuration and prepare the active trajectory with the new interpolation.
+    if (!TrajectoryInterpolator::isValidConfiguration(method, order))
+        error = AmelasError::INVALID_INTERPOLATION;
+    else if (this->trajectory_.size)
+        error = this->prepareTrajectory(this->trajectory_, *this->getPointingModel(), method, order);
+
+    // Store the configuration.
+    if (error == AmelasError::SUCCESS)
+    {
+        this->interp_method_ = method;
+        this->interp_order_ = order;
+    }
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> SET_INTERPOLATION | Method: ", static_cast<int>(method), " | Order: ", order,
+                    " | Error: ", static_cast<int>(error), " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
+
+    return error;
+}
+
+AmelasError AmelasController::getTrajectoryPosition(std::int64_t time, AltAzPos &pos)
+{
+    return std::atomic_load(&this->interpolator_)->evaluate(time, pos) ?
+               AmelasError::SUCCESS : AmelasError::OUT_OF_TRAJECTORY;
+}
+
+AmelasError AmelasController::loadPointingModel(std::uint32_t slot, const PointingModel &model)
+{
+    // Auxiliar result.
+    AmelasError error = AmelasError::SUCCESS;
+
+    // Check the slot and the model. If it is the active slot, the active trajectory is corrected with the new model
+    // first, so the slot and the active model are only replaced if it succeeds.
+    if (slot >= kPointingModelSlots || !model.isValid())
+    {
+        error = AmelasError::INVALID_POINTING_MODEL;
+    }
+    else
+    {
+        auto new_model = std::make_shared<const PointingModel>(model);
+        const bool active = (slot == this->pointing_slot_);
+        if (active && this->trajectory_.size)
+            error = this->prepareTrajectory(this->trajectory_, *new_model, this->interp_method_, this->interp_order_);
+        if (error == AmelasError::SUCCESS)
+        {
+            this->pointing_slots_[slot] = new_model;
+            if (active)
+                std::atomic_store(&this->pointing_model_, new_model);
+        }
+    }
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> LOAD_POINTING_MODEL | Slot: ", slot,
+                    " | Error: ", static_cast<int>(error), " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
+
+    return error;
+}
+
+AmelasError AmelasController::setPointingModel(std::uint32_t slot)
+{
+    // Auxiliar result.
+    AmelasError error = AmelasError::SUCCESS;
+
+    // Check the slot and correct the active trajectory with the new model. The previous model is kept if there is
+    // any error.
+    if (slot >= kPointingModelSlots)
+        error = AmelasError::INVALID_POINTING_MODEL;
+    else if (this->trajectory_.size)
+        error = this->prepareTrajectory(this->trajectory_, *this->pointing_slots_[slot], this->interp_method_,
+                                        this->interp_order_);
+
+    // Switch the active model.
+    if (error == AmelasError::SUCCESS)
+    {
+        std::atomic_store(&this->pointing_model_, this->pointing_slots_[slot]);
+        this->pointing_slot_ = slot;
+    }
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> SET_POINTING_MODEL | Slot: ", slot,
+                    " | Error: ", static_cast<int>(error), " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
+
+    return error;
+}
+
+std::shared_ptr<const PointingModel> AmelasController::getPointingModel() const
+{
+    return std::atomic_load(&this->pointing_model_);
+}
+
+AmelasError AmelasController::simulateTrajectory(MountSimulator &simulator, TrackingStats &stats)
+{
+    // Track the trajectory, publishing each simulated state (the home position is kept). The simulation takes the
+    // state writer role with its first state (so the commands are applied while it waits for the start), and it does
+    // not publish while the control loop holds it.
+    bool writer = false;
+    const auto interpolator = std::atomic_load(&this->interpolator_);
+    const AmelasError error = simulator.track(*interpolator, stats, [this, &writer](const MountStateBlock& sim_state)
+    {
+        if (!writer)
+            writer = this->acquireStateWriter(StateWriter::SIMULATION);
+        if (!writer)
+            return;
+        this->updateState([&sim_state](MountStateBlock& state)
+        {
+            state.timestamp = sim_state.timestamp;
+            state.az = sim_state.az;
+            state.el = sim_state.el;
+            state.az_rate = sim_state.az_rate;
+            state.el_rate = sim_state.el_rate;
+            state.status = sim_state.status;
+            state.error = sim_state.error;
+        });
+    });
+    if (writer)
+        this->releaseStateWriter();
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> SIMULATE_TRAJECTORY | Steps: ", stats.steps, " | RMS error: ",
+                    stats.rms_error, " arcsec | Max error: ", stats.max_error, " arcsec | Wall time: ", stats.wall_time,
+                    " s | Error: ", static_cast<int>(error), " (", ControllerErrorStr[static_cast<size_t>(error)], ")");
+
+    return error;
+}
+
+bool AmelasController::startControlLoop(const ControlLoopConfig &config)
+{
+    // The loop is the only writer of the mount state while it runs.
+    if (!this->acquireStateWriter(StateWriter::CONTROL_LOOP))
+    {
+        AMELAS_LOG_WARNING("<AMELAS CONTROLLER> START_CONTROL_LOOP | The mount state is already driven.");
+        return false;
+    }
+
+    // Get the active interpolator before the first cycle. The version is read first, so a trajectory published in
+    // between is loaded again in the next cycle.
+    this->loop_version_ = this->interpolator_version_.load(std::memory_order_acquire);
+    this->loop_interpolator_ = std::atomic_load(&this->interpolator_);
+    this->loop_tracking_ = false;
+
+    const bool started = this->control_loop_.start(config, [this](std::int64_t time, std::uint64_t cycle)
+                                                   {this->controlCycle(time, cycle);});
+    if (!started)
+        this->releaseStateWriter();
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> START_CONTROL_LOOP | Period: ", config.period, " ns | Started: ", started);
+
+    return started;
+}
+
+void AmelasController::stopControlLoop()
+{
+    this->control_loop_.stop();
+    if (this->state_writer_.load(std::memory_order_acquire) == StateWriter::CONTROL_LOOP)
+        this->releaseStateWriter();
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> STOP_CONTROL_LOOP");
+}
+
+AmelasError AmelasController::getControlLoopStats(ControlLoopStats &stats)
+{
+    this->control_loop_.getStats(stats);
+
+    // Log.
+    AMELAS_LOG_DEBUG("<AMELAS CONTROLLER> GET_CONTROL_LOOP_STATS");
+
+    return AmelasError::SUCCESS;
+}
+
+bool AmelasController::enableStateRing(const std::string &name, std::size_t capacity)
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->state_ring_mtx_);
+
+    // Close the previous ring first (closing it unlinks its name, which may be the same).
+    this->replaceStateRing(nullptr);
+
+    // Create the ring outside the state writer (it maps the shared memory) and hand it to the writer. The current
+    // state is its first frame.
+    auto ring = std::make_unique<MountStateRingWriter>();
+    const bool created = ring->create(name, capacity, kMountStateFrameId);
+    if (created)
+        this->replaceStateRing(std::move(ring));
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> ENABLE_STATE_RING | Name: ", name, " | Capacity: ", capacity,
+                    " | Enabled: ", created);
+
+    return created;
+}
+
+void AmelasController::disableStateRing()
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->state_ring_mtx_);
+
+    this->replaceStateRing(nullptr);
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROLLER> DISABLE_STATE_RING");
+}
+
+void AmelasController::controlCycle(std::int64_t time, std::uint64_t)
+{
+    // Get the new interpolator only when it changes (the shared_ptr is not touched in the rest of the cycles). A new
+    // trajectory starts without a previous setpoint, so its first rate is not computed against the old trajectory.
+    const std::uint64_t version = this->interpolator_version_.load(std::memory_order_acquire);
+    const bool was_tracking = this->loop_tracking_;
+    if (version != this->loop_version_)
+    {
+        this->loop_interpolator_ = std::atomic_load(&this->interpolator_);
+        this->loop_version_ = version;
+        this->loop_tracking_ = false;
+        this->loop_setpoint_ = AltAzPos();
+        this->loop_time_ = time;
+    }
+
+    // Evaluate the setpoint. Outside the trajectory (or without any) the mount stops.
+    AltAzPos setpoint;
+    if (!this->loop_interpolator_ || !this->loop_interpolator_->evaluate(time, setpoint))
+    {
+        if (was_tracking)
+        {
+            this->updateState([time](MountStateBlock& state)
+            {
+                state.timestamp = time;
+                state.az_rate = 0.0;
+                state.el_rate = 0.0;
+                state.status = MountStatus::IDLE;
+            });
+            this->loop_tracking_ = false;
+        }
+        else if (this->hasStateRequests())
+            this->updateState([](MountStateBlock&){});
+        return;
+    }
+
+    // The setpoint is published as the mount position (with hardware, it would be sent to the PLC/FPGA and the
+    // position read from the encoders).
+    const double dt = static_cast<double>(time - this->loop_time_) * 1e-9;
+    const double az_rate = this->loop_tracking_ ?
+                               std::remainder(setpoint.az - this->loop_setpoint_.az, 360.0) / dt : 0.0;
+    const double el_rate = this->loop_tracking_ ? (setpoint.el - this->loop_setpoint_.el) / dt : 0.0;
+    this->updateState([time, &setpoint, az_rate, el_rate](MountStateBlock& state)
+    {
+        state.timestamp = time;
+        state.az = setpoint.az;
+        state.el = setpoint.el;
+        state.az_rate = az_rate;
+        state.el_rate = el_rate;
+        state.status = MountStatus::TRACKING;
+    });
+    this->loop_setpoint_ = setpoint;
+    this->loop_time_ = time;
+    this->loop_tracking_ = true;
+}
+
+bool AmelasController::acquireStateWriter(StateWriter writer)
+{
+    // Wait only for the commands (their updates are short).
+    StateWriter expected = StateWriter::NONE;
+    for (unsigned spins = 0; !this->state_writer_.compare_exchange_weak(expected, writer, std::memory_order_acquire,
+                                                                        std::memory_order_relaxed); spins++)
+    {
+        if (expected != StateWriter::NONE && expected != StateWriter::COMMAND)
+            return false;
+        expected = StateWriter::NONE;
+        if (spins >= 64)
+            std::this_thread::yield();
+    }
+    return true;
+}
+
+void AmelasController::releaseStateWriter()
+{
+    this->state_writer_.store(StateWriter::NONE, std::memory_order_release);
+}
+
+void AmelasController::applyStateRequests()
+{
+    // Home position. If it is being written, it is applied in the next update (the writer never waits).
+    const std::uint64_t home_version = this->home_.getVersion();
+    HomeBlock home;
+    if (home_version != this->home_applied_.load(std::memory_order_relaxed) && this->home_.tryLoad(home))
+    {
+        this->writer_state_.home_az = home.az;
+        this->writer_state_.home_el = home.el;
+        this->home_applied_.store(home_version, std::memory_order_release);
+    }
+
+    // State ring. The previous one is left in the request slot, so it is closed by the command thread.
+    if (this->state_ring_pending_.load(std::memory_order_acquire))
+    {
+        std::swap(this->state_ring_, this->state_ring_request_);
+        this->state_ring_pending_.store(false, std::memory_order_release);
+    }
+}
+
+bool AmelasController::hasStateRequests() const
+{
+    return this->state_ring_pending_.load(std::memory_order_acquire) ||
+           this->home_.getVersion() != this->home_applied_.load(std::memory_order_acquire);
+}
+
+void AmelasController::syncStateRequests()
+{
+    // The control loop (or a simulation) applies the requests in its next update. If it stops, the role is free.
+    while (!this->acquireStateWriter(StateWriter::COMMAND))
+    {
+        if (!this->hasStateRequests())
+            return;
+        std::this_thread::yield();
+    }
+    this->updateState([](MountStateBlock&){});
+    this->releaseStateWriter();
+}
+
+void AmelasController::replaceStateRing(std::unique_ptr<MountStateRingWriter> ring)
+{
+    // Hand the ring to the state writer and close the previous one here, so the writer never waits for the unmap.
+    this->state_ring_request_ = std::move(ring);
+    this->state_ring_pending_.store(true, std::memory_order_release);
+    this->syncStateRequests();
+    this->state_ring_request_.reset();
+}
+
+AmelasError AmelasController::prepareTrajectory(const TrajectoryBuffer &trajectory, const PointingModel &model,
+                                                InterpolationMethod method, unsigned order)
+{
+    // Prepare a new interpolator and publish it (the active one is kept if there is any error).
+    model.apply(trajectory, this->mount_trajectory_);
+    auto interpolator = std::make_shared<TrajectoryInterpolator>();
+    const AmelasError error = interpolator->prepare(this->mount_trajectory_, method, order);
+    if (error == AmelasError::SUCCESS)
+    {
+        std::atomic_store(&this->interpolator_, std::shared_ptr<const TrajectoryInterpolator>(std::move(interpolator)));
+        this->interpolator_version_.fetch_add(1, std::memory_order_release);
+    }
+    return error;
+}
+
 // =====================================================================================================================
 
 }} // END NAMESPACES.
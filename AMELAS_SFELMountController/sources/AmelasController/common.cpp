@@ -21,9 +21,15 @@
  * @version 2309.5
 ***********************************************************************************************************************/
 
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cstring>
+// =====================================================================================================================
+
 // PROJECT INCLUDES
 // =====================================================================================================================
 #include "AmelasController/common.h"
+#include "AmelasUtils/crc32.h"
 // =====================================================================================================================
 
 // AMELAS NAMESPACES
@@ -53,6 +59,25 @@ size_t AltAzPos::serializedSize() const
 
 AltAzPos::~AltAzPos(){}
 
+TrajectoryBuffer::TrajectoryBuffer(std::size_t capacity) :
+    timestamps(capacity), az(capacity), el(capacity)
+{}
+
+std::uint32_t updateTrajectoryChecksum(std::uint32_t crc, const std::int64_t* timestamps, const double* az,
+                                       const double* el, std::size_t count)
+{
+    // Interleave each sample in a small buffer, so the checksum doesn't depend on the storage layout.
+    unsigned char sample[sizeof(std::int64_t) + 2 * sizeof(double)];
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::memcpy(sample, &timestamps[i], sizeof(std::int64_t));
+        std::memcpy(sample + sizeof(std::int64_t), &az[i], sizeof(double));
+        std::memcpy(sample + sizeof(std::int64_t) + sizeof(double), &el[i], sizeof(double));
+        crc = utils::crc32(crc, sample, sizeof(sample));
+    }
+    return crc;
+}
+
 // =====================================================================================================================
 
 
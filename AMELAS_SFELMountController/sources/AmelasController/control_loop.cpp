@@ -0,0 +1,269 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file control_loop.cpp
+ * @brief This file contains the implementation of the ControlLoop class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <utility>
+// =====================================================================================================================
+
+// SYSTEM INCLUDES
+// =====================================================================================================================
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/control_loop.h"
+#include "AmelasUtils/async_logger.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+namespace{
+
+// Monotonic time (nanoseconds).
+std::int64_t monotonicNow()
+{
+#if defined(__linux__)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Sleep until a monotonic time (nanoseconds).
+void sleepUntilMonotonic(std::int64_t time)
+{
+#if defined(__linux__)
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(time / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(time % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(time))));
+#endif
+}
+
+// Touch the stack that the loop will use, so the pages are mapped (and locked) before the first cycle.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+void prefaultStack()
+{
+    volatile unsigned char stack[ControlLoop::kPrefaultStackSize];
+    for (std::size_t i = 0; i < sizeof(stack); i += 4096)
+        stack[i] = 0;
+}
+
+} // END ANONYMOUS NAMESPACE.
+// ---------------------------------------------------------------------------------------------------------------------
+
+ControlLoop::ControlLoop() :
+    running_(false),
+    realtime_(false),
+    memory_locked_(false),
+    period_(0),
+    cycles_(0),
+    missed_(0),
+    skipped_(0)
+{}
+
+bool ControlLoop::start(const ControlLoopConfig &config, ControlCycleFunction function)
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->mtx_);
+
+    // Check the state and the configuration.
+    if (this->running_ || config.period <= 0 || !function)
+        return false;
+
+    // Join the previous thread (if any).
+    if (this->thread_.joinable())
+        this->thread_.join();
+
+    // Store the configuration, reset the stats and start the thread.
+    this->config_ = config;
+    this->function_ = std::move(function);
+    this->period_ = config.period;
+    this->resetStats();
+    this->running_ = true;
+    this->thread_ = std::thread(&ControlLoop::loopWorker, this);
+
+    // Log.
+    AMELAS_LOG_INFO("<AMELAS CONTROL LOOP> START | Period: ", config.period, " ns | Priority: ", config.priority,
+                    " | CPU: ", config.cpu);
+
+    return true;
+}
+
+void ControlLoop::stop()
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->mtx_);
+
+    // Stop and wait for the thread (it finishes in less than a period).
+    this->running_ = false;
+    if (this->thread_.joinable())
+        this->thread_.join();
+
+    // Unlock the memory.
+#if defined(__linux__)
+    if (this->memory_locked_.exchange(false))
+        munlockall();
+#endif
+}
+
+void ControlLoop::getStats(ControlLoopStats &stats) const
+{
+    stats.period = this->period_.load(std::memory_order_relaxed);
+    stats.cycles = this->cycles_.load(std::memory_order_relaxed);
+    stats.missed_deadlines = this->missed_.load(std::memory_order_relaxed);
+    stats.skipped_cycles = this->skipped_.load(std::memory_order_relaxed);
+    stats.realtime = this->realtime_.load(std::memory_order_relaxed);
+    stats.memory_locked = this->memory_locked_.load(std::memory_order_relaxed);
+    stats.wakeup_latency = this->wakeup_hist_.getSummary();
+    stats.execution_time = this->exec_hist_.getSummary();
+}
+
+void ControlLoop::resetStats()
+{
+    this->cycles_ = 0;
+    this->missed_ = 0;
+    this->skipped_ = 0;
+    this->wakeup_hist_.reset();
+    this->exec_hist_.reset();
+}
+
+ControlLoop::~ControlLoop()
+{
+    this->stop();
+}
+
+void ControlLoop::loopWorker()
+{
+    // Real time configuration and prefault (the histograms are touched again in this thread).
+    this->realtime_ = this->setupRealtime();
+    prefaultStack();
+    this->wakeup_hist_.reset();
+    this->exec_hist_.reset();
+
+    // Auxiliar variables. The cycle times are the scheduled ones (not the wake-up times) in UTC.
+    const std::int64_t period = this->config_.period;
+    const std::int64_t utc_offset = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::system_clock::now().time_since_epoch()).count() - monotonicNow();
+    std::int64_t next = monotonicNow() + period;
+    std::uint64_t cycle = 0;
+
+    // Periodic loop.
+    while (this->running_.load(std::memory_order_acquire))
+    {
+        // Wait for the deadline and execute the cycle.
+        sleepUntilMonotonic(next);
+        const std::int64_t wakeup = monotonicNow();
+        this->function_(next + utc_offset, cycle++);
+        const std::int64_t end = monotonicNow();
+
+        // Update the stats.
+        this->wakeup_hist_.record(wakeup - next);
+        this->exec_hist_.record(end - wakeup);
+        this->cycles_.fetch_add(1, std::memory_order_relaxed);
+
+        // Next deadline. After an overrun the late cycles are skipped, keeping the phase.
+        next += period;
+        if (end > next)
+        {
+            const std::int64_t late = (end - next) / period + 1;
+            this->missed_.fetch_add(1, std::memory_order_relaxed);
+            this->skipped_.fetch_add(static_cast<std::uint64_t>(late), std::memory_order_relaxed);
+            next += late * period;
+        }
+    }
+}
+
+bool ControlLoop::setupRealtime()
+{
+    // Auxiliar variables.
+    bool realtime = false;
+
+#if defined(__linux__)
+    // Lock the current and future memory of the process.
+    if (this->config_.lock_memory)
+    {
+        this->memory_locked_ = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        if (!this->memory_locked_)
+            AMELAS_LOG_WARNING("<AMELAS CONTROL LOOP> Memory lock not permitted: ", std::strerror(errno));
+    }
+
+    // CPU affinity.
+    if (this->config_.cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(this->config_.cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            AMELAS_LOG_WARNING("<AMELAS CONTROL LOOP> CPU affinity not permitted (CPU ", this->config_.cpu, ").");
+    }
+
+    // Real time scheduling.
+    if (this->config_.priority > 0)
+    {
+        sched_param param;
+        param.sched_priority = std::clamp(this->config_.priority, sched_get_priority_min(SCHED_FIFO),
+                                          sched_get_priority_max(SCHED_FIFO));
+        realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+        if (!realtime)
+            AMELAS_LOG_WARNING("<AMELAS CONTROL LOOP> SCHED_FIFO not permitted, using the normal scheduling.");
+    }
+#elif defined(_WIN32)
+    // Windows has no process memory lock, so only the priority and the affinity are configured.
+    if (this->config_.cpu >= 0)
+        SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << this->config_.cpu);
+    if (this->config_.priority > 0)
+        realtime = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#endif
+
+    return realtime;
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
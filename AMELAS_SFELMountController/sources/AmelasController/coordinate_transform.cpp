@@ -0,0 +1,381 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file coordinate_transform.cpp
+ * @brief This file contains the implementation of the CoordinateTransform class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/coordinate_transform.h"
+#include "AmelasUtils/simd_math.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// Constants.
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kRadToDeg = 180.0 / kPi;
+constexpr double kArcsecToRad = kDegToRad / 3600.0;
+constexpr double kUnixJ2000 = 946728000.0;          // J2000.0 (2000-01-01 12:00:00) in seconds since the Unix epoch.
+constexpr double kAberrationConstant = 20.49552;    // Arc seconds.
+
+// Refraction (Saemundsson). R[arcmin] = 1.02 / tan(h + 10.3 / (h + 5.11)) + 0.0019279, with h the true elevation in
+// degrees. The constant makes the refraction zero at the zenith. Below -1 degree the refraction is not applied.
+constexpr double kRefractionA = 1.02 / 60.0;
+constexpr double kRefractionB = 0.0019279 / 60.0;
+constexpr double kRefractionMinElevation = -1.0;
+
+// 3x3 matrix helpers (row major).
+using Matrix3 = std::array<double, 9>;
+
+static Matrix3 multiply(const Matrix3& a, const Matrix3& b)
+{
+    Matrix3 r;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            r[3*i + j] = a[3*i] * b[j] + a[3*i + 1] * b[3 + j] + a[3*i + 2] * b[6 + j];
+    return r;
+}
+
+static Matrix3 transpose(const Matrix3& a)
+{
+    return {a[0], a[3], a[6], a[1], a[4], a[7], a[2], a[5], a[8]};
+}
+
+// Rotations of the axes (angles in radians).
+static Matrix3 rotationX(double angle)
+{
+    const double s = std::sin(angle), c = std::cos(angle);
+    return {1.0, 0.0, 0.0, 0.0, c, s, 0.0, -s, c};
+}
+
+static Matrix3 rotationY(double angle)
+{
+    const double s = std::sin(angle), c = std::cos(angle);
+    return {c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c};
+}
+
+static Matrix3 rotationZ(double angle)
+{
+    const double s = std::sin(angle), c = std::cos(angle);
+    return {c, s, 0.0, -s, c, 0.0, 0.0, 0.0, 1.0};
+}
+
+// IAU 1976 precession matrix from J2000 to the date (t in Julian centuries of TT since J2000).
+static Matrix3 precessionMatrix(double t)
+{
+    const double zeta = ((0.017998 * t + 0.30188) * t + 2306.2181) * t * kArcsecToRad;
+    const double z = ((0.018203 * t + 1.09468) * t + 2306.2181) * t * kArcsecToRad;
+    const double theta = ((-0.041833 * t - 0.42665) * t + 2004.3109) * t * kArcsecToRad;
+    return multiply(rotationZ(-z), multiply(rotationY(theta), rotationZ(-zeta)));
+}
+
+CoordinateTransform::CoordinateTransform(const StationLocation &station, const TransformOptions &options) :
+    station_(station),
+    options_(options),
+    time_(0),
+    matrix_({1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0}),
+    velocity_({0.0, 0.0, 0.0}),
+    last_(0.0),
+    refraction_scale_(1.0)
+{
+    this->setTime(0);
+}
+
+void CoordinateTransform::setStation(const StationLocation &station)
+{
+    this->station_ = station;
+}
+
+void CoordinateTransform::setOptions(const TransformOptions &options)
+{
+    this->options_ = options;
+}
+
+void CoordinateTransform::setTime(std::int64_t time)
+{
+    // Auxiliar variables.
+    const double unix_time = static_cast<double>(time) * 1e-9;
+    const double d_ut1 = (unix_time + this->options_.dut1 - kUnixJ2000) / 86400.0;
+    const double t_ut1 = d_ut1 / 36525.0;
+    const double t = (unix_time + this->options_.tt_utc - kUnixJ2000) / 86400.0 / 36525.0;
+    Matrix3 matrix = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+
+    // Mean obliquity of the ecliptic.
+    const double eps0 = (((0.001813 * t - 0.00059) * t - 46.8150) * t + 84381.448) * kArcsecToRad;
+
+    // Precession from the catalog epoch to the date.
+    if (this->options_.precession)
+    {
+        const double t_epoch = (this->options_.epoch - 2000.0) / 100.0;
+        matrix = multiply(precessionMatrix(t), transpose(precessionMatrix(t_epoch)));
+    }
+
+    // Nutation (main terms of the IAU 1980 series, 0.5 arcsec accuracy).
+    double eq_equinoxes = 0.0;
+    if (this->options_.nutation)
+    {
+        const double omega = (125.04452 - 1934.136261 * t) * kDegToRad;
+        const double l_sun = (280.4665 + 36000.7698 * t) * kDegToRad;
+        const double l_moon = (218.3165 + 481267.8813 * t) * kDegToRad;
+        const double dpsi = (-17.20 * std::sin(omega) - 1.32 * std::sin(2.0 * l_sun) -
+                             0.23 * std::sin(2.0 * l_moon) + 0.21 * std::sin(2.0 * omega)) * kArcsecToRad;
+        const double deps = (9.20 * std::cos(omega) + 0.57 * std::cos(2.0 * l_sun) +
+                             0.10 * std::cos(2.0 * l_moon) - 0.09 * std::cos(2.0 * omega)) * kArcsecToRad;
+        const Matrix3 nutation = multiply(rotationX(-(eps0 + deps)), multiply(rotationZ(-dpsi), rotationX(eps0)));
+        matrix = multiply(nutation, matrix);
+        eq_equinoxes = dpsi * std::cos(eps0 + deps);
+    }
+
+    // Apparent local sidereal time (IAU 1982 GMST).
+    double gmst = 280.46061837 + 360.98564736629 * d_ut1 + (0.000387933 - t_ut1 / 38710000.0) * t_ut1 * t_ut1;
+    gmst = std::fmod(gmst, 360.0);
+    double last = std::fmod(gmst + eq_equinoxes * kRadToDeg + this->station_.longitude, 360.0);
+    this->last_ = last < 0.0 ? last + 360.0 : last;
+
+    // Hour angle frame and local horizon (north, east, up).
+    const double lat = this->station_.latitude * kDegToRad;
+    const double sin_lat = std::sin(lat), cos_lat = std::cos(lat);
+    const Matrix3 horizon = {-sin_lat, 0.0, cos_lat, 0.0, 1.0, 0.0, cos_lat, 0.0, sin_lat};
+    this->matrix_ = multiply(horizon, multiply(rotationZ(this->last_ * kDegToRad), matrix));
+
+    // Earth velocity (units of c) from the Sun true longitude, including the eccentricity terms.
+    this->velocity_ = {0.0, 0.0, 0.0};
+    if (this->options_.aberration)
+    {
+        const double l0 = 280.46646 + 36000.76983 * t;
+        const double m = (357.52911 + 35999.05029 * t) * kDegToRad;
+        const double e = 0.016708634 - 0.000042037 * t;
+        const double c = (1.914602 - 0.004817 * t) * std::sin(m) + (0.019993 - 0.000101 * t) * std::sin(2.0 * m) +
+                         0.000289 * std::sin(3.0 * m);
+        const double lambda = (l0 + c) * kDegToRad;
+        const double perihelion = (102.93735 + 1.71946 * t) * kDegToRad;
+        const double kappa = kAberrationConstant * kArcsecToRad;
+        const double v_ecl = -kappa * (std::cos(lambda) - e * std::cos(perihelion));
+        this->velocity_[0] = kappa * (std::sin(lambda) - e * std::sin(perihelion));
+        this->velocity_[1] = v_ecl * std::cos(eps0);
+        this->velocity_[2] = v_ecl * std::sin(eps0);
+    }
+
+    // Refraction factor.
+    this->refraction_scale_ = (this->station_.pressure / 1010.0) * (283.0 / (273.0 + this->station_.temperature));
+
+    // Store the time.
+    this->time_ = time;
+}
+
+void CoordinateTransform::transform(const double *ra, const double *dec, std::size_t count, double *az, double *el,
+                                    unsigned threads) const
+{
+    // Small lists in the calling thread.
+    if (count < kParallelThreshold || threads == 1)
+    {
+        this->transformRange(ra, dec, count, az, el);
+        return;
+    }
+
+    // Big lists, split in blocks between the threads.
+    const std::ptrdiff_t blocks = static_cast<std::ptrdiff_t>((count + kParallelBlock - 1) / kParallelBlock);
+#ifdef _OPENMP
+    const int workers = (threads == 0) ? omp_get_max_threads() : static_cast<int>(threads);
+    #pragma omp parallel for schedule(static) num_threads(workers)
+#endif
+    for (std::ptrdiff_t block = 0; block < blocks; block++)
+    {
+        const std::size_t first = static_cast<std::size_t>(block) * kParallelBlock;
+        const std::size_t size = (count - first < kParallelBlock) ? count - first : kParallelBlock;
+        this->transformRange(ra + first, dec + first, size, az + first, el + first);
+    }
+}
+
+void CoordinateTransform::transform(const EquatorialBatch &input, HorizontalBatch &output, unsigned threads) const
+{
+    const std::size_t count = std::min(input.ra.size(), input.dec.size());
+    output.az.resize(count);
+    output.el.resize(count);
+    this->transform(input.ra.data(), input.dec.data(), count, output.az.data(), output.el.data(), threads);
+}
+
+void CoordinateTransform::transformScalar(const double *ra, const double *dec, std::size_t count, double *az,
+                                          double *el) const
+{
+    // Auxiliar variables.
+    const Matrix3& m = this->matrix_;
+    const double vx = this->velocity_[0], vy = this->velocity_[1], vz = this->velocity_[2];
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // Unit vector.
+        const double a = ra[i] * kDegToRad, d = dec[i] * kDegToRad;
+        const double cos_dec = std::cos(d);
+        double x = cos_dec * std::cos(a), y = cos_dec * std::sin(a), z = std::sin(d);
+
+        // Annual aberration (first order), keeping the vector normalized.
+        if (this->options_.aberration)
+        {
+            const double dot = x * vx + y * vy + z * vz;
+            x = x + vx - dot * x;
+            y = y + vy - dot * y;
+            z = z + vz - dot * z;
+            const double inv_norm = 1.0 / std::sqrt(x * x + y * y + z * z);
+            x *= inv_norm;
+            y *= inv_norm;
+            z *= inv_norm;
+        }
+
+        // Local horizon.
+        const double n = m[0] * x + m[1] * y + m[2] * z;
+        const double e = m[3] * x + m[4] * y + m[5] * z;
+        const double u = m[6] * x + m[7] * y + m[8] * z;
+        double azimuth = std::atan2(e, n) * kRadToDeg;
+        double elevation = std::atan2(u, std::sqrt(n * n + e * e)) * kRadToDeg;
+
+        // Refraction.
+        if (this->options_.refraction && elevation > kRefractionMinElevation)
+        {
+            const double arg = (elevation + 10.3 / (elevation + 5.11)) * kDegToRad;
+            elevation += this->refraction_scale_ * (kRefractionA / std::tan(arg) + kRefractionB);
+        }
+
+        // Azimuth in [0, 360) (the small negative values can be rounded to 360 when adding the turn).
+        if (azimuth < 0.0)
+            azimuth += 360.0;
+        az[i] = azimuth < 360.0 ? azimuth : 0.0;
+        el[i] = elevation;
+    }
+}
+
+bool CoordinateTransform::isVectorized()
+{
+#ifdef AMELAS_SIMD_AVX2
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CoordinateTransform::transformRange(const double *ra, const double *dec, std::size_t count, double *az,
+                                         double *el) const
+{
+    const std::size_t done = this->transformAvx2(ra, dec, count, az, el);
+    this->transformScalar(ra + done, dec + done, count - done, az + done, el + done);
+}
+
+#ifdef AMELAS_SIMD_AVX2
+
+std::size_t CoordinateTransform::transformAvx2(const double *ra, const double *dec, std::size_t count, double *az,
+                                               double *el) const
+{
+    // Auxiliar variables.
+    const __m256d deg_to_rad = _mm256_set1_pd(kDegToRad);
+    const __m256d rad_to_deg = _mm256_set1_pd(kRadToDeg);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d full_turn = _mm256_set1_pd(360.0);
+    const __m256d vx = _mm256_set1_pd(this->velocity_[0]);
+    const __m256d vy = _mm256_set1_pd(this->velocity_[1]);
+    const __m256d vz = _mm256_set1_pd(this->velocity_[2]);
+    const __m256d refr_a = _mm256_set1_pd(this->refraction_scale_ * kRefractionA);
+    const __m256d refr_b = _mm256_set1_pd(this->refraction_scale_ * kRefractionB);
+    const __m256d refr_min = _mm256_set1_pd(kRefractionMinElevation);
+    __m256d m[9];
+    for (int k = 0; k < 9; k++)
+        m[k] = _mm256_set1_pd(this->matrix_[k]);
+    const bool aberration = this->options_.aberration;
+    const bool refraction = this->options_.refraction;
+    const std::size_t vector_count = count & ~static_cast<std::size_t>(3);
+
+    for (std::size_t i = 0; i < vector_count; i += 4)
+    {
+        // Unit vector.
+        __m256d sin_ra, cos_ra, sin_dec, cos_dec;
+        utils::sincosPd(_mm256_mul_pd(_mm256_loadu_pd(ra + i), deg_to_rad), sin_ra, cos_ra);
+        utils::sincosPd(_mm256_mul_pd(_mm256_loadu_pd(dec + i), deg_to_rad), sin_dec, cos_dec);
+        __m256d x = _mm256_mul_pd(cos_dec, cos_ra);
+        __m256d y = _mm256_mul_pd(cos_dec, sin_ra);
+        __m256d z = sin_dec;
+
+        // Annual aberration.
+        if (aberration)
+        {
+            const __m256d dot = _mm256_fmadd_pd(x, vx, _mm256_fmadd_pd(y, vy, _mm256_mul_pd(z, vz)));
+            x = _mm256_fnmadd_pd(dot, x, _mm256_add_pd(x, vx));
+            y = _mm256_fnmadd_pd(dot, y, _mm256_add_pd(y, vy));
+            z = _mm256_fnmadd_pd(dot, z, _mm256_add_pd(z, vz));
+            const __m256d norm = _mm256_sqrt_pd(_mm256_fmadd_pd(x, x, _mm256_fmadd_pd(y, y, _mm256_mul_pd(z, z))));
+            x = _mm256_div_pd(x, norm);
+            y = _mm256_div_pd(y, norm);
+            z = _mm256_div_pd(z, norm);
+        }
+
+        // Local horizon.
+        const __m256d n = _mm256_fmadd_pd(m[0], x, _mm256_fmadd_pd(m[1], y, _mm256_mul_pd(m[2], z)));
+        const __m256d e = _mm256_fmadd_pd(m[3], x, _mm256_fmadd_pd(m[4], y, _mm256_mul_pd(m[5], z)));
+        const __m256d u = _mm256_fmadd_pd(m[6], x, _mm256_fmadd_pd(m[7], y, _mm256_mul_pd(m[8], z)));
+        __m256d azimuth = _mm256_mul_pd(utils::atan2Pd(e, n), rad_to_deg);
+        azimuth = _mm256_add_pd(azimuth, _mm256_and_pd(_mm256_cmp_pd(azimuth, zero, _CMP_LT_OQ), full_turn));
+        azimuth = _mm256_and_pd(azimuth, _mm256_cmp_pd(azimuth, full_turn, _CMP_LT_OQ));
+        const __m256d horizontal = _mm256_sqrt_pd(_mm256_fmadd_pd(n, n, _mm256_mul_pd(e, e)));
+        __m256d elevation = _mm256_mul_pd(utils::atan2Pd(u, horizontal), rad_to_deg);
+
+        // Refraction (tangent as sine over cosine).
+        if (refraction)
+        {
+            const __m256d arg = _mm256_add_pd(elevation, _mm256_div_pd(_mm256_set1_pd(10.3),
+                                                                       _mm256_add_pd(elevation, _mm256_set1_pd(5.11))));
+            __m256d sin_arg, cos_arg;
+            utils::sincosPd(_mm256_mul_pd(arg, deg_to_rad), sin_arg, cos_arg);
+            const __m256d corr = _mm256_fmadd_pd(refr_a, _mm256_div_pd(cos_arg, sin_arg), refr_b);
+            const __m256d apply = _mm256_cmp_pd(elevation, refr_min, _CMP_GT_OQ);
+            elevation = _mm256_add_pd(elevation, _mm256_and_pd(apply, corr));
+        }
+
+        _mm256_storeu_pd(az + i, azimuth);
+        _mm256_storeu_pd(el + i, elevation);
+    }
+
+    return vector_count;
+}
+
+#else
+
+std::size_t CoordinateTransform::transformAvx2(const double*, const double*, std::size_t, double*, double*) const
+{
+    return 0;
+}
+
+#endif
+
+}} // END NAMESPACES.
+// =====================================================================================================================
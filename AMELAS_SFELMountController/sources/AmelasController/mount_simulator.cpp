@@ -0,0 +1,330 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file mount_simulator.cpp
+ * @brief This file contains the implementation of the MountSimulator class and the simulation clocks.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <thread>
+#include <utility>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/mount_simulator.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr double kDegToRad = 3.14159265358979323846 / 180.0;
+// ---------------------------------------------------------------------------------------------------------------------
+
+std::int64_t WallClock::now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void WallClock::sleepUntil(std::int64_t time)
+{
+    std::this_thread::sleep_until(std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time))));
+}
+
+VirtualClock::VirtualClock(std::int64_t start, double speed) :
+    time_(start),
+    start_(start),
+    wall_start_(std::chrono::steady_clock::now()),
+    speed_(std::max(speed, 0.0))
+{}
+
+std::int64_t VirtualClock::now() const
+{
+    return this->time_.load(std::memory_order_acquire);
+}
+
+void VirtualClock::sleepUntil(std::int64_t time)
+{
+    // Wait the scaled time (if the clock is paced).
+    if (this->speed_ > 0.0)
+    {
+        const auto wall = std::chrono::nanoseconds(
+            static_cast<std::int64_t>(static_cast<double>(time - this->start_) / this->speed_));
+        std::this_thread::sleep_until(this->wall_start_ + wall);
+    }
+
+    // Move the time forward.
+    std::int64_t current = this->time_.load(std::memory_order_relaxed);
+    while (current < time && !this->time_.compare_exchange_weak(current, time, std::memory_order_release,
+                                                                 std::memory_order_relaxed))
+    {}
+}
+
+void VirtualClock::advance(std::int64_t ns)
+{
+    if (ns > 0)
+        this->time_.fetch_add(ns, std::memory_order_acq_rel);
+}
+
+MountSimulator::MountSimulator(const MountSimulatorConfig &config, std::shared_ptr<SimulationClock> clock) :
+    config_(config),
+    clock_(std::move(clock)),
+    dt_(static_cast<double>(config.servo_period) * 1e-9),
+    last_setpoint_az_(0.0),
+    wrap_selected_(false),
+    settle_steps_(0),
+    time_(0),
+    status_(MountStatus::IDLE),
+    error_(AmelasError::SUCCESS)
+{
+    this->reset(AltAzPos(0.0, 0.0));
+}
+
+void MountSimulator::reset(const AltAzPos &pos)
+{
+    this->az_ = AxisState();
+    this->el_ = AxisState();
+    this->az_.position = this->az_.setpoint = pos.az;
+    this->el_.position = this->el_.setpoint = pos.el;
+    this->last_setpoint_az_ = pos.az;
+    this->wrap_selected_ = false;
+    this->settle_steps_ = 0;
+    this->time_ = this->clock_->now();
+    this->status_ = MountStatus::IDLE;
+    this->error_ = AmelasError::SUCCESS;
+}
+
+void MountSimulator::setSetpoint(const AltAzPos &pos, const AltAzPos &rate)
+{
+    // Auxiliar variables.
+    const AxisConfig& az_config = this->config_.azimuth;
+    double az = 0.0;
+
+    // Unwrap the azimuth. The first setpoint selects the nearest wrap inside the limits.
+    if (!this->wrap_selected_)
+    {
+        az = this->az_.position + std::remainder(pos.az - this->az_.position, 360.0);
+        if (az > az_config.max_position)
+            az -= 360.0;
+        else if (az < az_config.min_position)
+            az += 360.0;
+        this->wrap_selected_ = true;
+    }
+    else
+    {
+        az = this->az_.setpoint + std::remainder(pos.az - this->last_setpoint_az_, 360.0);
+    }
+    this->last_setpoint_az_ = pos.az;
+
+    // Store the setpoints, clamped to the limits.
+    double el = pos.el;
+    const bool az_ok = MountSimulator::clampSetpoint(az_config, az);
+    const bool el_ok = MountSimulator::clampSetpoint(this->config_.elevation, el);
+    this->az_.setpoint = az;
+    this->az_.rate = rate.az;
+    this->el_.setpoint = el;
+    this->el_.rate = rate.el;
+
+    // Update the status. The faults remain until the reset.
+    if (!az_ok || !el_ok)
+    {
+        this->status_ = MountStatus::FAULT;
+        this->error_ = AmelasError::UNSAFE_POSITION;
+    }
+    else if (this->status_ == MountStatus::IDLE)
+    {
+        this->status_ = MountStatus::SLEWING;
+    }
+}
+
+void MountSimulator::step()
+{
+    // Check the acquisition with the error of this tick (it must remain below the threshold the settle time).
+    if (this->status_ == MountStatus::SLEWING)
+    {
+        double az_error, el_error;
+        const bool inside = this->getTrackingError(az_error, el_error) * 3600.0 < this->config_.acquire_threshold;
+        this->settle_steps_ = inside ? this->settle_steps_ + 1 : 0;
+        if (static_cast<double>(this->settle_steps_) * this->dt_ >= this->config_.settle_time)
+            this->status_ = MountStatus::TRACKING;
+    }
+
+    // Advance the axes.
+    MountSimulator::stepAxis(this->config_.azimuth, this->az_, this->dt_);
+    MountSimulator::stepAxis(this->config_.elevation, this->el_, this->dt_);
+    this->time_ += this->config_.servo_period;
+}
+
+AmelasError MountSimulator::track(const TrajectoryInterpolator &interpolator, TrackingStats &stats,
+                                  const SimulationCallback &callback)
+{
+    // Auxiliar variables.
+    constexpr std::size_t block = TrajectoryInterpolator::kEvaluationBlock;
+    const std::int64_t period = this->config_.servo_period;
+    std::array<std::int64_t, block + 1> times;
+    std::array<double, block + 1> az, el;
+    AltAzPos rate(0.0, 0.0);
+    double sum_sq = 0.0;
+    bool finished = false;
+
+    // Reset the stats.
+    stats = TrackingStats();
+
+    // Check the trajectory and go to the start.
+    if (!interpolator.isReady() || this->clock_->now() > interpolator.getEndTime())
+    {
+        stats.error = AmelasError::OUT_OF_TRAJECTORY;
+        return stats.error;
+    }
+    const std::int64_t start = std::max(this->clock_->now(), interpolator.getStartTime());
+    this->clock_->sleepUntil(start);
+    this->time_ = start;
+    const auto wall_start = std::chrono::steady_clock::now();
+
+    // Servo loop. The setpoints are evaluated in blocks, with one more sample for the feed-forward velocity.
+    std::int64_t time = start;
+    while (!finished)
+    {
+        for (std::size_t i = 0; i <= block; i++)
+            times[i] = time + static_cast<std::int64_t>(i) * period;
+        interpolator.evaluate(times.data(), block + 1, az.data(), el.data());
+
+        for (std::size_t i = 0; i < block; i++)
+        {
+            // The positions outside the trajectory are NaN.
+            if (std::isnan(az[i]))
+            {
+                finished = true;
+                break;
+            }
+
+            // Feed-forward velocity (the last one is kept at the end of the trajectory).
+            if (!std::isnan(az[i + 1]))
+                rate = AltAzPos(std::remainder(az[i + 1] - az[i], 360.0) / this->dt_, (el[i + 1] - el[i]) / this->dt_);
+
+            // Set the setpoint, get the error of this tick and advance.
+            this->setSetpoint(AltAzPos(az[i], el[i]), rate);
+            double az_error, el_error;
+            const double error = this->getTrackingError(az_error, el_error) * 3600.0;
+            this->step();
+            stats.steps++;
+
+            // Update the stats after the acquisition.
+            if (this->status_ == MountStatus::TRACKING || (this->status_ == MountStatus::FAULT && stats.tracking_steps))
+            {
+                if (stats.acquire_time < 0.0)
+                    stats.acquire_time = static_cast<double>(times[i] - start) * 1e-9;
+                stats.tracking_steps++;
+                sum_sq += error * error;
+                stats.max_error = std::max(stats.max_error, error);
+                stats.max_az_error = std::max(stats.max_az_error, std::fabs(az_error) * 3600.0);
+                stats.max_el_error = std::max(stats.max_el_error, std::fabs(el_error) * 3600.0);
+            }
+
+            // Deliver the state and wait for the next tick.
+            if (callback)
+                callback(this->getState());
+            this->clock_->sleepUntil(times[i] + period);
+        }
+        time += static_cast<std::int64_t>(block) * period;
+    }
+
+    // Final stats.
+    if (stats.tracking_steps)
+        stats.rms_error = std::sqrt(sum_sq / static_cast<double>(stats.tracking_steps));
+    stats.simulated_time = static_cast<double>(stats.steps) * this->dt_;
+    stats.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    stats.error = this->error_;
+
+    // The target stops at the end of the trajectory.
+    this->az_.rate = 0.0;
+    this->el_.rate = 0.0;
+
+    return stats.error;
+}
+
+MountStateBlock MountSimulator::getState() const
+{
+    MountStateBlock state;
+    const double az = std::fmod(MountSimulator::readEncoder(this->config_.azimuth, this->az_.position), 360.0);
+    state.timestamp = this->time_;
+    state.az = az < 0.0 ? az + 360.0 : az;
+    state.el = MountSimulator::readEncoder(this->config_.elevation, this->el_.position);
+    state.az_rate = this->az_.velocity;
+    state.el_rate = this->el_.velocity;
+    state.status = this->status_;
+    state.error = this->error_;
+    return state;
+}
+
+void MountSimulator::stepAxis(const AxisConfig &config, AxisState &axis, double dt)
+{
+    // Position loop with braking: the feedback velocity never exceeds the one that stops at the setpoint.
+    const double error = axis.setpoint - MountSimulator::readEncoder(config, axis.position);
+    const double feedback = std::copysign(std::min(config.position_gain * std::fabs(error),
+                                                   std::sqrt(2.0 * config.max_acceleration * std::fabs(error))), error);
+
+    // Velocity and acceleration limits.
+    const double command = std::clamp(axis.rate + feedback, -config.max_velocity, config.max_velocity);
+    const double max_dv = config.max_acceleration * dt;
+    axis.velocity += std::clamp(command - axis.velocity, -max_dv, max_dv);
+    axis.position += axis.velocity * dt;
+
+    // Hard limits.
+    if (axis.position > config.max_position || axis.position < config.min_position)
+    {
+        axis.position = std::clamp(axis.position, config.min_position, config.max_position);
+        axis.velocity = 0.0;
+    }
+}
+
+double MountSimulator::readEncoder(const AxisConfig &config, double position)
+{
+    return config.encoder_resolution > 0.0 ?
+               std::round(position / config.encoder_resolution) * config.encoder_resolution : position;
+}
+
+bool MountSimulator::clampSetpoint(const AxisConfig &config, double &setpoint)
+{
+    const double clamped = std::clamp(setpoint, config.min_position, config.max_position);
+    const bool inside = clamped == setpoint;
+    setpoint = clamped;
+    return inside;
+}
+
+double MountSimulator::getTrackingError(double &az_error, double &el_error) const
+{
+    az_error = MountSimulator::readEncoder(this->config_.azimuth, this->az_.position) - this->az_.setpoint;
+    el_error = MountSimulator::readEncoder(this->config_.elevation, this->el_.position) - this->el_.setpoint;
+    const double cos_el = std::cos(this->el_.setpoint * kDegToRad);
+    return std::sqrt(az_error * az_error * cos_el * cos_el + el_error * el_error);
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,147 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file pointing_model.cpp
+ * @brief This file contains the implementation of the PointingModel class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cmath>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/pointing_model.h"
+#include "AmelasUtils/simd_math.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+PointingModel::PointingModel() :
+    PointingModel(std::array<double, kPointingModelTerms>{})
+{}
+
+PointingModel::PointingModel(const std::array<double, kPointingModelTerms> &terms) :
+    terms_(terms)
+{
+    // Auxiliar lambda to get a coefficient in degrees.
+    auto deg = [&terms](PointingTerm term){return terms[static_cast<std::size_t>(term)] / 3600.0;};
+
+    // Coefficients of the fused pass.
+    this->az_index_ = -deg(PointingTerm::IA);
+    this->az_coll_ = -deg(PointingTerm::CA);
+    this->az_npae_ = -deg(PointingTerm::NPAE);
+    this->az_an_ = -deg(PointingTerm::AN);
+    this->az_aw_ = -deg(PointingTerm::AW);
+    this->el_index_ = deg(PointingTerm::IE);
+    this->el_an_ = -deg(PointingTerm::AN);
+    this->el_aw_ = deg(PointingTerm::AW);
+    this->el_tf_ = -deg(PointingTerm::TF);
+}
+
+bool PointingModel::isValid() const
+{
+    return std::all_of(this->terms_.begin(), this->terms_.end(),
+                       [](double term){return std::isfinite(term) && std::fabs(term) <= kMaxTerm;});
+}
+
+AltAzPos PointingModel::apply(const AltAzPos &pos) const
+{
+    AltAzPos result;
+    this->applyBlock(&pos.az, &pos.el, 1, &result.az, &result.el);
+    return result;
+}
+
+void PointingModel::apply(const double *az, const double *el, std::size_t count, double *out_az,
+                          double *out_el) const
+{
+    for (std::size_t i = 0; i < count; i += kBlockSize)
+    {
+        const std::size_t block = std::min(kBlockSize, count - i);
+        this->applyBlock(az + i, el + i, block, out_az + i, out_el + i);
+    }
+}
+
+void PointingModel::apply(const TrajectoryBuffer &input, TrajectoryBuffer &output) const
+{
+    std::copy(input.timestamps.begin(), input.timestamps.begin() + static_cast<std::ptrdiff_t>(input.size),
+              output.timestamps.begin());
+    this->apply(input.az.data(), input.el.data(), input.size, output.az.data(), output.el.data());
+    output.size = input.size;
+}
+
+void PointingModel::applyBlock(const double *az, const double *el, std::size_t count, double *out_az,
+                               double *out_el) const
+{
+    // Auxiliar variables. The elevation is limited for the azimuth terms (they diverge at the zenith).
+    constexpr double deg_to_rad = 3.14159265358979323846 / 180.0;
+    constexpr double max_el = kMaxElevation * deg_to_rad;
+    alignas(32) double sin_a[kBlockSize], cos_a[kBlockSize], sin_e[kBlockSize], cos_e[kBlockSize];
+    std::size_t i = 0;
+
+    // First pass: sines and cosines of each sample.
+#ifdef AMELAS_SIMD_AVX2
+    const __m256d deg_to_rad_pd = _mm256_set1_pd(deg_to_rad);
+    const __m256d max_el_pd = _mm256_set1_pd(max_el);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d s, c;
+        utils::sincosPd(_mm256_mul_pd(_mm256_loadu_pd(az + i), deg_to_rad_pd), s, c);
+        _mm256_store_pd(sin_a + i, s);
+        _mm256_store_pd(cos_a + i, c);
+        utils::sincosPd(_mm256_min_pd(_mm256_mul_pd(_mm256_loadu_pd(el + i), deg_to_rad_pd), max_el_pd), s, c);
+        _mm256_store_pd(sin_e + i, s);
+        _mm256_store_pd(cos_e + i, c);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        const double a = az[i] * deg_to_rad;
+        const double e = std::min(el[i] * deg_to_rad, max_el);
+        sin_a[i] = std::sin(a);
+        cos_a[i] = std::cos(a);
+        sin_e[i] = std::sin(e);
+        cos_e[i] = std::cos(e);
+    }
+
+    // Second pass: all the terms together (without branches, so it is vectorized).
+    for (i = 0; i < count; i++)
+    {
+        const double sec_e = 1.0 / cos_e[i];
+        const double tan_e = sin_e[i] * sec_e;
+        const double d_az = this->az_index_ + this->az_coll_ * sec_e +
+                            (this->az_npae_ + this->az_an_ * sin_a[i] + this->az_aw_ * cos_a[i]) * tan_e;
+        const double d_el = this->el_index_ + this->el_an_ * cos_a[i] + this->el_aw_ * sin_a[i] +
+                            this->el_tf_ * cos_e[i];
+        double new_az = az[i] + d_az;
+        new_az += (new_az < 0.0) ? 360.0 : 0.0;
+        new_az -= (new_az >= 360.0) ? 360.0 : 0.0;
+        out_az[i] = new_az;
+        out_el[i] = el[i] + d_el;
+    }
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,318 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file trajectory_interpolator.cpp
+ * @brief This file contains the implementation of the TrajectoryInterpolator class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cmath>
+#include <limits>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasController/trajectory_interpolator.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace controller{
+// =====================================================================================================================
+
+TrajectoryInterpolator::TrajectoryInterpolator() :
+    segments_(0),
+    stride_(0),
+    degree_(0),
+    method_(kDefaultInterpolationMethod),
+    start_time_(0),
+    end_time_(0)
+{}
+
+AmelasError TrajectoryInterpolator::prepare(const TrajectoryBuffer &trajectory, InterpolationMethod method,
+                                            unsigned order)
+{
+    // Auxiliar variables.
+    const std::size_t samples = trajectory.size;
+    const unsigned degree = (method == InterpolationMethod::HERMITE) ? 3 : order;
+
+    // Check the configuration and the trajectory. The previous trajectory is kept if there is any error.
+    if (!TrajectoryInterpolator::isValidConfiguration(method, order))
+        return AmelasError::INVALID_INTERPOLATION;
+    if (samples < 2 || (method == InterpolationMethod::LAGRANGE && samples < degree + 1))
+        return AmelasError::INVALID_TRAJECTORY;
+    for (std::size_t i = 1; i < samples; i++)
+        if (trajectory.timestamps[i] <= trajectory.timestamps[i - 1])
+            return AmelasError::INVALID_TRAJECTORY;
+
+    // Prepare the containers (the memory is reused between trajectories).
+    this->segments_ = 0;
+    this->stride_ = degree + 1;
+    this->seg_start_.resize(samples - 1);
+    this->seg_inv_step_.resize(samples - 1);
+    this->az_coefs_.assign((samples - 1) * this->stride_, 0.0);
+    this->el_coefs_.assign((samples - 1) * this->stride_, 0.0);
+    this->unwrapped_az_.resize(samples);
+
+    // Unwrap the azimuth, so the 0/360 crossings are continuous.
+    this->unwrapped_az_[0] = trajectory.az[0];
+    for (std::size_t i = 1; i < samples; i++)
+    {
+        double delta = trajectory.az[i] - trajectory.az[i - 1];
+        if (delta > 180.0)
+            delta -= 360.0;
+        else if (delta < -180.0)
+            delta += 360.0;
+        this->unwrapped_az_[i] = this->unwrapped_az_[i - 1] + delta;
+    }
+
+    // Segments times.
+    for (std::size_t i = 0; i + 1 < samples; i++)
+    {
+        this->seg_start_[i] = trajectory.timestamps[i];
+        this->seg_inv_step_[i] = 1.0 / static_cast<double>(trajectory.timestamps[i + 1] - trajectory.timestamps[i]);
+    }
+
+    // Coefficients.
+    if (method == InterpolationMethod::HERMITE)
+        this->computeHermite(trajectory);
+    else
+        this->computeLagrange(trajectory, degree);
+
+    // Store the configuration.
+    this->degree_ = degree;
+    this->method_ = method;
+    this->start_time_ = trajectory.timestamps[0];
+    this->end_time_ = trajectory.timestamps[samples - 1];
+    this->segments_ = samples - 1;
+    return AmelasError::SUCCESS;
+}
+
+bool TrajectoryInterpolator::evaluate(std::int64_t time, AltAzPos &pos) const
+{
+    // Check the time.
+    if (!this->segments_ || time < this->start_time_ || time > this->end_time_)
+        return false;
+
+    // Evaluate the segment.
+    this->evaluateBlock(this->findSegment(time), &time, 1, &pos.az, &pos.el);
+    return true;
+}
+
+std::size_t TrajectoryInterpolator::evaluate(const std::int64_t *times, std::size_t count,
+                                             double *az, double *el) const
+{
+    // Auxiliar variables.
+    std::size_t valid = 0;
+    std::size_t segment = 0;
+    std::size_t i = 0;
+
+    while (i < count)
+    {
+        // Check the time.
+        const std::int64_t time = times[i];
+        if (!this->segments_ || time < this->start_time_ || time > this->end_time_)
+        {
+            az[i] = std::numeric_limits<double>::quiet_NaN();
+            el[i] = std::numeric_limits<double>::quiet_NaN();
+            i++;
+            continue;
+        }
+
+        // Get the segment. For increasing times the previous segment is usually valid, or the next one.
+        auto limit = [this](std::size_t seg)
+            {return seg + 1 < this->segments_ ? this->seg_start_[seg + 1] - 1 : this->end_time_;};
+        if (time < this->seg_start_[segment] || time > limit(segment))
+        {
+            if (segment + 1 < this->segments_ && time >= this->seg_start_[segment + 1] && time <= limit(segment + 1))
+                segment++;
+            else
+                segment = this->findSegment(time);
+        }
+
+        // Group the next times of the same segment and evaluate them.
+        const std::int64_t seg_limit = limit(segment);
+        std::size_t j = i + 1;
+        while (j < count && j - i < kEvaluationBlock && times[j] >= this->seg_start_[segment] && times[j] <= seg_limit)
+            j++;
+        this->evaluateBlock(segment, times + i, j - i, az + i, el + i);
+        valid += j - i;
+        i = j;
+    }
+
+    return valid;
+}
+
+void TrajectoryInterpolator::clear()
+{
+    this->segments_ = 0;
+    this->start_time_ = 0;
+    this->end_time_ = 0;
+}
+
+void TrajectoryInterpolator::computeLagrange(const TrajectoryBuffer &trajectory, unsigned order)
+{
+    // Auxiliar containers.
+    const std::size_t samples = trajectory.size;
+    double x[kMaxCoefficients];
+    double basis[kMaxCoefficients + 1];
+
+    for (std::size_t i = 0; i + 1 < samples; i++)
+    {
+        // Nodes centered on the segment [i, i + 1], shifted at the borders of the trajectory.
+        const std::ptrdiff_t centered = static_cast<std::ptrdiff_t>(i) - static_cast<std::ptrdiff_t>((order - 1) / 2);
+        const std::size_t first = static_cast<std::size_t>(
+            std::clamp<std::ptrdiff_t>(centered, 0, static_cast<std::ptrdiff_t>(samples - 1 - order)));
+
+        // Nodes in the local time of the segment.
+        const double step = static_cast<double>(trajectory.timestamps[i + 1] - trajectory.timestamps[i]);
+        for (unsigned m = 0; m <= order; m++)
+            x[m] = static_cast<double>(trajectory.timestamps[first + m] - trajectory.timestamps[i]) / step;
+
+        // Sum the Lagrange basis polynomials in monomial form. The values are relative to the segment start, which
+        // improves the conditioning for the unwrapped azimuths.
+        double* az_c = &this->az_coefs_[i * this->stride_];
+        double* el_c = &this->el_coefs_[i * this->stride_];
+        for (unsigned m = 0; m <= order; m++)
+        {
+            // Basis polynomial: product of (u - x_q) / (x_m - x_q) for all q != m.
+            std::fill(basis, basis + order + 2, 0.0);
+            basis[0] = 1.0;
+            double denom = 1.0;
+            unsigned deg = 0;
+            for (unsigned q = 0; q <= order; q++)
+            {
+                if (q == m)
+                    continue;
+                for (unsigned k = deg + 1; k > 0; k--)
+                    basis[k] = basis[k - 1] - x[q] * basis[k];
+                basis[0] = -x[q] * basis[0];
+                denom *= (x[m] - x[q]);
+                deg++;
+            }
+
+            // Accumulate the weighted basis.
+            const double w_az = (this->unwrapped_az_[first + m] - this->unwrapped_az_[i]) / denom;
+            const double w_el = (trajectory.el[first + m] - trajectory.el[i]) / denom;
+            for (unsigned k = 0; k <= order; k++)
+            {
+                az_c[k] += w_az * basis[k];
+                el_c[k] += w_el * basis[k];
+            }
+        }
+        az_c[0] += this->unwrapped_az_[i];
+        el_c[0] += trajectory.el[i];
+    }
+}
+
+void TrajectoryInterpolator::computeHermite(const TrajectoryBuffer &trajectory)
+{
+    // Derivative at a sample (per nanosecond), from the neighbour samples (non uniform three point formula).
+    const std::size_t samples = trajectory.size;
+    auto slope = [&trajectory, samples](const double* values, std::size_t k)
+    {
+        const auto& t = trajectory.timestamps;
+        if (k == 0)
+            return (values[1] - values[0]) / static_cast<double>(t[1] - t[0]);
+        if (k == samples - 1)
+            return (values[k] - values[k - 1]) / static_cast<double>(t[k] - t[k - 1]);
+        const double h0 = static_cast<double>(t[k] - t[k - 1]);
+        const double h1 = static_cast<double>(t[k + 1] - t[k]);
+        return ((values[k] - values[k - 1]) / h0) * (h1 / (h0 + h1)) +
+               ((values[k + 1] - values[k]) / h1) * (h0 / (h0 + h1));
+    };
+
+    // Cubic Hermite coefficients of each segment, with the derivatives scaled to the local time.
+    const double* az = this->unwrapped_az_.data();
+    const double* el = trajectory.el.data();
+    for (std::size_t i = 0; i + 1 < samples; i++)
+    {
+        const double step = static_cast<double>(trajectory.timestamps[i + 1] - trajectory.timestamps[i]);
+        const double* values[2] = {az, el};
+        double* coefs[2] = {&this->az_coefs_[i * this->stride_], &this->el_coefs_[i * this->stride_]};
+        for (int v = 0; v < 2; v++)
+        {
+            const double p0 = values[v][i];
+            const double p1 = values[v][i + 1];
+            const double m0 = slope(values[v], i) * step;
+            const double m1 = slope(values[v], i + 1) * step;
+            coefs[v][0] = p0;
+            coefs[v][1] = m0;
+            coefs[v][2] = -3.0 * p0 - 2.0 * m0 + 3.0 * p1 - m1;
+            coefs[v][3] = 2.0 * p0 + m0 - 2.0 * p1 + m1;
+        }
+    }
+}
+
+std::size_t TrajectoryInterpolator::findSegment(std::int64_t time) const
+{
+    // Binary search of the last segment that starts before the time.
+    const auto begin = this->seg_start_.begin();
+    const auto it = std::upper_bound(begin, begin + static_cast<std::ptrdiff_t>(this->segments_), time);
+    return it == begin ? 0 : static_cast<std::size_t>(it - begin) - 1;
+}
+
+void TrajectoryInterpolator::evaluateBlock(std::size_t segment, const std::int64_t *times, std::size_t count,
+                                           double *az, double *el) const
+{
+    // Auxiliar containers (in the stack).
+    double u[kEvaluationBlock];
+    double acc_az[kEvaluationBlock];
+    double acc_el[kEvaluationBlock];
+
+    // Segment data.
+    const double* az_c = &this->az_coefs_[segment * this->stride_];
+    const double* el_c = &this->el_coefs_[segment * this->stride_];
+    const std::int64_t start = this->seg_start_[segment];
+    const double inv_step = this->seg_inv_step_[segment];
+
+    // Local times.
+    for (std::size_t j = 0; j < count; j++)
+    {
+        u[j] = static_cast<double>(times[j] - start) * inv_step;
+        acc_az[j] = az_c[this->degree_];
+        acc_el[j] = el_c[this->degree_];
+    }
+
+    // Horner scheme, with the degree loop outside so the samples loop is vectorized.
+    for (unsigned k = this->degree_; k-- > 0;)
+    {
+        const double ca = az_c[k];
+        const double ce = el_c[k];
+        for (std::size_t j = 0; j < count; j++)
+        {
+            acc_az[j] = acc_az[j] * u[j] + ca;
+            acc_el[j] = acc_el[j] * u[j] + ce;
+        }
+    }
+
+    // Wrap the azimuth to [0, 360).
+    for (std::size_t j = 0; j < count; j++)
+    {
+        double wrapped = acc_az[j] - 360.0 * std::floor(acc_az[j] / 360.0);
+        az[j] = (wrapped >= 360.0) ? wrapped - 360.0 : wrapped;
+        el[j] = acc_el[j];
+    }
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
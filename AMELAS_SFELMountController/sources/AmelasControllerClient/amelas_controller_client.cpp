@@ -12,10 +12,17 @@
  *   Licensed under [...]
  **********************************************************************************************************************/
 
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cstring>
+// =====================================================================================================================
+
 // PROJECT INCLUDES
 // =====================================================================================================================
 #include "AmelasControllerClient/amelas_controller_client.h"
 #include "AmelasControllerServer/common.h"
+#include "AmelasUtils/async_logger.h"
 // =====================================================================================================================
 
 // AMELAS NAMESPACES
@@ -32,132 +39,750 @@ using zmqutils::common::ServerCommand;
 using zmqutils::common::OperationResult;
 using zmqutils::common::ResultType;
 using zmqutils::common::CommandType;
+using zmqutils::utils::LocalBinarySerializer;
 using zmqutils::utils::BinarySerializer;
+using zmqutils::utils::BorrowedBytes;
+using zmqutils::utils::BufferPool;
+using zmqutils::utils::makeZeroCopyMessage;
 
 AmelasControllerClient::AmelasControllerClient(const std::string& server_endpoint,
                            const std::string& client_name,
                            const std::string interf_name) :
-    zmqutils::CommandClientBase(server_endpoint, client_name, interf_name)
+    zmqutils::CommandClientBase(server_endpoint, client_name, interf_name),
+    heartbeat_([this]{this->sendHeartbeat();})
 {}
 
-AmelasControllerClient::~AmelasControllerClient(){}
+AmelasControllerClient::~AmelasControllerClient()
+{
+    this->disableSharedHeartbeat();
+    this->stopAsyncChannel();
+    this->stopTelemetry();
+}
+
+RequestData AmelasControllerClient::prepareBatchRequest(BatchMode mode, const std::vector<BatchEntry> &entries)
+{
+    // Serialize the mode, the number of entries and each entry.
+    RequestData request(static_cast<ServerCommand>(AmelasServerCommand::REQ_BATCH));
+    LocalBinarySerializer serializer;
+    serializer.write(mode, static_cast<std::uint32_t>(entries.size()));
+    for(const auto& entry : entries)
+        serializer.write(static_cast<CommandType>(entry.command), entry.params);
+    request.params_size = serializer.moveUnique(request.params);
+    return request;
+}
+
+bool AmelasControllerClient::parseBatchReply(const CommandReply &reply, std::vector<BatchResult> &results)
+{
+    // Auxiliar variables.
+    std::uint32_t count;
+
+    // Deserialize the number of entries and each entry result.
+    try
+    {
+        LocalBinarySerializer serializer(reply.params.get(), reply.params_size);
+        serializer.read(count);
+        if(count > reply.params_size)
+            return false;
+        results.resize(count);
+        for(auto& result : results)
+            serializer.read(result.result, result.params);
+        return serializer.allReaded();
+    }
+    catch(...)
+    {
+        return false;
+    }
+}
+
+OperationResult AmelasControllerClient::doUploadTrajectory(const std::vector<std::int64_t> &timestamps,
+                                                           const std::vector<double> &az,
+                                                           const std::vector<double> &el,
+                                                           controller::AmelasError &error)
+{
+    // Auxiliar variables and containers.
+    OperationResult result;
+    CommandReply reply;
+    std::uint32_t window = 0;
+    std::uint32_t max_chunk = 0;
+    std::uint32_t received = 0;
+    std::uint32_t checksum = 0;
+    std::deque<std::future<CommandReply>> in_flight;
+    std::vector<std::int64_t> chunk_times;
+    std::vector<double> chunk_az;
+    std::vector<double> chunk_el;
+    error = controller::AmelasError::INVALID_ERROR;
+
+    // Check the trajectory.
+    if(timestamps.empty() || timestamps.size() != az.size() || timestamps.size() != el.size() ||
+       timestamps.size() > controller::kMaxTrajectorySamples)
+        return OperationResult::BAD_PARAMETERS;
+    const auto samples = static_cast<std::uint32_t>(timestamps.size());
+
+    // Begin the upload and get the window granted by the server.
+    RequestData begin_req(static_cast<ServerCommand>(AmelasServerCommand::REQ_BEGIN_TRAJECTORY_UPLOAD));
+    begin_req.params_size = LocalBinarySerializer::fastSerialization(begin_req.params, samples);
+    result = this->sendCommand(begin_req, reply);
+    if(result == OperationResult::COMMAND_OK)
+        result = AmelasControllerClient::readControllerReply(reply, error, window, max_chunk);
+    if(result != OperationResult::COMMAND_OK || error != controller::AmelasError::SUCCESS)
+        return result;
+    if(!window || !max_chunk)
+        return OperationResult::BAD_PARAMETERS;
+    window = std::min(window, this->async_max_in_flight_);
+
+    // Send the chunks. Each reply returns one credit of the window.
+    for(std::uint32_t offset = 0; offset < samples && result == OperationResult::COMMAND_OK &&
+        error == controller::AmelasError::SUCCESS; offset += max_chunk)
+    {
+        // Prepare the chunk and update the checksum.
+        const std::uint32_t count = std::min(max_chunk, samples - offset);
+        chunk_times.assign(timestamps.begin() + offset, timestamps.begin() + offset + count);
+        chunk_az.assign(az.begin() + offset, az.begin() + offset + count);
+        chunk_el.assign(el.begin() + offset, el.begin() + offset + count);
+        RequestData chunk_req(static_cast<ServerCommand>(AmelasServerCommand::REQ_UPLOAD_TRAJECTORY_CHUNK));
+        chunk_req.params_size = LocalBinarySerializer::fastSerialization(chunk_req.params, offset, chunk_times,
+                                                                         chunk_az, chunk_el);
+        checksum = controller::updateTrajectoryChecksum(checksum, chunk_times.data(), chunk_az.data(),
+                                                        chunk_el.data(), count);
+
+        // Send the chunk. In the asynchronous channel, wait for the oldest reply only when there are no credits.
+        if(this->async_working_)
+        {
+            in_flight.push_back(this->sendCommandAsync(chunk_req));
+            if(in_flight.size() < window)
+                continue;
+            reply = in_flight.front().get();
+            in_flight.pop_front();
+        }
+        else if((result = this->sendCommand(chunk_req, reply)) != OperationResult::COMMAND_OK)
+            break;
+        result = AmelasControllerClient::readControllerReply(reply, error, received);
+    }
+
+    // Wait for the rest of the chunks.
+    while(!in_flight.empty())
+    {
+        reply = in_flight.front().get();
+        in_flight.pop_front();
+        if(result == OperationResult::COMMAND_OK && error == controller::AmelasError::SUCCESS)
+            result = AmelasControllerClient::readControllerReply(reply, error, received);
+    }
+    if(result != OperationResult::COMMAND_OK || error != controller::AmelasError::SUCCESS)
+        return result;
+
+    // Commit the upload with the checksum.
+    RequestData commit_req(static_cast<ServerCommand>(AmelasServerCommand::REQ_COMMIT_TRAJECTORY_UPLOAD));
+    commit_req.params_size = LocalBinarySerializer::fastSerialization(commit_req.params, checksum);
+    result = this->sendCommand(commit_req, reply);
+    if(result == OperationResult::COMMAND_OK)
+        result = AmelasControllerClient::readControllerReply(reply, error);
+    return result;
+}
+
+bool AmelasControllerClient::startTelemetry(const std::string &endpoint, const std::vector<TelemetryTopic> &topics,
+                                            TelemetryCallback callback)
+{
+    // Check if we are already subscribed.
+    if(this->telemetry_working_ || !callback)
+        return false;
+
+    // Create the subscriber.
+    try
+    {
+        this->telemetry_ctx_ = std::make_unique<zmq::context_t>();
+        this->telemetry_socket_ = std::make_unique<zmq::socket_t>(*this->telemetry_ctx_, zmq::socket_type::sub);
+        this->telemetry_socket_->set(zmq::sockopt::linger, 0);
+        if(topics.empty())
+            this->telemetry_socket_->set(zmq::sockopt::subscribe, "amelas.");
+        for(const auto& topic : topics)
+            if(topic < TelemetryTopic::END_TELEMETRY_TOPICS)
+                this->telemetry_socket_->set(zmq::sockopt::subscribe,
+                                             common::TelemetryTopicStr[static_cast<std::size_t>(topic)]);
+        this->telemetry_socket_->connect(endpoint);
+    }
+    catch (const zmq::error_t& error)
+    {
+        this->telemetry_socket_.reset();
+        this->telemetry_ctx_.reset();
+        this->onClientError(error, "Error while starting the telemetry.");
+        return false;
+    }
+
+    // Launch the worker. From now on, the socket is only used in the telemetry thread.
+    this->telemetry_clbk_ = std::move(callback);
+    this->telemetry_working_ = true;
+    this->telemetry_fut_ = std::async(std::launch::async, &AmelasControllerClient::telemetryWorker, this);
+    return true;
+}
+
+void AmelasControllerClient::stopTelemetry()
+{
+    // Check if we are already stopped.
+    if(!this->telemetry_working_)
+        return;
+
+    // Stop the worker and close the context.
+    this->telemetry_working_ = false;
+    this->telemetry_ctx_->shutdown();
+    this->telemetry_fut_.wait();
+    this->telemetry_ctx_->close();
+    this->telemetry_ctx_.reset();
+}
+
+void AmelasControllerClient::telemetryWorker()
+{
+    // Accumulated state.
+    controller::MountState state;
+
+    // Subscriber loop.
+    while(this->telemetry_working_)
+    {
+        try
+        {
+            // Receive the frame: [topic][payload].
+            zmq::multipart_t msg;
+            if(!msg.recv(*this->telemetry_socket_) || msg.size() != 2)
+                continue;
+
+            // Get the topic.
+            const std::string topic_str = msg[0].to_string();
+            std::size_t idx = 0;
+            while(idx < common::TelemetryTopicStr.size() && topic_str != common::TelemetryTopicStr[idx])
+                idx++;
+            if(idx == common::TelemetryTopicStr.size())
+                continue;
+            const auto topic = static_cast<TelemetryTopic>(idx);
+
+            // Update the state with the received fields.
+            const void* data = msg[1].data();
+            const std::size_t size = msg[1].size();
+            try
+            {
+                if(topic == TelemetryTopic::POSITION)
+                    BinarySerializer::fastDeserializationPacked(data, size, state.timestamp,
+                                                                state.position.az, state.position.el);
+                else if(topic == TelemetryTopic::HOME_POSITION)
+                    BinarySerializer::fastDeserializationPacked(data, size, state.timestamp,
+                                                                state.home_position.az, state.home_position.el);
+                else
+                    BinarySerializer::fastDeserializationPacked(data, size, state.timestamp,
+                                                                state.position.az, state.position.el,
+                                                                state.home_position.az, state.home_position.el);
+            }
+            catch(...)
+            {
+                AMELAS_LOG_WARNING("<", this->getClientName(), "> INVALID TELEMETRY FRAME | Topic: ", topic_str);
+                continue;
+            }
+
+            // Call to the user callback.
+            this->telemetry_clbk_(topic, state);
+        }
+        catch(const zmq::error_t& error)
+        {
+            if(error.num() == ETERM)
+                break;
+            this->onClientError(error, "Error in the telemetry worker.");
+        }
+    }
+
+    // Close the socket in this thread.
+    this->telemetry_socket_.reset();
+}
+
+bool AmelasControllerClient::startAsyncChannel(unsigned max_in_flight, unsigned timeout_ms,
+                                               const std::string &endpoint)
+{
+    // Check if the channel is already working.
+    if(this->async_working_ || !max_in_flight)
+        return false;
+
+    // Create the DEALER socket (in the shared context for the inproc endpoints) and the signal sockets.
+    const std::string& channel_endpoint = endpoint.empty() ? this->getServerEndpoint() : endpoint;
+    const bool inproc = common::isInprocEndpoint(channel_endpoint);
+    try
+    {
+        const std::string signal_endpoint = "inproc://amelas_async_signal";
+        this->async_ctx_ = std::make_unique<zmq::context_t>();
+        this->async_socket_ = std::make_unique<zmq::socket_t>(inproc ? common::getInprocContext() : *this->async_ctx_,
+                                                              zmq::socket_type::dealer);
+        this->async_socket_->set(zmq::sockopt::linger, 0);
+        this->async_socket_->connect(channel_endpoint);
+        this->async_signal_recv_ = std::make_unique<zmq::socket_t>(*this->async_ctx_, zmq::socket_type::pair);
+        this->async_signal_recv_->bind(signal_endpoint);
+        this->async_signal_send_ = std::make_unique<zmq::socket_t>(*this->async_ctx_, zmq::socket_type::pair);
+        this->async_signal_send_->connect(signal_endpoint);
+    }
+    catch (const zmq::error_t& error)
+    {
+        this->async_socket_.reset();
+        this->async_signal_recv_.reset();
+        this->async_signal_send_.reset();
+        this->async_ctx_.reset();
+        this->onClientError(error, "Error while starting the asynchronous channel.");
+        return false;
+    }
+
+    // Configure the channel before the worker starts. The limits are read by the callers under the mutex, so they
+    // are set under it too (a heartbeat can be queueing while the channel is restarted).
+    {
+        std::lock_guard<std::mutex> lock(this->async_mtx_);
+        this->async_max_in_flight_ = max_in_flight;
+        this->async_timeout_ = std::chrono::milliseconds(timeout_ms);
+        this->async_inproc_.store(inproc);
+        this->async_working_ = true;
+    }
+
+    // Launch the worker. From now on, the DEALER socket is only used in the asynchronous thread.
+    this->async_fut_ = std::async(std::launch::async, &AmelasControllerClient::asyncWorker, this);
+    return true;
+}
+
+void AmelasControllerClient::stopAsyncChannel()
+{
+    // Check if we are already stopped and wake up the worker.
+    {
+        std::lock_guard<std::mutex> lock(this->async_mtx_);
+        if(!this->async_working_)
+            return;
+        this->async_working_ = false;
+        this->async_signal_send_->send(zmq::message_t(), zmq::send_flags::dontwait);
+    }
+    this->async_cv_.notify_all();
+
+    // Wait the worker and close the context.
+    this->async_fut_.wait();
+    this->async_signal_send_.reset();
+    this->async_ctx_->close();
+    this->async_ctx_.reset();
+}
+
+std::future<CommandReply> AmelasControllerClient::sendCommandAsync(const RequestData &request)
+{
+    // Queue the request. If it fails, the future is ready with the error.
+    AsyncPending pending;
+    std::future<CommandReply> future = pending.promise.get_future();
+    this->checkAsyncQueued(pending, this->enqueueAsyncRequest(request, pending));
+    return future;
+}
+
+bool AmelasControllerClient::sendCommandAsync(const RequestData &request, AsyncReplyCallback callback)
+{
+    // Check the callback and queue the request.
+    if(!callback)
+        return false;
+    AsyncPending pending;
+    pending.callback = std::move(callback);
+    return this->enqueueAsyncRequest(request, pending) == OperationResult::COMMAND_OK;
+}
+
+std::future<CommandReply> AmelasControllerClient::sendCommandAsync(RequestData &&request)
+{
+    // Queue the request. If it fails, the future is ready with the error.
+    AsyncPending pending;
+    std::future<CommandReply> future = pending.promise.get_future();
+    this->checkAsyncQueued(pending, this->enqueueAsyncRequest(std::move(request), pending));
+    return future;
+}
+
+bool AmelasControllerClient::sendCommandAsync(RequestData &&request, AsyncReplyCallback callback)
+{
+    // Check the callback and queue the request.
+    if(!callback)
+        return false;
+    AsyncPending pending;
+    pending.callback = std::move(callback);
+    return this->enqueueAsyncRequest(std::move(request), pending) == OperationResult::COMMAND_OK;
+}
+
+unsigned AmelasControllerClient::getInFlightRequests() const
+{
+    std::lock_guard<std::mutex> lock(this->async_mtx_);
+    return static_cast<unsigned>(this->async_pending_.size());
+}
+
+void AmelasControllerClient::checkAsyncQueued(AsyncPending &pending, OperationResult result)
+{
+    // If the request was not queued, the pending request is still here and is completed with the error.
+    if(result != OperationResult::COMMAND_OK)
+    {
+        CommandReply reply;
+        reply.server_result = result;
+        pending.promise.set_value(std::move(reply));
+    }
+}
+
+OperationResult AmelasControllerClient::enqueueAsyncRequest(const RequestData &request, AsyncPending &pending)
+{
+    // Prepare the message: [uuid][command][params]. The envelope is added when the correlation id is assigned. The
+    // parameters are copied into a pooled buffer, which is sent without more copies.
+    const auto& uuid = this->getClientInfo().uuid.getBytes();
+    const auto command = LocalBinarySerializer::fastSerializationFixed(static_cast<CommandType>(request.command));
+    zmq::multipart_t msg;
+    msg.addmem(uuid.data(), uuid.size());
+    msg.addmem(command.data(), command.size());
+    if(request.params && request.params_size)
+    {
+        BufferPool::PooledBytes params = BufferPool::defaultPool().acquire(request.params_size);
+        std::memcpy(params.get(), request.params.get(), request.params_size);
+        msg.add(makeZeroCopyMessage(std::move(params), request.params_size));
+    }
+
+    // Call to the sending command callback.
+    this->onSendingCommand(request);
+
+    // Queue the message.
+    return this->enqueueAsyncMessage(msg, pending);
+}
+
+OperationResult AmelasControllerClient::enqueueAsyncRequest(RequestData &&request, AsyncPending &pending, bool wait)
+{
+    // Call to the sending command callback (before moving the parameters).
+    this->onSendingCommand(request);
+
+    // Prepare the message: [uuid][command][moved request][tag] in the inproc channels, [uuid][command][params]
+    // otherwise (the parameters without copies).
+    const auto& uuid = this->getClientInfo().uuid.getBytes();
+    const auto command = LocalBinarySerializer::fastSerializationFixed(static_cast<CommandType>(request.command));
+    zmq::multipart_t msg;
+    msg.addmem(uuid.data(), uuid.size());
+    msg.addmem(command.data(), command.size());
+    if(this->async_inproc_)
+    {
+        msg.add(common::makeMovedFrame(std::move(request)));
+        msg.add(common::makeMovedTagFrame());
+    }
+    else if(request.params && request.params_size)
+        msg.add(makeZeroCopyMessage(std::move(request.params), request.params_size));
 
+    // Queue the message.
+    return this->enqueueAsyncMessage(msg, pending, wait);
+}
+
+OperationResult AmelasControllerClient::enqueueAsyncMessage(zmq::multipart_t &msg, AsyncPending &pending, bool wait)
+{
+    // Wait for a free slot (or fail at once if the caller can not wait).
+    std::unique_lock<std::mutex> lock(this->async_mtx_);
+    auto free_slot = [this]
+        {return !this->async_working_ || this->async_pending_.size() < this->async_max_in_flight_;};
+    if(wait ? !this->async_cv_.wait_for(lock, this->async_timeout_, free_slot) : !free_slot())
+        return OperationResult::TIMEOUT_REACHED;
+    if(!this->async_working_)
+        return OperationResult::CLIENT_STOPPED;
+
+    // Add the envelope: [correlation id][empty].
+    const std::uint64_t id = this->async_next_id_++;
+    msg.push(zmq::message_t());
+    msg.pushtyp(id);
+
+    // Register the request and wake up the worker (only once for each group of queued messages).
+    pending.deadline = std::chrono::steady_clock::now() + this->async_timeout_;
+    this->async_pending_.emplace(id, std::move(pending));
+    this->async_outgoing_.push_back(std::move(msg));
+    if(this->async_outgoing_.size() == 1)
+        this->async_signal_send_->send(zmq::message_t(), zmq::send_flags::dontwait);
+    return OperationResult::COMMAND_OK;
+}
+
+void AmelasControllerClient::processAsyncReply(zmq::multipart_t &msg)
+{
+    // Auxiliar variables. The frame parameters can be borrowed by the reply until it is completed.
+    CommandReply reply;
+    common::BorrowedParams<CommandReply> borrowed_params(reply);
+    AsyncPending pending;
+    std::uint64_t id;
+    bool found = false;
+
+    // Check the reply: [correlation id][empty][result][params], or [correlation id][empty][result][moved reply][tag]
+    // in the inproc channels.
+    const bool moved = this->async_inproc_ && msg.size() == 5 && common::isMovedTagFrame(msg[4]);
+    if(msg.size() < 3 || (msg.size() > 4 && !moved) || msg[0].size() != sizeof(id) || msg[1].size() != 0)
+    {
+        reply.server_result = OperationResult::INVALID_PARTS;
+        this->onInvalidMsgReceived(reply);
+        return;
+    }
+    std::memcpy(&id, msg[0].data(), sizeof(id));
+
+    // Get the result.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(msg[2].data(), msg[2].size(), reply.server_result);
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::INVALID_MSG;
+    }
+
+    // Get the pending request. The replies of the expired requests are discarded.
+    {
+        std::lock_guard<std::mutex> lock(this->async_mtx_);
+        auto it = this->async_pending_.find(id);
+        if(it != this->async_pending_.end())
+        {
+            pending = std::move(it->second);
+            this->async_pending_.erase(it);
+            found = true;
+        }
+    }
+    if(!found)
+    {
+        AMELAS_LOG_WARNING("<", this->getClientName(), "> DISCARDED ASYNC REPLY | Id: ", id);
+        return;
+    }
+    this->async_cv_.notify_one();
+
+    // Get the parameters, moved from the reply object or read from the frame. The callbacks read them in place, while
+    // the futures need an owned copy because their reply outlives the message.
+    if(moved)
+    {
+        CommandReply* moved_reply = common::getMovedObject<CommandReply>(msg[3]);
+        if(moved_reply && moved_reply->params)
+        {
+            reply.params = std::move(moved_reply->params);
+            reply.params_size = moved_reply->params_size;
+        }
+    }
+    else if(msg.size() == 4 && pending.callback)
+        borrowed_params.borrow(std::move(msg[3]));
+    else if(msg.size() == 4)
+    {
+        BorrowedBytes params(std::move(msg[3]));
+        reply.params = params.toUnique();
+        reply.params_size = params.size();
+    }
+
+    // Complete the request.
+    this->onReplyReceived(reply);
+    this->completeAsyncRequest(pending, std::move(reply));
+}
+
+void AmelasControllerClient::completeAsyncRequest(AsyncPending &pending, CommandReply &&reply)
+{
+    // Call to the user callback or set the future value.
+    if(pending.callback)
+    {
+        try
+        {
+            pending.callback(reply);
+        }
+        catch(...)
+        {
+            AMELAS_LOG_WARNING("<", this->getClientName(), "> EXCEPTION IN ASYNC REPLY CALLBACK");
+        }
+    }
+    else
+        pending.promise.set_value(std::move(reply));
+}
+
+void AmelasControllerClient::asyncWorker()
+{
+    // Poll items: DEALER socket and signal socket.
+    zmq::pollitem_t items[] = {{this->async_socket_->handle(), 0, ZMQ_POLLIN, 0},
+                               {this->async_signal_recv_->handle(), 0, ZMQ_POLLIN, 0}};
+
+    // Auxiliar containers.
+    std::deque<zmq::multipart_t> outgoing;
+    std::vector<AsyncPending> expired;
+
+    // Channel loop.
+    while(this->async_working_)
+    {
+        try
+        {
+            zmq::poll(items, 2, std::chrono::milliseconds(common::kAsyncPollTimeoutMsec));
+
+            // Drain the signals and send the queued requests.
+            if(items[1].revents & ZMQ_POLLIN)
+            {
+                zmq::message_t signal;
+                while(this->async_signal_recv_->recv(signal, zmq::recv_flags::dontwait)){}
+            }
+            {
+                std::lock_guard<std::mutex> lock(this->async_mtx_);
+                outgoing.swap(this->async_outgoing_);
+            }
+            for(auto& msg : outgoing)
+                msg.send(*this->async_socket_);
+            outgoing.clear();
+
+            // Receive all the available replies.
+            if(items[0].revents & ZMQ_POLLIN)
+            {
+                zmq::multipart_t msg;
+                while(msg.recv(*this->async_socket_, ZMQ_DONTWAIT))
+                {
+                    this->processAsyncReply(msg);
+                    msg.clear();
+                }
+            }
+
+            // Complete the expired requests.
+            const auto now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(this->async_mtx_);
+                for(auto it = this->async_pending_.begin(); it != this->async_pending_.end();)
+                {
+                    if(it->second.deadline <= now)
+                    {
+                        expired.push_back(std::move(it->second));
+                        it = this->async_pending_.erase(it);
+                    }
+                    else
+                        it++;
+                }
+            }
+            if(!expired.empty())
+                this->async_cv_.notify_all();
+            for(auto& pending : expired)
+            {
+                CommandReply reply;
+                reply.server_result = OperationResult::TIMEOUT_REACHED;
+                this->completeAsyncRequest(pending, std::move(reply));
+            }
+            expired.clear();
+        }
+        catch(const zmq::error_t& error)
+        {
+            if(error.num() == ETERM)
+                break;
+            this->onClientError(error, "Error in the asynchronous channel.");
+        }
+    }
+
+    // Close the sockets in this thread.
+    this->async_socket_.reset();
+    this->async_signal_recv_.reset();
+
+    // Complete the rest of the requests.
+    {
+        std::lock_guard<std::mutex> lock(this->async_mtx_);
+        for(auto& entry : this->async_pending_)
+            expired.push_back(std::move(entry.second));
+        this->async_pending_.clear();
+        this->async_outgoing_.clear();
+    }
+    for(auto& pending : expired)
+    {
+        CommandReply reply;
+        reply.server_result = OperationResult::CLIENT_STOPPED;
+        this->completeAsyncRequest(pending, std::move(reply));
+    }
+}
+
+void AmelasControllerClient::enableSharedHeartbeat(unsigned period_ms)
+{
+    HeartbeatScheduler::getInstance().add(this->heartbeat_, std::chrono::milliseconds(period_ms));
+}
+
+void AmelasControllerClient::disableSharedHeartbeat()
+{
+    HeartbeatScheduler::getInstance().remove(this->heartbeat_);
+}
+
+std::uint64_t AmelasControllerClient::getSkippedHeartbeats() const
+{
+    return this->heartbeat_skipped_.load(std::memory_order_relaxed);
+}
+
+void AmelasControllerClient::sendHeartbeat()
+{
+    // Log.
+    AMELAS_LOG_TRACE("<", this->getClientName(), "> SENDING SHARED HEARTBEAT");
+
+    // Queue the alive request without waiting, so the scheduler thread never blocks (the synchronous path is never
+    // used here). The reply touches the heartbeat. If it can not be queued, it is skipped until the next period.
+    OperationResult result = OperationResult::CLIENT_STOPPED;
+    if(this->async_working_)
+    {
+        AsyncPending pending;
+        pending.callback = [](const CommandReply&){};
+        result = this->enqueueAsyncRequest(RequestData(ServerCommand::REQ_ALIVE), pending, false);
+    }
+    if(result != OperationResult::COMMAND_OK)
+    {
+        this->heartbeat_skipped_.fetch_add(1, std::memory_order_relaxed);
+        AMELAS_LOG_DEBUG("<", this->getClientName(), "> SHARED HEARTBEAT SKIPPED | Result: ",
+                         static_cast<ResultType>(result));
+    }
+}
 
 void AmelasControllerClient::onClientStart()
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON CLIENT START: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Endpoint: "<<this->getServerEndpoint()<<std::endl;
-    std::cout<<"Name: "<<this->getClientInfo().name<<std::endl;
-    std::cout<<"UUID: "<<this->getClientInfo().uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Ip: "<<this->getClientInfo().ip<<std::endl;
-    std::cout<<"Pid: "<<this->getClientInfo().pid<<std::endl;
-    std::cout<<"Hostname: "<<this->getClientInfo().hostname<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<", this->getClientName(), "> ON CLIENT START | Endpoint: ", this->getServerEndpoint(),
+                    " | Name: ", this->getClientInfo().name, " | UUID: ", this->getClientInfo().uuid,
+                    " | Ip: ", this->getClientInfo().ip, " | Pid: ", this->getClientInfo().pid,
+                    " | Hostname: ", this->getClientInfo().hostname);
 }
 
 void AmelasControllerClient::onClientStop()
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON CLIENT STOP: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<", this->getClientName(), "> ON CLIENT STOP");
 }
 
 void AmelasControllerClient::onWaitingReply()
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON WAITING REPLY: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_TRACE("<", this->getClientName(), "> ON WAITING REPLY");
 }
 
 void AmelasControllerClient::onDeadServer()
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON DEAD SERVER: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_WARNING("<", this->getClientName(), "> ON DEAD SERVER");
 }
 
 void AmelasControllerClient::onConnected()
 {
     // TODO In base get server info when connected.
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON CONNECTED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Endpoint: "<<this->getServerEndpoint()<<std::endl;
-    std::cout<<"Server Name: "<<std::endl;
-    std::cout<<"Server Version: "<<std::endl;
-    std::cout<<"Server Info: "<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<", this->getClientName(), "> ON CONNECTED | Endpoint: ", this->getServerEndpoint());
 }
 
 void AmelasControllerClient::onDisconnected()
 {
+    // Stop the shared heartbeat (without waiting, this callback can run while the heartbeat waits for the client).
+    HeartbeatScheduler::getInstance().remove(this->heartbeat_, false);
+
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON DISCONNECTED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<", this->getClientName(), "> ON DISCONNECTED");
 }
 
 void AmelasControllerClient::onReplyReceived(const CommandReply &reply)
 {
+    // Any successful command proves that the connection is alive.
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        this->heartbeat_.touch();
+
     // Auxiliar.
-    BinarySerializer serializer(reply.params.get(), reply.params_size);
     ResultType result = static_cast<ResultType>(reply.server_result);
-    std::string res_str = zmqutils::utils::getEnumString(reply.server_result, AmelasServerResultStr);
+    const char* res_str = (static_cast<std::size_t>(result) < AmelasServerResultStr.size()) ?
+                              AmelasServerResultStr[static_cast<std::size_t>(result)] : "Unknown result";
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON REPLY RECEIVED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Result: "<<result<<" ("<<res_str<<")"<<std::endl;
-    std::cout<<"Params Size: "<<reply.params_size<<std::endl;
-    std::cout<<"Params Hex: "<<serializer.getDataHexString()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_DEBUG("<", this->getClientName(), "> ON REPLY RECEIVED | Result: ", result, " (", res_str,
+                     ") | Params Size: ", reply.params_size,
+                     " | Params Hex: ", utils::logHex(reply.params.get(), reply.params_size));
 }
 
 void AmelasControllerClient::onSendingCommand(const RequestData &req)
 {
-    BinarySerializer serializer(req.params.get(), req.params_size);
+    // Auxiliar.
     CommandType command = static_cast<CommandType>(req.command);
-    std::string cmd_str = zmqutils::utils::getEnumString(req.command, AmelasServerCommandStr);
+    const char* cmd_str = (static_cast<std::size_t>(command) < AmelasServerCommandStr.size()) ?
+                              AmelasServerCommandStr[static_cast<std::size_t>(command)] : "Unknown command";
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON SEND COMMAND: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Command: "<<command<<" ("<<cmd_str<<")"<<std::endl;
-    std::cout<<"Params size: "<<req.params_size<<std::endl;
-    std::cout<<"Params Hex: "<<serializer.getDataHexString()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_DEBUG("<", this->getClientName(), "> ON SEND COMMAND | Command: ", command, " (", cmd_str,
+                     ") | Params Size: ", req.params_size,
+                     " | Params Hex: ", utils::logHex(req.params.get(), req.params_size));
 }
 
 void AmelasControllerClient::onClientError(const zmq::error_t& error, const std::string& ext_info)
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<"<<this->getClientName()<<">"<<std::endl;
-    std::cout<<"-> ON CLIENT ERROR: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Code: "<<error.num()<<std::endl;
-    std::cout<<"Error: "<<error.what()<<std::endl;
-    std::cout<<"Info: "<<ext_info<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_CRITICAL("<", this->getClientName(), "> ON CLIENT ERROR | Code: ", error.num(),
+                        " | Error: ", error.what(), " | Info: ", ext_info);
 }
 
 void amelas::communication::AmelasControllerClient::onInvalidMsgReceived(const CommandReply &) {}
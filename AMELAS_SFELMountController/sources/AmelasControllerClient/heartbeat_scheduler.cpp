@@ -0,0 +1,193 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file heartbeat_scheduler.cpp
+ * @brief This file contains the implementation of the HeartbeatScheduler class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasControllerClient/heartbeat_scheduler.h"
+#include "AmelasUtils/async_logger.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+HeartbeatScheduler::HeartbeatScheduler() :
+    next_generation_(0),
+    running_(nullptr),
+    sent_(0),
+    skipped_(0),
+    working_(false)
+{}
+
+HeartbeatScheduler &HeartbeatScheduler::getInstance()
+{
+    static HeartbeatScheduler scheduler;
+    return scheduler;
+}
+
+void HeartbeatScheduler::add(Connection &connection, std::chrono::milliseconds period)
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->mtx_);
+
+    // Register the connection with a new timer (the previous timer, if any, becomes stale).
+    const std::uint64_t generation = this->next_generation_++;
+    connection.period_ = std::max(period, std::chrono::milliseconds(1));
+    connection.touch();
+    this->connections_[&connection] = generation;
+    this->timers_.push({Clock::now() + connection.period_, &connection, generation});
+
+    // Start the thread if needed. A previous thread that is not working has already released the lock for good.
+    if(!this->working_)
+    {
+        if(this->worker_fut_.valid())
+            this->worker_fut_.wait();
+        this->working_ = true;
+        this->worker_fut_ = std::async(std::launch::async, &HeartbeatScheduler::worker, this);
+    }
+    this->worker_cv_.notify_one();
+}
+
+bool HeartbeatScheduler::remove(Connection &connection, bool wait)
+{
+    // Safe mutex.
+    std::unique_lock<std::mutex> lock(this->mtx_);
+
+    // Unregister the connection. Its timer is discarded when it reaches the top of the heap.
+    const bool removed = this->connections_.erase(&connection) != 0;
+    if(removed)
+        this->worker_cv_.notify_one();
+
+    // Wait for the heartbeat in progress, even if the connection was already removed (a previous remove without wait
+    // may have left its heartbeat running).
+    if(wait && std::this_thread::get_id() != this->worker_id_)
+        this->running_cv_.wait(lock, [this, &connection]{return this->running_ != &connection;});
+    return removed;
+}
+
+bool HeartbeatScheduler::contains(const Connection &connection) const
+{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->connections_.count(&connection) != 0;
+}
+
+std::size_t HeartbeatScheduler::size() const
+{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->connections_.size();
+}
+
+std::uint64_t HeartbeatScheduler::getSentHeartbeats() const
+{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->sent_;
+}
+
+std::uint64_t HeartbeatScheduler::getSkippedHeartbeats() const
+{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->skipped_;
+}
+
+HeartbeatScheduler::~HeartbeatScheduler()
+{
+    // Stop the thread.
+    {
+        std::lock_guard<std::mutex> lock(this->mtx_);
+        this->connections_.clear();
+        this->worker_cv_.notify_one();
+    }
+    if(this->worker_fut_.valid())
+        this->worker_fut_.wait();
+}
+
+void HeartbeatScheduler::worker()
+{
+    // Safe mutex. It is released only while waiting and while sending a heartbeat.
+    std::unique_lock<std::mutex> lock(this->mtx_);
+    this->worker_id_ = std::this_thread::get_id();
+
+    // Scheduler loop. It finishes when there are no connections.
+    while(!this->connections_.empty())
+    {
+        // Discard the stale timers.
+        const Timer timer = this->timers_.top();
+        auto it = this->connections_.find(timer.connection);
+        if(it == this->connections_.end() || it->second != timer.generation)
+        {
+            this->timers_.pop();
+            continue;
+        }
+
+        // Wait for the nearest deadline (or for a new connection or a removal).
+        const Clock::time_point now = Clock::now();
+        if(now < timer.deadline)
+        {
+            this->worker_cv_.wait_until(lock, timer.deadline);
+            continue;
+        }
+        this->timers_.pop();
+        Connection& connection = *timer.connection;
+
+        // Active connection: move the timer to the end of the period since the last activity.
+        const Clock::time_point last_activity = connection.getLastActivity();
+        if(now - last_activity < connection.period_)
+        {
+            this->timers_.push({last_activity + connection.period_, &connection, timer.generation});
+            this->skipped_++;
+            continue;
+        }
+
+        // Idle connection: send the heartbeat without the lock and schedule the next one.
+        this->timers_.push({now + connection.period_, &connection, timer.generation});
+        this->running_ = &connection;
+        lock.unlock();
+        try
+        {
+            connection.heartbeat_();
+        }
+        catch(...)
+        {
+            AMELAS_LOG_WARNING("<HEARTBEAT SCHEDULER> EXCEPTION IN HEARTBEAT FUNCTION");
+        }
+        lock.lock();
+        this->running_ = nullptr;
+        this->sent_++;
+        this->running_cv_.notify_all();
+    }
+
+    // Clean the stale timers and finish.
+    this->timers_ = decltype(this->timers_)();
+    this->worker_id_ = std::thread::id();
+    this->working_ = false;
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -21,9 +21,19 @@
  * @version 2309.5
 ***********************************************************************************************************************/
 
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <thread>
+// =====================================================================================================================
+
 // PROJECT INCLUDES
 // =====================================================================================================================
 #include "AmelasControllerServer/amelas_controller_server.h"
+#include "AmelasUtils/async_logger.h"
 // =====================================================================================================================
 
 // AMELAS NAMESPACES
@@ -37,10 +47,74 @@ using zmqutils::common::ServerCommand;
 using zmqutils::common::OperationResult;
 using zmqutils::common::ResultType;
 using zmqutils::utils::BinarySerializer;
+using zmqutils::utils::LocalBinarySerializer;
+using zmqutils::utils::BufferPool;
+using zmqutils::utils::makeZeroCopyMessage;
+using zmqutils::common::RequestData;
+// ---------------------------------------------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------------------------------------
+namespace{
+
+// Origin frame of the requests forwarded to the workers when there is an inproc front end.
+constexpr char kOriginNetwork = 'N';
+constexpr char kOriginInproc = 'I';
+
+// Read the controller error at the start of the reply parameters (tagged or packed format).
+bool readReplyError(const CommandReply& reply, controller::AmelasError& error)
+{
+    const std::byte* data = reply.params.get();
+    if(!data || reply.params_size == 0)
+        return false;
+    try
+    {
+        if(BinarySerializer::isPackedData(data, reply.params_size))
+        {
+            // The packed readers check the whole layout, so the first value is decoded from the header flags.
+            std::uint32_t value;
+            if(reply.params_size < BinarySerializer::kPackedHeaderSize + sizeof(value))
+                return false;
+            std::memcpy(&value, data + BinarySerializer::kPackedHeaderSize, sizeof(value));
+            const std::uint16_t probe = 1;
+            const bool host_little = *reinterpret_cast<const std::uint8_t*>(&probe) == 1;
+            const bool data_little = (static_cast<std::uint8_t>(data[1]) & BinarySerializer::kPackedFlagLittle) != 0;
+            if(host_little != data_little)
+                value = ((value & 0xFFu) << 24) | ((value & 0xFF00u) << 8) | ((value >> 8) & 0xFF00u) | (value >> 24);
+            error = static_cast<controller::AmelasError>(value);
+        }
+        else
+        {
+            LocalBinarySerializer serializer(data, reply.params_size);
+            serializer.read(error);
+        }
+    }
+    catch(...)
+    {
+        return false;
+    }
+    return true;
+}
+
+} // END ANONYMOUS NAMESPACE.
 // ---------------------------------------------------------------------------------------------------------------------
 
 AmelasControllerServer::AmelasControllerServer(unsigned int port, const std::string &local_addr) :
-    ClbkCommandServerBase(port, local_addr)
+    ClbkCommandServerBase(port, local_addr),
+    process_fncs_{},
+    server_addr_(local_addr),
+    telemetry_enabled_(false),
+    telemetry_port_(0),
+    telemetry_rate_(kDefaultTelemetryRateHz),
+    telemetry_ctrl_(nullptr),
+    telemetry_clbk_(nullptr),
+    telemetry_working_(false),
+    router_endpoint_("tcp://" + local_addr + ":" + std::to_string(port)),
+    router_mode_(false),
+    router_workers_(kDefaultRouterWorkers),
+    router_check_alive_(true),
+    router_alive_callbacks_(true),
+    router_alive_timeout_(zmqutils::common::kDefaultClientAliveTimeoutMsec),
+    router_working_(false)
 {
     // Register each internal specific process function in the base server.
 
@@ -51,9 +125,759 @@ AmelasControllerServer::AmelasControllerServer(unsigned int port, const std::str
     // REQ_GET_HOME_POSITION.
     this->registerRequestProcFunc(AmelasServerCommand::REQ_GET_HOME_POSITION,
                                   &AmelasControllerServer::processGetHomePosition);
+
+    // REQ_BATCH.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_BATCH,
+                                  &AmelasControllerServer::processBatch);
+
+    // REQ_BEGIN_TRAJECTORY_UPLOAD.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_BEGIN_TRAJECTORY_UPLOAD,
+                                  &AmelasControllerServer::processBeginTrajectoryUpload);
+
+    // REQ_UPLOAD_TRAJECTORY_CHUNK.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_UPLOAD_TRAJECTORY_CHUNK,
+                                  &AmelasControllerServer::processUploadTrajectoryChunk);
+
+    // REQ_COMMIT_TRAJECTORY_UPLOAD.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_COMMIT_TRAJECTORY_UPLOAD,
+                                  &AmelasControllerServer::processCommitTrajectoryUpload);
+
+    // REQ_LOAD_POINTING_MODEL.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_LOAD_POINTING_MODEL,
+                                  &AmelasControllerServer::processLoadPointingModel);
+
+    // REQ_SET_POINTING_MODEL.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_SET_POINTING_MODEL,
+                                  &AmelasControllerServer::processSetPointingModel);
+
+    // REQ_GET_CONTROL_LOOP_STATS.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS,
+                                  &AmelasControllerServer::processGetControlLoopStats);
+
+    // REQ_GET_METRICS.
+    this->registerRequestProcFunc(AmelasServerCommand::REQ_GET_METRICS,
+                                  &AmelasControllerServer::processGetMetrics);
+}
+
+AmelasControllerServer::~AmelasControllerServer()
+{
+    // Stop the server (router workers or base worker) and the telemetry here, so no worker calls the hooks of this
+    // class while its members are destroyed.
+    this->stopServer();
+    this->stopTelemetry();
+}
+
+void AmelasControllerServer::setTelemetry(bool enabled, unsigned port, unsigned rate_hz)
+{
+    // The configuration can't be changed while working.
+    if(this->telemetry_working_)
+        return;
+
+    this->telemetry_enabled_ = enabled;
+    this->telemetry_port_ = port;
+    this->telemetry_rate_ = std::clamp(rate_hz, 1u, kMaxTelemetryRateHz);
+}
+
+void AmelasControllerServer::setTelemetrySource(controller::AmelasController *object,
+                                                controller::AmelasControllerCallback<controller::MountState&> callback)
+{
+    // The source can't be changed while working.
+    if(this->telemetry_working_)
+        return;
+
+    this->telemetry_ctrl_ = object;
+    this->telemetry_clbk_ = callback;
+}
+
+void AmelasControllerServer::setRouterMode(bool enabled, unsigned workers)
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->router_mtx_);
+
+    // The mode can't be changed while working.
+    if(this->router_working_ || CommandServerBase::isWorking())
+        return;
+
+    this->router_mode_ = enabled;
+    this->router_workers_ = std::max(1u, workers);
+}
+
+void AmelasControllerServer::setLocalEndpoints(const std::vector<std::string> &endpoints)
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->router_mtx_);
+
+    // The endpoints can't be changed while working.
+    if(this->router_working_)
+        return;
+
+    this->router_local_endpoints_ = endpoints;
+}
+
+bool AmelasControllerServer::startServer()
+{
+    // Freeze the callbacks. From now on they are invoked without locks.
+    this->dispatch_table_.freeze();
+
+    // Classic mode, use the base server worker (it writes the metrics in the first shard).
+    if(!this->router_mode_)
+    {
+        if(!this->isWorking())
+            this->metrics_.configure(1);
+        if(!CommandServerBase::startServer())
+            return false;
+        if(!this->startTelemetry())
+        {
+            this->stopServer();
+            return false;
+        }
+        return true;
+    }
+
+    // Safe mutex.
+    std::unique_lock<std::mutex> lock(this->router_mtx_);
+
+    // Check if we are already working.
+    if(this->router_working_)
+        return true;
+
+    // Create the context and bind the front end and the inproc back ends.
+    try
+    {
+        this->router_ctx_ = std::make_unique<zmq::context_t>();
+        this->router_frontend_ = std::make_unique<zmq::socket_t>(*this->router_ctx_, zmq::socket_type::router);
+        this->router_read_backend_ = std::make_unique<zmq::socket_t>(*this->router_ctx_, zmq::socket_type::dealer);
+        this->router_write_backend_ = std::make_unique<zmq::socket_t>(*this->router_ctx_, zmq::socket_type::dealer);
+        this->router_frontend_->set(zmq::sockopt::linger, 0);
+        this->router_read_backend_->set(zmq::sockopt::linger, 0);
+        this->router_write_backend_->set(zmq::sockopt::linger, 0);
+        this->router_frontend_->bind(this->router_endpoint_);
+        this->router_read_backend_->bind("inproc://amelas_router_read");
+        this->router_write_backend_->bind("inproc://amelas_router_write");
+
+        // Local endpoints. The inproc ones go to their own front end in the shared inproc context.
+        for(const auto& endpoint : this->router_local_endpoints_)
+        {
+            if(!isInprocEndpoint(endpoint))
+            {
+                this->router_frontend_->bind(endpoint);
+                continue;
+            }
+            if(!this->router_inproc_frontend_)
+            {
+                this->router_inproc_frontend_ = std::make_unique<zmq::socket_t>(getInprocContext(),
+                                                                                zmq::socket_type::router);
+                this->router_inproc_frontend_->set(zmq::sockopt::linger, 0);
+            }
+            this->router_inproc_frontend_->bind(endpoint);
+        }
+    }
+    catch (const zmq::error_t& error)
+    {
+        this->router_frontend_.reset();
+        this->router_inproc_frontend_.reset();
+        this->router_read_backend_.reset();
+        this->router_write_backend_.reset();
+        this->router_ctx_.reset();
+        lock.unlock();
+        this->onServerError(error, "Error while starting the router mode.");
+        return false;
+    }
+
+    // Launch the workers. Concurrent pool for the read only commands and one worker for the rest. Each one has its own
+    // metrics shard.
+    this->metrics_.configure(this->router_workers_ + 1);
+    this->router_working_ = true;
+    for(unsigned i = 0; i < this->router_workers_; i++)
+        this->router_workers_futs_.push_back(std::async(std::launch::async, &AmelasControllerServer::routerWorker,
+                                                        this, "inproc://amelas_router_read", std::size_t(i)));
+    this->router_workers_futs_.push_back(std::async(std::launch::async, &AmelasControllerServer::routerWorker,
+                                                    this, "inproc://amelas_router_write",
+                                                    std::size_t(this->router_workers_)));
+
+    // Launch the proxy. From now on, the front end and back end sockets are only used in the proxy thread.
+    this->router_proxy_fut_ = std::async(std::launch::async, &AmelasControllerServer::routerProxyWorker, this);
+
+    // Call the start callbacks.
+    lock.unlock();
+    this->onServerStart();
+    this->onWaitingCommand();
+
+    // Start the telemetry.
+    if(!this->startTelemetry())
+    {
+        this->stopServer();
+        return false;
+    }
+    return true;
+}
+
+void AmelasControllerServer::stopServer()
+{
+    // Stop the telemetry.
+    this->stopTelemetry();
+
+    // Classic mode, use the base server.
+    if(!this->router_mode_)
+        return CommandServerBase::stopServer();
+
+    // Safe mutex.
+    std::unique_lock<std::mutex> lock(this->router_mtx_);
+
+    // Check if we are already stopped.
+    if(!this->router_working_)
+        return;
+
+    // Shutdown the context. All the blocking calls will return with ETERM.
+    this->router_working_ = false;
+    this->router_ctx_->shutdown();
+
+    // Wait the proxy and the workers.
+    this->router_proxy_fut_.wait();
+    for(auto& fut : this->router_workers_futs_)
+        fut.wait();
+    this->router_workers_futs_.clear();
+
+    // Close the context and clean the clients.
+    this->router_ctx_->close();
+    this->router_ctx_.reset();
+    {
+        std::lock_guard<std::mutex> clients_lock(this->router_clients_mtx_);
+        this->router_clients_.clear();
+    }
+
+    // Call the stop callback.
+    lock.unlock();
+    this->onServerStop();
+}
+
+bool AmelasControllerServer::isWorking() const
+{
+    return this->router_mode_ ? this->router_working_.load() : CommandServerBase::isWorking();
+}
+
+std::map<UUID, HostInfo> AmelasControllerServer::getConnectedClients() const
+{
+    // Classic mode, use the base server clients.
+    if(!this->router_mode_)
+        return CommandServerBase::getConnectedClients();
+
+    // The router mode clients are in a hash table, so the ordered map is a copy (O(n log n), not for hot paths). It is
+    // returned by value, so concurrent callers never share it.
+    std::lock_guard<std::mutex> lock(this->router_clients_mtx_);
+    return this->router_clients_.toMap();
+}
+
+std::size_t AmelasControllerServer::getConnectedClientsCount() const
+{
+    if(!this->router_mode_)
+        return CommandServerBase::getConnectedClients().size();
+    std::lock_guard<std::mutex> lock(this->router_clients_mtx_);
+    return this->router_clients_.size();
+}
+
+void AmelasControllerServer::setClientAliveTimeout(unsigned timeout_ms)
+{
+    this->router_alive_timeout_ = timeout_ms;
+    CommandServerBase::setClientAliveTimeout(timeout_ms);
+}
+
+void AmelasControllerServer::setClientStatusCheck(bool enabled)
+{
+    this->router_check_alive_ = enabled;
+    CommandServerBase::setClientStatusCheck(enabled);
+}
+
+ServerMetricsSnapshot AmelasControllerServer::getMetrics() const
+{
+    return this->metrics_.getSnapshot();
+}
+
+std::string AmelasControllerServer::dumpMetrics() const
+{
+    return ServerMetrics::formatSnapshot(this->metrics_.getSnapshot());
+}
+
+void AmelasControllerServer::setAliveCallbacksEnabled(bool enabled)
+{
+    this->router_alive_callbacks_ = enabled;
+    CommandServerBase::setAliveCallbacksEnabled(enabled);
+}
+
+bool AmelasControllerServer::startTelemetry()
+{
+    // Check the configuration.
+    if(!this->telemetry_enabled_ || this->telemetry_working_)
+        return true;
+
+    // Create the publisher. XPUB is used to know the subscribed topics and skip the rest.
+    try
+    {
+        this->telemetry_ctx_ = std::make_unique<zmq::context_t>();
+        this->telemetry_socket_ = std::make_unique<zmq::socket_t>(*this->telemetry_ctx_, zmq::socket_type::xpub);
+        this->telemetry_socket_->set(zmq::sockopt::linger, 0);
+        this->telemetry_socket_->bind("tcp://" + this->server_addr_ + ":" + std::to_string(this->telemetry_port_));
+    }
+    catch (const zmq::error_t& error)
+    {
+        this->telemetry_socket_.reset();
+        this->telemetry_ctx_.reset();
+        this->onServerError(error, "Error while starting the telemetry.");
+        return false;
+    }
+
+    // Launch the worker. From now on, the socket is only used in the telemetry thread.
+    this->telemetry_working_ = true;
+    this->telemetry_fut_ = std::async(std::launch::async, &AmelasControllerServer::telemetryWorker, this);
+    return true;
+}
+
+void AmelasControllerServer::stopTelemetry()
+{
+    // Check if we are already stopped.
+    if(!this->telemetry_working_)
+        return;
+
+    // Stop the worker and close the context.
+    this->telemetry_working_ = false;
+    this->telemetry_ctx_->shutdown();
+    this->telemetry_fut_.wait();
+    this->telemetry_ctx_->close();
+    this->telemetry_ctx_.reset();
+}
+
+void AmelasControllerServer::telemetryWorker()
+{
+    // Auxiliar variables and containers.
+    constexpr std::size_t kTopics = static_cast<std::size_t>(TelemetryTopic::END_TELEMETRY_TOPICS);
+    std::set<std::string> subscriptions;
+    std::array<bool, kTopics> active{};
+    controller::MountState state;
+    zmq::socket_t& socket = *this->telemetry_socket_;
+    const std::chrono::nanoseconds period(1000000000ull / this->telemetry_rate_);
+    auto next = std::chrono::steady_clock::now();
+
+    // Frame publication helper. The payload is serialized into a pooled buffer and sent without copies, so in steady
+    // state the publication does not touch the heap.
+    auto publish = [&socket](TelemetryTopic topic, const auto&... args)
+    {
+        BufferPool::PooledBytes payload;
+        const auto size = BinarySerializer::fastSerializationPackedNative(payload, args...);
+        const char* name = TelemetryTopicStr[static_cast<std::size_t>(topic)];
+        socket.send(zmq::buffer(name, std::strlen(name)), zmq::send_flags::sndmore);
+        socket.send(makeZeroCopyMessage(std::move(payload), size), zmq::send_flags::dontwait);
+    };
+
+    // Telemetry loop.
+    while(this->telemetry_working_)
+    {
+        try
+        {
+            // Update the subscriptions. Each message is the subscribe (1) or unsubscribe (0) byte and the prefix.
+            zmq::message_t sub_msg;
+            bool changed = false;
+            while(socket.recv(sub_msg, zmq::recv_flags::dontwait))
+            {
+                if(sub_msg.size() == 0)
+                    continue;
+                const std::string prefix(sub_msg.data<char>() + 1, sub_msg.size() - 1);
+                if(sub_msg.data<std::uint8_t>()[0] == 1)
+                    subscriptions.insert(prefix);
+                else
+                    subscriptions.erase(prefix);
+                changed = true;
+            }
+            if(changed)
+            {
+                for(std::size_t i = 0; i < kTopics; i++)
+                {
+                    const std::string topic = TelemetryTopicStr[i];
+                    active[i] = std::any_of(subscriptions.begin(), subscriptions.end(), [&topic](const auto& prefix)
+                                            {return topic.compare(0, prefix.size(), prefix) == 0;});
+                }
+            }
+
+            // Get the mount state and publish the subscribed topics.
+            if(std::any_of(active.begin(), active.end(), [](bool a){return a;}) &&
+               this->telemetry_ctrl_ && this->telemetry_clbk_)
+            {
+                // Lock free snapshot, so the telemetry never waits for (or delays) the controller commands.
+                (this->telemetry_ctrl_->*this->telemetry_clbk_)(state);
+                if(active[static_cast<std::size_t>(TelemetryTopic::POSITION)])
+                    publish(TelemetryTopic::POSITION, state.timestamp, state.position.az, state.position.el);
+                if(active[static_cast<std::size_t>(TelemetryTopic::HOME_POSITION)])
+                    publish(TelemetryTopic::HOME_POSITION, state.timestamp,
+                            state.home_position.az, state.home_position.el);
+                if(active[static_cast<std::size_t>(TelemetryTopic::MOUNT_STATE)])
+                    publish(TelemetryTopic::MOUNT_STATE, state.timestamp, state.position.az, state.position.el,
+                            state.home_position.az, state.home_position.el);
+            }
+        }
+        catch(const zmq::error_t& error)
+        {
+            if(error.num() == ETERM)
+                break;
+            this->onServerError(error, "Error in the telemetry worker.");
+        }
+
+        // Wait for the next period (without accumulating delays).
+        next += period;
+        const auto now = std::chrono::steady_clock::now();
+        if(next < now)
+            next = now;
+        std::this_thread::sleep_until(next);
+    }
+
+    // Close the socket in this thread.
+    this->telemetry_socket_.reset();
+}
+
+void AmelasControllerServer::routerProxyWorker()
+{
+    // Poll items: front end, read only back end, write back end and inproc front end (if any).
+    zmq::socket_t* inproc_frontend = this->router_inproc_frontend_.get();
+    zmq::pollitem_t items[] = {{this->router_frontend_->handle(), 0, ZMQ_POLLIN, 0},
+                               {this->router_read_backend_->handle(), 0, ZMQ_POLLIN, 0},
+                               {this->router_write_backend_->handle(), 0, ZMQ_POLLIN, 0},
+                               {inproc_frontend ? inproc_frontend->handle() : nullptr, 0, ZMQ_POLLIN, 0}};
+    const int nitems = inproc_frontend ? 4 : 3;
+
+    // Proxy loop.
+    while(this->router_working_)
+    {
+        try
+        {
+            zmq::poll(items, nitems, std::chrono::milliseconds(kRouterPollTimeoutMsec));
+
+            // Requests from the clients.
+            if(items[0].revents & ZMQ_POLLIN)
+            {
+                zmq::multipart_t msg;
+                msg.recv(*this->router_frontend_);
+                this->routerForwardRequest(msg, false);
+            }
+            if(inproc_frontend && (items[3].revents & ZMQ_POLLIN))
+            {
+                zmq::multipart_t msg;
+                msg.recv(*inproc_frontend);
+                this->routerForwardRequest(msg, true);
+            }
+
+            // Replies from the workers. With an inproc front end, the origin frame selects the front end.
+            for(std::size_t i = 1; i < 3; i++)
+            {
+                if(items[i].revents & ZMQ_POLLIN)
+                {
+                    zmq::multipart_t msg;
+                    msg.recv(i == 1 ? *this->router_read_backend_ : *this->router_write_backend_);
+                    zmq::socket_t* frontend = this->router_frontend_.get();
+                    if(inproc_frontend)
+                    {
+                        const zmq::message_t origin = msg.pop();
+                        if(origin.size() == 1 && *origin.data<char>() == kOriginInproc)
+                            frontend = inproc_frontend;
+                    }
+                    msg.send(*frontend);
+                    this->metrics_.popQueue(i == 1 ? MetricsQueue::READ : MetricsQueue::WRITE);
+                    this->onWaitingCommand();
+                }
+            }
+
+            // Check the clients status.
+            if(this->router_check_alive_)
+                this->routerCheckClientsAlive();
+        }
+        catch(const zmq::error_t& error)
+        {
+            if(error.num() == ETERM)
+                break;
+            this->onServerError(error, "Error in the router proxy.");
+        }
+    }
+
+    // Close the sockets in this thread.
+    this->router_frontend_.reset();
+    this->router_inproc_frontend_.reset();
+    this->router_read_backend_.reset();
+    this->router_write_backend_.reset();
+}
+
+bool AmelasControllerServer::routerForwardRequest(zmq::multipart_t &msg, bool inproc)
+{
+    // Request from a client: [identity][envelope][empty][uuid][command][params]. The envelope is empty for the REQ
+    // clients and holds the correlation id for the asynchronous DEALER clients.
+    zmq::socket_t* backend = this->router_read_backend_.get();
+    MetricsQueue queue = MetricsQueue::READ;
+    std::size_t delimiter = 1;
+    while(delimiter < msg.size() && msg[delimiter].size() != 0)
+        delimiter++;
+
+    // The moved requests are only valid within the process.
+    if(!inproc && !msg.empty() && isMovedTagFrame(msg[msg.size() - 1]))
+    {
+        AMELAS_LOG_WARNING("<AMELAS SERVER> DROPPED MOVED REQUEST FROM NETWORK ENDPOINT");
+        return false;
+    }
+
+    // Peek the command after the delimiter to select the worker.
+    if(delimiter + 2 < msg.size())
+    {
+        zmqutils::common::CommandType raw_command;
+        const zmq::message_t& command_msg = msg[delimiter + 2];
+        try
+        {
+            LocalBinarySerializer::fastDeserialization(command_msg.data(), command_msg.size(), raw_command);
+            if(raw_command >= kMinCmdId && !isReadOnlyCommand(static_cast<AmelasServerCommand>(raw_command)))
+            {
+                backend = this->router_write_backend_.get();
+                queue = MetricsQueue::WRITE;
+            }
+        }
+        catch(...){}
+    }
+
+    // Forward the request.
+    if(this->router_inproc_frontend_)
+        msg.pushmem(inproc ? &kOriginInproc : &kOriginNetwork, 1);
+    msg.send(*backend);
+    this->metrics_.pushQueue(queue);
+    return true;
+}
+
+void AmelasControllerServer::routerWorker(const std::string& endpoint, std::size_t metrics_shard)
+{
+    // Worker socket.
+    zmq::socket_t socket(*this->router_ctx_, zmq::socket_type::rep);
+    socket.set(zmq::sockopt::linger, 0);
+    socket.connect(endpoint);
+
+    // Worker loop.
+    while(this->router_working_)
+    {
+        try
+        {
+            // Receive the request: [uuid][command][params].
+            zmq::multipart_t msg;
+            if(!msg.recv(socket))
+                continue;
+            RequestTrace trace;
+            trace.received = ServerMetrics::now();
+
+            // Process the request. A REP socket must always reply. The moved requests are replied in the same way.
+            CommandReply reply;
+            bool alive_msg = false;
+            const bool moved = msg.size() == 4 && isMovedTagFrame(msg[3]);
+            this->routerProcessMessage(msg, moved, reply, alive_msg, trace);
+            trace.processed = ServerMetrics::now();
+
+            // Prepare the reply: [result][params] or [result][moved reply][tag]. The parameters are sent without
+            // copies.
+            if(!alive_msg || this->router_alive_callbacks_)
+                this->onSendingResponse(reply);
+            const OperationResult server_result = reply.server_result;
+            const auto result = LocalBinarySerializer::fastSerializationFixed(server_result);
+            zmq::multipart_t reply_msg;
+            reply_msg.addmem(result.data(), result.size());
+            if(moved)
+            {
+                reply_msg.add(makeMovedFrame(std::move(reply)));
+                reply_msg.add(makeMovedTagFrame());
+            }
+            else if(reply.params && reply.params_size)
+                reply_msg.add(makeZeroCopyMessage(std::move(reply.params), reply.params_size));
+            reply_msg.send(socket);
+
+            // Update the metrics.
+            trace.replied = ServerMetrics::now();
+            this->metrics_.record(metrics_shard, trace, server_result);
+        }
+        catch(const zmq::error_t& error)
+        {
+            if(error.num() == ETERM)
+                break;
+            this->onServerError(error, "Error in a router worker.");
+        }
+    }
+}
+
+void AmelasControllerServer::routerProcessMessage(zmq::multipart_t& msg, bool moved, CommandReply& reply,
+                                                  bool& alive_msg, RequestTrace& trace)
+{
+    // Auxiliar variables and containers. The frame parameters are borrowed by the request until it is processed.
+    CommandRequest request;
+    BorrowedParams<CommandRequest> borrowed_params(request);
+    zmqutils::common::CommandType raw_command;
+    reply.server_result = OperationResult::COMMAND_OK;
+
+    // Check the message parts.
+    if(msg.empty())
+    {
+        reply.server_result = OperationResult::EMPTY_MSG;
+        return;
+    }
+    if(moved ? msg.size() != 4 : (msg.size() != 2 && msg.size() != 3))
+    {
+        reply.server_result = OperationResult::INVALID_PARTS;
+        this->onInvalidMsgReceived(request);
+        return;
+    }
+
+    // Get the client uuid.
+    zmq::message_t uuid_msg = msg.pop();
+    if(uuid_msg.size() != UUID::kUUIDSize)
+    {
+        reply.server_result = OperationResult::INVALID_CLIENT_UUID;
+        this->onInvalidMsgReceived(request);
+        return;
+    }
+    std::array<std::byte, UUID::kUUIDSize> uuid_bytes;
+    std::memcpy(uuid_bytes.data(), uuid_msg.data(), UUID::kUUIDSize);
+    request.client_uuid = UUID(uuid_bytes);
+
+    // Get the parameters, moved from the request object or read in place from the frame.
+    zmq::message_t command_msg = msg.pop();
+    if(moved)
+    {
+        zmq::message_t moved_msg = msg.pop();
+        RequestData* moved_request = getMovedObject<RequestData>(moved_msg);
+        if(!moved_request)
+        {
+            reply.server_result = OperationResult::INVALID_PARTS;
+            this->onInvalidMsgReceived(request);
+            return;
+        }
+        request.params = std::move(moved_request->params);
+        request.params_size = request.params ? moved_request->params_size : 0;
+    }
+    else if(!msg.empty())
+        borrowed_params.borrow(msg.pop());
+
+    // Get and check the command.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(command_msg.data(), command_msg.size(), raw_command);
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::INVALID_MSG;
+        this->onInvalidMsgReceived(request);
+        return;
+    }
+    request.command = static_cast<ServerCommand>(raw_command);
+    trace.command = request.command;
+    const bool base_command = raw_command >= static_cast<int>(ServerCommand::REQ_CONNECT) &&
+                              raw_command < static_cast<int>(ServerCommand::RESERVED_COMMANDS);
+    if(!base_command && !this->validateCustomCommand(request.command))
+    {
+        reply.server_result = OperationResult::INVALID_MSG;
+        this->onInvalidMsgReceived(request);
+        return;
+    }
+
+    // Call to the command received callback.
+    alive_msg = (request.command == ServerCommand::REQ_ALIVE);
+    if(!alive_msg || this->router_alive_callbacks_)
+        this->onCommandReceived(request);
+    trace.decoded = ServerMetrics::now();
+
+    // Process the connect command.
+    if(request.command == ServerCommand::REQ_CONNECT)
+    {
+        reply.server_result = this->routerExecReqConnect(request);
+        return;
+    }
+
+    // The rest of the commands need a connected client. Any command updates the client status.
+    if(!this->routerUpdateClient(request.client_uuid))
+    {
+        reply.server_result = OperationResult::CLIENT_NOT_CONNECTED;
+        return;
+    }
+
+    // Process the command.
+    if(request.command == ServerCommand::REQ_DISCONNECT)
+        reply.server_result = this->routerExecReqDisconnect(request);
+    else if(request.command == ServerCommand::REQ_GET_SERVER_TIME)
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params,
+                                                                      zmqutils::utils::currentISO8601Date());
+    else if(!base_command)
+        this->onCustomCommandReceived(request, reply);
+}
+
+OperationResult AmelasControllerServer::routerExecReqConnect(const CommandRequest& request)
+{
+    // Auxiliar variables.
+    std::string ip, pid, hostname, name;
+
+    // Check the parameters.
+    if(request.params_size == 0 || !request.params)
+        return OperationResult::EMPTY_PARAMS;
+
+    // Get the client information.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, ip, pid, hostname, name);
+    }
+    catch(...)
+    {
+        return OperationResult::BAD_PARAMETERS;
+    }
+
+    // Register the client.
+    HostInfo client(request.client_uuid, ip, pid, hostname, name);
+    client.last_seen = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(this->router_clients_mtx_);
+        if(!this->router_clients_.insert(client))
+            return OperationResult::ALREADY_CONNECTED;
+    }
+
+    // Call to the connected callback.
+    this->onConnected(client);
+    return OperationResult::COMMAND_OK;
+}
+
+OperationResult AmelasControllerServer::routerExecReqDisconnect(const CommandRequest& request)
+{
+    // Auxiliar variables.
+    HostInfo client;
+
+    // Remove the client.
+    {
+        std::lock_guard<std::mutex> lock(this->router_clients_mtx_);
+        if(!this->router_clients_.erase(request.client_uuid, &client))
+            return OperationResult::CLIENT_NOT_CONNECTED;
+    }
+
+    // Call to the disconnected callback.
+    this->onDisconnected(client);
+    return OperationResult::COMMAND_OK;
+}
+
+bool AmelasControllerServer::routerUpdateClient(const UUID& uuid)
+{
+    std::lock_guard<std::mutex> lock(this->router_clients_mtx_);
+    return this->router_clients_.touch(uuid, std::chrono::steady_clock::now());
 }
 
-AmelasControllerServer::~AmelasControllerServer() {}
+void AmelasControllerServer::routerCheckClientsAlive()
+{
+    // Auxiliar variables.
+    std::vector<HostInfo> dead_clients;
+    const std::chrono::milliseconds timeout(this->router_alive_timeout_.load());
+    const auto now = std::chrono::steady_clock::now();
+
+    // Remove the dead clients. Only the expired timers are checked (a timeout of 0 disables the checking).
+    {
+        std::lock_guard<std::mutex> lock(this->router_clients_mtx_);
+        this->router_clients_.setTimeout(timeout);
+        this->router_clients_.collectExpired(now, dead_clients);
+    }
+
+    // Call to the dead client callback.
+    for(const auto& client : dead_clients)
+        this->onDeadClient(client);
+}
 
 void AmelasControllerServer::processSetHomePosition(const CommandRequest& request, CommandReply& reply)
 {
@@ -70,10 +894,16 @@ void AmelasControllerServer::processSetHomePosition(const CommandRequest& reques
         return;
     }
 
+    // Check the wire format used by the client.
+    const bool packed = BinarySerializer::isPackedData(request.params.get(), request.params_size);
+
     // Try to read the parameters data.
     try
     {
-        BinarySerializer::fastDeserialization(request.params.get(), request.params_size, pos);
+        if(packed)
+            BinarySerializer::fastDeserializationPacked(request.params.get(), request.params_size, pos.az, pos.el);
+        else
+            LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, pos.az, pos.el);
     }
     catch(...)
     {
@@ -82,11 +912,11 @@ void AmelasControllerServer::processSetHomePosition(const CommandRequest& reques
     }
 
     // Now we will process the command in the controller.
-    ctrl_err = this->invokeCallback<controller::SetHomePositionCallback>(request, reply, pos);
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_SET_HOME_POSITION>(reply, pos);
 
     // Serialize parameters if all ok.
     if(reply.server_result == OperationResult::COMMAND_OK)
-        reply.params_size = BinarySerializer::fastSerialization(reply.params, ctrl_err);
+        AmelasControllerServer::serializeReply(packed, reply, ctrl_err);
 }
 
 void AmelasControllerServer::processGetHomePosition(const CommandRequest& request, CommandReply &reply)
@@ -95,17 +925,384 @@ void AmelasControllerServer::processGetHomePosition(const CommandRequest& reques
     controller::AmelasError ctrl_err;
     controller::AltAzPos pos;
 
+    // A request with only the packed header (no parameters) asks for a packed reply.
+    const bool packed = BinarySerializer::isPackedData(request.params.get(), request.params_size);
+
     // Now we will process the command in the controller.
-    ctrl_err = this->invokeCallback<controller::GetHomePositionCallback>(request, reply, pos);
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_GET_HOME_POSITION>(reply, pos);
 
     // Serialize parameters if all ok.
     if(reply.server_result == OperationResult::COMMAND_OK)
-        reply.params_size = BinarySerializer::fastSerialization(reply.params, ctrl_err, pos.az, pos.el);
+        AmelasControllerServer::serializeReply(packed, reply, ctrl_err, pos.az, pos.el);
+}
+
+void AmelasControllerServer::processBatch(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    BatchMode mode;
+    std::uint32_t count;
+    std::vector<CommandRequest> entries;
+
+    // Check the request parameters size.
+    if (request.params_size == 0 || !request.params)
+    {
+        reply.server_result = OperationResult::EMPTY_PARAMS;
+        return;
+    }
+
+    // Try to read the entries.
+    try
+    {
+        LocalBinarySerializer serializer(request.params.get(), request.params_size);
+        serializer.read(mode, count);
+        if(mode != BatchMode::STOP_ON_ERROR && mode != BatchMode::BEST_EFFORT)
+            throw std::invalid_argument("Invalid batch mode.");
+        if(count > request.params_size)
+            throw std::invalid_argument("Invalid batch size.");
+        entries.resize(count);
+        for(auto& entry : entries)
+        {
+            zmqutils::common::CommandType command;
+            std::vector<std::byte> params;
+            serializer.read(command, params);
+            entry.client_uuid = request.client_uuid;
+            entry.command = static_cast<ServerCommand>(command);
+            entry.params_size = params.size();
+            if(!params.empty())
+            {
+                entry.params = std::make_unique<std::byte[]>(params.size());
+                std::memcpy(entry.params.get(), params.data(), params.size());
+            }
+        }
+        if(!serializer.allReaded())
+            throw std::invalid_argument("Unexpected batch data.");
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::BAD_PARAMETERS;
+        return;
+    }
+
+    // Get the process function of each entry. Nested batches and base commands are not allowed.
+    std::vector<AmelasRequestProcFunc> fncs(count, nullptr);
+    std::vector<OperationResult> results(count, OperationResult::COMMAND_OK);
+    bool valid = true;
+    for(std::uint32_t i = 0; i < count; i++)
+    {
+        const auto cmd = static_cast<zmqutils::common::CommandType>(entries[i].command);
+        if(cmd < kMinCmdId || cmd > kMaxCmdId || cmd == static_cast<int>(AmelasServerCommand::REQ_BATCH))
+            results[i] = OperationResult::UNKNOWN_COMMAND;
+        else if(!(fncs[i] = this->process_fncs_[static_cast<std::size_t>(cmd - kMinCmdId)]))
+            results[i] = OperationResult::NOT_IMPLEMENTED;
+        valid = valid && results[i] == OperationResult::COMMAND_OK;
+    }
+
+    // Execute the entries in order.
+    std::vector<CommandReply> replies(count);
+    const auto skipped = static_cast<OperationResult>(AmelasServerResult::BATCH_ENTRY_SKIPPED);
+    bool stop = (mode == BatchMode::STOP_ON_ERROR && !valid);
+    for(std::uint32_t i = 0; i < count; i++)
+    {
+        if(stop)
+        {
+            if(results[i] == OperationResult::COMMAND_OK)
+                results[i] = skipped;
+            continue;
+        }
+        if(results[i] != OperationResult::COMMAND_OK)
+            continue;
+        replies[i].server_result = OperationResult::COMMAND_OK;
+        (this->*fncs[i])(entries[i], replies[i]);
+        results[i] = replies[i].server_result;
+
+        // The handlers report the controller errors in the reply parameters with COMMAND_OK, so both are checked.
+        if(mode == BatchMode::STOP_ON_ERROR)
+        {
+            controller::AmelasError error = controller::AmelasError::SUCCESS;
+            const auto command = static_cast<AmelasServerCommand>(entries[i].command);
+            stop = results[i] != OperationResult::COMMAND_OK ||
+                   (hasControllerError(command) && (!readReplyError(replies[i], error) ||
+                                                    error != controller::AmelasError::SUCCESS));
+        }
+    }
+
+    // Serialize the results.
+    LocalBinarySerializer serializer;
+    serializer.write(count);
+    for(std::uint32_t i = 0; i < count; i++)
+    {
+        const std::byte* data = replies[i].params.get();
+        serializer.write(results[i], std::vector<std::byte>(data, data ? data + replies[i].params_size : data));
+    }
+    reply.params_size = serializer.moveUnique(reply.params);
+}
+
+void AmelasControllerServer::processBeginTrajectoryUpload(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    controller::AmelasError ctrl_err;
+    std::uint32_t samples;
+
+    // Check the request parameters size.
+    if (request.params_size == 0 || !request.params)
+    {
+        reply.server_result = OperationResult::EMPTY_PARAMS;
+        return;
+    }
+
+    // Try to read the parameters data.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, samples);
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::BAD_PARAMETERS;
+        return;
+    }
+
+    // Now we will process the command in the controller.
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_BEGIN_TRAJECTORY_UPLOAD>(reply, samples);
+
+    // Serialize parameters if all ok. The reply grants the upload window.
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params, ctrl_err,
+            static_cast<std::uint32_t>(kTrajectoryUploadWindow),
+            static_cast<std::uint32_t>(controller::kMaxTrajectoryChunkSamples));
+}
+
+void AmelasControllerServer::processUploadTrajectoryChunk(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers. The sample containers are reused between chunks to avoid allocations.
+    static thread_local std::vector<std::int64_t> times;
+    static thread_local std::vector<double> az;
+    static thread_local std::vector<double> el;
+    controller::AmelasError ctrl_err;
+    controller::TrajectoryChunk chunk;
+
+    // Check the request parameters size.
+    if (request.params_size == 0 || !request.params)
+    {
+        reply.server_result = OperationResult::EMPTY_PARAMS;
+        return;
+    }
+
+    // Try to read the parameters data.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size,
+                                                   chunk.offset, times, az, el);
+        if(times.size() != az.size() || times.size() != el.size())
+            throw std::invalid_argument("Invalid chunk sizes.");
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::BAD_PARAMETERS;
+        return;
+    }
+    chunk.count = static_cast<std::uint32_t>(times.size());
+    chunk.timestamps = times.data();
+    chunk.az = az.data();
+    chunk.el = el.data();
+
+    // Now we will process the command in the controller.
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_UPLOAD_TRAJECTORY_CHUNK>(reply, chunk);
+
+    // Serialize parameters if all ok. The received samples acknowledge the chunk and return its credit.
+    const std::uint32_t received = (ctrl_err == controller::AmelasError::SUCCESS) ? chunk.offset + chunk.count :
+                                                                                     chunk.offset;
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params, ctrl_err, received);
+}
+
+void AmelasControllerServer::processCommitTrajectoryUpload(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    controller::AmelasError ctrl_err;
+    std::uint32_t checksum;
+
+    // Check the request parameters size.
+    if (request.params_size == 0 || !request.params)
+    {
+        reply.server_result = OperationResult::EMPTY_PARAMS;
+        return;
+    }
+
+    // Try to read the parameters data.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, checksum);
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::BAD_PARAMETERS;
+        return;
+    }
+
+    // Now we will process the command in the controller.
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_COMMIT_TRAJECTORY_UPLOAD>(reply, checksum);
+
+    // Serialize parameters if all ok.
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params, ctrl_err);
+}
+
+void AmelasControllerServer::processLoadPointingModel(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    controller::AmelasError ctrl_err;
+    std::uint32_t slot;
+    std::vector<double> terms;
+    std::array<double, controller::kPointingModelTerms> model_terms;
+
+    // Check the request parameters size.
+    if (request.params_size == 0 || !request.params)
+    {
+        reply.server_result = OperationResult::EMPTY_PARAMS;
+        return;
+    }
+
+    // Try to read the parameters data.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, slot, terms);
+        if(terms.size() != model_terms.size())
+            throw std::invalid_argument("Invalid number of pointing model terms.");
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::BAD_PARAMETERS;
+        return;
+    }
+    std::copy(terms.begin(), terms.end(), model_terms.begin());
+
+    // Now we will process the command in the controller.
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_LOAD_POINTING_MODEL>(
+        reply, slot, controller::PointingModel(model_terms));
+
+    // Serialize parameters if all ok.
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params, ctrl_err);
+}
+
+void AmelasControllerServer::processSetPointingModel(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    controller::AmelasError ctrl_err;
+    std::uint32_t slot;
+
+    // Check the request parameters size.
+    if (request.params_size == 0 || !request.params)
+    {
+        reply.server_result = OperationResult::EMPTY_PARAMS;
+        return;
+    }
+
+    // Try to read the parameters data.
+    try
+    {
+        LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, slot);
+    }
+    catch(...)
+    {
+        reply.server_result = OperationResult::BAD_PARAMETERS;
+        return;
+    }
+
+    // Now we will process the command in the controller.
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_SET_POINTING_MODEL>(reply, slot);
+
+    // Serialize parameters if all ok.
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params, ctrl_err);
+}
+
+void AmelasControllerServer::processGetControlLoopStats(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    controller::AmelasError ctrl_err;
+    controller::ControlLoopStats stats;
+
+    // A request with only the packed header (no parameters) asks for a packed reply.
+    const bool packed = BinarySerializer::isPackedData(request.params.get(), request.params_size);
+
+    // Now we will process the command in the controller.
+    ctrl_err = this->invokeCallback<AmelasServerCommand::REQ_GET_CONTROL_LOOP_STATS>(reply, stats);
+
+    // Auxiliar lambda to flatten the latency summaries.
+    auto flatten = [](const utils::LatencySummary& summary)
+    {
+        return std::array<std::int64_t, 7>{static_cast<std::int64_t>(summary.count), summary.min, summary.mean,
+                                           summary.p50, summary.p99, summary.p999, summary.max};
+    };
+
+    // Serialize parameters if all ok.
+    if(reply.server_result == OperationResult::COMMAND_OK)
+        AmelasControllerServer::serializeReply(packed, reply, ctrl_err, stats.period, stats.cycles,
+                                               stats.missed_deadlines, stats.skipped_cycles, stats.realtime,
+                                               stats.memory_locked, flatten(stats.wakeup_latency),
+                                               flatten(stats.execution_time));
+}
+
+void AmelasControllerServer::processGetMetrics(const CommandRequest& request, CommandReply& reply)
+{
+    // Auxiliar variables and containers.
+    bool text = false;
+    std::array<std::int64_t, 4> queues;
+    std::vector<std::int32_t> commands;
+    std::vector<std::uint64_t> requests, errors;
+    std::vector<std::int64_t> latencies;
+
+    // A request with only the packed header (no parameters) asks for a packed reply.
+    const bool packed = BinarySerializer::isPackedData(request.params.get(), request.params_size);
+
+    // Try to read the optional text parameter (only in the tagged format).
+    if(!packed && request.params_size && request.params)
+    {
+        try
+        {
+            LocalBinarySerializer::fastDeserialization(request.params.get(), request.params_size, text);
+        }
+        catch(...)
+        {
+            reply.server_result = OperationResult::BAD_PARAMETERS;
+            return;
+        }
+    }
+
+    // Get the metrics.
+    const ServerMetricsSnapshot snapshot = this->metrics_.getSnapshot();
+
+    // Text dump.
+    if(text)
+    {
+        reply.params_size = LocalBinarySerializer::fastSerialization(reply.params,
+                                                                      ServerMetrics::formatSnapshot(snapshot));
+        return;
+    }
+
+    // Flatten the snapshot.
+    queues = {snapshot.queues[0].depth, snapshot.queues[0].max_depth,
+              snapshot.queues[1].depth, snapshot.queues[1].max_depth};
+    for(const CommandMetrics& metrics : snapshot.commands)
+    {
+        commands.push_back(metrics.command);
+        requests.push_back(metrics.requests);
+        errors.push_back(metrics.errors);
+        for(const utils::LatencySummary& summary : metrics.latencies)
+            latencies.insert(latencies.end(), {static_cast<std::int64_t>(summary.count), summary.min, summary.mean,
+                                               summary.p50, summary.p99, summary.p999, summary.max});
+    }
+
+    // Serialize parameters.
+    AmelasControllerServer::serializeReply(packed, reply, snapshot.results, queues, commands, requests, errors,
+                                           latencies);
 }
 
 void AmelasControllerServer::registerRequestProcFunc(AmelasServerCommand command, AmelasRequestProcFunc func)
 {
     CommandServerBase::registerRequestProcFunc(static_cast<ServerCommand>(command), this, func);
+    this->process_fncs_[static_cast<std::size_t>(static_cast<int>(command) - kMinCmdId)] = func;
 }
 
 bool AmelasControllerServer::validateCustomCommand(ServerCommand command)
@@ -122,20 +1319,21 @@ bool AmelasControllerServer::validateCustomCommand(ServerCommand command)
 void AmelasControllerServer::onCustomCommandReceived(CommandRequest& request, CommandReply& reply)
 {
     // Get the command string.
-    std::string cmd_str;
     std::uint32_t cmd_uint = static_cast<std::uint32_t>(request.command);
-    cmd_str = (cmd_uint < AmelasServerCommandStr.size()) ? AmelasServerCommandStr[cmd_uint] : "Unknown command";
+    const char* cmd_str = (cmd_uint < AmelasServerCommandStr.size()) ? AmelasServerCommandStr[cmd_uint] :
+                                                                        "Unknown command";
 
-    // Log the command.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"ON CUSTOM COMMAND RECEIVED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Client UUID: "<<request.client_uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Command: "<<cmd_uint<<" ("<<cmd_str<<")"<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    // Log.
+    AMELAS_LOG_DEBUG("<AMELAS SERVER> ON CUSTOM COMMAND RECEIVED | Client UUID: ", request.client_uuid,
+                     " | Command: ", cmd_uint, " (", cmd_str, ")");
 
-    // Call to the base function for process the custom command with the registered process functions.
+    // Call to the base function for process the custom command with the registered process functions. In the classic
+    // mode this is the only place where the processing can be timed (the router mode times it in the workers).
+    if(!this->router_mode_)
+        this->classic_trace_.decoded = ServerMetrics::now();
     CommandServerBase::onCustomCommandReceived(request, reply);
+    if(!this->router_mode_)
+        this->classic_trace_.processed = ServerMetrics::now();
 }
 
 void AmelasControllerServer::onServerStart()
@@ -153,144 +1351,105 @@ void AmelasControllerServer::onServerStart()
     ips.pop_back();
 
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON SERVER START: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Addresses: "<<ips<<std::endl;
-    std::cout<<"Port: "<<this->getServerPort()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<AMELAS SERVER> ON SERVER START | Addresses: ", ips, " | Port: ", this->getServerPort(),
+                    " | Router mode: ", this->router_mode_);
 }
 
 void AmelasControllerServer::onServerStop()
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON SERVER CLOSE: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<AMELAS SERVER> ON SERVER CLOSE");
 }
 
 void AmelasControllerServer::onWaitingCommand()
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON WAITING COMMAND: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_TRACE("<AMELAS SERVER> ON WAITING COMMAND");
 }
 
 void AmelasControllerServer::onDeadClient(const HostInfo& client)
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON DEAD CLIENT: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Current Clients: "<<this->getConnectedClients().size()<<std::endl;
-    std::cout<<"Client UUID: "<<client.uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Client Ip: "<<client.ip<<std::endl;
-    std::cout<<"Client Host: "<<client.hostname<<std::endl;
-    std::cout<<"Client Process: "<<client.pid<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_WARNING("<AMELAS SERVER> ON DEAD CLIENT | Current Clients: ", this->getConnectedClientsCount(),
+                       " | Client UUID: ", client.uuid, " | Client Ip: ", client.ip,
+                       " | Client Host: ", client.hostname, " | Client Process: ", client.pid);
 }
 
 void AmelasControllerServer::onConnected(const HostInfo& client)
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON CONNECTED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Current Clients: "<<this->getConnectedClients().size()<<std::endl;
-    std::cout<<"Client UUID: "<<client.uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Client Name: "<<client.name<<std::endl;
-    std::cout<<"Client Ip: "<<client.ip<<std::endl;
-    std::cout<<"Client Host: "<<client.hostname<<std::endl;
-    std::cout<<"Client Process: "<<client.pid<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<AMELAS SERVER> ON CONNECTED | Current Clients: ", this->getConnectedClientsCount(),
+                    " | Client UUID: ", client.uuid, " | Client Name: ", client.name, " | Client Ip: ", client.ip,
+                    " | Client Host: ", client.hostname, " | Client Process: ", client.pid);
 }
 
 void AmelasControllerServer::onDisconnected(const HostInfo& client)
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON DISCONNECTED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Current Clients: "<<this->getConnectedClients().size()<<std::endl;
-    std::cout<<"Client UUID: "<<client.uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Client Name: "<<client.name<<std::endl;
-    std::cout<<"Client Ip: "<<client.ip<<std::endl;
-    std::cout<<"Client Host: "<<client.hostname<<std::endl;
-    std::cout<<"Client Process: "<<client.pid<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_INFO("<AMELAS SERVER> ON DISCONNECTED | Current Clients: ", this->getConnectedClientsCount(),
+                    " | Client UUID: ", client.uuid, " | Client Name: ", client.name, " | Client Ip: ", client.ip,
+                    " | Client Host: ", client.hostname, " | Client Process: ", client.pid);
 }
 
 void AmelasControllerServer::onServerError(const zmq::error_t &error, const std::string &ext_info)
 {
     // Log.
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON SERVER ERROR: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Code: "<<error.num()<<std::endl;
-    std::cout<<"Error: "<<error.what()<<std::endl;
-    std::cout<<"Info: "<<ext_info<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_CRITICAL("<AMELAS SERVER> ON SERVER ERROR | Code: ", error.num(), " | Error: ", error.what(),
+                        " | Info: ", ext_info);
 }
 
 void AmelasControllerServer::onCommandReceived(const CommandRequest &request)
 {
+    // Start the metrics trace in the classic mode (the request is already received and deserialized by the base).
+    if(!this->router_mode_)
+    {
+        this->classic_trace_ = RequestTrace();
+        this->classic_trace_.command = request.command;
+        this->classic_trace_.received = ServerMetrics::now();
+    }
+
     // Get the command string.
-    std::string cmd_str;
     std::uint32_t command = static_cast<std::uint32_t>(request.command);
-    cmd_str = (command < AmelasServerCommandStr.size()) ? AmelasServerCommandStr[command] : "Unknown command";
+    const char* cmd_str = (command < AmelasServerCommandStr.size()) ? AmelasServerCommandStr[command] :
+                                                                       "Unknown command";
     // Log.
-    BinarySerializer serializer(request.params.get(), request.params_size);
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON COMMAND RECEIVED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Client UUID: "<<request.client_uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Command: "<<command<<" ("<<cmd_str<<")"<<std::endl;
-    std::cout<<"Params Size: "<<request.params_size<<std::endl;
-    std::cout<<"Params Hex: "<<serializer.getDataHexString()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_DEBUG("<AMELAS SERVER> ON COMMAND RECEIVED | Client UUID: ", request.client_uuid,
+                     " | Command: ", command, " (", cmd_str, ") | Params Size: ", request.params_size,
+                     " | Params Hex: ", utils::logHex(request.params.get(), request.params_size));
 }
 
 void AmelasControllerServer::onInvalidMsgReceived(const CommandRequest &request)
 {
+    // Start the metrics trace in the classic mode.
+    if(!this->router_mode_)
+    {
+        this->classic_trace_ = RequestTrace();
+        this->classic_trace_.command = request.command;
+        this->classic_trace_.received = ServerMetrics::now();
+    }
+
     // Log.
-    BinarySerializer serializer(request.params.get(), request.params_size);
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON BAD COMMAND RECEIVED: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Client UUID: "<<request.client_uuid.toRFC4122String()<<std::endl;
-    std::cout<<"Command: "<<static_cast<int>(request.command)<<std::endl;
-    std::cout<<"Params Size: "<<request.params_size<<std::endl;
-    std::cout<<"Params Hex: "<<serializer.getDataHexString()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_WARNING("<AMELAS SERVER> ON BAD COMMAND RECEIVED | Client UUID: ", request.client_uuid,
+                       " | Command: ", static_cast<int>(request.command), " | Params Size: ", request.params_size,
+                       " | Params Hex: ", utils::logHex(request.params.get(), request.params_size));
 }
 
 void AmelasControllerServer::onSendingResponse(const CommandReply &reply)
 {
+    // Finish the metrics trace in the classic mode (the reply is sent by the base after this callback).
+    if(!this->router_mode_)
+    {
+        this->classic_trace_.replied = ServerMetrics::now();
+        this->metrics_.record(0, this->classic_trace_, reply.server_result);
+        this->classic_trace_ = RequestTrace();
+    }
+
     // Log.
-    BinarySerializer serializer(reply.params.get(), reply.params_size);
     size_t result = static_cast<size_t>(reply.server_result);
-    std::cout << std::string(100, '-') << std::endl;
-    std::cout<<"<AMELAS SERVER>"<<std::endl;
-    std::cout<<"-> ON SENDING RESPONSE: "<<std::endl;
-    std::cout<<"Time: "<<zmqutils::utils::currentISO8601Date()<<std::endl;
-    std::cout<<"Result: "<<result<<" ("<<AmelasServerResultStr[result]<<")"<<std::endl;
-    std::cout<<"Params Size: "<<reply.params_size<<std::endl;
-    std::cout<<"Params Hex: "<<serializer.getDataHexString()<<std::endl;
-    std::cout << std::string(100, '-') << std::endl;
+    AMELAS_LOG_DEBUG("<AMELAS SERVER> ON SENDING RESPONSE | Result: ", result, " (", AmelasServerResultStr[result],
+                     ") | Params Size: ", reply.params_size,
+                     " | Params Hex: ", utils::logHex(reply.params.get(), reply.params_size));
 }
 
 }} // END NAMESPACES.
 // =====================================================================================================================
-
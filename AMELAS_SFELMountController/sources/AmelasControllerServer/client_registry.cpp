@@ -0,0 +1,269 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file client_registry.cpp
+ * @brief This file contains the implementation of the ClientRegistry class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cstring>
+#include <random>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasControllerServer/client_registry.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+namespace{
+
+// 64 bits finalizer (MurmurHash3).
+inline std::uint64_t mix(std::uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+} // END ANONYMOUS NAMESPACE.
+// ---------------------------------------------------------------------------------------------------------------------
+
+ClientRegistry::ClientRegistry() :
+    table_(kInitialCapacity, kEmpty),
+    size_(0),
+    seed_(0),
+    timeout_(0),
+    epoch_(Clock::now())
+{
+    std::random_device device;
+    this->seed_ = (static_cast<std::uint64_t>(device()) << 32) ^ device();
+}
+
+bool ClientRegistry::insert(const HostInfo& client)
+{
+    // Check if the client already exists.
+    const std::uint64_t hash = this->hashUUID(client.uuid);
+    std::size_t position = this->probe(client.uuid, hash);
+    if (this->table_[position] != kEmpty)
+        return false;
+
+    // Keep the load factor below 0.75.
+    if ((this->size_ + 1) * 4 > this->table_.size() * 3)
+    {
+        this->grow();
+        position = this->probe(client.uuid, hash);
+    }
+
+    // Store the client in a free node.
+    std::uint32_t node;
+    if (this->free_.empty())
+    {
+        node = static_cast<std::uint32_t>(this->nodes_.size());
+        this->nodes_.emplace_back();
+    }
+    else
+    {
+        node = this->free_.back();
+        this->free_.pop_back();
+    }
+    this->nodes_[node].client = client;
+    this->nodes_[node].hash = hash;
+    this->nodes_[node].used = true;
+    this->table_[position] = node;
+    this->size_++;
+
+    // Start the timer.
+    this->scheduleTimer(node);
+    return true;
+}
+
+bool ClientRegistry::erase(const UUID& uuid, HostInfo* client)
+{
+    const std::size_t position = this->probe(uuid, this->hashUUID(uuid));
+    if (this->table_[position] == kEmpty)
+        return false;
+    if (client)
+        *client = this->nodes_[this->table_[position]].client;
+    this->removeAt(position);
+    return true;
+}
+
+bool ClientRegistry::touch(const UUID& uuid, Clock::time_point now)
+{
+    // Only the last seen time is updated. The timer checks it when it expires.
+    const std::uint32_t node = this->table_[this->probe(uuid, this->hashUUID(uuid))];
+    if (node == kEmpty)
+        return false;
+    this->nodes_[node].client.last_seen = now;
+    return true;
+}
+
+const HostInfo* ClientRegistry::find(const UUID& uuid) const
+{
+    const std::uint32_t node = this->table_[this->probe(uuid, this->hashUUID(uuid))];
+    return node == kEmpty ? nullptr : &this->nodes_[node].client;
+}
+
+void ClientRegistry::setTimeout(std::chrono::milliseconds timeout)
+{
+    if (timeout == this->timeout_)
+        return;
+    this->timeout_ = timeout;
+    for (std::uint32_t node = 0; node < this->nodes_.size(); node++)
+    {
+        if (this->nodes_[node].used)
+            this->scheduleTimer(node);
+    }
+}
+
+void ClientRegistry::collectExpired(Clock::time_point now, std::vector<HostInfo>& dead)
+{
+    // Timeouts disabled.
+    if (this->timeout_.count() == 0)
+        return;
+
+    // Check the expired timers. The clients seen during the timeout get a new timer.
+    this->wheel_.advance(this->toTick(now), [this, now, &dead](std::uint32_t node)
+    {
+        const HostInfo& client = this->nodes_[node].client;
+        if (now - client.last_seen <= this->timeout_)
+        {
+            this->scheduleTimer(node);
+            return;
+        }
+        dead.push_back(client);
+        this->removeAt(this->probe(client.uuid, this->nodes_[node].hash));
+    });
+}
+
+void ClientRegistry::clear()
+{
+    this->nodes_.clear();
+    this->free_.clear();
+    this->table_.assign(kInitialCapacity, kEmpty);
+    this->size_ = 0;
+    this->wheel_.clear();
+}
+
+std::map<UUID, HostInfo> ClientRegistry::toMap() const
+{
+    std::map<UUID, HostInfo> clients;
+    for (const Node& node : this->nodes_)
+    {
+        if (node.used)
+            clients.emplace(node.client.uuid, node.client);
+    }
+    return clients;
+}
+
+std::uint64_t ClientRegistry::hashUUID(const UUID& uuid) const
+{
+    std::uint64_t low, high;
+    std::memcpy(&low, uuid.getBytes().data(), sizeof(low));
+    std::memcpy(&high, uuid.getBytes().data() + sizeof(low), sizeof(high));
+    return mix(low ^ this->seed_) ^ mix(high + (this->seed_ | 1));
+}
+
+std::size_t ClientRegistry::probe(const UUID& uuid, std::uint64_t hash) const
+{
+    const std::size_t mask = this->table_.size() - 1;
+    std::size_t position = static_cast<std::size_t>(hash) & mask;
+    while (this->table_[position] != kEmpty)
+    {
+        const Node& node = this->nodes_[this->table_[position]];
+        if (node.hash == hash && node.client.uuid == uuid)
+            break;
+        position = (position + 1) & mask;
+    }
+    return position;
+}
+
+void ClientRegistry::grow()
+{
+    // Double the table and insert again all the nodes.
+    std::vector<std::uint32_t> table(this->table_.size() * 2, kEmpty);
+    const std::size_t mask = table.size() - 1;
+    for (std::uint32_t node : this->table_)
+    {
+        if (node == kEmpty)
+            continue;
+        std::size_t position = static_cast<std::size_t>(this->nodes_[node].hash) & mask;
+        while (table[position] != kEmpty)
+            position = (position + 1) & mask;
+        table[position] = node;
+    }
+    this->table_.swap(table);
+}
+
+void ClientRegistry::removeAt(std::size_t position)
+{
+    // Release the node and its timer.
+    const std::uint32_t node = this->table_[position];
+    this->wheel_.cancel(node);
+    this->nodes_[node] = Node();
+    this->free_.push_back(node);
+    this->size_--;
+
+    // Backward shift deletion: move back the next entries of the cluster that can be placed in the hole.
+    const std::size_t mask = this->table_.size() - 1;
+    std::size_t hole = position;
+    std::size_t next = (position + 1) & mask;
+    while (this->table_[next] != kEmpty)
+    {
+        const std::size_t home = static_cast<std::size_t>(this->nodes_[this->table_[next]].hash) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            this->table_[hole] = this->table_[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    this->table_[hole] = kEmpty;
+}
+
+std::uint64_t ClientRegistry::toTick(Clock::time_point time) const
+{
+    return time <= this->epoch_ ? 0 : static_cast<std::uint64_t>((time - this->epoch_) / kTickDuration);
+}
+
+void ClientRegistry::scheduleTimer(std::uint32_t node)
+{
+    // The timer expires in the first tick after the deadline (if the timeouts are enabled).
+    if (this->timeout_.count() == 0)
+    {
+        this->wheel_.cancel(node);
+        return;
+    }
+    const Clock::time_point deadline = this->nodes_[node].client.last_seen + this->timeout_;
+    this->wheel_.schedule(node, this->toTick(deadline) + 1);
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
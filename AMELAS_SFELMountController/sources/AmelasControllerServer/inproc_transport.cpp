@@ -0,0 +1,44 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file inproc_transport.cpp
+ * @brief This file contains the implementation of the in-process transport helpers.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasControllerServer/inproc_transport.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+namespace common{
+// =====================================================================================================================
+
+zmq::context_t& getInprocContext()
+{
+    // Never destroyed: the sockets of the static objects can outlive any static context.
+    static zmq::context_t* context = new zmq::context_t();
+    return *context;
+}
+
+}}} // END NAMESPACES.
+// =====================================================================================================================
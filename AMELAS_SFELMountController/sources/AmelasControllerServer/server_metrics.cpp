@@ -0,0 +1,287 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file server_metrics.cpp
+ * @brief This file contains the implementation of the ServerMetrics class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <iomanip>
+#include <new>
+#include <sstream>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasControllerServer/server_metrics.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace communication{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+namespace{
+
+// Single writer increment.
+inline void increment(std::atomic<std::uint64_t>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Convert a summary in ticks to nanoseconds.
+utils::LatencySummary toNanoseconds(const utils::LatencySummary& summary)
+{
+    utils::LatencySummary result = summary;
+    const double ratio = utils::CycleClock::nanosecondsPerTick();
+    for (std::int64_t* value : {&result.min, &result.mean, &result.p50, &result.p99, &result.p999, &result.max})
+        *value = static_cast<std::int64_t>(static_cast<double>(*value) * ratio + 0.5);
+    return result;
+}
+
+// Name of a string with description ("NAME - Description.").
+std::string shortName(const char* str)
+{
+    const std::string name(str);
+    return name.substr(0, name.find(' '));
+}
+
+} // END ANONYMOUS NAMESPACE.
+// ---------------------------------------------------------------------------------------------------------------------
+
+ServerMetrics::ServerMetrics()
+{
+    // Calibrate the clock now, not in the first snapshot.
+    utils::CycleClock::nanosecondsPerTick();
+    this->configure(1);
+}
+
+void ServerMetrics::configure(std::size_t shards)
+{
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->mtx_);
+
+    // Release the previous shards and create the new ones.
+    this->clear();
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, shards); i++)
+        this->shards_.push_back(std::make_unique<Shard>());
+    for (auto& queue : this->queues_)
+    {
+        queue.depth = 0;
+        queue.max_depth = 0;
+    }
+}
+
+void ServerMetrics::record(std::size_t shard, const RequestTrace& trace, OperationResult result) noexcept
+{
+    // Check the shard.
+    if (shard >= this->shards_.size())
+        return;
+    Shard& data = *this->shards_[shard];
+
+    // Result counter.
+    const std::size_t result_slot = static_cast<std::size_t>(result);
+    if (result_slot < kResultSlots)
+        increment(data.results[result_slot]);
+
+    // Get the command slot. It is allocated by this thread the first time (the only allocation).
+    std::atomic<CommandSlot*>& entry = data.commands[ServerMetrics::commandSlot(trace.command)];
+    CommandSlot* slot = entry.load(std::memory_order_acquire);
+    if (!slot)
+    {
+        slot = new (std::nothrow) CommandSlot();
+        if (!slot)
+            return;
+        entry.store(slot, std::memory_order_release);
+    }
+
+    // Counters.
+    increment(slot->requests);
+    if (result != OperationResult::COMMAND_OK)
+        increment(slot->errors);
+
+    // Latencies of the measured stages.
+    auto stage = [slot](MetricsStage s, std::uint64_t start, std::uint64_t end)
+    {
+        if (start && end)
+            slot->stages[static_cast<std::size_t>(s)].recordSingleWriter(static_cast<std::int64_t>(end - start));
+    };
+    stage(MetricsStage::DECODE, trace.received, trace.decoded);
+    stage(MetricsStage::PROCESS, trace.decoded, trace.processed);
+    stage(MetricsStage::REPLY, trace.processed, trace.replied);
+    stage(MetricsStage::TOTAL, trace.received, trace.replied);
+}
+
+void ServerMetrics::pushQueue(MetricsQueue queue) noexcept
+{
+    QueueGauge& gauge = this->queues_[static_cast<std::size_t>(queue)];
+    const std::int64_t depth = gauge.depth.load(std::memory_order_relaxed) + 1;
+    gauge.depth.store(depth, std::memory_order_relaxed);
+    if (depth > gauge.max_depth.load(std::memory_order_relaxed))
+        gauge.max_depth.store(depth, std::memory_order_relaxed);
+}
+
+void ServerMetrics::popQueue(MetricsQueue queue) noexcept
+{
+    QueueGauge& gauge = this->queues_[static_cast<std::size_t>(queue)];
+    const std::int64_t depth = gauge.depth.load(std::memory_order_relaxed);
+    if (depth > 0)
+        gauge.depth.store(depth - 1, std::memory_order_relaxed);
+}
+
+ServerMetricsSnapshot ServerMetrics::getSnapshot() const
+{
+    // Auxiliar variables and containers.
+    ServerMetricsSnapshot snapshot;
+    std::array<std::uint64_t, kResultSlots> results{};
+
+    // Safe mutex.
+    std::lock_guard<std::mutex> lock(this->mtx_);
+
+    // Merge the result counters.
+    for (const auto& shard : this->shards_)
+        for (std::size_t i = 0; i < kResultSlots; i++)
+            results[i] += shard->results[i].load(std::memory_order_relaxed);
+    std::size_t last = kResultSlots;
+    while (last > 0 && results[last - 1] == 0)
+        last--;
+    snapshot.results.assign(results.begin(), results.begin() + static_cast<std::ptrdiff_t>(last));
+
+    // Merge the commands (the merge histograms are big, so they are in the heap).
+    auto merged = std::make_unique<std::array<utils::LatencyHistogram, kStages>>();
+    for (std::size_t i = 0; i < kCommandSlots; i++)
+    {
+        CommandMetrics metrics;
+        metrics.command = ServerMetrics::slotCommand(i);
+        for (auto& histogram : *merged)
+            histogram.reset();
+        for (const auto& shard : this->shards_)
+        {
+            const CommandSlot* slot = shard->commands[i].load(std::memory_order_acquire);
+            if (!slot)
+                continue;
+            metrics.requests += slot->requests.load(std::memory_order_relaxed);
+            metrics.errors += slot->errors.load(std::memory_order_relaxed);
+            for (std::size_t s = 0; s < kStages; s++)
+                (*merged)[s].merge(slot->stages[s]);
+        }
+        if (metrics.requests == 0)
+            continue;
+        for (std::size_t s = 0; s < kStages; s++)
+            metrics.latencies[s] = toNanoseconds((*merged)[s].getSummary());
+        snapshot.commands.push_back(metrics);
+    }
+
+    // Queue gauges.
+    for (std::size_t i = 0; i < snapshot.queues.size(); i++)
+    {
+        snapshot.queues[i].depth = this->queues_[i].depth.load(std::memory_order_relaxed);
+        snapshot.queues[i].max_depth = this->queues_[i].max_depth.load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+std::string ServerMetrics::formatSnapshot(const ServerMetricsSnapshot& snapshot)
+{
+    // Auxiliar variables.
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+
+    // Queues and results.
+    out << "Queues: read " << snapshot.queues[0].depth << " (max " << snapshot.queues[0].max_depth << ") | write "
+        << snapshot.queues[1].depth << " (max " << snapshot.queues[1].max_depth << ")\n";
+    out << "Results:";
+    for (std::size_t i = 0; i < snapshot.results.size(); i++)
+    {
+        if (snapshot.results[i] == 0)
+            continue;
+        out << ' ' << (i < common::AmelasServerResultStr.size() ? shortName(common::AmelasServerResultStr[i]) :
+                                                                  std::to_string(i)) << '=' << snapshot.results[i];
+    }
+    out << '\n';
+
+    // Commands. Each stage is p50/p99/p99.9/max in microseconds.
+    out << std::left << std::setw(30) << "Command" << std::right << std::setw(10) << "Requests" << std::setw(8)
+        << "Errors";
+    for (const char* stage : MetricsStageStr)
+        out << "  " << std::left << std::setw(30) << (std::string(stage) + " p50/p99/p99.9/max us") << std::right;
+    out << '\n';
+    for (const CommandMetrics& metrics : snapshot.commands)
+    {
+        const std::size_t id = static_cast<std::size_t>(metrics.command);
+        const std::string name = metrics.command >= 0 && id < common::AmelasServerCommandStr.size() ?
+                                     common::AmelasServerCommandStr[id] : "INVALID_COMMAND";
+        out << std::left << std::setw(30) << name << std::right << std::setw(10) << metrics.requests << std::setw(8)
+            << metrics.errors;
+        for (const utils::LatencySummary& summary : metrics.latencies)
+        {
+            std::ostringstream stage;
+            stage << std::fixed << std::setprecision(1);
+            if (summary.count)
+                stage << summary.p50 / 1e3 << '/' << summary.p99 / 1e3 << '/' << summary.p999 / 1e3 << '/'
+                      << summary.max / 1e3;
+            else
+                stage << '-';
+            out << "  " << std::left << std::setw(30) << stage.str() << std::right;
+        }
+        out << '\n';
+    }
+
+    return out.str();
+}
+
+ServerMetrics::~ServerMetrics()
+{
+    this->clear();
+}
+
+std::size_t ServerMetrics::commandSlot(ServerCommand command) noexcept
+{
+    const int id = static_cast<int>(command);
+    if (id >= 0 && id < static_cast<int>(kBaseCommandSlots))
+        return static_cast<std::size_t>(id);
+    if (id >= common::kMinCmdId && id <= common::kMaxCmdId)
+        return kBaseCommandSlots + static_cast<std::size_t>(id - common::kMinCmdId);
+    return kCommandSlots - 1;
+}
+
+std::int32_t ServerMetrics::slotCommand(std::size_t slot) noexcept
+{
+    if (slot < kBaseCommandSlots)
+        return static_cast<std::int32_t>(slot);
+    if (slot < kCommandSlots - 1)
+        return static_cast<std::int32_t>(slot - kBaseCommandSlots) + common::kMinCmdId;
+    return -1;
+}
+
+void ServerMetrics::clear()
+{
+    for (auto& shard : this->shards_)
+        for (auto& slot : shard->commands)
+            delete slot.exchange(nullptr);
+    this->shards_.clear();
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
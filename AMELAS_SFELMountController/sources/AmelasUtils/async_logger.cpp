@@ -0,0 +1,340 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file async_logger.cpp
+ * @brief This file contains the implementation of the AsyncLogger class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <ctime>
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/async_logger.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+static_assert((AsyncLogger::kRingSlots & (AsyncLogger::kRingSlots - 1)) == 0, "The ring slots must be power of two.");
+constexpr std::size_t kRingMask = AsyncLogger::kRingSlots - 1;
+constexpr std::chrono::milliseconds kWriterIdleSleep(1);
+constexpr std::size_t kWriterBatch = 256;
+// ---------------------------------------------------------------------------------------------------------------------
+
+AsyncLogger::AsyncLogger() :
+    cells_(new Cell[kRingSlots]),
+    enqueue_pos_(0),
+    dequeue_pos_(0),
+    level_(static_cast<std::int32_t>(LogLevel::TRACE)),
+    dropped_(0),
+    running_(true),
+    out_(stdout)
+{
+    // Initialize the cells sequences.
+    for (std::size_t i = 0; i < kRingSlots; i++)
+        this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+
+    // Start the writer.
+    this->writer_ = std::thread(&AsyncLogger::writerWorker, this);
+}
+
+AsyncLogger &AsyncLogger::getInstance()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+void AsyncLogger::setLevel(LogLevel level)
+{
+    this->level_.store(static_cast<std::int32_t>(level), std::memory_order_relaxed);
+}
+
+LogLevel AsyncLogger::getLevel() const
+{
+    return static_cast<LogLevel>(this->level_.load(std::memory_order_relaxed));
+}
+
+bool AsyncLogger::setOutputFile(const std::string &path)
+{
+    // Open the new output.
+    std::FILE* file = stdout;
+    if (!path.empty())
+    {
+        file = std::fopen(path.c_str(), "a");
+        if (!file)
+            return false;
+    }
+
+    // Swap the output.
+    std::lock_guard<std::mutex> lock(this->out_mtx_);
+    if (this->out_ != stdout)
+        std::fclose(this->out_);
+    this->out_ = file;
+    return true;
+}
+
+void AsyncLogger::flush()
+{
+    const std::size_t target = this->enqueue_pos_.load(std::memory_order_acquire);
+    while (this->running_ && this->dequeue_pos_.load(std::memory_order_acquire) < target)
+        std::this_thread::sleep_for(kWriterIdleSleep);
+}
+
+std::uint64_t AsyncLogger::getDroppedRecords() const
+{
+    return this->dropped_.load(std::memory_order_relaxed);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    // Stop the writer (it drains the pending records).
+    this->running_ = false;
+    if (this->writer_.joinable())
+        this->writer_.join();
+
+    // Close the output file.
+    if (this->out_ != stdout)
+        std::fclose(this->out_);
+}
+
+AsyncLogger::Cell *AsyncLogger::claimCell()
+{
+    std::size_t pos = this->enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell* cell = &this->cells_[pos & kRingMask];
+        const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        const auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+        if (dif == 0)
+        {
+            if (this->enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return cell;
+        }
+        else if (dif < 0)
+        {
+            this->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+            pos = this->enqueue_pos_.load(std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::publishCell(Cell *cell)
+{
+    // The cell sequence was the claimed position, so the next value marks it as ready for the reader.
+    cell->sequence.store(cell->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AsyncLogger::encodeRaw(Record &record, ArgType type, const void *data, std::size_t size, bool with_length)
+{
+    // Check the free space (type, optional length and at least one byte of data).
+    const std::size_t header = 1 + (with_length ? sizeof(std::uint16_t) : 0);
+    if (record.truncated || record.size + header + (size ? 1 : 0) > kRecordPayload)
+    {
+        record.truncated = true;
+        return;
+    }
+
+    // Fixed size values must fit completely. Variable size values are cut.
+    std::size_t n = std::min(size, kRecordPayload - record.size - header);
+    if (n < size)
+    {
+        record.truncated = true;
+        if (!with_length)
+            return;
+    }
+
+    // Store the argument.
+    std::byte* dst = record.payload.data() + record.size;
+    *dst++ = static_cast<std::byte>(type);
+    if (with_length)
+    {
+        const auto len = static_cast<std::uint16_t>(n);
+        std::memcpy(dst, &len, sizeof(len));
+        dst += sizeof(len);
+    }
+    if (n)
+        std::memcpy(dst, data, n);
+    record.size = static_cast<std::uint16_t>(record.size + header + n);
+}
+
+void AsyncLogger::writerWorker()
+{
+    // Auxiliar variables.
+    std::string batch;
+    bool running = true;
+    bool full = false;
+
+    // Writer loop. When stopping, the remaining records are drained (batch by batch) before exit.
+    while (running || full)
+    {
+        running = this->running_;
+
+        // Format the ready records, up to a batch. The cap bounds the batch size and the write delay when the
+        // producers keep the ring busy, and the freed slots are published after each batch.
+        std::size_t pos = this->dequeue_pos_.load(std::memory_order_relaxed);
+        const std::size_t last = pos + kWriterBatch;
+        while (pos != last)
+        {
+            Cell& cell = this->cells_[pos & kRingMask];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+                break;
+            AsyncLogger::formatRecord(cell.record, batch);
+            cell.sequence.store(pos + kRingSlots, std::memory_order_release);
+            pos++;
+        }
+
+        // Write the batch or wait for new records.
+        if (!batch.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->out_mtx_);
+                std::fwrite(batch.data(), 1, batch.size(), this->out_);
+                std::fflush(this->out_);
+            }
+            batch.clear();
+        }
+        this->dequeue_pos_.store(pos, std::memory_order_release);
+        full = (pos == last);
+        if (running && !full && pos == this->enqueue_pos_.load(std::memory_order_relaxed))
+            std::this_thread::sleep_for(kWriterIdleSleep);
+    }
+}
+
+void AsyncLogger::formatRecord(const Record &record, std::string &out)
+{
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    char buffer[64];
+
+    // ISO 8601 UTC time with milliseconds.
+    const std::time_t secs = static_cast<std::time_t>(record.timestamp / 1000000000);
+    const long msecs = static_cast<long>((record.timestamp / 1000000) % 1000);
+    std::tm tm_utc{};
+#if defined(_WIN32)
+    gmtime_s(&tm_utc, &secs);
+#else
+    gmtime_r(&secs, &tm_utc);
+#endif
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm_utc);
+    out.append(buffer);
+    std::snprintf(buffer, sizeof(buffer), ".%03ldZ [%s] ", msecs,
+                  LogLevelStr[static_cast<std::size_t>(record.level)]);
+    out.append(buffer);
+
+    // Decode the arguments.
+    const std::byte* src = record.payload.data();
+    const std::byte* end = src + record.size;
+    while (src < end)
+    {
+        const auto type = static_cast<ArgType>(*src++);
+        std::uint16_t len = 0;
+        if (type == ArgType::STRING || type == ArgType::HEX)
+        {
+            std::memcpy(&len, src, sizeof(len));
+            src += sizeof(len);
+        }
+        switch (type)
+        {
+            case ArgType::BOOL:
+            {
+                bool v;
+                std::memcpy(&v, src, sizeof(v));
+                out.append(v ? "true" : "false");
+                src += sizeof(v);
+                break;
+            }
+            case ArgType::SIGNED:
+            {
+                std::int64_t v;
+                std::memcpy(&v, src, sizeof(v));
+                std::snprintf(buffer, sizeof(buffer), "%" PRId64, v);
+                out.append(buffer);
+                src += sizeof(v);
+                break;
+            }
+            case ArgType::UNSIGNED:
+            {
+                std::uint64_t v;
+                std::memcpy(&v, src, sizeof(v));
+                std::snprintf(buffer, sizeof(buffer), "%" PRIu64, v);
+                out.append(buffer);
+                src += sizeof(v);
+                break;
+            }
+            case ArgType::REAL:
+            {
+                double v;
+                std::memcpy(&v, src, sizeof(v));
+                std::snprintf(buffer, sizeof(buffer), "%.10g", v);
+                out.append(buffer);
+                src += sizeof(v);
+                break;
+            }
+            case ArgType::STRING:
+            {
+                out.append(reinterpret_cast<const char*>(src), len);
+                src += len;
+                break;
+            }
+            case ArgType::HEX:
+            {
+                for (std::uint16_t i = 0; i < len; i++)
+                {
+                    const auto byte = static_cast<unsigned>(src[i]);
+                    if (i > 0)
+                        out.push_back(' ');
+                    out.push_back(kHexDigits[byte >> 4]);
+                    out.push_back(kHexDigits[byte & 0x0F]);
+                }
+                src += len;
+                break;
+            }
+            case ArgType::UUID:
+            {
+                std::array<std::byte, zmqutils::utils::UUID::kUUIDSize> bytes;
+                std::memcpy(bytes.data(), src, bytes.size());
+                const std::size_t position = out.size();
+                out.resize(position + zmqutils::utils::UUID::kRFC4122Size);
+                zmqutils::utils::UUID(bytes).writeRFC4122(&out[position]);
+                src += bytes.size();
+                break;
+            }
+        }
+    }
+
+    // End of line.
+    if (record.truncated)
+        out.append(" [...]");
+    out.push_back('\n');
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================
@@ -0,0 +1,238 @@
+/***********************************************************************************************************************
+ *   AMELAS_SFELMountController: [...].
+ *
+ *   Copyright (C) 2023 ROA Team (Royal Institute and Observatory of the Spanish Navy)
+ *                      < Ángel Vera Herrera, avera@roa.es - angeldelaveracruz@gmail.com >
+ *                      < Jesús Relinque Madroñal >
+ *                      AVS AMELAS Team
+ *                      <>
+ *
+ *   This file is part of AMELAS_SFELMountController.
+ *
+ *   Licensed under [...]
+ **********************************************************************************************************************/
+
+/** ********************************************************************************************************************
+ * @file shared_memory.cpp
+ * @brief This file contains the implementation of the SharedMemory class.
+ * @author Degoras Project Team
+ * @author AVS AMELAS Team
+ * @copyright EUPL License
+ * @version 2310.1
+***********************************************************************************************************************/
+
+// C++ INCLUDES
+// =====================================================================================================================
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+// =====================================================================================================================
+
+// SYSTEM INCLUDES
+// =====================================================================================================================
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+// =====================================================================================================================
+
+// PROJECT INCLUDES
+// =====================================================================================================================
+#include "AmelasUtils/shared_memory.h"
+#include "AmelasUtils/async_logger.h"
+// =====================================================================================================================
+
+// AMELAS NAMESPACES
+// =====================================================================================================================
+namespace amelas{
+namespace utils{
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+namespace{
+
+#if defined(_WIN32)
+// Windows object name of a POSIX style name.
+std::string toWindowsName(const std::string& name)
+{
+    return "Local\\" + (!name.empty() && name.front() == '/' ? name.substr(1) : name);
+}
+#endif
+
+} // END ANONYMOUS NAMESPACE.
+// ---------------------------------------------------------------------------------------------------------------------
+
+SharedMemory::SharedMemory() :
+    data_(nullptr),
+    size_(0),
+    handle_(nullptr),
+    owner_(false),
+    reused_(false)
+{}
+
+bool SharedMemory::create(const std::string &name, std::size_t size)
+{
+    // Close the previous region.
+    this->close();
+    if (size == 0)
+        return false;
+
+#if defined(_WIN32)
+    // Create the mapping backed by the paging file (already zero filled).
+    const std::uint64_t size64 = static_cast<std::uint64_t>(size);
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFu),
+                                       toWindowsName(name).c_str());
+    if (!handle)
+    {
+        AMELAS_LOG_WARNING("<SHARED MEMORY> Unable to create ", name, " (error ", GetLastError(), ").");
+        return false;
+    }
+    const bool exists = (GetLastError() == ERROR_ALREADY_EXISTS);
+    void* data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, exists ? 0 : size);
+    if (!data)
+    {
+        CloseHandle(handle);
+        AMELAS_LOG_WARNING("<SHARED MEMORY> Unable to map ", name, " (error ", GetLastError(), ").");
+        return false;
+    }
+
+    // The object lives while any process maps it, so a previous region can still exist (the readers of a restarted
+    // writer keep it). It is reused if it has the same size (rounded to pages), and the caller reinitializes it.
+    if (exists)
+    {
+        SYSTEM_INFO system;
+        GetSystemInfo(&system);
+        const std::size_t page = system.dwPageSize;
+        const std::size_t expected = (size + page - 1) / page * page;
+        MEMORY_BASIC_INFORMATION info;
+        const std::size_t current = VirtualQuery(data, &info, sizeof(info)) ? info.RegionSize : 0;
+        if (current != expected)
+        {
+            UnmapViewOfFile(data);
+            CloseHandle(handle);
+            AMELAS_LOG_WARNING("<SHARED MEMORY> Unable to create ", name, " (it is mapped by other processes with ",
+                               current, " bytes, ", expected, " required).");
+            return false;
+        }
+        AMELAS_LOG_INFO("<SHARED MEMORY> Reusing ", name, " (it is still mapped by other processes).");
+    }
+    this->handle_ = handle;
+    this->reused_ = exists;
+#else
+    // Replace any previous object and size the new one (ftruncate fills it with zeros).
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0)
+    {
+        AMELAS_LOG_WARNING("<SHARED MEMORY> Unable to create ", name, ": ", std::strerror(errno));
+        return false;
+    }
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        AMELAS_LOG_WARNING("<SHARED MEMORY> Unable to map ", name, ": ", std::strerror(error));
+        return false;
+    }
+#endif
+
+    this->name_ = name;
+    this->data_ = data;
+    this->size_ = size;
+    this->owner_ = true;
+    return true;
+}
+
+bool SharedMemory::open(const std::string &name, bool writable)
+{
+    // Close the previous region.
+    this->close();
+
+#if defined(_WIN32)
+    // Open the mapping. The size is the size of the view (rounded to pages).
+    const DWORD access = writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+    HANDLE handle = OpenFileMappingA(access, FALSE, toWindowsName(name).c_str());
+    if (!handle)
+        return false;
+    void* data = MapViewOfFile(handle, access, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (!data || VirtualQuery(data, &info, sizeof(info)) == 0)
+    {
+        if (data)
+            UnmapViewOfFile(data);
+        CloseHandle(handle);
+        return false;
+    }
+    this->handle_ = handle;
+    const std::size_t size = info.RegionSize;
+#else
+    // Open the object and map its whole size.
+    const int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        data = mmap(nullptr, static_cast<std::size_t>(info.st_size), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                    MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+#endif
+
+    this->name_ = name;
+    this->data_ = data;
+    this->size_ = size;
+    this->owner_ = false;
+    return true;
+}
+
+void SharedMemory::close()
+{
+    if (!this->data_)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(this->data_);
+    CloseHandle(static_cast<HANDLE>(this->handle_));
+    this->handle_ = nullptr;
+#else
+    munmap(this->data_, this->size_);
+    if (this->owner_)
+        shm_unlink(this->name_.c_str());
+#endif
+
+    this->name_.clear();
+    this->data_ = nullptr;
+    this->size_ = 0;
+    this->owner_ = false;
+    this->reused_ = false;
+}
+
+void SharedMemory::remove(const std::string &name)
+{
+#if defined(_WIN32)
+    // The Windows objects have no names to remove (they are destroyed with the last handle).
+    (void)name;
+#else
+    shm_unlink(name.c_str());
+#endif
+}
+
+SharedMemory::~SharedMemory()
+{
+    this->close();
+}
+
+}} // END NAMESPACES.
+// =====================================================================================================================